@@ -0,0 +1,177 @@
+///////////////////////////////////////////////////////////////////////////////
+// fragmentShader.glsl
+// ============
+// color the scene meshes with textures, materials and clustered lights
+//
+//  The lights are read from storage buffers.  The view frustum is split
+//  into a grid of clusters, and each cluster lists the lights that reach
+//  into it, so a fragment only looks at the lights of its own cluster,
+//  along with the lights that reach the whole scene.  The materials of
+//  the scene are in a storage buffer too, and each mesh only passes the
+//  index of its material, so that changing the material between draws
+//  costs nothing.
+///////////////////////////////////////////////////////////////////////////////
+#version 440 core
+
+struct Material
+{
+	vec3 ambientColor;
+	float ambientStrength;
+	vec3 diffuseColor;
+	vec3 specularColor;
+	float shininess;
+};
+
+struct LightSource
+{
+	// position in xyz and radius in w, a radius of 0 reaches everything
+	vec4 positionRadius;
+	// ambient color in rgb and focal strength in w
+	vec4 ambientColor;
+	// diffuse color in rgb and specular intensity in w
+	vec4 diffuseColor;
+	vec4 specularColor;
+};
+
+struct MaterialData
+{
+	// ambient color in rgb and ambient strength in w
+	vec4 ambientColor;
+	// diffuse color in rgb and shininess in w
+	vec4 diffuseColor;
+	vec4 specularColor;
+};
+
+in vec3 fragmentPosition;
+in vec3 fragmentVertexNormal;
+in vec3 fragmentTextureCoordinate;
+in vec4 fragmentColor;
+in vec4 fragmentClipPosition;
+in float fragmentViewDepth;
+flat in int fragmentMaterial;
+
+out vec4 outFragmentColor;
+
+uniform bool bUseTexture = false;
+uniform bool bUseLighting = false;
+// texture array holding the texture, which is sampled at the layer
+// passed in with the texture coordinate
+uniform sampler2DArray objectTexture;
+uniform vec3 viewPosition;
+
+layout (std430, binding = 0) readonly buffer LightBuffer
+{
+	LightSource lights[];
+};
+
+layout (std430, binding = 1) readonly buffer ClusterBuffer
+{
+	// clusters along x, y and depth, and the number of lights that
+	// reach the whole scene in w
+	uvec4 clusterGrid;
+	// depth of the first slice split, and the scale that turns the log
+	// of a depth over it into a slice
+	vec4 clusterDepth;
+	// offset into the light index list and light count of each cluster
+	uvec2 clusters[];
+};
+
+layout (std430, binding = 2) readonly buffer LightIndexBuffer
+{
+	// the lights that reach the whole scene, then the lights of each cluster
+	uint lightIndices[];
+};
+
+layout (std430, binding = 3) readonly buffer MaterialBuffer
+{
+	// every material of the scene, at the index of its handle
+	MaterialData materials[];
+};
+
+uint FindCluster();
+vec3 CalcLightSource(LightSource light, Material surface, vec3 lightNormal, vec3 viewDirection);
+
+void main()
+{
+	vec4 baseColor = fragmentColor;
+	if (bUseTexture == true)
+	{
+		baseColor = texture(objectTexture, fragmentTextureCoordinate);
+	}
+
+	if (bUseLighting == false)
+	{
+		outFragmentColor = baseColor;
+		return;
+	}
+
+	// meshes without a material only take the diffuse light
+	Material surface = Material(vec3(0.0f), 0.0f, vec3(1.0f), vec3(0.0f), 1.0f);
+	if (fragmentMaterial >= 0)
+	{
+		MaterialData data = materials[fragmentMaterial];
+		surface.ambientColor = data.ambientColor.rgb;
+		surface.ambientStrength = data.ambientColor.w;
+		surface.diffuseColor = data.diffuseColor.rgb;
+		surface.specularColor = data.specularColor.rgb;
+		surface.shininess = data.diffuseColor.w;
+	}
+
+	vec3 lightNormal = normalize(fragmentVertexNormal);
+	vec3 viewDirection = normalize(viewPosition - fragmentPosition);
+	vec3 phongResult = vec3(0.0f);
+
+	for (uint i = 0; i < clusterGrid.w; i++)
+	{
+		phongResult += CalcLightSource(lights[lightIndices[i]], surface, lightNormal, viewDirection);
+	}
+
+	uvec2 cluster = clusters[FindCluster()];
+	for (uint i = 0; i < cluster.y; i++)
+	{
+		phongResult += CalcLightSource(lights[lightIndices[cluster.x + i]], surface,
+			lightNormal, viewDirection);
+	}
+
+	outFragmentColor = vec4(phongResult * baseColor.rgb, baseColor.a);
+}
+
+// index of the cluster that the fragment falls in
+uint FindCluster()
+{
+	vec2 screen = clamp((fragmentClipPosition.xy / fragmentClipPosition.w) * 0.5f + 0.5f, 0.0f, 1.0f);
+	uvec2 tile = min(uvec2(screen * vec2(clusterGrid.xy)), clusterGrid.xy - 1);
+
+	float depth = max(fragmentViewDepth, clusterDepth.x);
+	uint slice = min(uint(log(depth / clusterDepth.x) * clusterDepth.y), clusterGrid.z - 1);
+
+	return tile.x + clusterGrid.x * (tile.y + clusterGrid.y * slice);
+}
+
+// ambient, diffuse and specular light from one light source - lights
+// with a radius fade out smoothly to nothing at the radius
+vec3 CalcLightSource(LightSource light, Material surface, vec3 lightNormal, vec3 viewDirection)
+{
+	vec3 lightOffset = light.positionRadius.xyz - fragmentPosition;
+	float attenuation = 1.0f;
+	if (light.positionRadius.w > 0.0f)
+	{
+		float distanceRatio = length(lightOffset) / light.positionRadius.w;
+		attenuation = clamp(1.0f - pow(distanceRatio, 4.0f), 0.0f, 1.0f);
+		attenuation *= attenuation;
+	}
+
+	vec3 ambient = light.ambientColor.rgb * surface.ambientColor * surface.ambientStrength;
+
+	vec3 lightDirection = normalize(lightOffset);
+	float impact = max(dot(lightNormal, lightDirection), 0.0f);
+	vec3 diffuse = impact * light.diffuseColor.rgb * surface.diffuseColor;
+
+	vec3 reflectDirection = reflect(-lightDirection, lightNormal);
+	float specularComponent = pow(max(dot(viewDirection, reflectDirection), 0.0f),
+		max(light.ambientColor.w * surface.shininess, 1.0f));
+	vec3 specular = light.diffuseColor.w * specularComponent *
+		light.specularColor.rgb * surface.specularColor;
+
+	return attenuation * (ambient + diffuse + specular);
+}
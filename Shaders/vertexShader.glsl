@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////
+// vertexShader.glsl
+// ============
+// transform the vertices of the scene meshes
+//
+//  Meshes drawn with instancing read the model matrix, color, texture
+//  mapping scale, texture array layer and material index of each
+//  instance from vertex attributes instead of from the uniforms.  The
+//  material index is passed on so that the fragment shader can read the
+//  material from the material buffer.
+///////////////////////////////////////////////////////////////////////////////
+#version 440 core
+
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+// per-instance values - the matrix uses locations 3 to 6
+layout (location = 3) in mat4 inInstanceModel;
+layout (location = 7) in vec4 inInstanceColor;
+// texture mapping scale in xy, texture array layer in z and material
+// index in w, or -1 for none
+layout (location = 8) in vec4 inInstanceTexture;
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+// texture coordinate in xy and texture array layer in z
+out vec3 fragmentTextureCoordinate;
+out vec4 fragmentColor;
+// clip space position and view space depth, which pick the light
+// cluster of the fragment
+out vec4 fragmentClipPosition;
+out float fragmentViewDepth;
+// index of the material in the material buffer, or -1 for none
+flat out int fragmentMaterial;
+
+uniform bool bUseInstancing = false;
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec4 objectColor = vec4(1.0f);
+uniform vec2 UVscale = vec2(1.0f, 1.0f);
+uniform float textureLayer = 0.0f;
+uniform int materialIndex = -1;
+
+void main()
+{
+	mat4 modelMatrix = model;
+	fragmentColor = objectColor;
+	vec3 textureScaleLayer = vec3(UVscale, textureLayer);
+	fragmentMaterial = materialIndex;
+	if (bUseInstancing == true)
+	{
+		modelMatrix = inInstanceModel;
+		fragmentColor = inInstanceColor;
+		textureScaleLayer = inInstanceTexture.xyz;
+		fragmentMaterial = int(inInstanceTexture.w);
+	}
+
+	vec4 worldPosition = modelMatrix * vec4(inVertexPosition, 1.0f);
+	vec4 viewPosition = view * worldPosition;
+	gl_Position = projection * viewPosition;
+	fragmentClipPosition = gl_Position;
+	fragmentViewDepth = -viewPosition.z;
+
+	fragmentPosition = vec3(worldPosition);
+	fragmentVertexNormal = mat3(transpose(inverse(modelMatrix))) * inVertexNormal;
+	fragmentTextureCoordinate = vec3(inTextureCoordinate * textureScaleLayer.xy,
+		textureScaleLayer.z);
+}
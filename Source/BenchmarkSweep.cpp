@@ -0,0 +1,235 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmarksweep.cpp
+// ============
+// compare the benchmark results of generated scenes with more and more objects
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BenchmarkSweep.h"
+#include "HeapCounter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// bytes in a megabyte, which the memory is reported in
+	const double g_BytesPerMegabyte = 1024.0 * 1024.0;
+}
+
+/***********************************************************
+ *  BenchmarkSweep()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BenchmarkSweep::BenchmarkSweep()
+{
+}
+
+/***********************************************************
+ *  AddResult()
+ *
+ *  This method is used for keeping the statistics and the
+ *  mean counts of the benchmark of one object count.
+ ***********************************************************/
+void BenchmarkSweep::AddResult(int objectCount, const FrameBenchmark& benchmark,
+	uint64_t memoryBefore, uint64_t memoryAfter)
+{
+	SWEEP_RESULT result;
+	result.objectCount = objectCount;
+	result.cpu = benchmark.GetCpuStats();
+	result.gpu = benchmark.GetGpuStats();
+	result.interval = benchmark.GetIntervalStats();
+	result.draws = benchmark.GetCounterMean("draws");
+	result.drawCalls = benchmark.GetCounterMean("drawCalls");
+	result.multiDraws = benchmark.GetCounterMean("multiDraws");
+	result.triangles = benchmark.GetCounterMean("triangles");
+	result.objectsVisible = benchmark.GetCounterMean("objectsVisible");
+	result.objectsCulled = benchmark.GetCounterMean("objectsCulled");
+	result.objectsOccluded = benchmark.GetCounterMean("objectsOccluded");
+	result.heapAllocations = benchmark.GetCounterMean("heapAllocations");
+	result.arenaBytes = benchmark.GetCounterMean("arenaBytes");
+	result.memoryBefore = memoryBefore;
+	result.memoryAfter = memoryAfter;
+
+	m_results.push_back(result);
+}
+
+/***********************************************************
+ *  GetFrameTime()
+ *
+ *  This method is used for getting the mean time between
+ *  frames of a count, which is limited by whichever of the
+ *  update, the drawing and the GPU is the slowest.  A single
+ *  measured frame has no interval, so its drawing time is
+ *  used instead.
+ ***********************************************************/
+double BenchmarkSweep::GetFrameTime(const SWEEP_RESULT& result)
+{
+	if (result.interval.mean > 0.0)
+	{
+		return(result.interval.mean);
+	}
+
+	return(std::max(result.cpu.mean, result.gpu.mean));
+}
+
+/***********************************************************
+ *  WriteResults()
+ *
+ *  This method is used for writing the results of every
+ *  object count to the passed in file as JSON, and printing
+ *  a summary table.  The extra time per object is taken from
+ *  the count before, so the time that every frame takes no
+ *  matter how many objects there are drops out of it.
+ ***********************************************************/
+bool BenchmarkSweep::WriteResults(const char* filename, const char* renderer, uint32_t seed) const
+{
+	std::ofstream output(filename);
+
+	if (!output.is_open())
+	{
+		std::cout << "Could not write benchmark sweep results:" << filename << std::endl;
+		return false;
+	}
+
+	output.precision(4);
+	output << std::fixed;
+
+	output << "{\n";
+	output << "  \"renderer\": ";
+	FrameBenchmark::WriteJsonString(output, renderer);
+	output << ",\n";
+	output << "  \"seed\": " << seed << ",\n";
+	output << "  \"sizes\": [";
+
+	std::printf("%10s %10s %10s %10s %10s %12s %10s %12s %12s\n",
+		"objects", "frameMs", "cpuMs", "gpuMs", "drawCalls", "triangles",
+		"memoryMB", "usPerObject", "usPerExtra");
+
+	for (size_t i = 0; i < m_results.size(); i++)
+	{
+		const SWEEP_RESULT& result = m_results[i];
+		const double frameTime = GetFrameTime(result);
+		const double perObject = (frameTime * 1000.0) / result.objectCount;
+		double perExtraObject = perObject;
+		if ((i > 0) && (result.objectCount > m_results[i - 1].objectCount))
+		{
+			perExtraObject = ((frameTime - GetFrameTime(m_results[i - 1])) * 1000.0) /
+				(result.objectCount - m_results[i - 1].objectCount);
+		}
+		const double memory = result.memoryAfter / g_BytesPerMegabyte;
+		const double sceneMemory = (result.memoryAfter > result.memoryBefore) ?
+			((result.memoryAfter - result.memoryBefore) / g_BytesPerMegabyte) : 0.0;
+
+		output << (i > 0 ? ",\n    {" : "\n    {");
+		output << "\"objects\": " << result.objectCount;
+		output << ", \"frameMeanMs\": " << frameTime;
+		output << ", \"frameP95Ms\": " << result.interval.p95;
+		output << ", \"cpuMeanMs\": " << result.cpu.mean;
+		output << ", \"cpuP95Ms\": " << result.cpu.p95;
+		output << ", \"gpuMeanMs\": " << result.gpu.mean;
+		output << ", \"gpuP95Ms\": " << result.gpu.p95;
+		output << ", \"draws\": " << result.draws;
+		output << ", \"drawCalls\": " << result.drawCalls;
+		output << ", \"multiDraws\": " << result.multiDraws;
+		output << ", \"triangles\": " << result.triangles;
+		output << ", \"objectsVisible\": " << result.objectsVisible;
+		output << ", \"objectsCulled\": " << result.objectsCulled;
+		output << ", \"objectsOccluded\": " << result.objectsOccluded;
+		if (HeapCounter::IsCounting() == true)
+		{
+			output << ", \"heapAllocations\": " << result.heapAllocations;
+		}
+		else
+		{
+			output << ", \"heapAllocations\": null";
+		}
+		output << ", \"arenaMB\": " << (result.arenaBytes / g_BytesPerMegabyte);
+		output << ", \"residentMB\": " << memory;
+		output << ", \"sceneMB\": " << sceneMemory;
+		output << ", \"usPerObject\": " << perObject;
+		output << ", \"usPerExtraObject\": " << perExtraObject;
+		output << "}";
+
+		std::printf("%10d %10.3f %10.3f %10.3f %10.1f %12.0f %10.1f %12.4f %12.4f\n",
+			result.objectCount, frameTime, result.cpu.mean, result.gpu.mean,
+			result.drawCalls, result.triangles, memory, perObject, perExtraObject);
+	}
+	output << "\n  ]\n}\n";
+
+	std::cout << "INFO: Benchmark sweep results written to " << filename << std::endl;
+
+	return output.good();
+}
+
+/***********************************************************
+ *  ParseCounts()
+ *
+ *  This method is used for parsing the object counts of a
+ *  sweep, such as "1000,10000,100000".  The counts are
+ *  sorted, so each is compared with the next smaller one.
+ ***********************************************************/
+bool BenchmarkSweep::ParseCounts(const char* text, std::vector<int>& counts)
+{
+	counts.clear();
+
+	const char* cursor = text;
+	while ((NULL != cursor) && (*cursor != '\0'))
+	{
+		char* end = NULL;
+		long count = std::strtol(cursor, &end, 10);
+		if ((end == cursor) || (count < 1) || ((*end != ',') && (*end != '\0')))
+		{
+			std::cout << "Could not parse the object counts:" << text << std::endl;
+			return false;
+		}
+		counts.push_back((int)count);
+		cursor = (*end == ',') ? (end + 1) : end;
+	}
+
+	std::sort(counts.begin(), counts.end());
+	counts.erase(std::unique(counts.begin(), counts.end()), counts.end());
+
+	return(counts.empty() == false);
+}
+
+/***********************************************************
+ *  GetResidentMemory()
+ *
+ *  This method is used for getting the memory of the process
+ *  that is resident in RAM - the working set on Windows.
+ ***********************************************************/
+uint64_t BenchmarkSweep::GetResidentMemory()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return((uint64_t)counters.WorkingSetSize);
+	}
+#elif defined(__linux__)
+	// the second value of statm is the number of resident pages
+	std::ifstream statm("/proc/self/statm");
+	uint64_t totalPages = 0;
+	uint64_t residentPages = 0;
+	if (statm >> totalPages >> residentPages)
+	{
+		return(residentPages * (uint64_t)sysconf(_SC_PAGESIZE));
+	}
+#endif
+
+	return(0);
+}
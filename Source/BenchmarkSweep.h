@@ -0,0 +1,74 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmarksweep.h
+// ============
+// compare the benchmark results of generated scenes with more and more objects
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FrameBenchmark.h"
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  BenchmarkSweep
+ *
+ *  This class contains the code for collecting the benchmark
+ *  of a generated scene at each object count of a sweep, and
+ *  for writing them side by side.  Each count reports its
+ *  frame times, draw calls and the memory of the process,
+ *  along with the time per object and the extra time of each
+ *  extra object since the last count.  While the rendering
+ *  scales linearly the extra time per object stays about the
+ *  same, and the count where it jumps is where it stops.
+ ***********************************************************/
+class BenchmarkSweep
+{
+public:
+	// constructor
+	BenchmarkSweep();
+
+	// add the results of the scene with the passed in object count, and
+	// the resident memory before the scene was prepared and after it
+	// was drawn
+	void AddResult(int objectCount, const FrameBenchmark& benchmark,
+		uint64_t memoryBefore, uint64_t memoryAfter);
+	// write the results of every count as JSON to the passed in file,
+	// and print them as a table
+	bool WriteResults(const char* filename, const char* renderer, uint32_t seed) const;
+
+	// parse a comma separated list of object counts, sorted from the
+	// smallest to the largest
+	static bool ParseCounts(const char* text, std::vector<int>& counts);
+	// get the bytes of memory that the process has resident, or 0 when
+	// the platform can't tell
+	static uint64_t GetResidentMemory();
+
+private:
+	// results of one object count
+	struct SWEEP_RESULT
+	{
+		int objectCount;
+		FrameBenchmark::TIMING_STATS cpu;
+		FrameBenchmark::TIMING_STATS gpu;
+		FrameBenchmark::TIMING_STATS interval;
+		double draws;
+		double drawCalls;
+		double multiDraws;
+		double triangles;
+		double objectsVisible;
+		double objectsCulled;
+		double objectsOccluded;
+		// heap allocations and frame arena bytes per frame
+		double heapAllocations;
+		double arenaBytes;
+		uint64_t memoryBefore;
+		uint64_t memoryAfter;
+	};
+
+	std::vector<SWEEP_RESULT> m_results;
+
+	// get the time of a frame that a count is compared by
+	static double GetFrameTime(const SWEEP_RESULT& result);
+};
@@ -0,0 +1,331 @@
+///////////////////////////////////////////////////////////////////////////////
+// dynamicresolution.cpp
+// ============
+// render at a lower resolution when the frames take longer than their budget
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DynamicResolution.h"
+#include "GLStateCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// smallest and largest fraction of the output size that a frame
+	// is drawn at
+	const float g_MinScale = 0.5f;
+	const float g_MaxScale = 1.0f;
+	// most that one change can shrink or grow the scale by
+	const float g_MaxStepDown = 0.8f;
+	const float g_MaxStepUp = 1.1f;
+	// fraction of the budget that a change aims for, which leaves
+	// room for frames that take a little longer than the average
+	const float g_TargetFraction = 0.9f;
+	// a frame time between this fraction of the budget and the budget
+	// is close enough, and keeps the scale as it is
+	const float g_HoldFraction = 0.8f;
+	// frames measured at a scale before it can change again, and how
+	// much each new frame moves the smoothed time
+	const int g_FramesPerChange = 8;
+	const float g_AverageWeight = 0.25f;
+	// smallest change of the scale that is made
+	const float g_MinScaleChange = 0.01f;
+}
+
+/***********************************************************
+ *  DynamicResolution()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DynamicResolution::DynamicResolution()
+{
+	m_outputFramebuffer = 0;
+	m_outputWidth = 0;
+	m_outputHeight = 0;
+	m_framebuffer = 0;
+	m_colorBuffer = 0;
+	m_depthBuffer = 0;
+	m_targetWidth = 0;
+	m_targetHeight = 0;
+	m_renderWidth = 0;
+	m_renderHeight = 0;
+	m_frameBudget = 0.0f;
+	m_scale = g_MaxScale;
+	m_averageTime = 0.0f;
+	m_measuredFrames = 0;
+	m_frameIndex = 0;
+
+	glGenQueries(TIMER_RING_SIZE * 2, m_timerQueries);
+	for (int i = 0; i < TIMER_RING_SIZE; i++)
+	{
+		m_timerCpuTimes[i] = 0.0f;
+		m_timerScales[i] = 0.0f;
+	}
+}
+
+/***********************************************************
+ *  ~DynamicResolution()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DynamicResolution::~DynamicResolution()
+{
+	DestroyTarget();
+	glDeleteQueries(TIMER_RING_SIZE * 2, m_timerQueries);
+}
+
+/***********************************************************
+ *  SetFrameBudget()
+ *
+ *  This method is used for setting the time that drawing each
+ *  frame should fit in.  The scale starts over at the full
+ *  output resolution.
+ ***********************************************************/
+void DynamicResolution::SetFrameBudget(float milliseconds)
+{
+	m_frameBudget = std::max(0.0f, milliseconds);
+	m_scale = g_MaxScale;
+	m_averageTime = 0.0f;
+	m_measuredFrames = 0;
+	for (int i = 0; i < TIMER_RING_SIZE; i++)
+	{
+		m_timerScales[i] = 0.0f;
+	}
+
+	if (m_frameBudget <= 0.0f)
+	{
+		DestroyTarget();
+	}
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for binding the framebuffer that the
+ *  next frame is drawn into.  The render target follows the
+ *  size of the output, and the frame is drawn into its lower
+ *  left part at the current scale, with the scissor keeping
+ *  the clear to that part.  The time of an earlier frame is
+ *  collected first, with its timestamps when they are ready.
+ ***********************************************************/
+void DynamicResolution::BeginFrame(int outputWidth, int outputHeight)
+{
+	m_outputWidth = std::max(1, outputWidth);
+	m_outputHeight = std::max(1, outputHeight);
+	m_renderWidth = m_outputWidth;
+	m_renderHeight = m_outputHeight;
+
+	if ((m_frameBudget > 0.0f) &&
+		((m_targetWidth != m_outputWidth) || (m_targetHeight != m_outputHeight)))
+	{
+		if (CreateTarget(m_outputWidth, m_outputHeight) == false)
+		{
+			std::cout << "Drawing at the output resolution without a scaled render target" << std::endl;
+			SetFrameBudget(0.0f);
+		}
+	}
+
+	if (m_frameBudget <= 0.0f)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_outputFramebuffer);
+		glViewport(0, 0, m_renderWidth, m_renderHeight);
+		return;
+	}
+
+	// the timestamps in this slot are from several frames ago, and are
+	// left out rather than waited on when they are still not ready
+	int slot = m_frameIndex % TIMER_RING_SIZE;
+	if (m_timerScales[slot] > 0.0f)
+	{
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(m_timerQueries[(slot * 2) + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		CollectTimer(slot, available == GL_TRUE);
+		m_timerScales[slot] = 0.0f;
+		UpdateScale();
+	}
+
+	m_renderWidth = std::max(1, (int)((m_outputWidth * m_scale) + 0.5f));
+	m_renderHeight = std::max(1, (int)((m_outputHeight * m_scale) + 0.5f));
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(0, 0, m_renderWidth, m_renderHeight);
+	GLStateCache::Current().Enable(GL_SCISSOR_TEST);
+	glScissor(0, 0, m_renderWidth, m_renderHeight);
+
+	glQueryCounter(m_timerQueries[slot * 2], GL_TIMESTAMP);
+	m_frameStart = std::chrono::steady_clock::now();
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for stretching the drawn part of the
+ *  render target over the whole output, filtered when it was
+ *  drawn smaller, and for binding the output again.
+ ***********************************************************/
+void DynamicResolution::EndFrame()
+{
+	if (m_frameBudget <= 0.0f)
+	{
+		return;
+	}
+
+	// the scissor also limits the pixels that a blit writes
+	GLStateCache::Current().Disable(GL_SCISSOR_TEST);
+
+	bool bScaled = (m_renderWidth != m_outputWidth) || (m_renderHeight != m_outputHeight);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_outputFramebuffer);
+	glBlitFramebuffer(0, 0, m_renderWidth, m_renderHeight,
+		0, 0, m_outputWidth, m_outputHeight,
+		GL_COLOR_BUFFER_BIT, bScaled ? GL_LINEAR : GL_NEAREST);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_outputFramebuffer);
+	glViewport(0, 0, m_outputWidth, m_outputHeight);
+
+	int slot = m_frameIndex % TIMER_RING_SIZE;
+	glQueryCounter(m_timerQueries[(slot * 2) + 1], GL_TIMESTAMP);
+	m_timerCpuTimes[slot] = std::chrono::duration<float, std::milli>(
+		std::chrono::steady_clock::now() - m_frameStart).count();
+	m_timerScales[slot] = m_scale;
+	m_frameIndex++;
+}
+
+/***********************************************************
+ *  CreateTarget()
+ *
+ *  This method is used for creating the render target with
+ *  color and depth attachments of the passed in size,
+ *  replacing the target of the last size.
+ ***********************************************************/
+bool DynamicResolution::CreateTarget(int width, int height)
+{
+	DestroyTarget();
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+
+	glGenRenderbuffers(1, &m_colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+
+	glGenRenderbuffers(1, &m_depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	bool bComplete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_outputFramebuffer);
+	if (bComplete == false)
+	{
+		std::cout << "Scaled render target is incomplete" << std::endl;
+		DestroyTarget();
+		return false;
+	}
+
+	m_targetWidth = width;
+	m_targetHeight = height;
+
+	return true;
+}
+
+/***********************************************************
+ *  DestroyTarget()
+ *
+ *  This method is used for deleting the render target.
+ ***********************************************************/
+void DynamicResolution::DestroyTarget()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteRenderbuffers(1, &m_colorBuffer);
+		glDeleteRenderbuffers(1, &m_depthBuffer);
+		m_framebuffer = 0;
+		m_colorBuffer = 0;
+		m_depthBuffer = 0;
+	}
+	m_targetWidth = 0;
+	m_targetHeight = 0;
+}
+
+/***********************************************************
+ *  CollectTimer()
+ *
+ *  This method is used for adding the time of a finished
+ *  frame to the smoothed time, when it was drawn at the
+ *  current scale.  Frames from before the last change of the
+ *  scale would only pull the time back to the old one.  The
+ *  time is the longer of the GPU and drawing thread times.
+ ***********************************************************/
+void DynamicResolution::CollectTimer(int slot, bool bGpuReady)
+{
+	if (m_timerScales[slot] != m_scale)
+	{
+		return;
+	}
+
+	float milliseconds = m_timerCpuTimes[slot];
+	if (bGpuReady == true)
+	{
+		GLuint64 gpuBegin = 0;
+		GLuint64 gpuEnd = 0;
+		glGetQueryObjectui64v(m_timerQueries[slot * 2], GL_QUERY_RESULT, &gpuBegin);
+		glGetQueryObjectui64v(m_timerQueries[(slot * 2) + 1], GL_QUERY_RESULT, &gpuEnd);
+		if (gpuEnd > gpuBegin)
+		{
+			milliseconds = std::max(milliseconds, (float)((gpuEnd - gpuBegin) / 1000000.0));
+		}
+	}
+
+	if (m_measuredFrames == 0)
+	{
+		m_averageTime = milliseconds;
+	}
+	else
+	{
+		m_averageTime += (milliseconds - m_averageTime) * g_AverageWeight;
+	}
+	m_measuredFrames++;
+}
+
+/***********************************************************
+ *  UpdateScale()
+ *
+ *  This method is used for changing the scale once enough
+ *  frames were measured at it, when the smoothed time is over
+ *  the budget, or far enough under it to draw more pixels.
+ *  The number of pixels, which a frame limited by filling
+ *  them takes time in proportion to, goes with the square of
+ *  the scale.
+ ***********************************************************/
+void DynamicResolution::UpdateScale()
+{
+	if ((m_measuredFrames < g_FramesPerChange) || (m_averageTime <= 0.0f))
+	{
+		return;
+	}
+
+	float budgetFraction = m_averageTime / m_frameBudget;
+	if ((budgetFraction >= g_HoldFraction) && (budgetFraction <= 1.0f))
+	{
+		return;
+	}
+
+	float step = std::sqrt(g_TargetFraction / budgetFraction);
+	step = std::min(g_MaxStepUp, std::max(g_MaxStepDown, step));
+	float scale = std::min(g_MaxScale, std::max(g_MinScale, m_scale * step));
+	if (std::fabs(scale - m_scale) < g_MinScaleChange)
+	{
+		return;
+	}
+
+	m_scale = scale;
+	m_measuredFrames = 0;
+}
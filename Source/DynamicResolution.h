@@ -0,0 +1,114 @@
+///////////////////////////////////////////////////////////////////////////////
+// dynamicresolution.h
+// ============
+// render at a lower resolution when the frames take longer than their budget
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+#include <chrono>
+
+/***********************************************************
+ *  DynamicResolution
+ *
+ *  This class contains the render target that the scene is
+ *  drawn into, and the controller that picks its
+ *  resolution.  With a frame budget set, the frame is drawn
+ *  into the lower left part of a framebuffer the size of
+ *  the output, scaled down on both axes, and stretched over
+ *  the output when it is done.  Each frame is measured from
+ *  the start of its drawing until it has been stretched, in
+ *  two ways.  The GPU time comes from timestamps that are
+ *  read back a few frames later, so the measuring never
+ *  waits on the GPU.  The time on the thread that draws the
+ *  frame is taken too, since software rasterizers do the
+ *  work there and their timestamps show none of it.  The
+ *  longer of the two is the time of the frame, and the wait
+ *  for the buffer swap is left out of both.  Since the time
+ *  of a frame that is limited by filling pixels follows the
+ *  number of pixels, the scale moves by the square root of
+ *  how far the measured time is from the budget, within
+ *  limits so it settles instead of swinging.  Only the
+ *  frames drawn at the current scale are counted after a
+ *  change.  Without a frame budget the frame is drawn
+ *  straight into the output.  The output size is passed in
+ *  each frame, so a resized window gets a render target of
+ *  its new size.
+ ***********************************************************/
+class DynamicResolution
+{
+public:
+	// constructor - needs a current OpenGL context
+	DynamicResolution();
+	// destructor
+	~DynamicResolution();
+
+	// set the milliseconds that a frame should take on the GPU, or
+	// zero to always draw at the output resolution
+	void SetFrameBudget(float milliseconds);
+	// set the framebuffer that the frames end up in, 0 for the window
+	void SetOutputFramebuffer(GLuint framebuffer) { m_outputFramebuffer = framebuffer; }
+
+	// bind the framebuffer and viewport that the next frame is drawn
+	// into, for an output of the passed in size
+	void BeginFrame(int outputWidth, int outputHeight);
+	// stretch the drawn frame over the output, and pick the scale of
+	// the next frames from the measured times
+	void EndFrame();
+
+	// get the fraction of the output size that frames are drawn at
+	float GetScale() const { return m_scale; }
+	// get the size that the current frame is drawn at
+	int GetRenderWidth() const { return m_renderWidth; }
+	int GetRenderHeight() const { return m_renderHeight; }
+	// get the smoothed time of the frames at the current scale
+	float GetAverageTime() const { return m_averageTime; }
+
+private:
+	// number of frames that the timestamps are read back after
+	static const int TIMER_RING_SIZE = 4;
+
+	// framebuffer that the frames are shown in, and its size
+	GLuint m_outputFramebuffer;
+	int m_outputWidth;
+	int m_outputHeight;
+	// scaled render target and its color and depth attachments, the
+	// size of the output
+	GLuint m_framebuffer;
+	GLuint m_colorBuffer;
+	GLuint m_depthBuffer;
+	int m_targetWidth;
+	int m_targetHeight;
+	// size that the current frame is drawn at
+	int m_renderWidth;
+	int m_renderHeight;
+
+	// time budget of a frame in milliseconds, zero when off
+	float m_frameBudget;
+	float m_scale;
+	// smoothed frame time at the current scale, and the number of
+	// frames measured at it so far
+	float m_averageTime;
+	int m_measuredFrames;
+	// start and end timestamps of the frames in flight, their time on
+	// the drawing thread, and the scale that each was drawn at, or zero
+	// for an unused slot
+	GLuint m_timerQueries[TIMER_RING_SIZE * 2];
+	float m_timerCpuTimes[TIMER_RING_SIZE];
+	float m_timerScales[TIMER_RING_SIZE];
+	int m_frameIndex;
+	// when the drawing of the current frame started
+	std::chrono::steady_clock::time_point m_frameStart;
+
+	// create the render target in the size of the output
+	bool CreateTarget(int width, int height);
+	// delete the render target
+	void DestroyTarget();
+	// add the time of a finished frame to the average, with its GPU
+	// time when the timestamps are ready
+	void CollectTimer(int slot, bool bGpuReady);
+	// move the scale toward the budget once enough frames are measured
+	void UpdateScale();
+};
@@ -0,0 +1,261 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.cpp
+// ============
+// report the watched files that were written since they were last checked
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FileWatcher.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <iostream>
+
+#if defined(__linux__)
+#include <climits>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// seconds between two polls of the file stamps, when there is no
+	// inotify to wait on
+	const float g_PollInterval = 0.25f;
+#if defined(__linux__)
+	// folder events that mean a file was written - a file closed after
+	// writing, or a new copy renamed over it
+	const uint32_t g_WatchEvents = IN_CLOSE_WRITE | IN_MOVED_TO;
+	// room for this many events with the longest file name per read
+	const size_t g_EventsPerRead = 16;
+#endif
+}
+
+/***********************************************************
+ *  FileWatcher()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FileWatcher::FileWatcher()
+{
+	m_notifyHandle = -1;
+	m_lastPoll = std::chrono::steady_clock::now();
+
+#if defined(__linux__)
+	m_notifyHandle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_notifyHandle < 0)
+	{
+		std::cout << "Could not start inotify, polling the watched files" << std::endl;
+	}
+	m_eventBuffer.resize(g_EventsPerRead * (sizeof(struct inotify_event) + NAME_MAX + 1));
+#endif
+}
+
+/***********************************************************
+ *  ~FileWatcher()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FileWatcher::~FileWatcher()
+{
+#if defined(__linux__)
+	// closing the instance removes all of its folder watches
+	if (m_notifyHandle >= 0)
+	{
+		close(m_notifyHandle);
+		m_notifyHandle = -1;
+	}
+#endif
+	m_files.clear();
+}
+
+/***********************************************************
+ *  AddFile()
+ *
+ *  This method is used for starting to watch a file.  With
+ *  inotify the folder of the file is watched, since editors
+ *  often save by replacing the file, which would end a watch
+ *  on the file itself.
+ ***********************************************************/
+int FileWatcher::AddFile(const std::string& filename)
+{
+	WATCHED_FILE file;
+	file.filename = filename;
+	file.folderWatch = -1;
+	file.size = 0;
+	file.modifiedTime = 0;
+	MappedFile::GetFileStamp(filename.c_str(), file.size, file.modifiedTime);
+
+	size_t separator = filename.find_last_of("/\\");
+	std::string folder = (separator == std::string::npos) ? "." : filename.substr(0, separator);
+	file.name = (separator == std::string::npos) ? filename : filename.substr(separator + 1);
+
+#if defined(__linux__)
+	if (m_notifyHandle >= 0)
+	{
+		// a folder that is already watched gives back its watch
+		file.folderWatch = inotify_add_watch(m_notifyHandle, folder.c_str(), g_WatchEvents);
+		if (file.folderWatch < 0)
+		{
+			std::cout << "Could not watch folder:" << folder << std::endl;
+			return(-1);
+		}
+	}
+#endif
+
+	m_files.push_back(file);
+	return((int)m_files.size() - 1);
+}
+
+/***********************************************************
+ *  CheckChanges()
+ *
+ *  This method is used for getting the files that were
+ *  written since the last check.  A file that was written
+ *  several times is only listed once.
+ ***********************************************************/
+int FileWatcher::CheckChanges(std::vector<int>& changed)
+{
+	changed.clear();
+
+	if (m_notifyHandle >= 0)
+	{
+		ReadEvents(changed);
+	}
+	else
+	{
+		PollStamps(changed);
+	}
+
+	return((int)changed.size());
+}
+
+/***********************************************************
+ *  ReadEvents()
+ *
+ *  This method is used for reading every pending inotify
+ *  event and listing the watched files that they name.  The
+ *  instance does not block, so the read stops as soon as no
+ *  more events are waiting.  The stamps of the listed files
+ *  are kept current, so that when the queue overflowed and
+ *  events were dropped, comparing the stamps of every file
+ *  finds the writes that were missed.
+ ***********************************************************/
+void FileWatcher::ReadEvents(std::vector<int>& changed)
+{
+#if defined(__linux__)
+	for (;;)
+	{
+		ssize_t length = read(m_notifyHandle, m_eventBuffer.data(), m_eventBuffer.size());
+		if (length <= 0)
+		{
+			break;
+		}
+
+		ssize_t offset = 0;
+		while (offset < length)
+		{
+			const struct inotify_event* event = (const struct inotify_event*)(m_eventBuffer.data() + offset);
+			offset += sizeof(struct inotify_event) + event->len;
+			if ((event->mask & IN_Q_OVERFLOW) != 0)
+			{
+				std::cout << "Missed file events, comparing every watched file" << std::endl;
+				CompareStamps(changed);
+				continue;
+			}
+			if ((event->len == 0) || ((event->mask & g_WatchEvents) == 0))
+			{
+				continue;
+			}
+
+			for (size_t i = 0; i < m_files.size(); i++)
+			{
+				if ((m_files[i].folderWatch == event->wd) && (m_files[i].name == event->name))
+				{
+					UpdateStamp(m_files[i]);
+					AddChanged(changed, (int)i);
+				}
+			}
+		}
+	}
+#endif
+}
+
+/***********************************************************
+ *  PollStamps()
+ *
+ *  This method is used for listing the watched files whose
+ *  size or modified time changed since they were last
+ *  polled, once the poll interval has passed.
+ ***********************************************************/
+void FileWatcher::PollStamps(std::vector<int>& changed)
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (std::chrono::duration<float>(now - m_lastPoll).count() < g_PollInterval)
+	{
+		return;
+	}
+	m_lastPoll = now;
+
+	CompareStamps(changed);
+}
+
+/***********************************************************
+ *  CompareStamps()
+ *
+ *  This method is used for listing every watched file whose
+ *  size or modified time changed since its stamp was last
+ *  taken.
+ ***********************************************************/
+void FileWatcher::CompareStamps(std::vector<int>& changed)
+{
+	for (size_t i = 0; i < m_files.size(); i++)
+	{
+		if (UpdateStamp(m_files[i]) == true)
+		{
+			AddChanged(changed, (int)i);
+		}
+	}
+}
+
+/***********************************************************
+ *  UpdateStamp()
+ *
+ *  This method is used for taking the current size and
+ *  modified time of a file, and checking whether either of
+ *  them changed.  A file that can't be found, such as while
+ *  it is being replaced, keeps its last stamp and is checked
+ *  again the next time.
+ ***********************************************************/
+bool FileWatcher::UpdateStamp(WATCHED_FILE& file)
+{
+	uint64_t size = 0;
+	uint64_t modifiedTime = 0;
+	if (MappedFile::GetFileStamp(file.filename.c_str(), size, modifiedTime) == false)
+	{
+		return(false);
+	}
+
+	if ((size == file.size) && (modifiedTime == file.modifiedTime))
+	{
+		return(false);
+	}
+
+	file.size = size;
+	file.modifiedTime = modifiedTime;
+	return(true);
+}
+
+/***********************************************************
+ *  AddChanged()
+ *
+ *  This method is used for adding a file handle to the list
+ *  of changed files, unless it is already listed.
+ ***********************************************************/
+void FileWatcher::AddChanged(std::vector<int>& changed, int handle)
+{
+	if (std::find(changed.begin(), changed.end(), handle) == changed.end())
+	{
+		changed.push_back(handle);
+	}
+}
@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.h
+// ============
+// report the watched files that were written since they were last checked
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  FileWatcher
+ *
+ *  This class contains the code for finding out which of a
+ *  list of files changed on disk.  On Linux the folders of
+ *  the files are watched through inotify, so checking costs
+ *  one read that returns right away when nothing changed,
+ *  and files that an editor replaces by renaming a new copy
+ *  over them are caught too.  When events were lost because
+ *  too many of them queued up, the size and modified time
+ *  of every file are compared instead.  On other platforms
+ *  those are always compared, at most a few times per
+ *  second.  Each watched file has a handle, which is the
+ *  order it was added in.
+ ***********************************************************/
+class FileWatcher
+{
+public:
+	// constructor
+	FileWatcher();
+	// destructor - stops watching every file
+	~FileWatcher();
+
+	// start watching a file, and return its handle, or -1 if its
+	// folder can't be watched
+	int AddFile(const std::string& filename);
+	// get the name of a watched file
+	const std::string& GetFilename(int handle) const { return m_files[handle].filename; }
+	// get the number of watched files
+	int GetFileCount() const { return (int)m_files.size(); }
+
+	// fill the list with the handles of the files that were written
+	// since the last check, each once, and return their count
+	int CheckChanges(std::vector<int>& changed);
+
+private:
+	struct WATCHED_FILE
+	{
+		std::string filename;
+		// name of the file inside of its folder, and the watch of the
+		// folder, for the inotify events
+		std::string name;
+		int folderWatch;
+		// size and modified time, for comparing when polling
+		uint64_t size;
+		uint64_t modifiedTime;
+	};
+
+	std::vector<WATCHED_FILE> m_files;
+	// inotify instance, or -1 when the files are polled
+	int m_notifyHandle;
+	// when the files were last polled
+	std::chrono::steady_clock::time_point m_lastPoll;
+	// events read from the inotify instance
+	std::vector<char> m_eventBuffer;
+
+	// read the pending inotify events
+	void ReadEvents(std::vector<int>& changed);
+	// compare the stamps of the files against the last ones, at
+	// most once per poll interval
+	void PollStamps(std::vector<int>& changed);
+	// compare the stamps of every file against the last ones
+	void CompareStamps(std::vector<int>& changed);
+	// take the current stamp of a file, and check whether it changed
+	static bool UpdateStamp(WATCHED_FILE& file);
+	// add a file to the list once
+	static void AddChanged(std::vector<int>& changed, int handle);
+};
@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////
+// framearena.cpp
+// ============
+// hand out the short-lived memory of a frame from one block that is reused
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+// declaration of global variables
+namespace
+{
+	// the block grows in steps of this many bytes, with a quarter more
+	// room than the largest frame so that small changes still fit
+	const size_t g_BlockGranularity = 64 * 1024;
+	const size_t g_GrowthDivisor = 4;
+
+	/***********************************************************
+	 *  AlignPointer()
+	 *
+	 *  Get the first address from the passed in one on that is
+	 *  a multiple of the alignment.
+	 ***********************************************************/
+	char* AlignPointer(char* pointer, size_t alignment)
+	{
+		uintptr_t address = reinterpret_cast<uintptr_t>(pointer);
+		uintptr_t aligned = (address + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+		return(pointer + (aligned - address));
+	}
+}
+
+/***********************************************************
+ *  FrameArena()
+ *
+ *  The constructor for the class - the block is allocated
+ *  by the first reset after a frame needed it.
+ ***********************************************************/
+FrameArena::FrameArena()
+{
+	m_used = 0;
+	m_stats.bytesUsed = 0;
+	m_stats.peakBytes = 0;
+	m_stats.capacity = 0;
+	m_stats.overflows = 0;
+	m_stats.blockAllocations = 0;
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for starting a new frame.  When the
+ *  last frame did not fit, its overflow is freed and the
+ *  block is replaced with one that holds all of it.
+ ***********************************************************/
+void FrameArena::Reset()
+{
+	if (m_stats.overflows > 0)
+	{
+		m_overflowBlocks.clear();
+
+		size_t capacity = m_stats.peakBytes + (m_stats.peakBytes / g_GrowthDivisor);
+		capacity = ((capacity + g_BlockGranularity - 1) / g_BlockGranularity) * g_BlockGranularity;
+		std::vector<char>(capacity).swap(m_block);
+		m_stats.capacity = capacity;
+		m_stats.blockAllocations++;
+	}
+
+	m_used = 0;
+	m_stats.bytesUsed = 0;
+	m_stats.overflows = 0;
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used for getting memory that stays valid
+ *  until the next reset.  It comes from the block when there
+ *  is room left, and from the heap when there is not.
+ ***********************************************************/
+void* FrameArena::Allocate(size_t bytes, size_t alignment)
+{
+	alignment = std::max(alignment, (size_t)1);
+
+	if (m_block.empty() == false)
+	{
+		char* start = m_block.data() + m_used;
+		char* aligned = AlignPointer(start, alignment);
+		size_t needed = (size_t)(aligned - start) + bytes;
+		if (needed <= m_block.size() - m_used)
+		{
+			m_used += needed;
+			m_stats.bytesUsed += needed;
+			m_stats.peakBytes = std::max(m_stats.peakBytes, m_stats.bytesUsed);
+			return(aligned);
+		}
+	}
+
+	// room for moving the start up to the alignment
+	size_t needed = bytes + alignment - 1;
+	m_overflowBlocks.push_back(std::vector<char>(std::max(needed, (size_t)1)));
+	m_stats.bytesUsed += needed;
+	m_stats.peakBytes = std::max(m_stats.peakBytes, m_stats.bytesUsed);
+	m_stats.overflows++;
+
+	return(AlignPointer(m_overflowBlocks.back().data(), alignment));
+}
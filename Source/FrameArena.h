@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+// framearena.h
+// ============
+// hand out the short-lived memory of a frame from one block that is reused
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+// memory use of a frame arena
+struct FRAME_ARENA_STATS
+{
+	// bytes handed out since the last reset, including the ones that
+	// did not fit in the block, and the most of any frame so far
+	size_t bytesUsed;
+	size_t peakBytes;
+	// size of the reused block
+	size_t capacity;
+	// allocations since the last reset that did not fit in the block
+	// and came from the heap
+	int overflows;
+	// times the block was allocated to grow it, since the arena was made
+	int blockAllocations;
+};
+
+/***********************************************************
+ *  FrameArena
+ *
+ *  This class hands out the memory that a frame only needs
+ *  until it is drawn, such as its draw packets, culling
+ *  results and draw commands, by moving a cursor through
+ *  one block.  Nothing is freed on its own - the whole block
+ *  is reused when the arena is reset for a later frame.  An
+ *  allocation that does not fit comes from the heap for that
+ *  frame, and the block is grown at the next reset to hold
+ *  everything the largest frame needed, so once the frames
+ *  stop growing no more heap memory is allocated.  Each frame
+ *  state has an arena of its own, so a frame can be updated
+ *  while the one before it is still being drawn from its own
+ *  memory.  Only types without a destructor can be put in it.
+ ***********************************************************/
+class FrameArena
+{
+public:
+	// constructor
+	FrameArena();
+
+	// start a new frame, freeing everything handed out before
+	void Reset();
+	// get memory for the passed in number of bytes, aligned to the
+	// passed in power of two
+	void* Allocate(size_t bytes, size_t alignment);
+	// get uninitialized memory for an array of values
+	template <typename T>
+	T* AllocateArray(int count)
+	{
+		static_assert(std::is_trivially_destructible<T>::value,
+			"the arena never runs destructors");
+		return static_cast<T*>(Allocate(sizeof(T) * (size_t)((count > 0) ? count : 0), alignof(T)));
+	}
+
+	// get the memory use of the frame so far
+	const FRAME_ARENA_STATS& GetStats() const { return m_stats; }
+
+private:
+	// reused block, and the bytes of it handed out in this frame
+	std::vector<char> m_block;
+	size_t m_used;
+	// allocations that did not fit, freed at the next reset
+	std::vector<std::vector<char> > m_overflowBlocks;
+	FRAME_ARENA_STATS m_stats;
+};
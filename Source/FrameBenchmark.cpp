@@ -0,0 +1,414 @@
+///////////////////////////////////////////////////////////////////////////////
+// framebenchmark.cpp
+// ============
+// measure per-frame CPU and GPU times and report their distribution
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameBenchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// upper edges of the histogram buckets in milliseconds, frames
+	// slower than the last edge are counted in one extra bucket
+	const double g_HistogramEdges[] = {
+		0.25, 0.5, 1.0, 2.0, 4.0, 8.0, 16.7, 33.3, 66.7, 100.0, 250.0 };
+	const int g_HistogramEdgeCount =
+		sizeof(g_HistogramEdges) / sizeof(g_HistogramEdges[0]);
+}
+
+/***********************************************************
+ *  FrameBenchmark()
+ *
+ *  The constructor for the class - needs a current OpenGL
+ *  context for creating the GPU timer queries.
+ ***********************************************************/
+FrameBenchmark::FrameBenchmark(int frameCount, int warmupFrames)
+{
+	m_frameCount = std::max(1, frameCount);
+	m_warmupFrames = std::max(0, warmupFrames);
+	m_frameIndex = 0;
+	m_cpuTimes.reserve(m_frameCount);
+	m_gpuTimes.reserve(m_frameCount);
+	m_intervalTimes.reserve(m_frameCount);
+
+	glGenQueries(QUERY_RING_SIZE, m_timerQueries);
+	for (int i = 0; i < QUERY_RING_SIZE; i++)
+	{
+		m_queryFrames[i] = -1;
+	}
+}
+
+/***********************************************************
+ *  ~FrameBenchmark()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameBenchmark::~FrameBenchmark()
+{
+	glDeleteQueries(QUERY_RING_SIZE, m_timerQueries);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting the CPU and GPU timers
+ *  for the next frame.  The GPU result for a frame is read
+ *  back QUERY_RING_SIZE frames later so it never stalls.
+ ***********************************************************/
+void FrameBenchmark::BeginFrame()
+{
+	int slot = m_frameIndex % QUERY_RING_SIZE;
+
+	// the query in this slot is from several frames ago
+	if (m_queryFrames[slot] >= 0)
+	{
+		CollectQuery(slot);
+	}
+
+	glBeginQuery(GL_TIME_ELAPSED, m_timerQueries[slot]);
+
+	// the interval ending at the first measured frame is still warmup
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (m_frameIndex > m_warmupFrames)
+	{
+		std::chrono::duration<double, std::milli> interval = now - m_frameStart;
+		m_intervalTimes.push_back(interval.count());
+	}
+	m_frameStart = now;
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for stopping the timers for the
+ *  current frame and flushing its commands to the GPU.
+ ***********************************************************/
+void FrameBenchmark::EndFrame()
+{
+	std::chrono::duration<double, std::milli> cpuTime =
+		std::chrono::steady_clock::now() - m_frameStart;
+	int slot = m_frameIndex % QUERY_RING_SIZE;
+
+	glEndQuery(GL_TIME_ELAPSED);
+	m_queryFrames[slot] = m_frameIndex;
+
+	// there is no buffer swap offscreen, so submit the frame here
+	glFlush();
+
+	if (m_frameIndex >= m_warmupFrames)
+	{
+		m_cpuTimes.push_back(cpuTime.count());
+	}
+	m_frameIndex++;
+}
+
+/***********************************************************
+ *  RecordCounter()
+ *
+ *  This method is used for adding a count for the frame that
+ *  is being drawn, such as the number of draws.  Counts from
+ *  the warmup frames are ignored, but the counter is added by
+ *  the first one, so the measured frames allocate nothing.
+ ***********************************************************/
+void FrameBenchmark::RecordCounter(const char* name, double value)
+{
+	COUNTER& counter = FindCounter(name);
+	counter.bMeasured = true;
+
+	if (m_frameIndex >= m_warmupFrames)
+	{
+		counter.total += value;
+		counter.frames++;
+	}
+}
+
+/***********************************************************
+ *  RecordMissingCounter()
+ *
+ *  This method is used for adding a count that this build
+ *  has no way of measuring, so that the results list it as
+ *  null instead of leaving it out.
+ ***********************************************************/
+void FrameBenchmark::RecordMissingCounter(const char* name)
+{
+	FindCounter(name);
+}
+
+/***********************************************************
+ *  FindCounter()
+ *
+ *  This method is used for finding a counter by name, and
+ *  for adding it, not measured yet, when there is none.
+ ***********************************************************/
+FrameBenchmark::COUNTER& FrameBenchmark::FindCounter(const char* name)
+{
+	for (size_t i = 0; i < m_counters.size(); i++)
+	{
+		if (m_counters[i].name == name)
+		{
+			return(m_counters[i]);
+		}
+	}
+
+	COUNTER counter;
+	counter.name = name;
+	counter.total = 0.0;
+	counter.frames = 0;
+	counter.bMeasured = false;
+	m_counters.push_back(counter);
+	return(m_counters.back());
+}
+
+/***********************************************************
+ *  GetCounterMean()
+ *
+ *  This method is used for getting the mean of a count over
+ *  the measured frames that it was recorded for.
+ ***********************************************************/
+double FrameBenchmark::GetCounterMean(const char* name) const
+{
+	for (size_t i = 0; i < m_counters.size(); i++)
+	{
+		if ((m_counters[i].name == name) && (m_counters[i].frames > 0))
+		{
+			return(m_counters[i].total / m_counters[i].frames);
+		}
+	}
+
+	return(0.0);
+}
+
+/***********************************************************
+ *  IsComplete()
+ *
+ *  This method is used for checking whether all of the
+ *  warmup and measured frames have been drawn.
+ ***********************************************************/
+bool FrameBenchmark::IsComplete() const
+{
+	return(m_frameIndex >= (m_warmupFrames + m_frameCount));
+}
+
+/***********************************************************
+ *  Finish()
+ *
+ *  This method is used for reading back the GPU timer
+ *  results that are still outstanding, oldest first.
+ ***********************************************************/
+void FrameBenchmark::Finish()
+{
+	for (int frame = m_frameIndex - QUERY_RING_SIZE; frame < m_frameIndex; frame++)
+	{
+		if (frame < 0)
+		{
+			continue;
+		}
+
+		int slot = frame % QUERY_RING_SIZE;
+		if (m_queryFrames[slot] == frame)
+		{
+			CollectQuery(slot);
+		}
+	}
+}
+
+/***********************************************************
+ *  CollectQuery()
+ *
+ *  This method is used for reading the elapsed GPU time
+ *  from the timer query in the passed in ring slot.
+ ***********************************************************/
+void FrameBenchmark::CollectQuery(int slot)
+{
+	GLuint64 elapsed = 0;
+
+	glGetQueryObjectui64v(m_timerQueries[slot], GL_QUERY_RESULT, &elapsed);
+	if (m_queryFrames[slot] >= m_warmupFrames)
+	{
+		m_gpuTimes.push_back(elapsed / 1000000.0);
+	}
+	m_queryFrames[slot] = -1;
+}
+
+/***********************************************************
+ *  CalculateStats()
+ *
+ *  This method is used for calculating the min, max, mean,
+ *  nearest-rank percentiles and histogram of frame times.
+ ***********************************************************/
+FrameBenchmark::TIMING_STATS FrameBenchmark::CalculateStats(std::vector<double> samples)
+{
+	TIMING_STATS stats;
+
+	stats.minimum = 0.0;
+	stats.maximum = 0.0;
+	stats.mean = 0.0;
+	stats.p50 = 0.0;
+	stats.p95 = 0.0;
+	stats.p99 = 0.0;
+	stats.histogram.assign(g_HistogramEdgeCount + 1, 0);
+
+	if (samples.empty())
+	{
+		return(stats);
+	}
+
+	std::sort(samples.begin(), samples.end());
+
+	double total = 0.0;
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		total += samples[i];
+
+		int bucket = 0;
+		while ((bucket < g_HistogramEdgeCount) && (samples[i] > g_HistogramEdges[bucket]))
+		{
+			bucket++;
+		}
+		stats.histogram[bucket]++;
+	}
+
+	// nearest-rank percentile of the sorted samples
+	const size_t count = samples.size();
+	auto percentile = [&samples, count](double p)
+	{
+		size_t rank = (size_t)std::ceil((p / 100.0) * count);
+		return samples[std::min(count, std::max((size_t)1, rank)) - 1];
+	};
+
+	stats.minimum = samples.front();
+	stats.maximum = samples.back();
+	stats.mean = total / count;
+	stats.p50 = percentile(50.0);
+	stats.p95 = percentile(95.0);
+	stats.p99 = percentile(99.0);
+
+	return(stats);
+}
+
+/***********************************************************
+ *  WriteStats()
+ *
+ *  This method is used for writing the statistics and the
+ *  raw samples for one timer as a JSON object.
+ ***********************************************************/
+void FrameBenchmark::WriteStats(std::ostream& output, const char* name,
+	const std::vector<double>& samples)
+{
+	TIMING_STATS stats = CalculateStats(samples);
+
+	output << "  \"" << name << "\": {\n";
+	output << "    \"samples\": " << samples.size() << ",\n";
+	output << "    \"minMs\": " << stats.minimum << ",\n";
+	output << "    \"maxMs\": " << stats.maximum << ",\n";
+	output << "    \"meanMs\": " << stats.mean << ",\n";
+	output << "    \"p50Ms\": " << stats.p50 << ",\n";
+	output << "    \"p95Ms\": " << stats.p95 << ",\n";
+	output << "    \"p99Ms\": " << stats.p99 << ",\n";
+
+	output << "    \"histogram\": [";
+	for (size_t i = 0; i < stats.histogram.size(); i++)
+	{
+		output << (i > 0 ? ", " : "") << stats.histogram[i];
+	}
+	output << "],\n";
+
+	output << "    \"frameTimesMs\": [";
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		output << (i > 0 ? ", " : "") << samples[i];
+	}
+	output << "]\n";
+	output << "  }";
+}
+
+/***********************************************************
+ *  WriteJsonString()
+ *
+ *  This method is used for writing the passed in text as a
+ *  quoted and escaped JSON string value.
+ ***********************************************************/
+void FrameBenchmark::WriteJsonString(std::ostream& output, const char* text)
+{
+	output << '"';
+	for (const char* c = text; (NULL != c) && (*c != '\0'); c++)
+	{
+		if ((*c == '"') || (*c == '\\'))
+			output << '\\' << *c;
+		else if ((unsigned char)*c < 0x20)
+			output << ' ';
+		else
+			output << *c;
+	}
+	output << '"';
+}
+
+/***********************************************************
+ *  WriteResults()
+ *
+ *  This method is used for writing the benchmark results to
+ *  the passed in file as JSON, so that runs can be compared
+ *  by scripts on the build boxes.
+ ***********************************************************/
+bool FrameBenchmark::WriteResults(const char* filename, const char* renderer) const
+{
+	std::ofstream output(filename);
+
+	if (!output.is_open())
+	{
+		std::cout << "Could not write benchmark results:" << filename << std::endl;
+		return false;
+	}
+
+	output.precision(4);
+	output << std::fixed;
+
+	output << "{\n";
+	output << "  \"renderer\": ";
+	WriteJsonString(output, renderer);
+	output << ",\n";
+	output << "  \"frames\": " << m_frameCount << ",\n";
+	output << "  \"warmupFrames\": " << m_warmupFrames << ",\n";
+
+	// the histogram has one more bucket than there are edges
+	output << "  \"histogramEdgesMs\": [";
+	for (int i = 0; i < g_HistogramEdgeCount; i++)
+	{
+		output << (i > 0 ? ", " : "") << g_HistogramEdges[i];
+	}
+	output << "],\n";
+
+	WriteStats(output, "cpu", m_cpuTimes);
+	output << ",\n";
+	WriteStats(output, "gpu", m_gpuTimes);
+	output << ",\n";
+	WriteStats(output, "interval", m_intervalTimes);
+	output << ",\n";
+
+	// mean of each counter per measured frame
+	output << "  \"counters\": {";
+	for (size_t i = 0; i < m_counters.size(); i++)
+	{
+		output << (i > 0 ? ",\n    " : "\n    ");
+		WriteJsonString(output, m_counters[i].name.c_str());
+		if (m_counters[i].bMeasured == true)
+		{
+			output << ": " << GetCounterMean(m_counters[i].name.c_str());
+		}
+		else
+		{
+			output << ": null";
+		}
+	}
+	output << "\n  }\n}\n";
+
+	std::cout << "INFO: Benchmark results written to " << filename << std::endl;
+
+	return output.good();
+}
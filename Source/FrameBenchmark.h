@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+// framebenchmark.h
+// ============
+// measure per-frame CPU and GPU times and report their distribution
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+#include <chrono>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  FrameBenchmark
+ *
+ *  This class contains the code for timing a fixed number of
+ *  rendered frames and writing the min/max and percentile
+ *  statistics for the CPU and GPU frame times, and for the
+ *  intervals between the frames, to a file.
+ ***********************************************************/
+class FrameBenchmark
+{
+public:
+	// constructor
+	FrameBenchmark(int frameCount, int warmupFrames);
+	// destructor
+	~FrameBenchmark();
+
+	struct TIMING_STATS
+	{
+		double minimum;
+		double maximum;
+		double mean;
+		double p50;
+		double p95;
+		double p99;
+		// frame counts per bucket of the histogram
+		std::vector<int> histogram;
+	};
+
+	// mark the start and end of the commands for one frame
+	void BeginFrame();
+	void EndFrame();
+	// add a count for the current frame, reported as a per-frame mean
+	void RecordCounter(const char* name, double value);
+	// add a count that this build can't measure, reported as null
+	void RecordMissingCounter(const char* name);
+	// true once all of the measured frames have been drawn
+	bool IsComplete() const;
+	// wait for the outstanding GPU timer results
+	void Finish();
+	// write the collected results as JSON to the passed in file
+	bool WriteResults(const char* filename, const char* renderer) const;
+	// write text as a quoted and escaped JSON string value
+	static void WriteJsonString(std::ostream& output, const char* text);
+
+	// statistics of the measured frames - the interval is the time from
+	// the start of one frame to the start of the next, which includes
+	// waiting on the update of the frame
+	TIMING_STATS GetCpuStats() const { return CalculateStats(m_cpuTimes); }
+	TIMING_STATS GetGpuStats() const { return CalculateStats(m_gpuTimes); }
+	TIMING_STATS GetIntervalStats() const { return CalculateStats(m_intervalTimes); }
+	// get the per-frame mean of a recorded count, or 0 if there is none
+	double GetCounterMean(const char* name) const;
+
+private:
+	// running total of a per-frame count
+	struct COUNTER
+	{
+		std::string name;
+		double total;
+		int frames;
+		// whether the count was measured at all
+		bool bMeasured;
+	};
+
+	// number of timer queries in flight before results are read
+	static const int QUERY_RING_SIZE = 4;
+
+	// number of frames to measure and to skip before measuring
+	int m_frameCount;
+	int m_warmupFrames;
+	// number of frames that have been started so far
+	int m_frameIndex;
+	// ring of GPU timer queries and the frame each one timed
+	GLuint m_timerQueries[QUERY_RING_SIZE];
+	int m_queryFrames[QUERY_RING_SIZE];
+	// CPU time when the current frame started
+	std::chrono::steady_clock::time_point m_frameStart;
+	// measured frame times in milliseconds
+	std::vector<double> m_cpuTimes;
+	std::vector<double> m_gpuTimes;
+	std::vector<double> m_intervalTimes;
+	// per-frame counts recorded by the renderer
+	std::vector<COUNTER> m_counters;
+
+	// read back the result of a finished timer query
+	void CollectQuery(int slot);
+	// find a counter by name, adding it when there is none
+	COUNTER& FindCounter(const char* name);
+	// calculate the statistics for a set of frame times
+	static TIMING_STATS CalculateStats(std::vector<double> samples);
+	// write one set of statistics as a JSON object
+	static void WriteStats(std::ostream& output, const char* name,
+		const std::vector<double>& samples);
+};
@@ -0,0 +1,195 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepipeline.cpp
+// ============
+// update the next frame while the last one is rendered on its own thread
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FramePipeline.h"
+
+#include <algorithm>
+#include <iostream>
+
+/***********************************************************
+ *  FramePipeline()
+ *
+ *  The constructor for the class - the frame states are used
+ *  in turn, so the index of a frame is its number modulo the
+ *  frame count.
+ ***********************************************************/
+FramePipeline::FramePipeline(int frameCount, RENDER_FUNCTION renderFrame,
+	CONTEXT_FUNCTION makeContextCurrent)
+{
+	m_frameCount = std::max(1, frameCount);
+	m_renderFrame = renderFrame;
+	m_makeContextCurrent = makeContextCurrent;
+	m_updatedFrames = 0;
+	m_renderedFrames = 0;
+	m_bStopping = false;
+	m_bFailed = false;
+}
+
+/***********************************************************
+ *  ~FramePipeline()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FramePipeline::~FramePipeline()
+{
+	Stop();
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for releasing the context on the
+ *  calling thread and starting the render thread, which makes
+ *  it current on its own.  Nothing is started for a single
+ *  frame state.
+ ***********************************************************/
+bool FramePipeline::Start()
+{
+	if ((IsThreaded() == false) || (m_renderThread.joinable()))
+	{
+		return(true);
+	}
+
+	if (m_makeContextCurrent(false) == false)
+	{
+		return(false);
+	}
+
+	m_updatedFrames = 0;
+	m_renderedFrames = 0;
+	m_bStopping = false;
+	m_bFailed = false;
+	m_renderThread = std::thread(&FramePipeline::RenderLoop, this);
+
+	return(true);
+}
+
+/***********************************************************
+ *  BeginUpdate()
+ *
+ *  This method is used for getting the frame state that the
+ *  next frame is updated into.  It waits while every state is
+ *  still queued or being rendered.
+ ***********************************************************/
+int FramePipeline::BeginUpdate()
+{
+	if (IsThreaded() == false)
+	{
+		return(0);
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_frameRendered.wait(lock, [this] {
+		return m_bFailed || ((m_updatedFrames - m_renderedFrames) < m_frameCount);
+	});
+
+	if (m_bFailed == true)
+	{
+		return(-1);
+	}
+
+	return(m_updatedFrames % m_frameCount);
+}
+
+/***********************************************************
+ *  EndUpdate()
+ *
+ *  This method is used for handing the updated frame state to
+ *  the render thread, or for rendering it right away when
+ *  there is a single frame state.
+ ***********************************************************/
+void FramePipeline::EndUpdate()
+{
+	if (IsThreaded() == false)
+	{
+		m_renderFrame(0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_updatedFrames++;
+	}
+	m_frameUpdated.notify_one();
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used for letting the render thread finish
+ *  the frames that are queued, and making the context current
+ *  on the calling thread again once it has exited.
+ ***********************************************************/
+bool FramePipeline::Stop()
+{
+	if (m_renderThread.joinable() == false)
+	{
+		return(m_bFailed == false);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+	}
+	m_frameUpdated.notify_one();
+	m_renderThread.join();
+
+	if (m_makeContextCurrent(true) == false)
+	{
+		m_bFailed = true;
+	}
+
+	return(m_bFailed == false);
+}
+
+/***********************************************************
+ *  RenderLoop()
+ *
+ *  This method is used by the render thread for rendering the
+ *  queued frame states in order.  The lock is not held while
+ *  rendering, so the next frame can be updated meanwhile.
+ ***********************************************************/
+void FramePipeline::RenderLoop()
+{
+	if (m_makeContextCurrent(true) == false)
+	{
+		std::cout << "Could not make the OpenGL context current on the render thread" << std::endl;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_bFailed = true;
+		}
+		m_frameRendered.notify_one();
+		return;
+	}
+
+	while (true)
+	{
+		int frame = 0;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_frameUpdated.wait(lock, [this] {
+				return m_bStopping || (m_renderedFrames < m_updatedFrames);
+			});
+
+			// the queued frames are still rendered after stopping
+			if (m_renderedFrames == m_updatedFrames)
+			{
+				break;
+			}
+			frame = m_renderedFrames % m_frameCount;
+		}
+
+		m_renderFrame(frame);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_renderedFrames++;
+		}
+		m_frameRendered.notify_one();
+	}
+
+	m_makeContextCurrent(false);
+}
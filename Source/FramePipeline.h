@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepipeline.h
+// ============
+// update the next frame while the last one is rendered on its own thread
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/***********************************************************
+ *  FramePipeline
+ *
+ *  This class contains the code for overlapping the update of
+ *  a frame with the rendering of the frames before it.  The
+ *  frames are updated into a ring of frame states on the
+ *  calling thread, and rendered from them in order on a render
+ *  thread that owns the OpenGL context.  With three states, one
+ *  frame is rendered while one waits and the next is updated,
+ *  so a slow frame on one side does not hold up the other.
+ *  The update only waits when every state is still in use.
+ *  With a single state nothing overlaps, and every frame is
+ *  rendered on the calling thread as soon as it is updated.
+ ***********************************************************/
+class FramePipeline
+{
+public:
+	// renders the frame state with the passed in index
+	typedef void (*RENDER_FUNCTION)(int frame);
+	// makes the OpenGL context current on the calling thread, or
+	// releases it, and returns false if that failed
+	typedef bool (*CONTEXT_FUNCTION)(bool bCurrent);
+
+	// constructor
+	FramePipeline(int frameCount, RENDER_FUNCTION renderFrame,
+		CONTEXT_FUNCTION makeContextCurrent);
+	// destructor
+	~FramePipeline();
+
+	// hand the context over to the render thread, if there is one
+	bool Start();
+	// wait for a frame state that is free to update, and get its
+	// index, or -1 once the render thread has stopped
+	int BeginUpdate();
+	// queue the updated frame state for rendering
+	void EndUpdate();
+	// render the queued frames, stop the render thread and take the
+	// context back, returns false if the render thread failed
+	bool Stop();
+
+	// get the number of frame states
+	int GetFrameCount() const { return m_frameCount; }
+	// check whether the frames are rendered on their own thread
+	bool IsThreaded() const { return m_frameCount > 1; }
+
+private:
+	int m_frameCount;
+	RENDER_FUNCTION m_renderFrame;
+	CONTEXT_FUNCTION m_makeContextCurrent;
+	std::thread m_renderThread;
+	// guards the frame counts and the flags
+	std::mutex m_mutex;
+	std::condition_variable m_frameUpdated;
+	std::condition_variable m_frameRendered;
+	// frames handed to the render thread, and frames it has rendered
+	int m_updatedFrames;
+	int m_renderedFrames;
+	bool m_bStopping;
+	bool m_bFailed;
+
+	// render the queued frames until the pipeline is stopped
+	void RenderLoop();
+};
@@ -0,0 +1,542 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameprofiler.cpp
+// ============
+// time named sections of each frame on the CPU and GPU
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameProfiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+// declaration of global variables
+namespace
+{
+	// name of the zone that covers the whole frame
+	const char* g_FrameZoneName = "frame";
+	// trace events kept at most, so a long session can't use up memory
+	const size_t g_MaxTraceEvents = 1 << 20;
+	// thread ids that the CPU and GPU zones are shown on in the trace
+	const int g_CpuTraceThread = 1;
+	const int g_GpuTraceThread = 2;
+	const int g_OtherTraceThread = 3;
+
+	/***********************************************************
+	 *  CopyDetail()
+	 *
+	 *  Copy a zone detail into a fixed size buffer, replacing
+	 *  the characters that would need escaping in JSON.
+	 ***********************************************************/
+	void CopyDetail(char* destination, size_t size, const char* detail)
+	{
+		size_t length = 0;
+
+		if (NULL != detail)
+		{
+			for (; (detail[length] != '\0') && (length + 1 < size); length++)
+			{
+				char c = detail[length];
+				bool bEscaped = (c == '"') || (c == '\\') || ((unsigned char)c < 0x20);
+				destination[length] = bEscaped ? ' ' : c;
+			}
+		}
+		destination[length] = '\0';
+	}
+}
+
+/***********************************************************
+ *  FrameProfiler()
+ *
+ *  The constructor for the class - needs a current OpenGL
+ *  context for lining up the GPU clock with the CPU clock.
+ ***********************************************************/
+FrameProfiler::FrameProfiler()
+{
+	m_frameIndex = 0;
+	m_bTracing = false;
+	m_summaryInterval = 0;
+	m_summaryFrames = 0;
+	m_droppedFrames = 0;
+	m_threadFrameIndex = 0;
+	m_bInFrame = false;
+	m_startTime = std::chrono::steady_clock::now();
+	m_frameThread = std::this_thread::get_id();
+
+	for (int i = 0; i < FRAME_RING_SIZE; i++)
+	{
+		m_frames[i].frameIndex = -1;
+	}
+
+	// the GPU timestamps are moved onto the CPU timeline in the trace
+	GLint64 gpuTime = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+	m_gpuClockOffset = GetCpuTime() - gpuTime;
+}
+
+/***********************************************************
+ *  ~FrameProfiler()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameProfiler::~FrameProfiler()
+{
+	for (int i = 0; i < FRAME_RING_SIZE; i++)
+	{
+		if (m_frames[i].queries.empty() == false)
+		{
+			glDeleteQueries((GLsizei)m_frames[i].queries.size(), m_frames[i].queries.data());
+		}
+	}
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting a frame and the zone that
+ *  covers it.  The frame that used the same ring slot several
+ *  frames ago is read back first, if the GPU has finished it.
+ ***********************************************************/
+void FrameProfiler::BeginFrame()
+{
+	PROFILE_FRAME& frame = m_frames[m_frameIndex % FRAME_RING_SIZE];
+
+	// the frames can be handed over to another thread along with the
+	// context, such as a render thread
+	m_frameThread = std::this_thread::get_id();
+
+	if (frame.frameIndex >= 0)
+	{
+		CollectFrame(frame, false);
+	}
+
+	frame.frameIndex = m_frameIndex;
+	frame.zones.clear();
+	m_openZones.clear();
+	m_bInFrame = true;
+
+	BeginZone(g_FrameZoneName);
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for ending any zones that are still
+ *  open along with the frame zone.
+ ***********************************************************/
+void FrameProfiler::EndFrame()
+{
+	while (m_openZones.empty() == false)
+	{
+		EndZone();
+	}
+
+	m_bInFrame = false;
+	m_frameIndex++;
+}
+
+/***********************************************************
+ *  BeginZone()
+ *
+ *  This method is used for starting a zone of the current
+ *  frame, inside of any zone that is still open.  The query
+ *  pool of the frame grows the first time it needs to.
+ ***********************************************************/
+void FrameProfiler::BeginZone(const char* name, const char* detail)
+{
+	if (IsOutsideFrame())
+	{
+		BeginThreadZone(name, detail);
+		return;
+	}
+
+	PROFILE_FRAME& frame = m_frames[m_frameIndex % FRAME_RING_SIZE];
+	PROFILE_ZONE zone;
+
+	zone.name = name;
+	CopyDetail(zone.detail, DETAIL_LENGTH, detail);
+	zone.depth = (int)m_openZones.size();
+	zone.cpuEnd = 0;
+
+	size_t queryCount = (frame.zones.size() + 1) * 2;
+	if (frame.queries.size() < queryCount)
+	{
+		size_t oldCount = frame.queries.size();
+		frame.queries.resize(std::max(queryCount, oldCount * 2));
+		glGenQueries((GLsizei)(frame.queries.size() - oldCount), &frame.queries[oldCount]);
+	}
+
+	m_openZones.push_back((int)frame.zones.size());
+	glQueryCounter(frame.queries[frame.zones.size() * 2], GL_TIMESTAMP);
+	zone.cpuBegin = GetCpuTime();
+	frame.zones.push_back(zone);
+}
+
+/***********************************************************
+ *  EndZone()
+ *
+ *  This method is used for ending the zone that was started
+ *  last and is still open.
+ ***********************************************************/
+void FrameProfiler::EndZone()
+{
+	if (IsOutsideFrame())
+	{
+		EndThreadZone();
+		return;
+	}
+
+	if (m_openZones.empty())
+	{
+		return;
+	}
+
+	PROFILE_FRAME& frame = m_frames[m_frameIndex % FRAME_RING_SIZE];
+	int index = m_openZones.back();
+	m_openZones.pop_back();
+
+	frame.zones[index].cpuEnd = GetCpuTime();
+	glQueryCounter(frame.queries[(index * 2) + 1], GL_TIMESTAMP);
+}
+
+/***********************************************************
+ *  IsOutsideFrame()
+ *
+ *  This method is used for checking whether the calling
+ *  thread is not inside of a frame.  The frame flag is only
+ *  looked at on the thread that runs the frames.
+ ***********************************************************/
+bool FrameProfiler::IsOutsideFrame() const
+{
+	return((std::this_thread::get_id() != m_frameThread.load()) || (m_bInFrame == false));
+}
+
+/***********************************************************
+ *  BeginThreadZone()
+ *
+ *  This method is used for starting a zone outside of the
+ *  frames, inside of any such zone that is still open.
+ ***********************************************************/
+void FrameProfiler::BeginThreadZone(const char* name, const char* detail)
+{
+	PROFILE_ZONE zone;
+
+	zone.name = name;
+	CopyDetail(zone.detail, DETAIL_LENGTH, detail);
+	zone.depth = (int)m_threadOpenZones.size();
+	zone.cpuEnd = 0;
+
+	m_threadOpenZones.push_back((int)m_threadZones.size());
+	zone.cpuBegin = GetCpuTime();
+	m_threadZones.push_back(zone);
+}
+
+/***********************************************************
+ *  EndThreadZone()
+ *
+ *  This method is used for ending the last started zone
+ *  outside of the frames.  Once the outermost one ends, all
+ *  of the zones inside of it are recorded.
+ ***********************************************************/
+void FrameProfiler::EndThreadZone()
+{
+	if (m_threadOpenZones.empty())
+	{
+		return;
+	}
+
+	int index = m_threadOpenZones.back();
+	m_threadOpenZones.pop_back();
+	m_threadZones[index].cpuEnd = GetCpuTime();
+
+	if (m_threadOpenZones.empty())
+	{
+		std::lock_guard<std::mutex> lock(m_recordMutex);
+		for (size_t z = 0; z < m_threadZones.size(); z++)
+		{
+			RecordZone(m_threadZones[z], m_threadFrameIndex, g_OtherTraceThread, 0, 0, false);
+		}
+		m_threadZones.clear();
+		m_threadFrameIndex++;
+	}
+}
+
+/***********************************************************
+ *  Finish()
+ *
+ *  This method is used for reading back the frames that are
+ *  still in flight, oldest first, waiting for the GPU.
+ ***********************************************************/
+void FrameProfiler::Finish()
+{
+	for (int frameIndex = m_frameIndex - FRAME_RING_SIZE; frameIndex < m_frameIndex; frameIndex++)
+	{
+		if (frameIndex < 0)
+		{
+			continue;
+		}
+
+		PROFILE_FRAME& frame = m_frames[frameIndex % FRAME_RING_SIZE];
+		if (frame.frameIndex == frameIndex)
+		{
+			CollectFrame(frame, true);
+		}
+	}
+
+	if (m_droppedFrames > 0)
+	{
+		std::cout << "INFO: GPU times of " << m_droppedFrames << " profiled frames were not ready in time" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  SetSummaryInterval()
+ *
+ *  This method is used for choosing how many frames the mean
+ *  zone times are printed for.
+ ***********************************************************/
+void FrameProfiler::SetSummaryInterval(int frames)
+{
+	m_summaryInterval = std::max(0, frames);
+	m_summaryFrames = 0;
+	m_summary.clear();
+}
+
+/***********************************************************
+ *  SetTracing()
+ *
+ *  This method is used for choosing whether the zones of the
+ *  frames are kept to be written as a trace.
+ ***********************************************************/
+void FrameProfiler::SetTracing(bool bTracing)
+{
+	m_bTracing = bTracing;
+}
+
+/***********************************************************
+ *  WriteTrace()
+ *
+ *  This method is used for writing the kept zones to the
+ *  passed in file in the Chrome trace event format, with the
+ *  CPU and GPU zones on two separate tracks.
+ ***********************************************************/
+bool FrameProfiler::WriteTrace(const char* filename) const
+{
+	std::ofstream output(filename);
+
+	if (!output.is_open())
+	{
+		std::cout << "Could not write profile trace:" << filename << std::endl;
+		return false;
+	}
+
+	output << std::fixed << std::setprecision(3);
+	output << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+	output << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << g_CpuTraceThread << ", \"args\": {\"name\": \"CPU\"}},\n";
+	output << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << g_GpuTraceThread << ", \"args\": {\"name\": \"GPU\"}},\n";
+	output << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << g_OtherTraceThread << ", \"args\": {\"name\": \"Update\"}}";
+
+	for (size_t i = 0; i < m_traceEvents.size(); i++)
+	{
+		const TRACE_EVENT& event = m_traceEvents[i];
+
+		output << ",\n{\"name\": \"" << event.name << "\"";
+		output << ", \"cat\": \"" << ((event.thread == g_GpuTraceThread) ? "gpu" : "cpu") << "\"";
+		output << ", \"ph\": \"X\", \"pid\": 1";
+		output << ", \"tid\": " << event.thread;
+		output << ", \"ts\": " << event.start << ", \"dur\": " << event.duration;
+		output << ", \"args\": {\"frame\": " << event.frameIndex;
+		if (event.detail[0] != '\0')
+		{
+			output << ", \"detail\": \"" << event.detail << "\"";
+		}
+		output << "}}";
+	}
+	output << "\n]}\n";
+
+	std::cout << "INFO: Profile trace written to " << filename << std::endl;
+
+	return output.good();
+}
+
+/***********************************************************
+ *  GetCpuTime()
+ *
+ *  This method is used for getting the time in nanoseconds
+ *  since the profiler was created.
+ ***********************************************************/
+int64_t FrameProfiler::GetCpuTime() const
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - m_startTime).count();
+}
+
+/***********************************************************
+ *  CollectFrame()
+ *
+ *  This method is used for reading the GPU timestamps of a
+ *  frame and recording all of its zones.  The queries finish
+ *  in order, so when the last one is ready all of them are.
+ *  When it is not ready and waiting was not asked for, the
+ *  zones are recorded with their CPU times only.
+ ***********************************************************/
+void FrameProfiler::CollectFrame(PROFILE_FRAME& frame, bool bWait)
+{
+	if (frame.zones.empty())
+	{
+		frame.frameIndex = -1;
+		return;
+	}
+
+	GLuint available = GL_TRUE;
+	if (bWait == false)
+	{
+		// the frame zone ends last, so its end query is the last one
+		glGetQueryObjectuiv(frame.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+	}
+	if (available == GL_FALSE)
+	{
+		m_droppedFrames++;
+	}
+
+	std::lock_guard<std::mutex> lock(m_recordMutex);
+	for (size_t z = 0; z < frame.zones.size(); z++)
+	{
+		GLuint64 gpuBegin = 0;
+		GLuint64 gpuEnd = 0;
+		if (available == GL_TRUE)
+		{
+			glGetQueryObjectui64v(frame.queries[z * 2], GL_QUERY_RESULT, &gpuBegin);
+			glGetQueryObjectui64v(frame.queries[(z * 2) + 1], GL_QUERY_RESULT, &gpuEnd);
+		}
+		RecordZone(frame.zones[z], frame.frameIndex, g_CpuTraceThread,
+			(int64_t)gpuBegin, (int64_t)gpuEnd, available == GL_TRUE);
+	}
+
+	frame.frameIndex = -1;
+	frame.zones.clear();
+
+	if (m_summaryInterval > 0)
+	{
+		m_summaryFrames++;
+		if (m_summaryFrames >= m_summaryInterval)
+		{
+			PrintSummary();
+		}
+	}
+}
+
+/***********************************************************
+ *  RecordZone()
+ *
+ *  This method is used for adding the CPU and GPU times of a
+ *  zone to the trace events and to the running summary.
+ ***********************************************************/
+void FrameProfiler::RecordZone(const PROFILE_ZONE& zone, int frameIndex, int cpuThread,
+	int64_t gpuBegin, int64_t gpuEnd, bool bGpuValid)
+{
+	double cpuMs = (zone.cpuEnd - zone.cpuBegin) / 1000000.0;
+	double gpuMs = bGpuValid ? ((gpuEnd - gpuBegin) / 1000000.0) : 0.0;
+
+	if (m_summaryInterval > 0)
+	{
+		ZONE_SUMMARY* summary = NULL;
+		for (size_t i = 0; (i < m_summary.size()) && (NULL == summary); i++)
+		{
+			if ((m_summary[i].name == zone.name) || (std::strcmp(m_summary[i].name, zone.name) == 0))
+			{
+				summary = &m_summary[i];
+			}
+		}
+		if (NULL == summary)
+		{
+			ZONE_SUMMARY added;
+			added.name = zone.name;
+			added.depth = zone.depth;
+			added.cpuTotal = 0.0;
+			added.gpuTotal = 0.0;
+			m_summary.push_back(added);
+			summary = &m_summary.back();
+		}
+		summary->cpuTotal += cpuMs;
+		summary->gpuTotal += gpuMs;
+	}
+
+	if ((m_bTracing == true) && ((m_traceEvents.size() + 2) <= g_MaxTraceEvents))
+	{
+		TRACE_EVENT event;
+		event.name = zone.name;
+		std::memcpy(event.detail, zone.detail, DETAIL_LENGTH);
+		event.frameIndex = frameIndex;
+		event.thread = cpuThread;
+		event.start = zone.cpuBegin / 1000.0;
+		event.duration = (zone.cpuEnd - zone.cpuBegin) / 1000.0;
+		m_traceEvents.push_back(event);
+
+		if (bGpuValid)
+		{
+			event.thread = g_GpuTraceThread;
+			event.start = (gpuBegin + m_gpuClockOffset) / 1000.0;
+			event.duration = (gpuEnd - gpuBegin) / 1000.0;
+			m_traceEvents.push_back(event);
+		}
+	}
+}
+
+/***********************************************************
+ *  PrintSummary()
+ *
+ *  This method is used for printing the mean CPU and GPU time
+ *  per frame of each zone name, in the order the zones were
+ *  first seen and indented by how deeply they are nested.
+ ***********************************************************/
+void FrameProfiler::PrintSummary()
+{
+	std::cout << "INFO: Mean zone times of the last " << m_summaryFrames
+		<< " frames in ms (cpu / gpu)" << std::endl;
+
+	std::ios_base::fmtflags flags = std::cout.flags();
+	std::cout << std::fixed << std::setprecision(3);
+	for (size_t i = 0; i < m_summary.size(); i++)
+	{
+		const ZONE_SUMMARY& summary = m_summary[i];
+		std::cout << "  " << std::string(summary.depth * 2, ' ')
+			<< std::left << std::setw(std::max(1, 24 - (summary.depth * 2))) << summary.name << std::right
+			<< std::setw(9) << (summary.cpuTotal / m_summaryFrames) << " / "
+			<< std::setw(9) << (summary.gpuTotal / m_summaryFrames) << std::endl;
+	}
+	std::cout.flags(flags);
+
+	m_summary.clear();
+	m_summaryFrames = 0;
+}
+
+/***********************************************************
+ *  ProfileZone()
+ *
+ *  The constructor for the class - starts the zone.
+ ***********************************************************/
+ProfileZone::ProfileZone(FrameProfiler* pProfiler, const char* name, const char* detail)
+{
+	m_pProfiler = pProfiler;
+	if (NULL != m_pProfiler)
+	{
+		m_pProfiler->BeginZone(name, detail);
+	}
+}
+
+/***********************************************************
+ *  ~ProfileZone()
+ *
+ *  The destructor for the class - ends the zone.
+ ***********************************************************/
+ProfileZone::~ProfileZone()
+{
+	if (NULL != m_pProfiler)
+	{
+		m_pProfiler->EndZone();
+	}
+}
@@ -0,0 +1,175 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameprofiler.h
+// ============
+// time named sections of each frame on the CPU and GPU
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  FrameProfiler
+ *
+ *  This class contains the code for timing named zones of a
+ *  frame, such as the view setup, each draw group and the
+ *  buffer swap.  Each zone is timed on the CPU with a steady
+ *  clock, and on the GPU with a pair of timestamp queries.
+ *  The queries of a frame are read back several frames later,
+ *  and only once the GPU has finished them, so the profiler
+ *  never waits on the GPU.  The zones can be written as a
+ *  Chrome trace (chrome://tracing or ui.perfetto.dev), and
+ *  a summary of the mean zone times is printed every few
+ *  frames.  Zones can nest, and every zone name has to stay
+ *  valid for the life of the profiler, such as a literal.
+ *  Zones can also be timed outside of a frame, or on one other
+ *  thread, such as the update of the next frame while this
+ *  one renders.  Those may have no OpenGL context, so they are
+ *  timed on the CPU only, on a track of their own, and each
+ *  outermost zone counts as one of their frames.
+ ***********************************************************/
+class FrameProfiler
+{
+public:
+	// constructor - needs a current OpenGL context
+	FrameProfiler();
+	// destructor
+	~FrameProfiler();
+
+	// mark the start and end of a frame, which is a zone of its own
+	void BeginFrame();
+	void EndFrame();
+	// start and end a zone of the current frame, with an optional
+	// detail that is copied, such as the material of a draw group -
+	// outside of a frame, or on another thread than the one running
+	// the frames, the zone is timed on the CPU only
+	void BeginZone(const char* name, const char* detail = NULL);
+	void EndZone();
+	// wait for the frames that are not read back yet
+	void Finish();
+
+	// print the mean zone times every passed in number of frames,
+	// or never when it is zero
+	void SetSummaryInterval(int frames);
+	// keep the zones of every frame for the Chrome trace
+	void SetTracing(bool bTracing);
+	// write the kept zones as Chrome trace event JSON
+	bool WriteTrace(const char* filename) const;
+
+private:
+	// number of frames in flight before their queries are read back
+	static const int FRAME_RING_SIZE = 4;
+	// longest zone detail that is kept, with the terminator
+	static const int DETAIL_LENGTH = 64;
+
+	// one timed zone - the GPU timestamps are the queries at
+	// twice the zone index and the one after it
+	struct PROFILE_ZONE
+	{
+		const char* name;
+		char detail[DETAIL_LENGTH];
+		int depth;
+		// nanoseconds since the profiler was created
+		int64_t cpuBegin;
+		int64_t cpuEnd;
+	};
+
+	// zones and timestamp queries of one frame in flight
+	struct PROFILE_FRAME
+	{
+		int frameIndex;
+		std::vector<PROFILE_ZONE> zones;
+		std::vector<GLuint> queries;
+	};
+
+	// a zone as it is written to the trace, in microseconds
+	struct TRACE_EVENT
+	{
+		const char* name;
+		char detail[DETAIL_LENGTH];
+		int frameIndex;
+		// trace thread id that the zone is shown on
+		int thread;
+		double start;
+		double duration;
+	};
+
+	// running total of the times of the zones with one name
+	struct ZONE_SUMMARY
+	{
+		const char* name;
+		int depth;
+		double cpuTotal;
+		double gpuTotal;
+	};
+
+	PROFILE_FRAME m_frames[FRAME_RING_SIZE];
+	// number of frames started so far
+	int m_frameIndex;
+	// zones of the current frame that are not ended yet
+	std::vector<int> m_openZones;
+	// CPU time that the zone times are measured from, and the
+	// difference from the GPU clock in nanoseconds
+	std::chrono::steady_clock::time_point m_startTime;
+	int64_t m_gpuClockOffset;
+	bool m_bTracing;
+	std::vector<TRACE_EVENT> m_traceEvents;
+	int m_summaryInterval;
+	int m_summaryFrames;
+	std::vector<ZONE_SUMMARY> m_summary;
+	// frames whose GPU times were not ready when their slot was reused
+	int m_droppedFrames;
+	// thread that begins and ends the frames, and has the context,
+	// and whether it is between the two
+	std::atomic<std::thread::id> m_frameThread;
+	bool m_bInFrame;
+	// zones outside of the frames that are open or not recorded
+	// yet, and the number of outermost ones that were recorded
+	std::vector<PROFILE_ZONE> m_threadZones;
+	std::vector<int> m_threadOpenZones;
+	int m_threadFrameIndex;
+	// guards the trace and the summary, which both threads record to
+	std::mutex m_recordMutex;
+
+	// get the CPU time in nanoseconds since the profiler was created
+	int64_t GetCpuTime() const;
+	// read back the times of a finished frame, waiting if asked to
+	void CollectFrame(PROFILE_FRAME& frame, bool bWait);
+	// check whether a zone is started or ended outside of a frame
+	bool IsOutsideFrame() const;
+	// start and end a zone outside of the frames
+	void BeginThreadZone(const char* name, const char* detail);
+	void EndThreadZone();
+	// add a zone time to the trace and the summary, with the trace
+	// thread that its CPU time is shown on
+	void RecordZone(const PROFILE_ZONE& zone, int frameIndex, int cpuThread,
+		int64_t gpuBegin, int64_t gpuEnd, bool bGpuValid);
+	// print the mean zone times and start a new summary
+	void PrintSummary();
+};
+
+/***********************************************************
+ *  ProfileZone
+ *
+ *  This class times the scope it is declared in as a zone of
+ *  the passed in profiler.  Nothing is timed when there is
+ *  no profiler.
+ ***********************************************************/
+class ProfileZone
+{
+public:
+	// constructor - starts the zone
+	ProfileZone(FrameProfiler* pProfiler, const char* name, const char* detail = NULL);
+	// destructor - ends the zone
+	~ProfileZone();
+
+private:
+	FrameProfiler* m_pProfiler;
+};
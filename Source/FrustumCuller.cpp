@@ -0,0 +1,376 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustumculler.cpp
+// ============
+// test the bounding spheres of the scene objects against the view frustum
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrustumCuller.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define FRUSTUM_CULL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// SSE2 is always there on x64, and on x86 unless /arch:IA32 is used, so
+// it is used whenever the compiler targets it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define FRUSTUM_CULL_SSE
+#endif
+
+// the AVX kernel is only built with the instructions that it uses, and
+// only run when the CPU has them, so the rest of the program still runs
+// on any CPU
+#if defined(FRUSTUM_CULL_X86) && defined(__GNUC__)
+#define FRUSTUM_TARGET_AVX __attribute__((target("avx")))
+#else
+#define FRUSTUM_TARGET_AVX
+#endif
+
+// declaration of global variables
+namespace
+{
+	// number of frustum planes
+	const int g_PlaneCount = 6;
+
+	// pointers to the component arrays of the spheres
+	struct SPHERE_ARRAYS
+	{
+		const float* centerX;
+		const float* centerY;
+		const float* centerZ;
+		const float* radius;
+	};
+
+#ifdef FRUSTUM_CULL_X86
+	/***********************************************************
+	 *  CullAvx()
+	 *
+	 *  Test the spheres 8 at a time with AVX, from the passed
+	 *  in index on, writing the indexes of the visible ones
+	 *  and moving the index past the spheres that were tested.
+	 *  Returns the number of visible spheres.
+	 ***********************************************************/
+	FRUSTUM_TARGET_AVX int CullAvx(const FRUSTUM_PLANES& planes, const SPHERE_ARRAYS& spheres,
+		int count, int& first, int* visible)
+	{
+		int visibleCount = 0;
+
+		__m256 planeA[g_PlaneCount];
+		__m256 planeB[g_PlaneCount];
+		__m256 planeC[g_PlaneCount];
+		__m256 planeD[g_PlaneCount];
+		for (int p = 0; p < g_PlaneCount; p++)
+		{
+			planeA[p] = _mm256_set1_ps(planes.a[p]);
+			planeB[p] = _mm256_set1_ps(planes.b[p]);
+			planeC[p] = _mm256_set1_ps(planes.c[p]);
+			planeD[p] = _mm256_set1_ps(planes.d[p]);
+		}
+
+		for (; (first + 8) <= count; first += 8)
+		{
+			__m256 x = _mm256_loadu_ps(spheres.centerX + first);
+			__m256 y = _mm256_loadu_ps(spheres.centerY + first);
+			__m256 z = _mm256_loadu_ps(spheres.centerZ + first);
+			__m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(spheres.radius + first));
+			__m256 outside = _mm256_setzero_ps();
+
+			for (int p = 0; p < g_PlaneCount; p++)
+			{
+				__m256 distance = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(planeA[p], x), _mm256_mul_ps(planeB[p], y)),
+					_mm256_add_ps(_mm256_mul_ps(planeC[p], z), planeD[p]));
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, negativeRadius, _CMP_LT_OQ));
+			}
+
+			int mask = ~_mm256_movemask_ps(outside) & 0xFF;
+			for (int lane = 0; mask != 0; lane++, mask >>= 1)
+			{
+				if (mask & 1)
+				{
+					visible[visibleCount++] = first + lane;
+				}
+			}
+		}
+
+		// leave the registers clean for SSE code that follows
+		_mm256_zeroupper();
+
+		return(visibleCount);
+	}
+
+	/***********************************************************
+	 *  IsAvxSupported()
+	 *
+	 *  Find out whether the CPU, and the operating system that
+	 *  saves its registers, support AVX.
+	 ***********************************************************/
+	bool IsAvxSupported()
+	{
+#ifdef _MSC_VER
+		int info[4] = { 0, 0, 0, 0 };
+		__cpuid(info, 1);
+		const bool bAvx = (info[2] & (1 << 28)) != 0;
+		const bool bOsSavesAvx = ((info[2] & (1 << 27)) != 0) && ((_xgetbv(0) & 0x6) == 0x6);
+
+		return(bAvx && bOsSavesAvx);
+#else
+		// the check of the compiler includes the operating system support
+		__builtin_cpu_init();
+		return(__builtin_cpu_supports("avx") != 0);
+#endif
+	}
+
+	// whether the spheres are tested with AVX, checked at startup
+	const bool g_bUseAvx = IsAvxSupported();
+#endif
+
+#ifdef FRUSTUM_CULL_SSE
+	/***********************************************************
+	 *  CullSse()
+	 *
+	 *  Test the spheres 4 at a time with SSE2, from the passed
+	 *  in index on, writing the indexes of the visible ones
+	 *  and moving the index past the spheres that were tested.
+	 *  Returns the number of visible spheres.
+	 ***********************************************************/
+	int CullSse(const FRUSTUM_PLANES& planes, const SPHERE_ARRAYS& spheres,
+		int count, int& first, int* visible)
+	{
+		int visibleCount = 0;
+
+		__m128 planeA[g_PlaneCount];
+		__m128 planeB[g_PlaneCount];
+		__m128 planeC[g_PlaneCount];
+		__m128 planeD[g_PlaneCount];
+		for (int p = 0; p < g_PlaneCount; p++)
+		{
+			planeA[p] = _mm_set1_ps(planes.a[p]);
+			planeB[p] = _mm_set1_ps(planes.b[p]);
+			planeC[p] = _mm_set1_ps(planes.c[p]);
+			planeD[p] = _mm_set1_ps(planes.d[p]);
+		}
+
+		for (; (first + 4) <= count; first += 4)
+		{
+			__m128 x = _mm_loadu_ps(spheres.centerX + first);
+			__m128 y = _mm_loadu_ps(spheres.centerY + first);
+			__m128 z = _mm_loadu_ps(spheres.centerZ + first);
+			__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(spheres.radius + first));
+			__m128 outside = _mm_setzero_ps();
+
+			for (int p = 0; p < g_PlaneCount; p++)
+			{
+				__m128 distance = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(planeA[p], x), _mm_mul_ps(planeB[p], y)),
+					_mm_add_ps(_mm_mul_ps(planeC[p], z), planeD[p]));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+			}
+
+			int mask = ~_mm_movemask_ps(outside) & 0xF;
+			for (int lane = 0; mask != 0; lane++, mask >>= 1)
+			{
+				if (mask & 1)
+				{
+					visible[visibleCount++] = first + lane;
+				}
+			}
+		}
+
+		return(visibleCount);
+	}
+#endif
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for setting the number of spheres.
+ *  The memory is kept when the count gets smaller.
+ ***********************************************************/
+void FrustumCuller::Resize(int count)
+{
+	m_centerX.resize(count, 0.0f);
+	m_centerY.resize(count, 0.0f);
+	m_centerZ.resize(count, 0.0f);
+	m_radius.resize(count, 0.0f);
+}
+
+/***********************************************************
+ *  SetSphere()
+ *
+ *  This method is used for placing a sphere in world space
+ *  from a sphere in object space and the world transform of
+ *  the object.  The radius grows with the largest scale, so
+ *  the sphere still holds the object when it is scaled
+ *  unevenly.
+ ***********************************************************/
+void FrustumCuller::SetSphere(int index, const glm::mat4& transform, const glm::vec4& localSphere)
+{
+	glm::vec4 center = transform * glm::vec4(localSphere.x, localSphere.y, localSphere.z, 1.0f);
+
+	// the length of each of the first three columns is the scale
+	// along that axis
+	float scaleSquared = 0.0f;
+	for (int column = 0; column < 3; column++)
+	{
+		const glm::vec4& axis = transform[column];
+		scaleSquared = std::max(scaleSquared, (axis.x * axis.x) + (axis.y * axis.y) + (axis.z * axis.z));
+	}
+	float scale = std::sqrt(scaleSquared);
+
+	m_centerX[index] = center.x;
+	m_centerY[index] = center.y;
+	m_centerZ[index] = center.z;
+	m_radius[index] = localSphere.w * scale;
+}
+
+/***********************************************************
+ *  GetSphere()
+ *
+ *  This method is used for getting a sphere in world space.
+ ***********************************************************/
+glm::vec4 FrustumCuller::GetSphere(int index) const
+{
+	return(glm::vec4(m_centerX[index], m_centerY[index], m_centerZ[index], m_radius[index]));
+}
+
+/***********************************************************
+ *  ExtractPlanes()
+ *
+ *  This method is used for getting the six planes of the
+ *  view frustum from the rows of the combined view and
+ *  projection matrix.  The planes are normalized, so that
+ *  the plane equation gives the distance to the plane.
+ ***********************************************************/
+FRUSTUM_PLANES FrustumCuller::ExtractPlanes(const glm::mat4& viewProjection)
+{
+	FRUSTUM_PLANES planes;
+
+	for (int i = 0; i < g_PlaneCount; i++)
+	{
+		// left and right use the first row, bottom and top the
+		// second, and near and far the third
+		int row = i / 2;
+		float sign = ((i % 2) == 0) ? 1.0f : -1.0f;
+
+		float a = viewProjection[0][3] + (sign * viewProjection[0][row]);
+		float b = viewProjection[1][3] + (sign * viewProjection[1][row]);
+		float c = viewProjection[2][3] + (sign * viewProjection[2][row]);
+		float d = viewProjection[3][3] + (sign * viewProjection[3][row]);
+		float length = std::sqrt((a * a) + (b * b) + (c * c));
+		if (length > 0.0f)
+		{
+			a /= length;
+			b /= length;
+			c /= length;
+			d /= length;
+		}
+
+		planes.a[i] = a;
+		planes.b[i] = b;
+		planes.c[i] = c;
+		planes.d[i] = d;
+	}
+
+	return(planes);
+}
+
+/***********************************************************
+ *  Cull()
+ *
+ *  This method is used for finding the spheres that are not
+ *  completely behind any of the frustum planes.  The spheres
+ *  are tested 8 at a time when the CPU has AVX, then 4 at a
+ *  time with SSE2, and the ones left over at the end are
+ *  tested one at a time.
+ ***********************************************************/
+int FrustumCuller::Cull(const FRUSTUM_PLANES& planes, int* visible) const
+{
+	const int count = GetCount();
+	int visibleCount = 0;
+	int first = 0;
+
+	// room for every sphere, so no check is needed while writing
+	int* output = visible;
+
+	if (count > 0)
+	{
+		SPHERE_ARRAYS spheres;
+		spheres.centerX = m_centerX.data();
+		spheres.centerY = m_centerY.data();
+		spheres.centerZ = m_centerZ.data();
+		spheres.radius = m_radius.data();
+
+#ifdef FRUSTUM_CULL_X86
+		if (g_bUseAvx == true)
+		{
+			visibleCount += CullAvx(planes, spheres, count, first, output + visibleCount);
+		}
+#endif
+#ifdef FRUSTUM_CULL_SSE
+		visibleCount += CullSse(planes, spheres, count, first, output + visibleCount);
+#endif
+	}
+
+	visibleCount += CullScalar(planes, first, output + visibleCount);
+
+	return(visibleCount);
+}
+
+/***********************************************************
+ *  CullScalar()
+ *
+ *  This method is used for testing the spheres from the
+ *  passed in index to the end one at a time, and writing the
+ *  indexes of the visible ones.  It returns their count.
+ ***********************************************************/
+int FrustumCuller::CullScalar(const FRUSTUM_PLANES& planes, int first, int* visible) const
+{
+	int visibleCount = 0;
+
+	for (int i = first; i < GetCount(); i++)
+	{
+		bool bOutside = false;
+		for (int p = 0; (p < g_PlaneCount) && (bOutside == false); p++)
+		{
+			float distance = (planes.a[p] * m_centerX[i]) + (planes.b[p] * m_centerY[i]) +
+				(planes.c[p] * m_centerZ[i]) + planes.d[p];
+			bOutside = distance < -m_radius[i];
+		}
+
+		if (bOutside == false)
+		{
+			visible[visibleCount++] = i;
+		}
+	}
+
+	return(visibleCount);
+}
+
+/***********************************************************
+ *  GetInstructionSet()
+ *
+ *  This method is used for getting the name of the widest
+ *  instruction set that the spheres are tested with.
+ ***********************************************************/
+const char* FrustumCuller::GetInstructionSet()
+{
+#ifdef FRUSTUM_CULL_X86
+	if (g_bUseAvx == true)
+	{
+		return("avx");
+	}
+#endif
+#ifdef FRUSTUM_CULL_SSE
+	return("sse2");
+#else
+	return("scalar");
+#endif
+}
@@ -0,0 +1,66 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustumculler.h
+// ============
+// test the bounding spheres of the scene objects against the view frustum
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// the six planes of a view frustum, one plane per column and each
+// plane facing inward - a point is inside a plane when
+// a * x + b * y + c * z + d is not negative
+struct FRUSTUM_PLANES
+{
+	float a[6];
+	float b[6];
+	float c[6];
+	float d[6];
+};
+
+/***********************************************************
+ *  FrustumCuller
+ *
+ *  This class contains the world space bounding spheres of
+ *  the drawable objects, stored as one array per component,
+ *  and the code for finding the spheres that are inside the
+ *  view frustum.  The spheres are tested 8 at a time with
+ *  AVX when the CPU has it, 4 at a time with SSE2 when the
+ *  compiler targets it, and one at a time otherwise.
+ ***********************************************************/
+class FrustumCuller
+{
+public:
+	// set the number of spheres, keeping the allocated memory
+	void Resize(int count);
+	// get the number of spheres
+	int GetCount() const { return (int)m_radius.size(); }
+	// place a sphere by transforming a sphere in object space, with
+	// the center in xyz and the radius in w
+	void SetSphere(int index, const glm::mat4& transform, const glm::vec4& localSphere);
+	// get a sphere, with the center in xyz and the radius in w
+	glm::vec4 GetSphere(int index) const;
+
+	// get the planes of the frustum of a view and projection matrix
+	static FRUSTUM_PLANES ExtractPlanes(const glm::mat4& viewProjection);
+	// write the indexes of the spheres that are at least partly inside
+	// of the frustum, in order, and return their count - there has to
+	// be room for the index of every sphere
+	int Cull(const FRUSTUM_PLANES& planes, int* visible) const;
+
+	// name of the instruction set that the spheres are tested with
+	static const char* GetInstructionSet();
+
+private:
+	// sphere centers and radii
+	std::vector<float> m_centerX;
+	std::vector<float> m_centerY;
+	std::vector<float> m_centerZ;
+	std::vector<float> m_radius;
+
+	// test the spheres from the passed in index on, one at a time
+	int CullScalar(const FRUSTUM_PLANES& planes, int first, int* visible) const;
+};
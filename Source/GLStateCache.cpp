@@ -0,0 +1,318 @@
+///////////////////////////////////////////////////////////////////////////////
+// glstatecache.cpp
+// ============
+// shadow the OpenGL state so that calls which change nothing are skipped
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GLStateCache.h"
+
+#include <cstddef>
+
+/***********************************************************
+ *  Current()
+ *
+ *  This method is used for getting the state cache of the
+ *  OpenGL context.
+ ***********************************************************/
+GLStateCache& GLStateCache::Current()
+{
+	static GLStateCache cache;
+
+	return(cache);
+}
+
+/***********************************************************
+ *  GLStateCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GLStateCache::GLStateCache()
+{
+	Invalidate();
+	ResetStats();
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for comparing a call with the value it
+ *  would set, counting it, and remembering the new value.
+ ***********************************************************/
+template <typename T>
+bool GLStateCache::Update(SHADOW_VALUE<T>& shadow, const T& value)
+{
+	if ((shadow.bKnown == true) && (shadow.value == value))
+	{
+		m_stats.stateCallsSkipped++;
+		return(false);
+	}
+
+	shadow.value = value;
+	shadow.bKnown = true;
+	m_stats.stateCalls++;
+	return(true);
+}
+
+/***********************************************************
+ *  SetEnabled()
+ *
+ *  This method is used for turning a capability on or off.
+ *  Capabilities that are not shadowed are always set.
+ ***********************************************************/
+void GLStateCache::SetEnabled(GLenum capability, bool bEnabled)
+{
+	int index = GetCapabilityIndex(capability);
+
+	if ((index >= 0) && (Update(m_enabled[index], bEnabled) == false))
+	{
+		return;
+	}
+
+	if (bEnabled)
+		glEnable(capability);
+	else
+		glDisable(capability);
+}
+
+/***********************************************************
+ *  BlendFunc()
+ *
+ *  This method is used for setting the blend factors.
+ ***********************************************************/
+void GLStateCache::BlendFunc(GLenum source, GLenum destination)
+{
+	// the two factors are set by one call, so they are known together
+	if ((m_blendSource.bKnown == true) && (m_blendSource.value == source) &&
+		(m_blendDestination.value == destination))
+	{
+		m_stats.stateCallsSkipped++;
+		return;
+	}
+
+	m_blendSource.value = source;
+	m_blendSource.bKnown = true;
+	m_blendDestination.value = destination;
+	m_blendDestination.bKnown = true;
+	m_stats.stateCalls++;
+	glBlendFunc(source, destination);
+}
+
+/***********************************************************
+ *  CullFace()
+ *
+ *  This method is used for setting the faces that are culled.
+ ***********************************************************/
+void GLStateCache::CullFace(GLenum mode)
+{
+	if (Update(m_cullFace, mode))
+	{
+		glCullFace(mode);
+	}
+}
+
+/***********************************************************
+ *  DepthFunc()
+ *
+ *  This method is used for setting the depth comparison.
+ ***********************************************************/
+void GLStateCache::DepthFunc(GLenum function)
+{
+	if (Update(m_depthFunction, function))
+	{
+		glDepthFunc(function);
+	}
+}
+
+/***********************************************************
+ *  DepthMask()
+ *
+ *  This method is used for turning depth writes on or off.
+ ***********************************************************/
+void GLStateCache::DepthMask(bool bWrite)
+{
+	if (Update(m_depthMask, bWrite))
+	{
+		glDepthMask(bWrite ? GL_TRUE : GL_FALSE);
+	}
+}
+
+/***********************************************************
+ *  ClearColor()
+ *
+ *  This method is used for setting the color that the color
+ *  buffer is cleared to.
+ ***********************************************************/
+void GLStateCache::ClearColor(const glm::vec4& color)
+{
+	if (Update(m_clearColor, color))
+	{
+		glClearColor(color.x, color.y, color.z, color.w);
+	}
+}
+
+/***********************************************************
+ *  ActiveTexture()
+ *
+ *  This method is used for making a texture unit the one
+ *  that textures are bound to and specified on.
+ ***********************************************************/
+void GLStateCache::ActiveTexture(int unit)
+{
+	if (Update(m_activeUnit, unit))
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+}
+
+/***********************************************************
+ *  BindTexture()
+ *
+ *  This method is used for binding a texture to a unit.  The
+ *  unit is only made active when the binding changes, so code
+ *  that specifies the texture makes it active on its own.
+ ***********************************************************/
+void GLStateCache::BindTexture(int unit, GLenum target, GLuint texture)
+{
+	if ((size_t)unit >= m_textureUnits.size())
+	{
+		TEXTURE_BINDING unknown;
+		unknown.target = GL_NONE;
+		unknown.texture = 0;
+		m_textureUnits.resize(unit + 1, unknown);
+	}
+
+	TEXTURE_BINDING& binding = m_textureUnits[unit];
+	if ((binding.target == target) && (binding.texture == texture))
+	{
+		m_stats.stateCallsSkipped++;
+		return;
+	}
+
+	ActiveTexture(unit);
+	glBindTexture(target, texture);
+	binding.target = target;
+	binding.texture = texture;
+	m_stats.stateCalls++;
+}
+
+/***********************************************************
+ *  ForgetTexture()
+ *
+ *  This method is used for clearing a texture that is about
+ *  to be deleted from the units it is bound to, so that a
+ *  texture created later with the same name still gets bound.
+ ***********************************************************/
+void GLStateCache::ForgetTexture(GLuint texture)
+{
+	for (size_t i = 0; i < m_textureUnits.size(); i++)
+	{
+		if (m_textureUnits[i].texture == texture)
+		{
+			m_textureUnits[i].target = GL_NONE;
+			m_textureUnits[i].texture = 0;
+		}
+	}
+}
+
+/***********************************************************
+ *  BindVertexArray()
+ *
+ *  This method is used for binding a vertex array.
+ ***********************************************************/
+void GLStateCache::BindVertexArray(GLuint vertexArray)
+{
+	if (Update(m_vertexArray, vertexArray))
+	{
+		glBindVertexArray(vertexArray);
+	}
+}
+
+/***********************************************************
+ *  ForgetVertexArray()
+ *
+ *  This method is used for clearing a vertex array that is
+ *  about to be deleted, if it is the one that is bound.
+ ***********************************************************/
+void GLStateCache::ForgetVertexArray(GLuint vertexArray)
+{
+	if ((m_vertexArray.bKnown == true) && (m_vertexArray.value == vertexArray))
+	{
+		m_vertexArray.bKnown = false;
+	}
+}
+
+/***********************************************************
+ *  CountUniform()
+ *
+ *  This method is used for counting a uniform value that was
+ *  sent to the shader, or skipped.
+ ***********************************************************/
+void GLStateCache::CountUniform(bool bSent)
+{
+	if (bSent)
+		m_stats.uniformCalls++;
+	else
+		m_stats.uniformCallsSkipped++;
+}
+
+/***********************************************************
+ *  ResetStats()
+ *
+ *  This method is used for starting the counts over.
+ ***********************************************************/
+void GLStateCache::ResetStats()
+{
+	m_stats.stateCalls = 0;
+	m_stats.stateCallsSkipped = 0;
+	m_stats.uniformCalls = 0;
+	m_stats.uniformCallsSkipped = 0;
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for forgetting all of the shadowed
+ *  state, such as after code that does not go through the
+ *  cache has changed it.
+ ***********************************************************/
+void GLStateCache::Invalidate()
+{
+	for (int i = 0; i < CAPABILITY_COUNT; i++)
+	{
+		m_enabled[i].bKnown = false;
+	}
+	m_blendSource.bKnown = false;
+	m_blendDestination.bKnown = false;
+	m_cullFace.bKnown = false;
+	m_depthFunction.bKnown = false;
+	m_depthMask.bKnown = false;
+	m_clearColor.bKnown = false;
+	m_activeUnit.bKnown = false;
+	m_vertexArray.bKnown = false;
+	m_textureUnits.clear();
+}
+
+/***********************************************************
+ *  GetCapabilityIndex()
+ *
+ *  This method is used for getting the slot that the state of
+ *  a capability is shadowed in.
+ ***********************************************************/
+int GLStateCache::GetCapabilityIndex(GLenum capability)
+{
+	switch (capability)
+	{
+	case GL_DEPTH_TEST:
+		return(CAPABILITY_DEPTH_TEST);
+	case GL_BLEND:
+		return(CAPABILITY_BLEND);
+	case GL_CULL_FACE:
+		return(CAPABILITY_CULL_FACE);
+	case GL_SCISSOR_TEST:
+		return(CAPABILITY_SCISSOR_TEST);
+	case GL_STENCIL_TEST:
+		return(CAPABILITY_STENCIL_TEST);
+	default:
+		return(-1);
+	}
+}
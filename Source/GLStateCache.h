@@ -0,0 +1,128 @@
+///////////////////////////////////////////////////////////////////////////////
+// glstatecache.h
+// ============
+// shadow the OpenGL state so that calls which change nothing are skipped
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// counts of the calls that went through the state cache
+struct GL_STATE_STATS
+{
+	// state calls that were sent to OpenGL, and that were skipped
+	// because the state was already set
+	int stateCalls;
+	int stateCallsSkipped;
+	// uniform values that were sent to the shader, and that were
+	// skipped because the uniform already held the value
+	int uniformCalls;
+	int uniformCallsSkipped;
+};
+
+/***********************************************************
+ *  GLStateCache
+ *
+ *  This class keeps a copy of the OpenGL state that the scene
+ *  changes while drawing: the enable bits, the blend, cull and
+ *  depth settings, the clear color, the active texture unit
+ *  with the texture bound to each unit, and the vertex array.
+ *  A call that would set the value that is already set is not
+ *  sent to the driver.  Every value starts out unknown, so the
+ *  first call always goes through, and state that was changed
+ *  without the cache has to be forgotten with Invalidate().
+ *  There is one cache for the single OpenGL context, and it is
+ *  only used on the thread that has the context current.  The
+ *  uniform values are shadowed by ShaderUniforms, which counts
+ *  them here so that all of the counts are in one place.
+ ***********************************************************/
+class GLStateCache
+{
+public:
+	// get the cache of the OpenGL context
+	static GLStateCache& Current();
+
+	// turn a capability such as GL_DEPTH_TEST on or off
+	void SetEnabled(GLenum capability, bool bEnabled);
+	void Enable(GLenum capability) { SetEnabled(capability, true); }
+	void Disable(GLenum capability) { SetEnabled(capability, false); }
+
+	// set the fixed function settings
+	void BlendFunc(GLenum source, GLenum destination);
+	void CullFace(GLenum mode);
+	void DepthFunc(GLenum function);
+	void DepthMask(bool bWrite);
+	void ClearColor(const glm::vec4& color);
+
+	// make a texture unit active, and bind a texture to a unit
+	void ActiveTexture(int unit);
+	void BindTexture(int unit, GLenum target, GLuint texture);
+	// clear a deleted texture from the units that it was bound to
+	void ForgetTexture(GLuint texture);
+	// bind a vertex array, and clear one that is deleted
+	void BindVertexArray(GLuint vertexArray);
+	void ForgetVertexArray(GLuint vertexArray);
+
+	// count a uniform value that was sent or skipped
+	void CountUniform(bool bSent);
+	// get the counts since they were last reset, and reset them,
+	// such as once per frame
+	const GL_STATE_STATS& GetStats() const { return m_stats; }
+	void ResetStats();
+	// forget all of the shadowed state, so every call goes through
+	void Invalidate();
+
+private:
+	// constructor - every value starts out unknown
+	GLStateCache();
+
+	// capabilities that are shadowed, others always go through
+	enum CAPABILITY
+	{
+		CAPABILITY_DEPTH_TEST = 0,
+		CAPABILITY_BLEND,
+		CAPABILITY_CULL_FACE,
+		CAPABILITY_SCISSOR_TEST,
+		CAPABILITY_STENCIL_TEST,
+		CAPABILITY_COUNT
+	};
+
+	// a shadowed value and whether it is known
+	template <typename T>
+	struct SHADOW_VALUE
+	{
+		T value;
+		bool bKnown;
+	};
+
+	// texture that was last bound to a unit, and its target
+	struct TEXTURE_BINDING
+	{
+		GLenum target;
+		GLuint texture;
+	};
+
+	SHADOW_VALUE<bool> m_enabled[CAPABILITY_COUNT];
+	SHADOW_VALUE<GLenum> m_blendSource;
+	SHADOW_VALUE<GLenum> m_blendDestination;
+	SHADOW_VALUE<GLenum> m_cullFace;
+	SHADOW_VALUE<GLenum> m_depthFunction;
+	SHADOW_VALUE<bool> m_depthMask;
+	SHADOW_VALUE<glm::vec4> m_clearColor;
+	SHADOW_VALUE<int> m_activeUnit;
+	SHADOW_VALUE<GLuint> m_vertexArray;
+	// bound textures by unit, a target of GL_NONE is unknown
+	std::vector<TEXTURE_BINDING> m_textureUnits;
+	GL_STATE_STATS m_stats;
+
+	// get the slot of a capability, or -1 if it is not shadowed
+	static int GetCapabilityIndex(GLenum capability);
+	// check a shadowed value, and remember the new one if it differs -
+	// returns true when the call has to be sent
+	template <typename T>
+	bool Update(SHADOW_VALUE<T>& shadow, const T& value);
+};
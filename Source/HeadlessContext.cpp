@@ -0,0 +1,286 @@
+///////////////////////////////////////////////////////////////////////////////
+// headlesscontext.cpp
+// ============
+// create an OpenGL context and offscreen framebuffer without a display
+//
+//  On Linux the context is created through EGL so that it can run on
+//  machines that have no GPU and no display server, such as Mesa
+//  llvmpipe on the build boxes.  Set LIBGL_ALWAYS_SOFTWARE=1 to force
+//  llvmpipe.  Other platforms use the context of a hidden GLFW window,
+//  which is never shown or drawn to.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "HeadlessContext.h"
+
+#include <iostream>
+
+#if defined(__linux__)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#else
+#include "GLFW/glfw3.h"     // GLFW library
+#endif
+
+/***********************************************************
+ *  HeadlessContext()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+HeadlessContext::HeadlessContext()
+{
+	m_display = NULL;
+	m_context = NULL;
+	m_framebuffer = 0;
+	m_colorBuffer = 0;
+	m_depthBuffer = 0;
+}
+
+/***********************************************************
+ *  ~HeadlessContext()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+HeadlessContext::~HeadlessContext()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  CreateContext()
+ *
+ *  This method is used for creating an OpenGL core profile
+ *  context through EGL without any window surface, or with a
+ *  hidden GLFW window where there is no EGL, and then making
+ *  it the current context for this thread.
+ ***********************************************************/
+bool HeadlessContext::CreateContext()
+{
+#if defined(__linux__)
+	EGLDisplay display = EGL_NO_DISPLAY;
+
+	// prefer the surfaceless platform, which needs no display server
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (NULL != getPlatformDisplay)
+	{
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	}
+	if (EGL_NO_DISPLAY == display)
+	{
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint major = 0;
+	EGLint minor = 0;
+	if ((EGL_NO_DISPLAY == display) || (EGL_TRUE != eglInitialize(display, &major, &minor)))
+	{
+		std::cout << "Failed to initialize EGL display" << std::endl;
+		return false;
+	}
+
+	if (EGL_TRUE != eglBindAPI(EGL_OPENGL_API))
+	{
+		std::cout << "EGL display does not support desktop OpenGL" << std::endl;
+		eglTerminate(display);
+		return false;
+	}
+
+	// the default surface type is a window, which a surfaceless
+	// display has no configs for
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig config = NULL;
+	EGLint numConfigs = 0;
+	if ((EGL_TRUE != eglChooseConfig(display, configAttributes, &config, 1, &numConfigs)) ||
+		(numConfigs < 1))
+	{
+		std::cout << "Failed to find an EGL config for OpenGL" << std::endl;
+		eglTerminate(display);
+		return false;
+	}
+
+	// try the same version as the display window first, then fall
+	// back to the oldest versions that have everything the shaders use
+	const EGLint versions[][2] = { { 4, 6 }, { 4, 5 }, { 4, 4 } };
+	EGLContext context = EGL_NO_CONTEXT;
+	for (int i = 0; (i < 3) && (EGL_NO_CONTEXT == context); i++)
+	{
+		const EGLint contextAttributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION, versions[i][0],
+			EGL_CONTEXT_MINOR_VERSION, versions[i][1],
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+	}
+
+	if (EGL_NO_CONTEXT == context)
+	{
+		std::cout << "Failed to create EGL OpenGL context" << std::endl;
+		eglTerminate(display);
+		return false;
+	}
+
+	// no surface is needed since all rendering goes to the framebuffer
+	if (EGL_TRUE != eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+	{
+		std::cout << "Failed to make EGL context current" << std::endl;
+		eglDestroyContext(display, context);
+		eglTerminate(display);
+		return false;
+	}
+
+	m_display = display;
+	m_context = context;
+
+	std::cout << "INFO: EGL " << major << "." << minor << " headless context created" << std::endl;
+
+	return true;
+#else
+	if (GLFW_TRUE != glfwInit())
+	{
+		std::cout << "Failed to initialize GLFW" << std::endl;
+		return false;
+	}
+
+	// the window is only there for its context, so it is never shown
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+	const int versions[][2] = { { 4, 6 }, { 4, 5 }, { 4, 4 } };
+	GLFWwindow* window = NULL;
+	for (int i = 0; (i < 3) && (NULL == window); i++)
+	{
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, versions[i][0]);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, versions[i][1]);
+		window = glfwCreateWindow(1, 1, "Headless", NULL, NULL);
+	}
+	glfwDefaultWindowHints();
+
+	if (NULL == window)
+	{
+		std::cout << "Failed to create a hidden GLFW window with OpenGL 4.4 or newer" << std::endl;
+		glfwTerminate();
+		return false;
+	}
+
+	glfwMakeContextCurrent(window);
+	m_context = window;
+
+	std::cout << "INFO: Hidden window headless context created" << std::endl;
+
+	return true;
+#endif
+}
+
+/***********************************************************
+ *  CreateFramebuffer()
+ *
+ *  This method is used for creating the offscreen framebuffer
+ *  with color and depth attachments of the passed in size.
+ ***********************************************************/
+bool HeadlessContext::CreateFramebuffer(int width, int height)
+{
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+
+	glGenRenderbuffers(1, &m_colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+
+	glGenRenderbuffers(1, &m_depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Offscreen framebuffer is incomplete" << std::endl;
+		return false;
+	}
+
+	glViewport(0, 0, width, height);
+
+	return true;
+}
+
+/***********************************************************
+ *  BindFramebuffer()
+ *
+ *  This method is used for making the offscreen framebuffer
+ *  the target of all following draw commands.
+ ***********************************************************/
+void HeadlessContext::BindFramebuffer()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+}
+
+/***********************************************************
+ *  MakeCurrent()
+ *
+ *  This method is used for moving the context between
+ *  threads.  A context can only be current on one thread at
+ *  a time, so it is released on the old thread first.
+ ***********************************************************/
+bool HeadlessContext::MakeCurrent(bool bCurrent)
+{
+	if (NULL == m_context)
+	{
+		return false;
+	}
+
+#if defined(__linux__)
+	EGLContext context = bCurrent ? (EGLContext)m_context : EGL_NO_CONTEXT;
+	if (EGL_TRUE != eglMakeCurrent((EGLDisplay)m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+	{
+		std::cout << "Failed to make EGL context current" << std::endl;
+		return false;
+	}
+#else
+	glfwMakeContextCurrent(bCurrent ? (GLFWwindow*)m_context : NULL);
+#endif
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the offscreen framebuffer
+ *  and releasing the EGL context, or the hidden window.
+ ***********************************************************/
+void HeadlessContext::Destroy()
+{
+	if (NULL == m_context)
+	{
+		return;
+	}
+
+	if (0 != m_framebuffer)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteRenderbuffers(1, &m_colorBuffer);
+		glDeleteRenderbuffers(1, &m_depthBuffer);
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+		m_colorBuffer = 0;
+		m_depthBuffer = 0;
+	}
+
+#if defined(__linux__)
+	eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(m_display, m_context);
+	eglTerminate(m_display);
+#else
+	glfwDestroyWindow((GLFWwindow*)m_context);
+	glfwTerminate();
+#endif
+	m_context = NULL;
+	m_display = NULL;
+}
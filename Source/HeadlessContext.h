@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////
+// headlesscontext.h
+// ============
+// create an OpenGL context and offscreen framebuffer without a display
+//
+//  On Linux the context is created through EGL so that it can run on
+//  machines that have no GPU and no display server, such as Mesa
+//  llvmpipe on the build boxes.  Set LIBGL_ALWAYS_SOFTWARE=1 to force
+//  llvmpipe.  Other platforms use the context of a hidden GLFW window,
+//  which is never shown or drawn to.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+/***********************************************************
+ *  HeadlessContext
+ *
+ *  This class contains the code for creating an OpenGL
+ *  context that does not draw to any window, along with the
+ *  offscreen framebuffer that the scene is rendered into.
+ ***********************************************************/
+class HeadlessContext
+{
+public:
+	// constructor
+	HeadlessContext();
+	// destructor
+	~HeadlessContext();
+
+	// create the offscreen OpenGL context and make it current
+	bool CreateContext();
+	// create the offscreen framebuffer - needs GLEW initialized
+	bool CreateFramebuffer(int width, int height);
+	// bind the offscreen framebuffer as the render target
+	void BindFramebuffer();
+	// get the offscreen framebuffer
+	GLuint GetFramebuffer() const { return m_framebuffer; }
+	// make the context current on the calling thread, or release it
+	// so that another thread can make it current
+	bool MakeCurrent(bool bCurrent);
+	// free the framebuffer and the OpenGL context
+	void Destroy();
+
+private:
+	// EGL display and context handles, or no display and the hidden
+	// GLFW window that owns the context
+	void* m_display;
+	void* m_context;
+	// offscreen framebuffer and its color and depth attachments
+	GLuint m_framebuffer;
+	GLuint m_colorBuffer;
+	GLuint m_depthBuffer;
+};
@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////////////////////////
+// heapcounter.cpp
+// ============
+// count the heap allocations of the program, to find the ones made per frame
+///////////////////////////////////////////////////////////////////////////////
+
+#include "HeapCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef COUNT_HEAP_ALLOCATIONS
+// declaration of global variables
+namespace
+{
+	// constant initialized, so they are ready before the constructors
+	// of any other global that allocates
+	std::atomic<uint64_t> g_Allocations(0);
+	std::atomic<uint64_t> g_AllocatedBytes(0);
+
+	/***********************************************************
+	 *  CountedAllocate()
+	 *
+	 *  Count an allocation and get its memory from malloc, or
+	 *  NULL if there is none left.
+	 ***********************************************************/
+	void* CountedAllocate(size_t size)
+	{
+		g_Allocations.fetch_add(1, std::memory_order_relaxed);
+		g_AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+		// every allocation has to be unique, even an empty one
+		return(std::malloc((size > 0) ? size : 1));
+	}
+}
+
+/***********************************************************
+ *  IsCounting()
+ *
+ *  This method is used for checking whether the allocations
+ *  are counted.
+ ***********************************************************/
+bool HeapCounter::IsCounting()
+{
+	return(true);
+}
+
+/***********************************************************
+ *  GetAllocations() / GetAllocatedBytes()
+ *
+ *  These methods get the running totals of the allocations
+ *  made through new.
+ ***********************************************************/
+uint64_t HeapCounter::GetAllocations()
+{
+	return(g_Allocations.load(std::memory_order_relaxed));
+}
+
+uint64_t HeapCounter::GetAllocatedBytes()
+{
+	return(g_AllocatedBytes.load(std::memory_order_relaxed));
+}
+
+/***********************************************************
+ *  operator new / operator delete
+ *
+ *  The replacements of the global allocation functions, in
+ *  their plain, array, nothrow and sized delete forms.  The
+ *  aligned forms only exist from C++17 on, which this
+ *  project is not built as, so they are not replaced.
+ ***********************************************************/
+void* operator new(size_t size)
+{
+	void* memory = CountedAllocate(size);
+	if (NULL == memory)
+	{
+		throw std::bad_alloc();
+	}
+	return(memory);
+}
+
+void* operator new[](size_t size)
+{
+	return(operator new(size));
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return(CountedAllocate(size));
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return(CountedAllocate(size));
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	std::free(memory);
+}
+#else
+/***********************************************************
+ *  IsCounting() / GetAllocations() / GetAllocatedBytes()
+ *
+ *  Without COUNT_HEAP_ALLOCATIONS the allocation functions
+ *  are left alone, and nothing is counted.
+ ***********************************************************/
+bool HeapCounter::IsCounting()
+{
+	return(false);
+}
+
+uint64_t HeapCounter::GetAllocations()
+{
+	return(0);
+}
+
+uint64_t HeapCounter::GetAllocatedBytes()
+{
+	return(0);
+}
+#endif
@@ -0,0 +1,38 @@
+///////////////////////////////////////////////////////////////////////////////
+// heapcounter.h
+// ============
+// count the heap allocations of the program, to find the ones made per frame
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+
+/***********************************************************
+ *  HeapCounter
+ *
+ *  This class reports how many times, and how many bytes,
+ *  the program has allocated with new since it started, on
+ *  any thread.  When the program is built with
+ *  COUNT_HEAP_ALLOCATIONS defined, as the Profile
+ *  configuration does, the global new and delete operators
+ *  are replaced by ones that count before going to malloc,
+ *  so the containers of the standard library are counted
+ *  too.  Memory that the drivers and C libraries get with
+ *  malloc directly is not.  Comparing the counts at the end
+ *  of two frames gives the allocations made in between,
+ *  which should be zero once the scene has been drawn a few
+ *  times.  Without the define nothing is counted, and the
+ *  counts stay at zero.
+ ***********************************************************/
+class HeapCounter
+{
+public:
+	// check whether the program was built to count its allocations
+	static bool IsCounting();
+	// get the number of allocations since the program started
+	static uint64_t GetAllocations();
+	// get the number of bytes allocated since the program started,
+	// without taking away the ones freed since
+	static uint64_t GetAllocatedBytes();
+};
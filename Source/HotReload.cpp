@@ -0,0 +1,223 @@
+///////////////////////////////////////////////////////////////////////////////
+// hotreload.cpp
+// ============
+// apply the shaders, textures and materials that changed on disk while running
+///////////////////////////////////////////////////////////////////////////////
+
+#include "HotReload.h"
+#include "ShaderUniforms.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+/***********************************************************
+ *  HotReload()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+HotReload::HotReload(ShaderManager* pShaderManager, SceneManager* pSceneManager,
+	ViewManager* pViewManager)
+{
+	m_pShaderManager = pShaderManager;
+	m_pSceneManager = pSceneManager;
+	m_pViewManager = pViewManager;
+	m_vertexShaderFile = -1;
+	m_fragmentShaderFile = -1;
+	m_sceneFile = -1;
+}
+
+/***********************************************************
+ *  WatchShaders()
+ *
+ *  This method is used for watching the vertex and fragment
+ *  shader files that the program in use was linked from.
+ ***********************************************************/
+void HotReload::WatchShaders(const char* vertexFilename, const char* fragmentFilename)
+{
+	m_vertexShaderFile = m_watcher.AddFile(vertexFilename);
+	m_fragmentShaderFile = m_watcher.AddFile(fragmentFilename);
+}
+
+/***********************************************************
+ *  WatchScene()
+ *
+ *  This method is used for watching the text file that the
+ *  scene was prepared from, and the image file of every
+ *  texture that it uses.  A scene loaded straight from its
+ *  cooked file has no text to watch.
+ ***********************************************************/
+void HotReload::WatchScene(const char* sceneFilename)
+{
+	if (SceneFile::IsCookedFile(sceneFilename) == false)
+	{
+		m_sceneFile = m_watcher.AddFile(sceneFilename);
+	}
+
+	const SceneFile& sceneFile = m_pSceneManager->GetSceneFile();
+	for (int i = 0; i < sceneFile.GetTextureCount(); i++)
+	{
+		m_watcher.AddFile(sceneFile.GetTexturePath(i));
+	}
+}
+
+/***********************************************************
+ *  ApplyChanges()
+ *
+ *  This method is used for applying the watched files that
+ *  were written since the last call.  Both shaders are linked
+ *  once, even when both of them changed.
+ ***********************************************************/
+int HotReload::ApplyChanges()
+{
+	bool bShadersChanged = false;
+
+	int changed = m_watcher.CheckChanges(m_changedFiles);
+	for (int i = 0; i < changed; i++)
+	{
+		const int file = m_changedFiles[i];
+		const std::string& filename = m_watcher.GetFilename(file);
+
+		if ((file == m_vertexShaderFile) || (file == m_fragmentShaderFile))
+		{
+			bShadersChanged = true;
+		}
+		else if (file == m_sceneFile)
+		{
+			int materials = m_pSceneManager->ReloadMaterials(filename.c_str());
+			std::cout << "Reloaded scene:" << filename << ", materials changed:" << materials << std::endl;
+		}
+		else if (m_pSceneManager->ReloadTextureFile(filename) > 0)
+		{
+			std::cout << "Reloading texture:" << filename << std::endl;
+		}
+	}
+
+	if (bShadersChanged == true)
+	{
+		ReloadShaders();
+	}
+
+	return(changed);
+}
+
+/***********************************************************
+ *  ReloadShaders()
+ *
+ *  This method is used for linking the changed shader files
+ *  into a new program and handing it to the shader manager
+ *  in place of the old one, which is deleted along with its
+ *  cached uniforms.  The shaders are only compiled and linked
+ *  once, and when they have mistakes the old program is kept.
+ *  The uniforms of the new program are looked up again.
+ ***********************************************************/
+bool HotReload::ReloadShaders()
+{
+	if ((m_vertexShaderFile < 0) || (m_fragmentShaderFile < 0))
+	{
+		return(false);
+	}
+
+	GLuint program = LinkShaders();
+	if (program == 0)
+	{
+		std::cout << "Keeping the shaders in use until the errors are fixed" << std::endl;
+		return(false);
+	}
+
+	GLuint previousProgram = m_pShaderManager->m_programID;
+	m_pShaderManager->m_programID = program;
+	m_pShaderManager->use();
+
+	if (previousProgram != 0)
+	{
+		ShaderUniforms::Release(previousProgram);
+		glDeleteProgram(previousProgram);
+	}
+
+	m_pViewManager->ReloadShaderUniforms();
+	m_pSceneManager->ReloadShaderUniforms();
+
+	std::cout << "Reloaded shaders, program:" << program << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  LinkShaders()
+ *
+ *  This method is used for compiling the shader files and
+ *  linking them into a new program.  A shader with errors
+ *  is reported and no program is returned, so the program
+ *  in use is left alone.
+ ***********************************************************/
+GLuint HotReload::LinkShaders() const
+{
+	GLuint vertexShader = CompileShaderFile(GL_VERTEX_SHADER, m_watcher.GetFilename(m_vertexShaderFile));
+	GLuint fragmentShader = CompileShaderFile(GL_FRAGMENT_SHADER, m_watcher.GetFilename(m_fragmentShaderFile));
+	GLuint program = 0;
+
+	if ((vertexShader != 0) && (fragmentShader != 0))
+	{
+		program = glCreateProgram();
+		glAttachShader(program, vertexShader);
+		glAttachShader(program, fragmentShader);
+		glLinkProgram(program);
+
+		GLint status = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &status);
+		if (status != GL_TRUE)
+		{
+			GLchar log[1024];
+			glGetProgramInfoLog(program, sizeof(log), NULL, log);
+			std::cout << "Could not link shaders:" << std::endl << log << std::endl;
+			glDeleteProgram(program);
+			program = 0;
+		}
+	}
+
+	// the linked program keeps the shaders it needs, and deleting
+	// the shader name 0 is ignored
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	return(program);
+}
+
+/***********************************************************
+ *  CompileShaderFile()
+ *
+ *  This method is used for reading a shader file and
+ *  compiling it, and for printing the errors when it does
+ *  not compile.
+ ***********************************************************/
+GLuint HotReload::CompileShaderFile(GLenum type, const std::string& filename)
+{
+	std::ifstream file(filename.c_str());
+	if (!file.is_open())
+	{
+		std::cout << "Could not open shader:" << filename << std::endl;
+		return(0);
+	}
+
+	std::stringstream source;
+	source << file.rdbuf();
+	std::string code = source.str();
+	const GLchar* codePointer = code.c_str();
+
+	GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 1, &codePointer, NULL);
+	glCompileShader(shader);
+
+	GLint status = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		GLchar log[1024];
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		std::cout << "Could not compile shader:" << filename << std::endl << log << std::endl;
+		glDeleteShader(shader);
+		return(0);
+	}
+
+	return(shader);
+}
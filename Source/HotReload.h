@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////////////
+// hotreload.h
+// ============
+// apply the shaders, textures and materials that changed on disk while running
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FileWatcher.h"
+#include "SceneManager.h"
+#include "ShaderManager.h"
+#include "ViewManager.h"
+
+#include <GL/glew.h>        // GLEW library
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  HotReload
+ *
+ *  This class contains the code for picking up the edits to
+ *  the files of a running scene, without restarting it.  The
+ *  shaders, the scene text file and the scene textures are
+ *  watched, and only what was made from a changed file is
+ *  replaced.  Changed shaders are compiled on their own first
+ *  and only replace the program in use once they link, so a
+ *  mistake leaves the last working program drawing.  Changed
+ *  textures are loaded again into the array layers that they
+ *  already have, and changed materials are copied into the
+ *  materials of the scene, while everything else on the GPU
+ *  stays as it is.  The changes are applied on the thread
+ *  that owns the OpenGL context, before a frame is drawn.
+ ***********************************************************/
+class HotReload
+{
+public:
+	// constructor
+	HotReload(ShaderManager* pShaderManager, SceneManager* pSceneManager,
+		ViewManager* pViewManager);
+
+	// watch the shader files of the program in use
+	void WatchShaders(const char* vertexFilename, const char* fragmentFilename);
+	// watch the text file of the prepared scene, and its textures
+	void WatchScene(const char* sceneFilename);
+
+	// apply the files that changed since the last call, and return
+	// how many there were
+	int ApplyChanges();
+
+private:
+	ShaderManager* m_pShaderManager;
+	SceneManager* m_pSceneManager;
+	ViewManager* m_pViewManager;
+	FileWatcher m_watcher;
+	// watch handles of the shaders and the scene text file, -1 when
+	// they are not watched
+	int m_vertexShaderFile;
+	int m_fragmentShaderFile;
+	int m_sceneFile;
+	// files that changed, kept between calls
+	std::vector<int> m_changedFiles;
+
+	// link the changed shaders into a new program in use
+	bool ReloadShaders();
+	// compile and link the shader files into a new program, and
+	// return it, or 0 when they have mistakes
+	GLuint LinkShaders() const;
+	// compile one shader file, and return it, or 0 when it failed
+	static GLuint CompileShaderFile(GLenum type, const std::string& filename);
+};
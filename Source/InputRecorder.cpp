@@ -0,0 +1,231 @@
+///////////////////////////////////////////////////////////////////////////////
+// inputrecorder.cpp
+// ============
+// record the camera input to a file and replay it frame by frame
+///////////////////////////////////////////////////////////////////////////////
+
+#include "InputRecorder.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// identifies input recordings and their layout version
+	const char g_InputMagic[4] = { 'I', 'N', 'P', 'R' };
+	const uint32_t g_InputVersion = 2;
+
+	static_assert(sizeof(INPUT_EVENT) == 20, "input event layout changed");
+	static_assert(sizeof(INPUT_FILE_HEADER) == 32, "input header layout changed");
+}
+
+/***********************************************************
+ *  InputRecorder()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+InputRecorder::InputRecorder()
+{
+	m_bRecording = false;
+	m_bReplaying = false;
+	m_frame = 0;
+	m_replayEvent = 0;
+}
+
+/***********************************************************
+ *  ~InputRecorder()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+InputRecorder::~InputRecorder()
+{
+	if (m_bRecording == true)
+	{
+		StopRecording();
+	}
+}
+
+/***********************************************************
+ *  StartRecording()
+ *
+ *  This method is used for starting a new recording, which
+ *  is written to the passed in file when it stops.
+ ***********************************************************/
+void InputRecorder::StartRecording(const char* filename)
+{
+	m_events.clear();
+	m_filename = filename;
+	m_bRecording = true;
+	m_bReplaying = false;
+	m_frame = 0;
+	m_startTime = std::chrono::steady_clock::now();
+}
+
+/***********************************************************
+ *  StopRecording()
+ *
+ *  This method is used for writing the header and the events
+ *  of the recording to its file.
+ ***********************************************************/
+bool InputRecorder::StopRecording()
+{
+	if (m_bRecording == false)
+	{
+		return(false);
+	}
+	m_bRecording = false;
+
+	INPUT_FILE_HEADER header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, g_InputMagic, sizeof(header.magic));
+	header.version = g_InputVersion;
+	header.frameCount = m_frame;
+	header.eventCount = (uint32_t)m_events.size();
+
+	std::ofstream output(m_filename.c_str(), std::ios::binary | std::ios::trunc);
+	output.write((const char*)&header, sizeof(header));
+	if (m_events.empty() == false)
+	{
+		output.write((const char*)m_events.data(), m_events.size() * sizeof(INPUT_EVENT));
+	}
+	if (!output.good())
+	{
+		std::cout << "Could not write input recording:" << m_filename << std::endl;
+		return(false);
+	}
+
+	std::cout << "Recorded input:" << m_filename << ", frames:" << header.frameCount << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  LoadReplay()
+ *
+ *  This method is used for loading a recording to replay.
+ *  Recordings from another version, and recordings whose
+ *  events do not end with a frame event, are rejected.
+ ***********************************************************/
+bool InputRecorder::LoadReplay(const char* filename)
+{
+	std::ifstream input(filename, std::ios::binary);
+	INPUT_FILE_HEADER header;
+
+	if (!input.read((char*)&header, sizeof(header)) ||
+		(std::memcmp(header.magic, g_InputMagic, sizeof(header.magic)) != 0) ||
+		(header.version != g_InputVersion))
+	{
+		std::cout << "Could not load input recording:" << filename << std::endl;
+		return(false);
+	}
+
+	m_events.resize(header.eventCount);
+	if ((header.eventCount > 0) &&
+		!input.read((char*)m_events.data(), header.eventCount * sizeof(INPUT_EVENT)))
+	{
+		m_events.clear();
+		std::cout << "Input recording is damaged:" << filename << std::endl;
+		return(false);
+	}
+	if ((m_events.empty() == false) && (m_events.back().type != INPUT_EVENT_FRAME))
+	{
+		m_events.clear();
+		std::cout << "Input recording is damaged:" << filename << std::endl;
+		return(false);
+	}
+
+	m_bRecording = false;
+	m_bReplaying = true;
+	m_replayEvent = 0;
+
+	std::cout << "Replaying input:" << filename << ", frames:" << header.frameCount << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  AddEvent()
+ *
+ *  This method is used for adding an event to the current
+ *  frame of the recording, stamped with the time since the
+ *  recording started.
+ ***********************************************************/
+void InputRecorder::AddEvent(uint16_t type, uint16_t keys, float x, float y)
+{
+	if (m_bRecording == false)
+	{
+		return;
+	}
+
+	INPUT_EVENT event;
+	event.frame = m_frame;
+	event.type = type;
+	event.keys = keys;
+	event.time = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_startTime).count();
+	event.x = x;
+	event.y = y;
+	m_events.push_back(event);
+}
+
+/***********************************************************
+ *  RecordMouseMove()
+ *
+ *  This method is used for recording the position that the
+ *  mouse moved to.
+ ***********************************************************/
+void InputRecorder::RecordMouseMove(float x, float y)
+{
+	AddEvent(INPUT_EVENT_MOUSE_MOVE, 0, x, y);
+}
+
+/***********************************************************
+ *  RecordScroll()
+ *
+ *  This method is used for recording a scroll of the mouse
+ *  wheel.
+ ***********************************************************/
+void InputRecorder::RecordScroll(float distance)
+{
+	AddEvent(INPUT_EVENT_SCROLL, 0, 0.0f, distance);
+}
+
+/***********************************************************
+ *  RecordFrame()
+ *
+ *  This method is used for recording the camera keys that
+ *  were held for a frame, and the wall clock time it took,
+ *  which ends the input of the frame.
+ ***********************************************************/
+void InputRecorder::RecordFrame(uint16_t keys, float deltaTime)
+{
+	AddEvent(INPUT_EVENT_FRAME, keys, deltaTime, 0.0f);
+	if (m_bRecording == true)
+	{
+		m_frame++;
+	}
+}
+
+/***********************************************************
+ *  ReplayFrame()
+ *
+ *  This method is used for getting the recorded events of
+ *  the next frame, up to and including its frame event.
+ ***********************************************************/
+int InputRecorder::ReplayFrame(const INPUT_EVENT*& events)
+{
+	events = NULL;
+	if ((m_bReplaying == false) || (IsReplayFinished() == true))
+	{
+		return(0);
+	}
+
+	size_t first = m_replayEvent;
+	while ((m_replayEvent < m_events.size()) && (m_events[m_replayEvent].type != INPUT_EVENT_FRAME))
+	{
+		m_replayEvent++;
+	}
+	m_replayEvent++;
+
+	events = &m_events[first];
+	return((int)(m_replayEvent - first));
+}
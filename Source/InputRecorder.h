@@ -0,0 +1,122 @@
+///////////////////////////////////////////////////////////////////////////////
+// inputrecorder.h
+// ============
+// record the camera input to a file and replay it frame by frame
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// kinds of recorded input events
+enum INPUT_EVENT_TYPE
+{
+	// end of the input of a frame, with the camera keys that were held
+	INPUT_EVENT_FRAME = 0,
+	// mouse position in x and y
+	INPUT_EVENT_MOUSE_MOVE,
+	// mouse wheel distance in y
+	INPUT_EVENT_SCROLL
+};
+
+// camera keys held during a frame, as the bits of a frame event
+enum INPUT_KEY
+{
+	INPUT_KEY_FORWARD = 0x01,
+	INPUT_KEY_BACKWARD = 0x02,
+	INPUT_KEY_LEFT = 0x04,
+	INPUT_KEY_RIGHT = 0x08,
+	INPUT_KEY_UP = 0x10,
+	INPUT_KEY_DOWN = 0x20,
+	INPUT_KEY_ORTHOGRAPHIC = 0x40,
+	INPUT_KEY_PERSPECTIVE = 0x80
+};
+
+// one recorded input event, as it is stored in the file
+struct INPUT_EVENT
+{
+	// frame that the event belongs to, and the seconds since the
+	// recording started
+	uint32_t frame;
+	uint16_t type;
+	// held camera keys of a frame event
+	uint16_t keys;
+	float time;
+	// mouse position, or scroll distance in y, and the wall clock
+	// frame time in x of a frame event, which its replay is advanced by
+	float x;
+	float y;
+};
+
+// header at the start of an input recording
+struct INPUT_FILE_HEADER
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t frameCount;
+	uint32_t eventCount;
+	uint32_t padding[4];
+};
+
+/***********************************************************
+ *  InputRecorder
+ *
+ *  This class contains the code for recording the camera
+ *  input of a run and replaying it later.  The mouse moves
+ *  and scrolls are recorded as they arrive, and every frame
+ *  ends with an event that holds the camera keys that were
+ *  down, so a replay feeds the camera the same input on the
+ *  same frames.  The events are kept in memory and written
+ *  in one go when the recording stops.  A replay advances
+ *  every frame by the time that was recorded for it instead
+ *  of by the wall clock, so every replay takes the camera
+ *  along the recorded path, whatever the frame rate.
+ ***********************************************************/
+class InputRecorder
+{
+public:
+	// constructor
+	InputRecorder();
+	// destructor - writes out a recording that was not stopped
+	~InputRecorder();
+
+	// start recording the input, to be written to the passed in file
+	void StartRecording(const char* filename);
+	// write out the recorded input and stop recording
+	bool StopRecording();
+	// load a recording to replay
+	bool LoadReplay(const char* filename);
+
+	// check whether the input is being recorded or replayed
+	bool IsRecording() const { return m_bRecording; }
+	bool IsReplaying() const { return m_bReplaying; }
+	// check whether every recorded frame has been replayed
+	bool IsReplayFinished() const { return m_replayEvent >= m_events.size(); }
+
+	// record a mouse move or scroll of the current frame
+	void RecordMouseMove(float x, float y);
+	void RecordScroll(float distance);
+	// record the held camera keys and frame time, ending the frame
+	void RecordFrame(uint16_t keys, float deltaTime);
+
+	// get the events of the next replayed frame, ending with its frame
+	// event, and return their count - zero once the replay is finished
+	int ReplayFrame(const INPUT_EVENT*& events);
+
+private:
+	std::vector<INPUT_EVENT> m_events;
+	std::string m_filename;
+	bool m_bRecording;
+	bool m_bReplaying;
+	// frame that new events belong to, and when the recording started
+	uint32_t m_frame;
+	std::chrono::steady_clock::time_point m_startTime;
+	// next event to replay
+	size_t m_replayEvent;
+
+	// add an event to the current frame of the recording
+	void AddEvent(uint16_t type, uint16_t keys, float x, float y);
+};
@@ -0,0 +1,436 @@
+///////////////////////////////////////////////////////////////////////////////
+// instancedmeshes.cpp
+// ============
+// draw many copies of the basic 3D shapes with one draw call
+///////////////////////////////////////////////////////////////////////////////
+
+#include "InstancedMeshes.h"
+#include "GLStateCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// declaration of global variables
+namespace
+{
+	// vertex attribute locations, matching Shaders/vertexShader.glsl
+	const GLuint g_PositionAttribute = 0;
+	const GLuint g_NormalAttribute = 1;
+	const GLuint g_TextureCoordinateAttribute = 2;
+	// the model matrix takes one location for each of its columns
+	const GLuint g_InstanceModelAttribute = 3;
+	const GLuint g_InstanceColorAttribute = 7;
+	const GLuint g_InstanceTextureAttribute = 8;
+	// room for this many instances and draws is allocated at first
+	const int g_InitialInstanceCapacity = 1024;
+	const int g_InitialDrawCapacity = 256;
+	const float g_Pi = 3.14159265358979f;
+	// longest that the edge of a slice may get on the screen, as a
+	// fraction of the screen height, before a finer level is used
+	const float g_MaxSliceEdgeSize = 0.01f;
+	// how far past the switch size an object has to get before it
+	// changes its level of detail, so that an object sitting right at
+	// the switch size does not flicker between two levels
+	const float g_LodHysteresis = 0.15f;
+}
+
+/***********************************************************
+ *  InstancedMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+InstancedMeshes::InstancedMeshes()
+{
+	for (int i = 0; i < SCENE_MESH_COUNT; i++)
+	{
+		for (int lod = 0; lod < ShapeGeometry::LOD_COUNT; lod++)
+		{
+			m_meshes[i][lod].firstIndex = 0;
+			m_meshes[i][lod].indexCount = 0;
+			m_meshes[i][lod].baseVertex = 0;
+			m_lodScreenSizes[i][lod] = 0.0f;
+		}
+		m_lodCounts[i] = 1;
+	}
+	m_vertexArray = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+	m_instanceBuffer = 0;
+	m_instanceCapacity = 0;
+	m_commandBuffer = 0;
+	m_drawCapacity = 0;
+}
+
+/***********************************************************
+ *  ~InstancedMeshes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+InstancedMeshes::~InstancedMeshes()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  LoadMeshes()
+ *
+ *  This method is used for building all of the basic 3D
+ *  shapes and packing them into the shared vertex and index
+ *  buffers, which are read by one vertex array that also
+ *  reads the per-instance values from the instance buffer.
+ *  The round shapes are built once for each level of detail,
+ *  and a level is drawn down to the screen size where the
+ *  edges of the next level's slices are short enough to not
+ *  be seen.  The bounding sphere comes from the finest level.
+ ***********************************************************/
+void InstancedMeshes::LoadMeshes(int slices)
+{
+	Destroy();
+
+	glGenBuffers(1, &m_instanceBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, g_InitialInstanceCapacity * sizeof(MESH_INSTANCE),
+		NULL, GL_STREAM_DRAW);
+	m_instanceCapacity = g_InitialInstanceCapacity;
+
+	glGenBuffers(1, &m_commandBuffer);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER,
+		g_InitialDrawCapacity * sizeof(DRAW_ELEMENTS_INDIRECT_COMMAND), NULL, GL_STREAM_DRAW);
+	m_drawCapacity = g_InitialDrawCapacity;
+
+	std::vector<SHAPE_VERTEX> vertices;
+	std::vector<uint32_t> indices;
+	SHAPE_GEOMETRY geometry;
+	for (uint32_t mesh = 0; mesh < SCENE_MESH_COUNT; mesh++)
+	{
+		m_lodCounts[mesh] = 0;
+		for (int lod = 0; lod < ShapeGeometry::LOD_COUNT; lod++)
+		{
+			int lodSlices = ShapeGeometry::GetLodSlices(slices, lod);
+
+			// stop once the levels stop getting any coarser
+			if ((lod > 0) && ((ShapeGeometry::IsRound(mesh) == false) ||
+				(lodSlices == ShapeGeometry::GetLodSlices(slices, lod - 1))))
+			{
+				break;
+			}
+
+			ShapeGeometry::Build(mesh, lodSlices, geometry);
+			if (lod == 0)
+			{
+				m_boundingSpheres[mesh] = CalculateBoundingSphere(geometry);
+			}
+			else
+			{
+				// a slice of this level is short enough below this size
+				m_lodScreenSizes[mesh][lod - 1] = lodSlices * g_MaxSliceEdgeSize / g_Pi;
+			}
+			AddMesh(geometry, m_meshes[mesh][lod], vertices, indices);
+			m_lodScreenSizes[mesh][lod] = 0.0f;
+			m_lodCounts[mesh]++;
+		}
+	}
+
+	glGenVertexArrays(1, &m_vertexArray);
+	GLStateCache::Current().BindVertexArray(m_vertexArray);
+
+	glGenBuffers(1, &m_vertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(SHAPE_VERTEX),
+		vertices.data(), GL_STATIC_DRAW);
+
+	glGenBuffers(1, &m_indexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t),
+		indices.data(), GL_STATIC_DRAW);
+
+	// per-vertex values
+	glEnableVertexAttribArray(g_PositionAttribute);
+	glVertexAttribPointer(g_PositionAttribute, 3, GL_FLOAT, GL_FALSE,
+		sizeof(SHAPE_VERTEX), (void*)offsetof(SHAPE_VERTEX, position));
+	glEnableVertexAttribArray(g_NormalAttribute);
+	glVertexAttribPointer(g_NormalAttribute, 3, GL_FLOAT, GL_FALSE,
+		sizeof(SHAPE_VERTEX), (void*)offsetof(SHAPE_VERTEX, normal));
+	glEnableVertexAttribArray(g_TextureCoordinateAttribute);
+	glVertexAttribPointer(g_TextureCoordinateAttribute, 2, GL_FLOAT, GL_FALSE,
+		sizeof(SHAPE_VERTEX), (void*)offsetof(SHAPE_VERTEX, uv));
+
+	BindInstanceAttributes();
+
+	GLStateCache::Current().BindVertexArray(0);
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used for adding the triangles of a shape to
+ *  the end of the vertices and indices that are packed into
+ *  the shared buffers.  The indices are kept relative to the
+ *  first vertex of the shape, which every draw of the shape
+ *  passes as its base vertex.
+ ***********************************************************/
+void InstancedMeshes::AddMesh(const SHAPE_GEOMETRY& geometry, GPU_MESH& gpuMesh,
+	std::vector<SHAPE_VERTEX>& vertices, std::vector<uint32_t>& indices)
+{
+	gpuMesh.firstIndex = (GLuint)indices.size();
+	gpuMesh.indexCount = (GLsizei)geometry.indices.size();
+	gpuMesh.baseVertex = (GLint)vertices.size();
+
+	vertices.insert(vertices.end(), geometry.vertices.begin(), geometry.vertices.end());
+	indices.insert(indices.end(), geometry.indices.begin(), geometry.indices.end());
+}
+
+/***********************************************************
+ *  SelectLod()
+ *
+ *  This method is used for picking the level of detail of an
+ *  object from the fraction of the screen height that it
+ *  covers.  An object only moves to a finer level once it is
+ *  a little larger than the switch size, and to a coarser
+ *  level once it is a little smaller, so an object that sits
+ *  near the switch size keeps the level that it has.
+ ***********************************************************/
+uint32_t InstancedMeshes::SelectLod(uint32_t mesh, float screenSize, uint32_t currentLod) const
+{
+	int lod = std::min((int)currentLod, m_lodCounts[mesh] - 1);
+
+	while ((lod > 0) && (screenSize > m_lodScreenSizes[mesh][lod - 1] * (1.0f + g_LodHysteresis)))
+	{
+		lod--;
+	}
+	while ((lod < m_lodCounts[mesh] - 1) && (screenSize < m_lodScreenSizes[mesh][lod] * (1.0f - g_LodHysteresis)))
+	{
+		lod++;
+	}
+
+	return((uint32_t)lod);
+}
+
+/***********************************************************
+ *  BindInstanceAttributes()
+ *
+ *  This method is used for pointing the per-instance
+ *  attributes of the bound vertex array at the instance
+ *  buffer, advancing once per instance instead of once per
+ *  vertex.
+ ***********************************************************/
+void InstancedMeshes::BindInstanceAttributes()
+{
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+
+	for (GLuint column = 0; column < 4; column++)
+	{
+		GLuint attribute = g_InstanceModelAttribute + column;
+		glEnableVertexAttribArray(attribute);
+		glVertexAttribPointer(attribute, 4, GL_FLOAT, GL_FALSE, sizeof(MESH_INSTANCE),
+			(void*)(offsetof(MESH_INSTANCE, model) + (column * sizeof(glm::vec4))));
+		glVertexAttribDivisor(attribute, 1);
+	}
+
+	glEnableVertexAttribArray(g_InstanceColorAttribute);
+	glVertexAttribPointer(g_InstanceColorAttribute, 4, GL_FLOAT, GL_FALSE,
+		sizeof(MESH_INSTANCE), (void*)offsetof(MESH_INSTANCE, color));
+	glVertexAttribDivisor(g_InstanceColorAttribute, 1);
+
+	glEnableVertexAttribArray(g_InstanceTextureAttribute);
+	glVertexAttribPointer(g_InstanceTextureAttribute, 4, GL_FLOAT, GL_FALSE,
+		sizeof(MESH_INSTANCE), (void*)offsetof(MESH_INSTANCE, uvScale));
+	glVertexAttribDivisor(g_InstanceTextureAttribute, 1);
+}
+
+/***********************************************************
+ *  CalculateBoundingSphere()
+ *
+ *  This method is used for getting a sphere around all of the
+ *  vertices of a shape, centered on their bounding box.  It
+ *  is not the smallest sphere, but it is close for the basic
+ *  shapes.
+ ***********************************************************/
+glm::vec4 InstancedMeshes::CalculateBoundingSphere(const SHAPE_GEOMETRY& geometry)
+{
+	float minimum[3] = { 0.0f, 0.0f, 0.0f };
+	float maximum[3] = { 0.0f, 0.0f, 0.0f };
+
+	for (size_t i = 0; i < geometry.vertices.size(); i++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float value = geometry.vertices[i].position[axis];
+			minimum[axis] = (i == 0) ? value : std::min(minimum[axis], value);
+			maximum[axis] = (i == 0) ? value : std::max(maximum[axis], value);
+		}
+	}
+
+	float center[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		center[axis] = (minimum[axis] + maximum[axis]) * 0.5f;
+	}
+
+	float radiusSquared = 0.0f;
+	for (size_t i = 0; i < geometry.vertices.size(); i++)
+	{
+		const float* position = geometry.vertices[i].position;
+		float x = position[0] - center[0];
+		float y = position[1] - center[1];
+		float z = position[2] - center[2];
+		radiusSquared = std::max(radiusSquared, (x * x) + (y * y) + (z * z));
+	}
+
+	return(glm::vec4(center[0], center[1], center[2], std::sqrt(radiusSquared)));
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the buffers and the vertex
+ *  array of the shapes.
+ ***********************************************************/
+void InstancedMeshes::Destroy()
+{
+	for (int i = 0; i < SCENE_MESH_COUNT; i++)
+	{
+		for (int lod = 0; lod < ShapeGeometry::LOD_COUNT; lod++)
+		{
+			m_meshes[i][lod].firstIndex = 0;
+			m_meshes[i][lod].indexCount = 0;
+			m_meshes[i][lod].baseVertex = 0;
+		}
+		m_lodCounts[i] = 1;
+	}
+
+	if (m_vertexArray != 0)
+	{
+		GLStateCache::Current().ForgetVertexArray(m_vertexArray);
+		glDeleteVertexArrays(1, &m_vertexArray);
+		glDeleteBuffers(1, &m_vertexBuffer);
+		glDeleteBuffers(1, &m_indexBuffer);
+		m_vertexArray = 0;
+		m_vertexBuffer = 0;
+		m_indexBuffer = 0;
+	}
+
+	if (m_instanceBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_instanceBuffer);
+		m_instanceBuffer = 0;
+	}
+	m_instanceCapacity = 0;
+
+	if (m_commandBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_commandBuffer);
+		m_commandBuffer = 0;
+	}
+	m_drawCapacity = 0;
+}
+
+/***********************************************************
+ *  UploadInstances()
+ *
+ *  This method is used for copying the per-instance values of
+ *  the current frame into the instance buffer.  The buffer is
+ *  orphaned first so that the driver does not wait for the
+ *  draws of the previous frame that are still reading it.
+ ***********************************************************/
+void InstancedMeshes::UploadInstances(const MESH_INSTANCE* instances, int count)
+{
+	if ((m_instanceBuffer == 0) || (count <= 0))
+	{
+		return;
+	}
+
+	// grow the buffer by doubling, so it settles after a few frames
+	while (m_instanceCapacity < count)
+	{
+		m_instanceCapacity *= 2;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, m_instanceCapacity * sizeof(MESH_INSTANCE),
+		NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(MESH_INSTANCE), instances);
+}
+
+/***********************************************************
+ *  GetDrawCommand()
+ *
+ *  This method is used for getting the indirect command that
+ *  draws a range of the uploaded instances with a level of
+ *  detail of the passed in shape.  The base instance picks
+ *  the range of the instance buffer, so the per-instance
+ *  attributes need nothing else to find their values.
+ ***********************************************************/
+DRAW_ELEMENTS_INDIRECT_COMMAND InstancedMeshes::GetDrawCommand(uint32_t mesh, uint32_t lod,
+	int firstInstance, int instanceCount) const
+{
+	DRAW_ELEMENTS_INDIRECT_COMMAND command;
+	command.count = 0;
+	command.instanceCount = 0;
+	command.firstIndex = 0;
+	command.baseVertex = 0;
+	command.baseInstance = 0;
+
+	if ((mesh < SCENE_MESH_COUNT) && (instanceCount > 0))
+	{
+		const GPU_MESH& gpuMesh = m_meshes[mesh][std::min((int)lod, m_lodCounts[mesh] - 1)];
+
+		command.count = (GLuint)gpuMesh.indexCount;
+		command.instanceCount = (GLuint)instanceCount;
+		command.firstIndex = gpuMesh.firstIndex;
+		command.baseVertex = gpuMesh.baseVertex;
+		command.baseInstance = (GLuint)firstInstance;
+	}
+
+	return(command);
+}
+
+/***********************************************************
+ *  UploadDraws()
+ *
+ *  This method is used for copying the indirect commands of
+ *  the current frame into the indirect buffer.  The buffer is
+ *  orphaned first, the same as the instance buffer, and it is
+ *  left bound.
+ ***********************************************************/
+void InstancedMeshes::UploadDraws(const DRAW_ELEMENTS_INDIRECT_COMMAND* commands, int count)
+{
+	if ((m_commandBuffer == 0) || (count <= 0))
+	{
+		return;
+	}
+
+	while (m_drawCapacity < count)
+	{
+		m_drawCapacity *= 2;
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER,
+		m_drawCapacity * sizeof(DRAW_ELEMENTS_INDIRECT_COMMAND), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0,
+		count * sizeof(DRAW_ELEMENTS_INDIRECT_COMMAND), commands);
+}
+
+/***********************************************************
+ *  MultiDrawIndirect()
+ *
+ *  This method is used for drawing a range of the uploaded
+ *  indirect commands with one call.  The commands can draw
+ *  any mix of the shapes, since all of them are in the shared
+ *  buffers of the one vertex array.
+ ***********************************************************/
+void InstancedMeshes::MultiDrawIndirect(int firstDraw, int drawCount) const
+{
+	if ((m_vertexArray == 0) || (drawCount <= 0))
+	{
+		return;
+	}
+
+	GLStateCache::Current().BindVertexArray(m_vertexArray);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+		(void*)(firstDraw * sizeof(DRAW_ELEMENTS_INDIRECT_COMMAND)), drawCount, 0);
+}
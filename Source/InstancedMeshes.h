@@ -0,0 +1,131 @@
+///////////////////////////////////////////////////////////////////////////////
+// instancedmeshes.h
+// ============
+// draw many copies of the basic 3D shapes with one draw call
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShapeGeometry.h"
+
+#include <GL/glew.h>        // GLEW library
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// per-instance values, read by the vertex shader as attributes
+struct MESH_INSTANCE
+{
+	glm::mat4 model;
+	glm::vec4 color;
+	// texture mapping scale, the texture array layer to sample and the
+	// index of the material in the material buffer, or -1 for none,
+	// read together as one attribute
+	glm::vec2 uvScale;
+	float textureLayer;
+	float material;
+};
+
+// one draw of a multi-draw call, laid out the way that
+// glMultiDrawElementsIndirect reads it from the indirect buffer
+struct DRAW_ELEMENTS_INDIRECT_COMMAND
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
+/***********************************************************
+ *  InstancedMeshes
+ *
+ *  This class contains the basic 3D shapes, packed together
+ *  into one vertex buffer and one index buffer that are read
+ *  through a single vertex array, along with one buffer of
+ *  per-instance values that is shared by all of them.  The
+ *  instances of a frame are uploaded once, and the draws of
+ *  the frame are uploaded as indirect commands that each pick
+ *  the index range of a shape and a range of the instances,
+ *  so that a run of draws of different shapes goes out with
+ *  one glMultiDrawElementsIndirect call.  Everything else
+ *  that differs between the objects, down to the material,
+ *  is in the instance values, so the draws need nothing more.
+ *  The round shapes are built at several levels of detail,
+ *  and each object picks the coarsest level whose slices
+ *  still look smooth at the size it covers on the screen.
+ ***********************************************************/
+class InstancedMeshes
+{
+public:
+	// constructor
+	InstancedMeshes();
+	// destructor
+	~InstancedMeshes();
+
+	// build the shapes and pack them into the shared buffers
+	void LoadMeshes(int slices = ShapeGeometry::DEFAULT_SLICES);
+	// free the buffers of the shapes
+	void Destroy();
+
+	// upload the per-instance values of the current frame
+	void UploadInstances(const MESH_INSTANCE* instances, int count);
+
+	// get the indirect command that draws a range of the uploaded
+	// instances with a level of detail of a shape
+	DRAW_ELEMENTS_INDIRECT_COMMAND GetDrawCommand(uint32_t mesh, uint32_t lod,
+		int firstInstance, int instanceCount) const;
+	// upload the indirect commands of the current frame
+	void UploadDraws(const DRAW_ELEMENTS_INDIRECT_COMMAND* commands, int count);
+	// draw a range of the uploaded commands with one call
+	void MultiDrawIndirect(int firstDraw, int drawCount) const;
+
+	// get the number of indices of a level of detail of a shape
+	int GetIndexCount(uint32_t mesh, uint32_t lod) const { return m_meshes[mesh][lod].indexCount; }
+	// pick the level of detail of an object from the fraction of the
+	// screen height that its bounding sphere covers, starting from the
+	// level it was drawn with last, so it does not flicker between two
+	uint32_t SelectLod(uint32_t mesh, float screenSize, uint32_t currentLod) const;
+	// get the sphere around a shape, with the center in xyz and the
+	// radius in w
+	const glm::vec4& GetBoundingSphere(uint32_t mesh) const { return m_boundingSpheres[mesh]; }
+
+private:
+	// where a level of detail of a shape is in the shared buffers
+	struct GPU_MESH
+	{
+		GLuint firstIndex;
+		GLsizei indexCount;
+		GLint baseVertex;
+	};
+
+	GPU_MESH m_meshes[SCENE_MESH_COUNT][ShapeGeometry::LOD_COUNT];
+	int m_lodCounts[SCENE_MESH_COUNT];
+	// smallest screen size that each level of detail but the last
+	// is drawn at, as a fraction of the screen height
+	float m_lodScreenSizes[SCENE_MESH_COUNT][ShapeGeometry::LOD_COUNT];
+	glm::vec4 m_boundingSpheres[SCENE_MESH_COUNT];
+	// vertices and indices of every shape, and the vertex array that
+	// reads them along with the instance buffer
+	GLuint m_vertexArray;
+	GLuint m_vertexBuffer;
+	GLuint m_indexBuffer;
+	GLuint m_instanceBuffer;
+	// number of instances the instance buffer has room for
+	int m_instanceCapacity;
+	// indirect commands of the current frame, and the number of draws
+	// that they have room for
+	GLuint m_commandBuffer;
+	int m_drawCapacity;
+
+	// add the triangles of a shape to the vertices and indices that are
+	// packed into the shared buffers
+	void AddMesh(const SHAPE_GEOMETRY& geometry, GPU_MESH& gpuMesh,
+		std::vector<SHAPE_VERTEX>& vertices, std::vector<uint32_t>& indices);
+	// get the sphere around the vertices of a shape
+	static glm::vec4 CalculateBoundingSphere(const SHAPE_GEOMETRY& geometry);
+	// point the per-instance attributes of the bound vertex array
+	// at the instance buffer
+	void BindInstanceAttributes();
+};
@@ -0,0 +1,682 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightclusters.cpp
+// ============
+// bin the scene lights into view space clusters for the fragment shader
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LightClusters.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// clusters across, down and in depth - the fragment shader reads
+	// the grid size from the cluster buffer
+	const int g_ClusterCountX = 16;
+	const int g_ClusterCountY = 9;
+	const int g_ClusterCountZ = 24;
+	const int g_ClusterCount = g_ClusterCountX * g_ClusterCountY * g_ClusterCountZ;
+	// the first slice reaches at least this far, so a near plane at or
+	// behind the camera still gives usable slices
+	const float g_MinSliceDepth = 0.1f;
+	// with fewer lights than this, starting the workers costs more
+	// than the binning, so it is done on the calling thread alone
+	const int g_ParallelLightCount = 32;
+	// most worker threads that are picked from the cores
+	const int g_MaxWorkers = 3;
+
+	// storage buffer binding points, which match the fragment shader
+	const GLuint g_LightBinding = 0;
+	const GLuint g_ClusterBinding = 1;
+	const GLuint g_IndexBinding = 2;
+
+	/***********************************************************
+	 *  SphereTouchesBox()
+	 *
+	 *  Check whether a sphere overlaps an axis aligned box.
+	 ***********************************************************/
+	bool SphereTouchesBox(const glm::vec3& center, float radius,
+		const glm::vec3& minimum, const glm::vec3& maximum)
+	{
+		float distanceSquared = 0.0f;
+		for (int i = 0; i < 3; i++)
+		{
+			float outside = std::max(minimum[i] - center[i], 0.0f) + std::max(center[i] - maximum[i], 0.0f);
+			distanceSquared += outside * outside;
+		}
+
+		return(distanceSquared <= radius * radius);
+	}
+
+	/***********************************************************
+	 *  Unproject()
+	 *
+	 *  Turn a point in normalized device coordinates into view
+	 *  space with the inverse of the projection.
+	 ***********************************************************/
+	glm::vec3 Unproject(const glm::mat4& inverseProjection, float x, float y, float z)
+	{
+		glm::vec4 point = inverseProjection * glm::vec4(x, y, z, 1.0f);
+
+		return(glm::vec3(point.x, point.y, point.z) / point.w);
+	}
+
+	/***********************************************************
+	 *  UploadBuffer()
+	 *
+	 *  Replace the contents of a storage buffer.  Empty buffers
+	 *  are given a little storage so they can still be bound.
+	 ***********************************************************/
+	void UploadBuffer(GLuint buffer, const void* data, size_t size)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		if (size == 0)
+			glBufferData(GL_SHADER_STORAGE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+		else
+			glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_STREAM_DRAW);
+	}
+}
+
+/***********************************************************
+ *  LightClusters()
+ *
+ *  The constructor for the class - creates the storage
+ *  buffers, so it needs a current OpenGL context, and starts
+ *  the binning workers.
+ ***********************************************************/
+LightClusters::LightClusters(int workerCount)
+{
+	m_lightsVersion = 0;
+	m_uploadedVersion = -1;
+	m_bBoundsValid = false;
+	m_depthNear = g_MinSliceDepth;
+	m_depthFar = g_MinSliceDepth;
+	m_sliceNear = g_MinSliceDepth;
+	m_depthScale = 1.0f;
+	m_pBinFrame = NULL;
+	m_bBinEverywhere = false;
+	m_binGeneration = 0;
+	m_workersDone = 0;
+	m_bStopping = false;
+
+	glGenBuffers(1, &m_lightBuffer);
+	glGenBuffers(1, &m_clusterBuffer);
+	glGenBuffers(1, &m_indexBuffer);
+	UploadBuffer(m_lightBuffer, NULL, 0);
+	UploadBuffer(m_clusterBuffer, NULL, 0);
+	UploadBuffer(m_indexBuffer, NULL, 0);
+
+	if (workerCount < 0)
+	{
+		workerCount = std::min(g_MaxWorkers, (int)std::thread::hardware_concurrency() - 1);
+	}
+	workerCount = std::max(0, std::min(workerCount, g_ClusterCountZ - 1));
+
+	m_work.resize(workerCount + 1);
+	for (int i = 0; i < workerCount; i++)
+	{
+		m_workers.push_back(std::thread(&LightClusters::WorkerLoop, this, i));
+	}
+
+	SetFrameCount(1);
+}
+
+/***********************************************************
+ *  ~LightClusters()
+ *
+ *  The destructor for the class - stops the workers and
+ *  frees the storage buffers.
+ ***********************************************************/
+LightClusters::~LightClusters()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+	}
+	m_binReady.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+
+	GLuint buffers[3] = { m_lightBuffer, m_clusterBuffer, m_indexBuffer };
+	glDeleteBuffers(3, buffers);
+	m_lightBuffer = 0;
+	m_clusterBuffer = 0;
+	m_indexBuffer = 0;
+}
+
+/***********************************************************
+ *  SetFrameCount()
+ *
+ *  This method is used for setting the number of frame states
+ *  that the lights are binned into and uploaded from in turn.
+ ***********************************************************/
+void LightClusters::SetFrameCount(int frameCount)
+{
+	m_frames.resize(std::max(1, frameCount));
+	for (size_t i = 0; i < m_frames.size(); i++)
+	{
+		CLUSTER_FRAME& frame = m_frames[i];
+		frame.lights.clear();
+		frame.lightsVersion = -1;
+		frame.clusters.clear();
+		frame.indices.clear();
+		frame.stats.lights = 0;
+		frame.stats.globalLights = 0;
+		frame.stats.lightsVisible = 0;
+		frame.stats.clusterLights = 0;
+		frame.stats.maxClusterLights = 0;
+	}
+	m_uploadedVersion = -1;
+}
+
+/***********************************************************
+ *  ClearLights()
+ *
+ *  This method is used for removing all of the lights.
+ ***********************************************************/
+void LightClusters::ClearLights()
+{
+	m_lights.clear();
+	m_lightsVersion++;
+}
+
+/***********************************************************
+ *  AddLight()
+ *
+ *  This method is used for adding a light, which is packed
+ *  the way the fragment shader reads it.
+ ***********************************************************/
+int LightClusters::AddLight(const LIGHT_SOURCE& light)
+{
+	GPU_LIGHT packed;
+	packed.positionRadius = glm::vec4(light.position, std::max(light.radius, 0.0f));
+	packed.ambientColor = glm::vec4(light.ambientColor, light.focalStrength);
+	packed.diffuseColor = glm::vec4(light.diffuseColor, light.specularIntensity);
+	packed.specularColor = glm::vec4(light.specularColor, 0.0f);
+
+	m_lights.push_back(packed);
+	m_lightsVersion++;
+
+	return((int)m_lights.size() - 1);
+}
+
+/***********************************************************
+ *  SetLightPosition()
+ *
+ *  This method is used for moving a light.  The lights are
+ *  only copied and uploaded again when one has moved.
+ ***********************************************************/
+void LightClusters::SetLightPosition(int light, const glm::vec3& position)
+{
+	glm::vec4& positionRadius = m_lights[light].positionRadius;
+	if ((positionRadius.x != position.x) || (positionRadius.y != position.y) ||
+		(positionRadius.z != position.z))
+	{
+		positionRadius = glm::vec4(position, positionRadius.w);
+		m_lightsVersion++;
+	}
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for binning the lights into the
+ *  clusters of a view.  The cluster bounds only have to be
+ *  built again when the projection changes.
+ ***********************************************************/
+void LightClusters::Update(int frame, const glm::mat4& view, const glm::mat4& projection)
+{
+	if ((m_bBoundsValid == false) || (projection != m_boundsProjection))
+	{
+		BuildClusterBounds(projection);
+	}
+
+	FindLightRanges(view, projection);
+	m_bBinEverywhere = false;
+	BinLights(m_frames[frame]);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for binning every light with a radius
+ *  into every cluster, so that the lighting is still right
+ *  before a view has been set, only slower.
+ ***********************************************************/
+void LightClusters::Update(int frame)
+{
+	m_ranges.clear();
+	for (size_t i = 0; i < m_lights.size(); i++)
+	{
+		if (m_lights[i].positionRadius.w > 0.0f)
+		{
+			LIGHT_RANGE range;
+			range.light = (int)i;
+			range.minX = 0;
+			range.maxX = g_ClusterCountX - 1;
+			range.minY = 0;
+			range.maxY = g_ClusterCountY - 1;
+			range.minZ = 0;
+			range.maxZ = g_ClusterCountZ - 1;
+			range.center = glm::vec3(0.0f);
+			range.radius = m_lights[i].positionRadius.w;
+			m_ranges.push_back(range);
+		}
+	}
+
+	m_bBinEverywhere = true;
+	BinLights(m_frames[frame]);
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for uploading the binned lights of a
+ *  frame into the storage buffers, and binding them to the
+ *  binding points that the fragment shader reads them from.
+ *  The lights themselves are only uploaded when they changed.
+ ***********************************************************/
+void LightClusters::Upload(int frame)
+{
+	CLUSTER_FRAME& clusterFrame = m_frames[frame];
+
+	if (clusterFrame.lightsVersion != m_uploadedVersion)
+	{
+		UploadBuffer(m_lightBuffer, clusterFrame.lights.data(),
+			clusterFrame.lights.size() * sizeof(GPU_LIGHT));
+		m_uploadedVersion = clusterFrame.lightsVersion;
+	}
+
+	// the header and the clusters share a buffer
+	size_t clusterSize = clusterFrame.clusters.size() * sizeof(GLuint);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_clusterBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GPU_CLUSTER_HEADER) + clusterSize, NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GPU_CLUSTER_HEADER), &clusterFrame.header);
+	if (clusterSize > 0)
+	{
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(GPU_CLUSTER_HEADER), clusterSize,
+			clusterFrame.clusters.data());
+	}
+
+	UploadBuffer(m_indexBuffer, clusterFrame.indices.data(),
+		clusterFrame.indices.size() * sizeof(GLuint));
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, g_LightBinding, m_lightBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, g_ClusterBinding, m_clusterBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, g_IndexBinding, m_indexBuffer);
+}
+
+/***********************************************************
+ *  BuildClusterBounds()
+ *
+ *  This method is used for finding the near and far depth of
+ *  a projection, spacing the depth slices between them, and
+ *  building the view space bounding box of every cluster from
+ *  the rays through the corners of the screen tiles.  This
+ *  works for perspective and orthographic projections alike.
+ ***********************************************************/
+void LightClusters::BuildClusterBounds(const glm::mat4& projection)
+{
+	glm::mat4 inverseProjection = glm::inverse(projection);
+
+	m_depthNear = -Unproject(inverseProjection, 0.0f, 0.0f, -1.0f).z;
+	m_depthFar = -Unproject(inverseProjection, 0.0f, 0.0f, 1.0f).z;
+	m_sliceNear = std::max(m_depthNear, g_MinSliceDepth);
+	m_depthScale = g_ClusterCountZ / std::log(std::max(m_depthFar / m_sliceNear, 1.001f));
+
+	// depth of each slice split - the first and last slices reach
+	// the near and far planes
+	float splits[g_ClusterCountZ + 1];
+	splits[0] = m_depthNear;
+	for (int z = 1; z < g_ClusterCountZ; z++)
+	{
+		splits[z] = m_sliceNear * std::exp(z / m_depthScale);
+	}
+	splits[g_ClusterCountZ] = m_depthFar;
+
+	// the near and far points of the ray through each tile corner
+	const int cornersX = g_ClusterCountX + 1;
+	const int cornersY = g_ClusterCountY + 1;
+	std::vector<glm::vec3> nearPoints(cornersX * cornersY);
+	std::vector<glm::vec3> farPoints(cornersX * cornersY);
+	for (int y = 0; y < cornersY; y++)
+	{
+		for (int x = 0; x < cornersX; x++)
+		{
+			float ndcX = -1.0f + (2.0f * x) / g_ClusterCountX;
+			float ndcY = -1.0f + (2.0f * y) / g_ClusterCountY;
+			nearPoints[x + (y * cornersX)] = Unproject(inverseProjection, ndcX, ndcY, -1.0f);
+			farPoints[x + (y * cornersX)] = Unproject(inverseProjection, ndcX, ndcY, 1.0f);
+		}
+	}
+
+	m_bounds.resize(g_ClusterCount);
+	for (int z = 0; z < g_ClusterCountZ; z++)
+	{
+		for (int y = 0; y < g_ClusterCountY; y++)
+		{
+			for (int x = 0; x < g_ClusterCountX; x++)
+			{
+				CLUSTER_BOUNDS& bounds = m_bounds[x + (g_ClusterCountX * (y + (g_ClusterCountY * z)))];
+				bounds.minimum = glm::vec3(1e30f);
+				bounds.maximum = glm::vec3(-1e30f);
+
+				// the four corners of the tile, at the two splits of the slice
+				for (int i = 0; i < 8; i++)
+				{
+					int corner = (x + (i & 1)) + ((y + ((i >> 1) & 1)) * cornersX);
+					float depth = splits[z + (i >> 2)];
+					const glm::vec3& nearPoint = nearPoints[corner];
+					const glm::vec3& farPoint = farPoints[corner];
+					float t = (depth + nearPoint.z) / (nearPoint.z - farPoint.z);
+					glm::vec3 point = nearPoint + ((farPoint - nearPoint) * t);
+
+					bounds.minimum = glm::min(bounds.minimum, point);
+					bounds.maximum = glm::max(bounds.maximum, point);
+				}
+			}
+		}
+	}
+
+	m_boundsProjection = projection;
+	m_bBoundsValid = true;
+}
+
+/***********************************************************
+ *  GetSlice()
+ *
+ *  This method is used for getting the depth slice that a
+ *  view space depth falls in, the same way the fragment
+ *  shader does.
+ ***********************************************************/
+int LightClusters::GetSlice(float depth) const
+{
+	if (depth <= m_sliceNear)
+	{
+		return(0);
+	}
+
+	int slice = (int)std::floor(std::log(depth / m_sliceNear) * m_depthScale);
+
+	return(std::max(0, std::min(slice, g_ClusterCountZ - 1)));
+}
+
+/***********************************************************
+ *  FindLightRanges()
+ *
+ *  This method is used for finding the range of clusters
+ *  that each light with a radius can touch.  The depth range
+ *  comes from the depth of the sphere, and the screen range
+ *  from projecting the corners of the box around the sphere.
+ *  A sphere that reaches behind the camera can cover any
+ *  part of the screen, so it gets the whole screen.  Lights
+ *  that are outside of the view are left out.
+ ***********************************************************/
+void LightClusters::FindLightRanges(const glm::mat4& view, const glm::mat4& projection)
+{
+	m_ranges.clear();
+
+	for (size_t i = 0; i < m_lights.size(); i++)
+	{
+		const glm::vec4& positionRadius = m_lights[i].positionRadius;
+		if (positionRadius.w <= 0.0f)
+		{
+			continue;
+		}
+
+		LIGHT_RANGE range;
+		glm::vec4 center = view * glm::vec4(positionRadius.x, positionRadius.y, positionRadius.z, 1.0f);
+		range.light = (int)i;
+		range.center = glm::vec3(center.x, center.y, center.z);
+		range.radius = positionRadius.w;
+
+		float depth = -range.center.z;
+		if ((depth + range.radius < m_depthNear) || (depth - range.radius > m_depthFar))
+		{
+			continue;
+		}
+		range.minZ = GetSlice(depth - range.radius);
+		range.maxZ = GetSlice(depth + range.radius);
+
+		float minimumX = 1.0f;
+		float maximumX = -1.0f;
+		float minimumY = 1.0f;
+		float maximumY = -1.0f;
+		bool bProjected = true;
+		for (int corner = 0; (corner < 8) && bProjected; corner++)
+		{
+			glm::vec4 point(
+				range.center.x + ((corner & 1) ? range.radius : -range.radius),
+				range.center.y + ((corner & 2) ? range.radius : -range.radius),
+				range.center.z + ((corner & 4) ? range.radius : -range.radius),
+				1.0f);
+			glm::vec4 clip = projection * point;
+			if (clip.w <= 0.0f)
+			{
+				bProjected = false;
+			}
+			else
+			{
+				minimumX = std::min(minimumX, clip.x / clip.w);
+				maximumX = std::max(maximumX, clip.x / clip.w);
+				minimumY = std::min(minimumY, clip.y / clip.w);
+				maximumY = std::max(maximumY, clip.y / clip.w);
+			}
+		}
+
+		if (bProjected == false)
+		{
+			minimumX = -1.0f;
+			maximumX = 1.0f;
+			minimumY = -1.0f;
+			maximumY = 1.0f;
+		}
+		else if ((maximumX < -1.0f) || (minimumX > 1.0f) || (maximumY < -1.0f) || (minimumY > 1.0f))
+		{
+			continue;
+		}
+
+		range.minX = std::max(0, (int)std::floor((minimumX * 0.5f + 0.5f) * g_ClusterCountX));
+		range.maxX = std::min(g_ClusterCountX - 1, (int)std::floor((maximumX * 0.5f + 0.5f) * g_ClusterCountX));
+		range.minY = std::max(0, (int)std::floor((minimumY * 0.5f + 0.5f) * g_ClusterCountY));
+		range.maxY = std::min(g_ClusterCountY - 1, (int)std::floor((maximumY * 0.5f + 0.5f) * g_ClusterCountY));
+
+		m_ranges.push_back(range);
+	}
+}
+
+/***********************************************************
+ *  BinLights()
+ *
+ *  This method is used for binning the lights of the found
+ *  ranges into the clusters of a frame.  Each thread bins a
+ *  run of depth slices into its own index list, and the
+ *  lists are joined after the lights that reach the whole
+ *  scene, in order, so the result is the same for any
+ *  number of threads.
+ ***********************************************************/
+void LightClusters::BinLights(CLUSTER_FRAME& frame)
+{
+	if (frame.lightsVersion != m_lightsVersion)
+	{
+		frame.lights = m_lights;
+		frame.lightsVersion = m_lightsVersion;
+	}
+	frame.clusters.resize(g_ClusterCount * 2);
+
+	// only start the workers when there is enough to bin
+	const int threadCount = ((int)m_ranges.size() >= g_ParallelLightCount) ? (int)m_work.size() : 1;
+	for (int i = 0; i < (int)m_work.size(); i++)
+	{
+		m_work[i].firstSlice = std::min(i, threadCount) * g_ClusterCountZ / threadCount;
+		m_work[i].lastSlice = std::min(i + 1, threadCount) * g_ClusterCountZ / threadCount;
+	}
+
+	m_pBinFrame = &frame;
+	if (threadCount > 1)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_workersDone = 0;
+			m_binGeneration++;
+		}
+		m_binReady.notify_all();
+	}
+
+	BinSlices(m_work[0]);
+
+	if (threadCount > 1)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_binDone.wait(lock, [this] { return m_workersDone == (int)m_workers.size(); });
+	}
+	m_pBinFrame = NULL;
+
+	// the lights that reach the whole scene come first
+	frame.indices.clear();
+	for (size_t i = 0; i < frame.lights.size(); i++)
+	{
+		if (frame.lights[i].positionRadius.w <= 0.0f)
+		{
+			frame.indices.push_back((GLuint)i);
+		}
+	}
+	const int globalLights = (int)frame.indices.size();
+
+	int maxClusterLights = 0;
+	for (int i = 0; i < threadCount; i++)
+	{
+		const BIN_WORK& work = m_work[i];
+		const GLuint base = (GLuint)frame.indices.size();
+		const int firstCluster = work.firstSlice * g_ClusterCountX * g_ClusterCountY;
+		const int lastCluster = work.lastSlice * g_ClusterCountX * g_ClusterCountY;
+
+		for (int cluster = firstCluster; cluster < lastCluster; cluster++)
+		{
+			frame.clusters[cluster * 2] += base;
+			maxClusterLights = std::max(maxClusterLights, (int)frame.clusters[(cluster * 2) + 1]);
+		}
+		frame.indices.insert(frame.indices.end(), work.indices.begin(), work.indices.end());
+	}
+
+	frame.header.grid[0] = g_ClusterCountX;
+	frame.header.grid[1] = g_ClusterCountY;
+	frame.header.grid[2] = g_ClusterCountZ;
+	frame.header.grid[3] = (GLuint)globalLights;
+	frame.header.depthNear = m_sliceNear;
+	frame.header.depthScale = m_depthScale;
+	frame.header.padding[0] = 0.0f;
+	frame.header.padding[1] = 0.0f;
+
+	frame.stats.lights = (int)frame.lights.size();
+	frame.stats.globalLights = globalLights;
+	frame.stats.lightsVisible = (int)m_ranges.size();
+	frame.stats.clusterLights = (int)frame.indices.size() - globalLights;
+	frame.stats.maxClusterLights = maxClusterLights;
+}
+
+/***********************************************************
+ *  BinSlices()
+ *
+ *  This method is used for binning the lights into the
+ *  clusters of a run of depth slices.  The lights that reach
+ *  into a slice, and then into each row of it, are gathered
+ *  first, and each of them is tested against the box of every
+ *  cluster of the row that is inside its range.  The offsets
+ *  are relative to the index list of the thread until the
+ *  lists are joined.
+ ***********************************************************/
+void LightClusters::BinSlices(BIN_WORK& work)
+{
+	std::vector<GLuint>& clusters = m_pBinFrame->clusters;
+
+	work.indices.clear();
+	for (int z = work.firstSlice; z < work.lastSlice; z++)
+	{
+		work.sliceLights.clear();
+		for (size_t i = 0; i < m_ranges.size(); i++)
+		{
+			if ((m_ranges[i].minZ <= z) && (z <= m_ranges[i].maxZ))
+			{
+				work.sliceLights.push_back(m_ranges[i]);
+			}
+		}
+
+		for (int y = 0; y < g_ClusterCountY; y++)
+		{
+			work.rowLights.clear();
+			for (size_t i = 0; i < work.sliceLights.size(); i++)
+			{
+				if ((work.sliceLights[i].minY <= y) && (y <= work.sliceLights[i].maxY))
+				{
+					work.rowLights.push_back(work.sliceLights[i]);
+				}
+			}
+
+			for (int x = 0; x < g_ClusterCountX; x++)
+			{
+				const int cluster = x + (g_ClusterCountX * (y + (g_ClusterCountY * z)));
+				const size_t offset = work.indices.size();
+
+				for (size_t i = 0; i < work.rowLights.size(); i++)
+				{
+					const LIGHT_RANGE& range = work.rowLights[i];
+					if ((x < range.minX) || (x > range.maxX))
+					{
+						continue;
+					}
+					if ((m_bBinEverywhere == true) ||
+						SphereTouchesBox(range.center, range.radius,
+							m_bounds[cluster].minimum, m_bounds[cluster].maximum))
+					{
+						work.indices.push_back((GLuint)range.light);
+					}
+				}
+
+				clusters[cluster * 2] = (GLuint)offset;
+				clusters[(cluster * 2) + 1] = (GLuint)(work.indices.size() - offset);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is used by each worker thread for binning its
+ *  run of slices whenever a new binning is started.
+ ***********************************************************/
+void LightClusters::WorkerLoop(int worker)
+{
+	int generation = 0;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_binReady.wait(lock, [this, &generation] {
+				return m_bStopping || (m_binGeneration != generation);
+			});
+			if (m_bStopping)
+			{
+				return;
+			}
+			generation = m_binGeneration;
+		}
+
+		BinSlices(m_work[worker + 1]);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_workersDone++;
+		}
+		m_binDone.notify_one();
+	}
+}
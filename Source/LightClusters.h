@@ -0,0 +1,217 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightclusters.h
+// ============
+// bin the scene lights into view space clusters for the fragment shader
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// a light of the scene - a radius of 0 reaches the whole scene
+struct LIGHT_SOURCE
+{
+	glm::vec3 position;
+	float radius;
+	glm::vec3 ambientColor;
+	glm::vec3 diffuseColor;
+	glm::vec3 specularColor;
+	float focalStrength;
+	float specularIntensity;
+};
+
+// counts of the lights that were binned for a frame
+struct LIGHT_CLUSTER_STATS
+{
+	// lights of the scene, and the lights that reach the whole scene
+	int lights;
+	int globalLights;
+	// lights with a radius that reach into the view
+	int lightsVisible;
+	// light references of all of the clusters together, and of the
+	// cluster with the most lights
+	int clusterLights;
+	int maxClusterLights;
+};
+
+/***********************************************************
+ *  LightClusters
+ *
+ *  This class contains the code for clustered forward
+ *  lighting.  The view frustum is split into a grid of
+ *  clusters, with the depth slices spaced exponentially so
+ *  the clusters stay about as deep as they are wide.  Every
+ *  frame, the lights with a radius are binned into the
+ *  clusters that their sphere touches, with the depth slices
+ *  split between worker threads, and the fragment shader only
+ *  looks at the lights of the cluster that it falls in.  The
+ *  lights without a radius are looked at by every fragment.
+ *  The binning makes no OpenGL calls, so it can run while a
+ *  frame is rendered, and the result is kept in one of several
+ *  frame states until it is uploaded into storage buffers on
+ *  the thread that owns the context.
+ ***********************************************************/
+class LightClusters
+{
+public:
+	// constructor - the binning is split between the calling thread
+	// and the worker threads, a count of -1 picks one from the cores
+	LightClusters(int workerCount = -1);
+	// destructor
+	~LightClusters();
+
+	// set the number of frame states, before updating any frame
+	void SetFrameCount(int frameCount);
+
+	// remove all of the lights
+	void ClearLights();
+	// add a light and return its handle
+	int AddLight(const LIGHT_SOURCE& light);
+	// move a light, such as along with the object it is attached to
+	void SetLightPosition(int light, const glm::vec3& position);
+	// get the number of lights
+	int GetLightCount() const { return (int)m_lights.size(); }
+
+	// bin the lights into the clusters of a view, without OpenGL calls
+	void Update(int frame, const glm::mat4& view, const glm::mat4& projection);
+	// bin every light into every cluster, when no view is known
+	void Update(int frame);
+	// upload the binned lights of a frame and bind the storage buffers
+	void Upload(int frame);
+
+	// get the light counts of a frame
+	const LIGHT_CLUSTER_STATS& GetStats(int frame) const { return m_frames[frame].stats; }
+	// get the number of worker threads
+	int GetWorkerCount() const { return (int)m_workers.size(); }
+
+private:
+	// light in the storage buffer, laid out as std430 to match the
+	// fragment shader
+	struct GPU_LIGHT
+	{
+		// position in xyz and radius in w
+		glm::vec4 positionRadius;
+		// ambient color in rgb and focal strength in w
+		glm::vec4 ambientColor;
+		// diffuse color in rgb and specular intensity in w
+		glm::vec4 diffuseColor;
+		glm::vec4 specularColor;
+	};
+
+	// start of the cluster storage buffer, laid out as std430
+	struct GPU_CLUSTER_HEADER
+	{
+		// clusters along x, y and depth, and the number of lights that
+		// reach the whole scene, which come first in the index list
+		GLuint grid[4];
+		// depth of the first slice split, and the scale that turns the
+		// log of a depth over it into a slice
+		GLfloat depthNear;
+		GLfloat depthScale;
+		GLfloat padding[2];
+	};
+
+	// range of clusters that a light can touch
+	struct LIGHT_RANGE
+	{
+		int light;
+		int minX, maxX;
+		int minY, maxY;
+		int minZ, maxZ;
+		// center of the light in view space, and its radius
+		glm::vec3 center;
+		float radius;
+	};
+
+	// view space bounding box of a cluster
+	struct CLUSTER_BOUNDS
+	{
+		glm::vec3 minimum;
+		glm::vec3 maximum;
+	};
+
+	// everything the binning of a frame hands over to its upload
+	struct CLUSTER_FRAME
+	{
+		// copy of the lights, taken when they changed
+		std::vector<GPU_LIGHT> lights;
+		int lightsVersion;
+		GPU_CLUSTER_HEADER header;
+		// offset into the index list and light count of each cluster
+		std::vector<GLuint> clusters;
+		// the lights that reach the whole scene, then the lights of
+		// each cluster
+		std::vector<GLuint> indices;
+		LIGHT_CLUSTER_STATS stats;
+	};
+
+	// what a thread bins, and the light indexes that it found
+	struct BIN_WORK
+	{
+		int firstSlice;
+		int lastSlice;
+		// lights that reach into the slice, and into the row of it,
+		// that is being binned
+		std::vector<LIGHT_RANGE> sliceLights;
+		std::vector<LIGHT_RANGE> rowLights;
+		std::vector<GLuint> indices;
+	};
+
+	std::vector<GPU_LIGHT> m_lights;
+	// bumped whenever a light changes, so unchanged lights are not
+	// copied or uploaded again
+	int m_lightsVersion;
+	int m_uploadedVersion;
+	std::vector<CLUSTER_FRAME> m_frames;
+
+	// projection that the cluster bounds were built for
+	glm::mat4 m_boundsProjection;
+	bool m_bBoundsValid;
+	std::vector<CLUSTER_BOUNDS> m_bounds;
+	float m_depthNear;
+	float m_depthFar;
+	float m_sliceNear;
+	float m_depthScale;
+
+	// lights with a radius, with the clusters they can touch
+	std::vector<LIGHT_RANGE> m_ranges;
+	// frame that is being binned, and whether every light goes into
+	// every cluster
+	CLUSTER_FRAME* m_pBinFrame;
+	bool m_bBinEverywhere;
+
+	// binning work of the calling thread, then of each worker
+	std::vector<BIN_WORK> m_work;
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_binReady;
+	std::condition_variable m_binDone;
+	// bumped for every binning that the workers take part in
+	int m_binGeneration;
+	int m_workersDone;
+	bool m_bStopping;
+
+	// storage buffers of the lights, clusters and light indexes
+	GLuint m_lightBuffer;
+	GLuint m_clusterBuffer;
+	GLuint m_indexBuffer;
+
+	// build the view space bounds of the clusters for a projection
+	void BuildClusterBounds(const glm::mat4& projection);
+	// get the slice that a view space depth falls in
+	int GetSlice(float depth) const;
+	// find the clusters that each light with a radius can touch
+	void FindLightRanges(const glm::mat4& view, const glm::mat4& projection);
+	// bin the lights into the clusters of the frame
+	void BinLights(CLUSTER_FRAME& frame);
+	// bin the lights into the clusters of the slices of one thread
+	void BinSlices(BIN_WORK& work);
+	// bin for the workers until the clusters are destroyed
+	void WorkerLoop(int worker);
+};
@@ -1,5 +1,7 @@
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // command line option parsing
+#include <vector>
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -13,6 +15,18 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "ShaderUniforms.h"
+#include "HeadlessContext.h"
+#include "FrameBenchmark.h"
+#include "FrameProfiler.h"
+#include "FramePipeline.h"
+#include "GLStateCache.h"
+#include "InputRecorder.h"
+#include "HotReload.h"
+#include "DynamicResolution.h"
+#include "BenchmarkSweep.h"
+#include "TransformBatch.h"
+#include "HeapCounter.h"
 
 // Namespace for declaring global variables
 namespace
@@ -29,12 +43,79 @@ namespace
 	ShaderManager* g_ShaderManager = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+	// offscreen OpenGL context used in place of the window when headless
+	HeadlessContext* g_HeadlessContext = nullptr;
+	// times the sections of each frame, when profiling is turned on
+	FrameProfiler* g_FrameProfiler = nullptr;
+	// times the rendered frames of the headless benchmark
+	FrameBenchmark* g_FrameBenchmark = nullptr;
+	// records or replays the camera input, when asked for
+	InputRecorder* g_InputRecorder = nullptr;
+	// applies the edits to the shaders, textures and materials, when asked for
+	HotReload* g_HotReload = nullptr;
+	// render target that the frames are drawn into, at a lower
+	// resolution when they take longer than the frame budget
+	DynamicResolution* g_DynamicResolution = nullptr;
+	// camera matrices of each frame state, from the frame's update
+	std::vector<VIEW_STATE> g_FrameViews;
+
+	// command line options for the benchmark modes
+	bool g_bHeadless = false;
+	int g_BenchmarkFrames = 300;
+	int g_BenchmarkWarmup = 10;
+	const char* g_BenchmarkOutput = "benchmark.json";
+	// scene description file that is rendered
+	const char* g_SceneFilename = "Scenes/desk.scene";
+	// number of random objects to render in place of the objects of the
+	// scene file, which only gives its textures, materials and lights,
+	// and the seed that they are placed with
+	int g_GenerateObjects = 0;
+	uint32_t g_GenerateSeed = 1;
+	// object counts of the generated scenes that the benchmark is run
+	// for one after the other
+	std::vector<int> g_SweepCounts;
+	// shader files that the program is linked from
+	const char* g_VertexShaderFilename = "Shaders/vertexShader.glsl";
+	const char* g_FragmentShaderFilename = "Shaders/fragmentShader.glsl";
+	// pick up the edited shaders, textures and materials while running
+	bool g_bHotReload = false;
+	// milliseconds of GPU time that a frame should fit in by lowering
+	// the resolution, zero to always draw at the full resolution
+	float g_FrameBudget = 0.0f;
+	// store the cooked textures block compressed
+	bool g_bCompressTextures = false;
+	// skip the objects hidden behind large objects
+	bool g_bOcclusionCulling = true;
+	// file the camera input is recorded to, or replayed from
+	const char* g_RecordInput = NULL;
+	const char* g_ReplayInput = NULL;
+	// print the mean section times every this many frames, and the
+	// file the section times of every frame are written to
+	int g_ProfileInterval = 0;
+	const char* g_TraceOutput = NULL;
+	// number of frame states that the update and rendering take turns
+	// on - more than one renders on a thread of its own
+	int g_PipelineFrames = 3;
+	// threads besides the update thread that calculate the transforms
+	// of the objects that moved
+	int g_TransformThreads = 0;
+	// heap allocations of the program when the last frame was drawn
+	uint64_t g_FrameAllocations = 0;
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
 bool InitializeGLFW();
 bool InitializeGLEW();
+void ParseCommandLine(int argc, char* argv[]);
+void UpdateFrame(int frame);
+void RenderFrame(int frame);
+bool MakeContextCurrent(bool bCurrent);
+bool RunFramePipeline(int frameLimit);
+bool CreateScene(int objectCount);
+bool MeasureFrames(FrameBenchmark& benchmark);
+bool RunHeadlessBenchmark();
+bool RunBenchmarkSweep();
 
 
 /***********************************************************
@@ -45,8 +126,23 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	int exitCode = EXIT_SUCCESS;
+
+	ParseCommandLine(argc, argv);
+	std::cout << "INFO: Transform kernel: " << TransformBatch::GetKernelName(TransformBatch::GetKernel()) << std::endl;
+	std::cout << "INFO: Culling instruction set: " << FrustumCuller::GetInstructionSet() << std::endl;
+
+	if (g_bHeadless == true)
+	{
+		// render offscreen without any window or display server
+		g_HeadlessContext = new HeadlessContext();
+		if (g_HeadlessContext->CreateContext() == false)
+		{
+			return(EXIT_FAILURE);
+		}
+	}
 	// if GLFW fails initialization, then terminate the application
-	if (InitializeGLFW() == false)
+	else if (InitializeGLFW() == false)
 	{
 		return(EXIT_FAILURE);
 	}
@@ -57,8 +153,30 @@ int main(int argc, char* argv[])
 	g_ViewManager = new ViewManager(
 		g_ShaderManager);
 
+	// replay the camera input of an earlier run, so the frames can be
+	// compared one by one, or record the input of this run
+	if ((NULL != g_ReplayInput) || (NULL != g_RecordInput))
+	{
+		g_InputRecorder = new InputRecorder();
+		if (NULL != g_ReplayInput)
+		{
+			if (g_InputRecorder->LoadReplay(g_ReplayInput) == false)
+			{
+				return(EXIT_FAILURE);
+			}
+		}
+		else
+		{
+			g_InputRecorder->StartRecording(g_RecordInput);
+		}
+		g_ViewManager->SetInputRecorder(g_InputRecorder);
+	}
+
 	// try to create the main display window
-	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	if (g_bHeadless == false)
+	{
+		g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	}
 
 	// if GLEW fails initialization, then terminate the application
 	if (InitializeGLEW() == false)
@@ -66,42 +184,121 @@ int main(int argc, char* argv[])
 		return(EXIT_FAILURE);
 	}
 
+	// create the offscreen render target the same size as the window
+	if (g_bHeadless == true)
+	{
+		if (g_HeadlessContext->CreateFramebuffer(
+			g_ViewManager->GetViewWidth(),
+			g_ViewManager->GetViewHeight()) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+		g_ViewManager->CreateOffscreenView();
+	}
+
+	// draw the frames into the output, or into a scaled render target
+	// that is stretched over it
+	g_DynamicResolution = new DynamicResolution();
+	g_DynamicResolution->SetFrameBudget(g_FrameBudget);
+	if (g_bHeadless == true)
+	{
+		g_DynamicResolution->SetOutputFramebuffer(g_HeadlessContext->GetFramebuffer());
+	}
+
 	// load the shader code from the external GLSL files
 	g_ShaderManager->LoadShaders(
-		"../../Utilities/shaders/vertexShader.glsl",
-		"../../Utilities/shaders/fragmentShader.glsl");
+		g_VertexShaderFilename,
+		g_FragmentShaderFilename);
 	g_ShaderManager->use();
 
-	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
-	g_SceneManager->PrepareScene();
-
-	// loop will keep running until the application is closed 
-	// or until an error has occurred
-	while (!glfwWindowShouldClose(g_Window))
+	// time the frame sections when a summary or trace is asked for
+	if ((g_ProfileInterval > 0) || (NULL != g_TraceOutput))
 	{
-		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
-
-		// Clear the frame and z buffers
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		g_FrameProfiler = new FrameProfiler();
+		g_FrameProfiler->SetSummaryInterval(g_ProfileInterval);
+		g_FrameProfiler->SetTracing(NULL != g_TraceOutput);
+	}
 
-		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
+	// try to create a new scene manager object and prepare the 3D scene -
+	// a sweep creates each of its scenes itself
+	if ((g_SweepCounts.empty() == true) && (CreateScene(g_GenerateObjects) == false))
+	{
+		return(EXIT_FAILURE);
+	}
 
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
+	// watch the files of the scene for edits - a sweep replaces the
+	// scene, so it is not watched then
+	if ((g_bHotReload == true) && (g_SweepCounts.empty() == false))
+	{
+		std::cout << "Ignoring --hot-reload during a benchmark sweep" << std::endl;
+	}
+	else if (g_bHotReload == true)
+	{
+		g_HotReload = new HotReload(g_ShaderManager, g_SceneManager, g_ViewManager);
+		g_HotReload->WatchShaders(g_VertexShaderFilename, g_FragmentShaderFilename);
+		g_HotReload->WatchScene(g_SceneFilename);
+	}
 
+	if (g_SweepCounts.empty() == false)
+	{
+		// benchmark the generated scene at every object count
+		if (RunBenchmarkSweep() == false)
+		{
+			exitCode = EXIT_FAILURE;
+		}
+	}
+	else if (g_bHeadless == true)
+	{
+		// draw the fixed number of frames and report their timings
+		if (RunHeadlessBenchmark() == false)
+		{
+			exitCode = EXIT_FAILURE;
+		}
+	}
+	else
+	{
+		// loop will keep running until the application is closed 
+		// or until an error has occurred
+		if (RunFramePipeline(0) == false)
+		{
+			exitCode = EXIT_FAILURE;
+		}
+	}
 
-		// Flips the the back buffer with the front buffer every frame.
-		glfwSwapBuffers(g_Window);
+	// write out the section times of the frames that were profiled
+	if (NULL != g_FrameProfiler)
+	{
+		g_FrameProfiler->Finish();
+		if ((NULL != g_TraceOutput) && (g_FrameProfiler->WriteTrace(g_TraceOutput) == false))
+		{
+			exitCode = EXIT_FAILURE;
+		}
+		if (NULL != g_SceneManager)
+		{
+			g_SceneManager->SetProfiler(NULL);
+		}
+		delete g_FrameProfiler;
+		g_FrameProfiler = NULL;
+	}
 
-		// query the latest GLFW events
-		glfwPollEvents();
+	// write out the recorded input
+	if (NULL != g_InputRecorder)
+	{
+		if ((g_InputRecorder->IsRecording() == true) && (g_InputRecorder->StopRecording() == false))
+		{
+			exitCode = EXIT_FAILURE;
+		}
+		g_ViewManager->SetInputRecorder(NULL);
+		delete g_InputRecorder;
+		g_InputRecorder = NULL;
 	}
 
 	// clear the allocated manager objects from memory
+	if (NULL != g_HotReload)
+	{
+		delete g_HotReload;
+		g_HotReload = NULL;
+	}
 	if (NULL != g_SceneManager)
 	{
 		delete g_SceneManager;
@@ -117,36 +314,519 @@ int main(int argc, char* argv[])
 		delete g_ShaderManager;
 		g_ShaderManager = NULL;
 	}
+	if (NULL != g_DynamicResolution)
+	{
+		delete g_DynamicResolution;
+		g_DynamicResolution = NULL;
+	}
+	// clear the cached shader uniform locations
+	ShaderUniforms::ReleaseAll();
+	if (NULL != g_HeadlessContext)
+	{
+		delete g_HeadlessContext;
+		g_HeadlessContext = NULL;
+	}
 
-	// Terminates the program successfully
-	exit(EXIT_SUCCESS); 
+	// Terminates the program
+	exit(exitCode); 
+}
+
+/***********************************************************
+ *	ParseCommandLine()
+ *
+ *  This function is used to read the command line options.
+ *
+ *    --scene <file>    scene text or cooked file to render
+ *    --generate <n>    render n randomly placed objects, with the
+ *                      textures, materials and lights of the scene
+ *    --seed <n>        seed that the generated objects are placed with
+ *    --sweep <n,n,...>  run the benchmark on a generated scene of
+ *                      each object count, in the window or offscreen
+ *                      with --headless, and write the results side
+ *                      by side to the output file
+ *    --headless        render offscreen and run the benchmark
+ *    --frames <n>      number of measured benchmark frames
+ *    --warmup <n>      number of frames drawn before measuring
+ *    --output <file>   file the benchmark results are written to,
+ *                      with the heap allocations per frame only
+ *                      counted by the Profile build, which defines
+ *                      COUNT_HEAP_ALLOCATIONS - other builds write
+ *                      null for them
+ *    --compress-textures  cook and load the textures as BC1/BC3
+ *    --no-occlusion    draw the objects hidden behind others too
+ *    --record <file>   record the camera input to a file
+ *    --replay <file>   replay recorded camera input with its
+ *                      recorded frame times, in place of the
+ *                      live input
+ *    --hot-reload      apply the edited shaders, textures and
+ *                      materials without restarting
+ *    --frame-budget <ms>  lower the resolution to keep the GPU
+ *                      time of a frame within the budget
+ *    --profile <n>     print the mean section times every n frames
+ *    --trace <file>    write the section times as a Chrome trace
+ *    --pipeline <n>    frame states shared by the update and the
+ *                      render thread, 1 runs both on one thread
+ *    --transform-threads <n>  extra threads that calculate the
+ *                      transforms of large numbers of moving objects
+ *    --transform-kernel <name>  calculate the transforms with the
+ *                      scalar, sse or avx2 kernel, in place of the
+ *                      best one that the CPU supports
+ ***********************************************************/
+void ParseCommandLine(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		bool bHasValue = (i + 1) < argc;
+
+		if ((std::strcmp(argv[i], "--scene") == 0) && bHasValue)
+		{
+			g_SceneFilename = argv[++i];
+		}
+		else if ((std::strcmp(argv[i], "--generate") == 0) && bHasValue)
+		{
+			g_GenerateObjects = std::atoi(argv[++i]);
+		}
+		else if ((std::strcmp(argv[i], "--seed") == 0) && bHasValue)
+		{
+			g_GenerateSeed = (uint32_t)std::strtoul(argv[++i], NULL, 10);
+		}
+		else if ((std::strcmp(argv[i], "--sweep") == 0) && bHasValue)
+		{
+			BenchmarkSweep::ParseCounts(argv[++i], g_SweepCounts);
+		}
+		else if (std::strcmp(argv[i], "--headless") == 0)
+		{
+			g_bHeadless = true;
+		}
+		else if ((std::strcmp(argv[i], "--frames") == 0) && bHasValue)
+		{
+			g_BenchmarkFrames = std::atoi(argv[++i]);
+		}
+		else if ((std::strcmp(argv[i], "--warmup") == 0) && bHasValue)
+		{
+			g_BenchmarkWarmup = std::atoi(argv[++i]);
+		}
+		else if ((std::strcmp(argv[i], "--output") == 0) && bHasValue)
+		{
+			g_BenchmarkOutput = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--compress-textures") == 0)
+		{
+			g_bCompressTextures = true;
+		}
+		else if (std::strcmp(argv[i], "--no-occlusion") == 0)
+		{
+			g_bOcclusionCulling = false;
+		}
+		else if ((std::strcmp(argv[i], "--record") == 0) && bHasValue)
+		{
+			g_RecordInput = argv[++i];
+		}
+		else if ((std::strcmp(argv[i], "--replay") == 0) && bHasValue)
+		{
+			g_ReplayInput = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--hot-reload") == 0)
+		{
+			g_bHotReload = true;
+		}
+		else if ((std::strcmp(argv[i], "--frame-budget") == 0) && bHasValue)
+		{
+			g_FrameBudget = (float)std::atof(argv[++i]);
+		}
+		else if ((std::strcmp(argv[i], "--profile") == 0) && bHasValue)
+		{
+			g_ProfileInterval = std::atoi(argv[++i]);
+		}
+		else if ((std::strcmp(argv[i], "--trace") == 0) && bHasValue)
+		{
+			g_TraceOutput = argv[++i];
+		}
+		else if ((std::strcmp(argv[i], "--pipeline") == 0) && bHasValue)
+		{
+			g_PipelineFrames = std::atoi(argv[++i]);
+		}
+		else if ((std::strcmp(argv[i], "--transform-threads") == 0) && bHasValue)
+		{
+			g_TransformThreads = std::atoi(argv[++i]);
+		}
+		else if ((std::strcmp(argv[i], "--transform-kernel") == 0) && bHasValue)
+		{
+			const char* kernelName = argv[++i];
+			if (TransformBatch::SetKernel(TransformBatch::FindKernel(kernelName)) == false)
+			{
+				std::cout << "Transform kernel is unknown or not supported by the CPU: " << kernelName << std::endl;
+			}
+		}
+		else
+		{
+			std::cout << "Ignoring unknown option: " << argv[i] << std::endl;
+		}
+	}
+}
+
+/***********************************************************
+ *	UpdateFrame()
+ *
+ *  This function is used to process the input and update the
+ *  passed in frame state with the camera and the visible
+ *  objects of the next frame.  It makes no OpenGL calls.
+ ***********************************************************/
+void UpdateFrame(int frame)
+{
+	ProfileZone zone(g_FrameProfiler, "update");
+
+	// convert from 3D object space to 2D view
+	g_ViewManager->UpdateView();
+	g_FrameViews[frame] = g_ViewManager->GetViewState();
+	g_SceneManager->SetViewFrustum(g_FrameViews[frame].view, g_FrameViews[frame].projection);
+
+	// refresh the 3D scene
+	g_SceneManager->UpdateScene(frame);
+}
+
+/***********************************************************
+ *	RenderFrame()
+ *
+ *  This function is used to clear the frame and render the
+ *  passed in frame state into the current render target, on
+ *  the thread that owns the OpenGL context.
+ ***********************************************************/
+void RenderFrame(int frame)
+{
+	if (NULL != g_FrameBenchmark)
+	{
+		g_FrameBenchmark->BeginFrame();
+	}
+	if (NULL != g_FrameProfiler)
+	{
+		g_FrameProfiler->BeginFrame();
+	}
+
+	// the state that is already set is skipped, and counted per frame
+	GLStateCache& stateCache = GLStateCache::Current();
+	stateCache.ResetStats();
+
+	// apply the files that were edited since the last frame
+	if (NULL != g_HotReload)
+	{
+		ProfileZone zone(g_FrameProfiler, "hotReload");
+		g_HotReload->ApplyChanges();
+	}
+
+	// draw into the render target at the size of the frame's output
+	g_DynamicResolution->BeginFrame(g_FrameViews[frame].width, g_FrameViews[frame].height);
+
+	// Enable z-depth
+	stateCache.Enable(GL_DEPTH_TEST);
+
+	// Clear the frame and z buffers
+	{
+		ProfileZone zone(g_FrameProfiler, "clear");
+		stateCache.ClearColor(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	}
+
+	// set the camera of the frame into the shader
+	{
+		ProfileZone zone(g_FrameProfiler, "view");
+		g_ViewManager->ApplyView(g_FrameViews[frame]);
+	}
+
+	{
+		ProfileZone zone(g_FrameProfiler, "scene");
+		g_SceneManager->RenderScene(frame);
+	}
+
+	// stretch a frame drawn at a lower resolution over the output
+	{
+		ProfileZone zone(g_FrameProfiler, "upscale");
+		g_DynamicResolution->EndFrame();
+	}
+
+	// Flips the the back buffer with the front buffer every frame.
+	if (NULL != g_Window)
+	{
+		ProfileZone zone(g_FrameProfiler, "swap");
+		glfwSwapBuffers(g_Window);
+	}
+
+	if (NULL != g_FrameProfiler)
+	{
+		g_FrameProfiler->EndFrame();
+	}
+	if (NULL != g_FrameBenchmark)
+	{
+		const RENDER_QUEUE_STATS& renderStats = g_SceneManager->GetRenderStats();
+		g_FrameBenchmark->RecordCounter("draws", renderStats.draws);
+		g_FrameBenchmark->RecordCounter("drawCalls", renderStats.drawCalls);
+		g_FrameBenchmark->RecordCounter("multiDraws", renderStats.multiDraws);
+		g_FrameBenchmark->RecordCounter("triangles", renderStats.triangles);
+		g_FrameBenchmark->RecordCounter("stateChanges", renderStats.stateChanges);
+		g_FrameBenchmark->RecordCounter("stateChangesAvoided", renderStats.stateChangesAvoided);
+		g_FrameBenchmark->RecordCounter("transformUpdates", renderStats.transformUpdates);
+		g_FrameBenchmark->RecordCounter("objectsVisible", renderStats.objectsVisible);
+		g_FrameBenchmark->RecordCounter("objectsCulled", renderStats.objectsCulled);
+		g_FrameBenchmark->RecordCounter("objectsOccluded", renderStats.objectsOccluded);
+		g_FrameBenchmark->RecordCounter("resolutionScale", g_DynamicResolution->GetScale());
+		const LIGHT_CLUSTER_STATS& lightStats = g_SceneManager->GetLightStats();
+		g_FrameBenchmark->RecordCounter("lights", lightStats.lights);
+		g_FrameBenchmark->RecordCounter("lightsVisible", lightStats.lightsVisible);
+		g_FrameBenchmark->RecordCounter("clusterLights", lightStats.clusterLights);
+		g_FrameBenchmark->RecordCounter("maxClusterLights", lightStats.maxClusterLights);
+		const GL_STATE_STATS& stateStats = stateCache.GetStats();
+		g_FrameBenchmark->RecordCounter("glStateCalls", stateStats.stateCalls);
+		g_FrameBenchmark->RecordCounter("glStateCallsSkipped", stateStats.stateCallsSkipped);
+		g_FrameBenchmark->RecordCounter("uniformCalls", stateStats.uniformCalls);
+		g_FrameBenchmark->RecordCounter("uniformCallsSkipped", stateStats.uniformCallsSkipped);
+		// allocations on every thread since the last frame was drawn,
+		// which stay at zero once the frame arenas have grown
+		if (HeapCounter::IsCounting() == true)
+		{
+			const uint64_t allocations = HeapCounter::GetAllocations();
+			g_FrameBenchmark->RecordCounter("heapAllocations", (double)(allocations - g_FrameAllocations));
+			g_FrameAllocations = allocations;
+		}
+		else
+		{
+			g_FrameBenchmark->RecordMissingCounter("heapAllocations");
+		}
+		const FRAME_ARENA_STATS& arenaStats = g_SceneManager->GetArenaStats();
+		g_FrameBenchmark->RecordCounter("arenaBytes", (double)arenaStats.bytesUsed);
+		g_FrameBenchmark->RecordCounter("arenaCapacity", (double)arenaStats.capacity);
+		g_FrameBenchmark->RecordCounter("arenaOverflows", arenaStats.overflows);
+		g_FrameBenchmark->EndFrame();
+	}
+}
+
+/***********************************************************
+ *	MakeContextCurrent()
+ *
+ *  This function is used to make the OpenGL context of the
+ *  window, or the headless context, current on the calling
+ *  thread, or to release it so another thread can use it.
+ ***********************************************************/
+bool MakeContextCurrent(bool bCurrent)
+{
+	if (NULL != g_HeadlessContext)
+	{
+		return(g_HeadlessContext->MakeCurrent(bCurrent));
+	}
+
+	glfwMakeContextCurrent(bCurrent ? g_Window : NULL);
+
+	return(true);
+}
+
+/***********************************************************
+ *	RunFramePipeline()
+ *
+ *  This function is used to update frames on this thread and
+ *  render them through the frame pipeline, until the window
+ *  is closed or the passed in number of frames is reached,
+ *  if it is not zero.  The events are polled right before
+ *  each update, so the input is as recent as possible.
+ ***********************************************************/
+bool RunFramePipeline(int frameLimit)
+{
+	FramePipeline pipeline(g_PipelineFrames, RenderFrame, MakeContextCurrent);
+	int frames = 0;
+
+	g_SceneManager->SetFrameCount(pipeline.GetFrameCount());
+	g_FrameViews.resize(pipeline.GetFrameCount());
+	if (pipeline.Start() == false)
+	{
+		return(false);
+	}
+
+	while ((frameLimit == 0) || (frames < frameLimit))
+	{
+		// query the latest GLFW events
+		if (NULL != g_Window)
+		{
+			glfwPollEvents();
+			if (glfwWindowShouldClose(g_Window))
+			{
+				break;
+			}
+		}
+
+		int frame = pipeline.BeginUpdate();
+		if (frame < 0)
+		{
+			break;
+		}
+		UpdateFrame(frame);
+		pipeline.EndUpdate();
+		frames++;
+	}
+
+	return(pipeline.Stop());
+}
+
+/***********************************************************
+ *	CreateScene()
+ *
+ *  This function is used to create the scene manager and
+ *  prepare the scene file, or a scene of the passed in number
+ *  of generated objects, replacing any scene manager there
+ *  already is.
+ ***********************************************************/
+bool CreateScene(int objectCount)
+{
+	if (NULL != g_SceneManager)
+	{
+		delete g_SceneManager;
+		g_SceneManager = NULL;
+	}
+
+	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager->SetTextureCompression(g_bCompressTextures);
+	g_SceneManager->SetOcclusionCulling(g_bOcclusionCulling);
+	g_SceneManager->SetProfiler(g_FrameProfiler);
+	g_SceneManager->SetTransformThreads(g_TransformThreads);
+
+	if (objectCount > 0)
+	{
+		return(g_SceneManager->PrepareGeneratedScene(g_SceneFilename, objectCount, g_GenerateSeed));
+	}
+
+	return(g_SceneManager->PrepareScene(g_SceneFilename));
+}
+
+/***********************************************************
+ *	MeasureFrames()
+ *
+ *  This function is used to render the warmup and measured
+ *  frames of the passed in benchmark into the offscreen
+ *  framebuffer, or into the window without waiting for the
+ *  vertical sync.  The frames are timed on the thread that
+ *  renders them.  Closing the window before the last frame
+ *  fails the benchmark.
+ ***********************************************************/
+bool MeasureFrames(FrameBenchmark& benchmark)
+{
+	// measure the scene with its real textures, not the placeholders
+	g_SceneManager->FinishTextureLoads();
+	if (NULL != g_HeadlessContext)
+	{
+		g_HeadlessContext->BindFramebuffer();
+	}
+	else
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glfwSwapInterval(0);
+	}
+
+	g_FrameBenchmark = &benchmark;
+	g_FrameAllocations = HeapCounter::GetAllocations();
+	bool bRendered = RunFramePipeline(g_BenchmarkWarmup + g_BenchmarkFrames);
+	g_FrameBenchmark = NULL;
+	if (bRendered == false)
+	{
+		return(false);
+	}
+	if (benchmark.IsComplete() == false)
+	{
+		std::cout << "Benchmark stopped before all of its frames were drawn" << std::endl;
+		return(false);
+	}
+
+	// wait for the last frames so that every GPU time is recorded
+	benchmark.Finish();
+
+	return(true);
+}
+
+/***********************************************************
+ *	RunHeadlessBenchmark()
+ *
+ *  This function is used to render a fixed number of frames
+ *  into the offscreen framebuffer and write the CPU and GPU
+ *  frame time statistics to the benchmark output file.
+ ***********************************************************/
+bool RunHeadlessBenchmark()
+{
+	FrameBenchmark benchmark(g_BenchmarkFrames, g_BenchmarkWarmup);
+
+	if (MeasureFrames(benchmark) == false)
+	{
+		return(false);
+	}
+
+	return(benchmark.WriteResults(
+		g_BenchmarkOutput,
+		(const char*)glGetString(GL_RENDERER)));
+}
+
+/***********************************************************
+ *	RunBenchmarkSweep()
+ *
+ *  This function is used to run the benchmark on a
+ *  generated scene of each object count of the sweep, from
+ *  the smallest up, and to write their results side by side
+ *  to the benchmark output file.  Each scene replaces the
+ *  one before, so the memory is measured with only one
+ *  scene loaded.
+ ***********************************************************/
+bool RunBenchmarkSweep()
+{
+	BenchmarkSweep sweep;
+
+	for (size_t i = 0; i < g_SweepCounts.size(); i++)
+	{
+		// the memory of the last scene is freed before measuring
+		if (NULL != g_SceneManager)
+		{
+			delete g_SceneManager;
+			g_SceneManager = NULL;
+		}
+		uint64_t memoryBefore = BenchmarkSweep::GetResidentMemory();
+		if (CreateScene(g_SweepCounts[i]) == false)
+		{
+			return(false);
+		}
+
+		FrameBenchmark benchmark(g_BenchmarkFrames, g_BenchmarkWarmup);
+		if (MeasureFrames(benchmark) == false)
+		{
+			return(false);
+		}
+		sweep.AddResult(g_SweepCounts[i], benchmark, memoryBefore,
+			BenchmarkSweep::GetResidentMemory());
+	}
+
+	return(sweep.WriteResults(
+		g_BenchmarkOutput,
+		(const char*)glGetString(GL_RENDERER),
+		g_GenerateSeed));
 }
 
 /***********************************************************
  *	InitializeGLFW()
  * 
- *  This function is used to initialize the GLFW library.   
+ *  This function is used to initialize the GLFW library.
+ *  The shaders need OpenGL 4.4, which macOS does not offer,
+ *  so the program stops there right away.
  ***********************************************************/
 bool InitializeGLFW()
 {
+#ifdef __APPLE__
+	std::cout << "This program requires OpenGL 4.4, and macOS only supports up to 4.1" << std::endl;
+	return(false);
+#else
 	// GLFW: initialize and configure library
 	// --------------------------------------
 	glfwInit();
 
-#ifdef __APPLE__
-	// set the version of OpenGL and profile to use
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#else
 	// set the version of OpenGL and profile to use
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-#endif
 	// GLFW: end -------------------------------
 
 	return(true);
+#endif
 }
 
 /***********************************************************
@@ -162,6 +842,14 @@ bool InitializeGLEW()
 
 	// try to initialize the GLEW library
 	GLEWInitResult = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	// GLEW built for GLX reports this for EGL contexts after it has
+	// already loaded the core OpenGL entry points, so it is harmless
+	if ((g_bHeadless == true) && (GLEW_ERROR_NO_GLX_DISPLAY == GLEWInitResult))
+	{
+		GLEWInitResult = GLEW_OK;
+	}
+#endif
 	if (GLEW_OK != GLEWInitResult)
 	{
 		std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
@@ -169,6 +857,18 @@ bool InitializeGLEW()
 	}
 	// GLEW: end -------------------------------
 
+	// the shaders use storage buffers and the draws take their base
+	// instance from indirect commands, which are OpenGL 4.4 and up
+	GLint majorVersion = 0;
+	GLint minorVersion = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+	glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+	if ((majorVersion < 4) || ((majorVersion == 4) && (minorVersion < 4)))
+	{
+		std::cout << "This program requires OpenGL 4.4, but the context is " << glGetString(GL_VERSION) << std::endl;
+		return false;
+	}
+
 	// Displays a successful OpenGL initialization message
 	std::cout << "INFO: OpenGL Successfully Initialized\n";
 	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
@@ -0,0 +1,242 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.cpp
+// ============
+// map a file read-only into memory
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MappedFile.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/***********************************************************
+ *  MappedFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MappedFile::MappedFile()
+{
+	m_data = NULL;
+	m_size = 0;
+	m_fileHandle = NULL;
+	m_mappingHandle = NULL;
+}
+
+/***********************************************************
+ *  ~MappedFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping the whole passed in file
+ *  into memory as read-only data.
+ ***********************************************************/
+bool MappedFile::Open(const char* filename)
+{
+	Close();
+
+#ifdef _WIN32
+	// sharing delete lets a newer file be renamed over this one
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (INVALID_HANDLE_VALUE == file)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if ((GetFileSizeEx(file, &fileSize) == FALSE) || (fileSize.QuadPart == 0) ||
+		((uint64_t)fileSize.QuadPart > (uint64_t)SIZE_MAX))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (NULL == mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (NULL == data)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_fileHandle = file;
+	m_mappingHandle = mapping;
+	m_data = (const unsigned char*)data;
+	m_size = (size_t)fileSize.QuadPart;
+#else
+	int file = open(filename, O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	struct stat fileInfo;
+	if ((fstat(file, &fileInfo) != 0) || (fileInfo.st_size <= 0))
+	{
+		close(file);
+		return false;
+	}
+
+	void* data = mmap(NULL, (size_t)fileInfo.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	// the mapping stays valid after the file is closed
+	close(file);
+	if (MAP_FAILED == data)
+	{
+		return false;
+	}
+
+	m_data = (const unsigned char*)data;
+	m_size = (size_t)fileInfo.st_size;
+#endif
+
+	return true;
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for unmapping the file from memory.
+ ***********************************************************/
+void MappedFile::Close()
+{
+	if (NULL == m_data)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_data);
+	CloseHandle((HANDLE)m_mappingHandle);
+	CloseHandle((HANDLE)m_fileHandle);
+#else
+	munmap((void*)m_data, m_size);
+#endif
+
+	m_data = NULL;
+	m_size = 0;
+	m_fileHandle = NULL;
+	m_mappingHandle = NULL;
+}
+
+/***********************************************************
+ *  GetFileStamp()
+ *
+ *  This method is used for getting the size and the last
+ *  modified time of a file, for noticing that it changed.
+ *  The time is as fine as the file system keeps it, so two
+ *  edits within the same second are still told apart.
+ ***********************************************************/
+bool MappedFile::GetFileStamp(const char* filename, uint64_t& size, uint64_t& modifiedTime)
+{
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA fileInfo;
+	if (GetFileAttributesExA(filename, GetFileExInfoStandard, &fileInfo) == FALSE)
+	{
+		return false;
+	}
+
+	size = ((uint64_t)fileInfo.nFileSizeHigh << 32) | fileInfo.nFileSizeLow;
+	modifiedTime = ((uint64_t)fileInfo.ftLastWriteTime.dwHighDateTime << 32) |
+		fileInfo.ftLastWriteTime.dwLowDateTime;
+#else
+	struct stat fileInfo;
+	if (stat(filename, &fileInfo) != 0)
+	{
+		return false;
+	}
+
+	size = (uint64_t)fileInfo.st_size;
+	modifiedTime = ((uint64_t)fileInfo.st_mtim.tv_sec * 1000000000ull) + (uint64_t)fileInfo.st_mtim.tv_nsec;
+#endif
+
+	return true;
+}
+
+/***********************************************************
+ *  HashData()
+ *
+ *  This method is used for hashing the contents of a file
+ *  with 64 bit FNV-1a, which is plenty to notice that a
+ *  file was edited, even when its size and modified time
+ *  stayed the same.
+ ***********************************************************/
+uint64_t MappedFile::HashData(const unsigned char* data, size_t size)
+{
+	uint64_t hash = 14695981039346656037ull;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= data[i];
+		hash *= 1099511628211ull;
+	}
+
+	return(hash);
+}
+
+/***********************************************************
+ *  SaveFile()
+ *
+ *  This method is used for writing cooked data.  The data is
+ *  written to a temporary file next to the passed in one,
+ *  which is then renamed over it.  Truncating a file that is
+ *  still mapped would cut the mapping short under whoever
+ *  uses it, while the renamed file leaves the old contents
+ *  alone until they are unmapped.
+ ***********************************************************/
+bool MappedFile::SaveFile(const char* filename, const unsigned char* data, size_t size)
+{
+	std::string temporaryFilename = std::string(filename) + ".tmp";
+
+	{
+		std::ofstream file(temporaryFilename.c_str(), std::ios::binary | std::ios::trunc);
+		if (file.is_open())
+		{
+			file.write((const char*)data, size);
+		}
+		if (!file.good())
+		{
+			file.close();
+			std::remove(temporaryFilename.c_str());
+			return false;
+		}
+	}
+
+#ifdef _WIN32
+	bool bReplaced = (MoveFileExA(temporaryFilename.c_str(), filename, MOVEFILE_REPLACE_EXISTING) != FALSE);
+#else
+	bool bReplaced = (std::rename(temporaryFilename.c_str(), filename) == 0);
+#endif
+	if (bReplaced == false)
+	{
+		std::remove(temporaryFilename.c_str());
+	}
+
+	return(bReplaced);
+}
@@ -0,0 +1,51 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.h
+// ============
+// map a file read-only into memory
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/***********************************************************
+ *  MappedFile
+ *
+ *  This class maps the contents of a file into memory so
+ *  that cooked data can be used in place, without reading
+ *  or parsing it first.
+ ***********************************************************/
+class MappedFile
+{
+public:
+	// constructor
+	MappedFile();
+	// destructor
+	~MappedFile();
+
+	// map the passed in file into memory
+	bool Open(const char* filename);
+	// unmap the file
+	void Close();
+
+	// get the mapped contents of the file
+	const unsigned char* GetData() const { return m_data; }
+	size_t GetSize() const { return m_size; }
+
+	// get the size and last modified time of a file
+	static bool GetFileStamp(const char* filename, uint64_t& size, uint64_t& modifiedTime);
+	// hash the contents of a file
+	static uint64_t HashData(const unsigned char* data, size_t size);
+	// write a whole file through a temporary file that replaces it,
+	// so that a mapping of the old contents is never cut short
+	static bool SaveFile(const char* filename, const unsigned char* data, size_t size);
+
+private:
+	// mapped contents of the file
+	const unsigned char* m_data;
+	size_t m_size;
+	// platform handles for the open file and its mapping
+	void* m_fileHandle;
+	void* m_mappingHandle;
+};
@@ -0,0 +1,327 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculler.cpp
+// ============
+// reject the scene objects that are hidden behind large occluders
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// size of the depth buffer - powers of two, so every level of the
+	// pyramid is exactly half of the level above
+	const int g_DepthWidth = 256;
+	const int g_DepthHeight = 128;
+	// normalized depth of the far plane, which the buffer is cleared to
+	const float g_FarDepth = 1.0f;
+}
+
+/***********************************************************
+ *  OcclusionCuller()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OcclusionCuller::OcclusionCuller()
+{
+	for (uint32_t mesh = 0; mesh < SCENE_MESH_COUNT; mesh++)
+	{
+		if (ShapeGeometry::IsRound(mesh) == false)
+		{
+			ShapeGeometry::Build(mesh, ShapeGeometry::DEFAULT_SLICES, m_shapes[mesh]);
+		}
+	}
+
+	int width = g_DepthWidth;
+	int height = g_DepthHeight;
+	while (true)
+	{
+		m_levels.push_back(std::vector<float>(width * height, g_FarDepth));
+		m_levelWidths.push_back(width);
+		m_levelHeights.push_back(height);
+		if ((width == 1) && (height == 1))
+		{
+			break;
+		}
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+
+	m_view = glm::mat4(1.0f);
+	m_projection = glm::mat4(1.0f);
+	m_viewProjection = glm::mat4(1.0f);
+	m_stats.occluders = 0;
+	m_stats.occluderTriangles = 0;
+	m_stats.objectsTested = 0;
+	m_stats.objectsOccluded = 0;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for clearing the depth buffer to the
+ *  far plane and the counts to zero, for a new view.
+ ***********************************************************/
+void OcclusionCuller::BeginFrame(const glm::mat4& view, const glm::mat4& projection)
+{
+	m_view = view;
+	m_projection = projection;
+	m_viewProjection = projection * view;
+
+	std::fill(m_levels[0].begin(), m_levels[0].end(), g_FarDepth);
+
+	m_stats.occluders = 0;
+	m_stats.occluderTriangles = 0;
+	m_stats.objectsTested = 0;
+	m_stats.objectsOccluded = 0;
+}
+
+/***********************************************************
+ *  AddOccluder()
+ *
+ *  This method is used for drawing the triangles of a shape
+ *  into the depth buffer at its world transform.  Both sides
+ *  of every triangle are drawn, and only the nearest depth
+ *  of each pixel is kept.
+ ***********************************************************/
+void OcclusionCuller::AddOccluder(uint32_t mesh, const glm::mat4& transform)
+{
+	if ((mesh >= SCENE_MESH_COUNT) || (IsOccluderShape(mesh) == false))
+	{
+		return;
+	}
+
+	const SHAPE_GEOMETRY& shape = m_shapes[mesh];
+	glm::mat4 clipTransform = m_viewProjection * transform;
+
+	m_clipVertices.resize(shape.vertices.size());
+	for (size_t i = 0; i < shape.vertices.size(); i++)
+	{
+		const float* position = shape.vertices[i].position;
+		m_clipVertices[i] = clipTransform * glm::vec4(position[0], position[1], position[2], 1.0f);
+	}
+
+	for (size_t i = 0; i + 2 < shape.indices.size(); i += 3)
+	{
+		RasterizeTriangle(m_clipVertices[shape.indices[i]],
+			m_clipVertices[shape.indices[i + 1]],
+			m_clipVertices[shape.indices[i + 2]]);
+	}
+
+	m_stats.occluders++;
+	m_stats.occluderTriangles += (int)(shape.indices.size() / 3);
+}
+
+/***********************************************************
+ *  RasterizeTriangle()
+ *
+ *  This method is used for drawing one triangle into the
+ *  depth buffer, at the pixels that it covers completely,
+ *  which are the ones with all four corners inside of it.
+ *  Each of them takes the farthest depth of the triangle over
+ *  the pixel, which is at one of its corners since the depth
+ *  is a plane in screen space.  That way a pixel only hides
+ *  what is behind the occluder everywhere in it, and objects
+ *  just past the edge of an occluder stay visible.  Triangles
+ *  that reach behind the near plane are skipped, which only
+ *  makes the occluder hide less than it could.
+ ***********************************************************/
+void OcclusionCuller::RasterizeTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+{
+	const glm::vec4* corners[3] = { &a, &b, &c };
+	float x[3];
+	float y[3];
+	float z[3];
+
+	for (int i = 0; i < 3; i++)
+	{
+		const glm::vec4& corner = *corners[i];
+		if ((corner.w <= 0.0f) || (corner.z < -corner.w))
+		{
+			return;
+		}
+		x[i] = ((corner.x / corner.w) * 0.5f + 0.5f) * g_DepthWidth;
+		y[i] = ((corner.y / corner.w) * 0.5f + 0.5f) * g_DepthHeight;
+		z[i] = corner.z / corner.w;
+	}
+
+	// twice the signed area, which also gives the winding
+	float area = ((x[1] - x[0]) * (y[2] - y[0])) - ((x[2] - x[0]) * (y[1] - y[0]));
+	if (std::fabs(area) < 1e-6f)
+	{
+		return;
+	}
+	float sign = (area > 0.0f) ? 1.0f : -1.0f;
+	float inverseArea = 1.0f / std::fabs(area);
+
+	// only the pixels that lie between the corners can be covered
+	int minX = std::max(0, (int)std::ceil(std::min(x[0], std::min(x[1], x[2]))));
+	int maxX = std::min(g_DepthWidth - 1, (int)std::floor(std::max(x[0], std::max(x[1], x[2]))) - 1);
+	int minY = std::max(0, (int)std::ceil(std::min(y[0], std::min(y[1], y[2]))));
+	int maxY = std::min(g_DepthHeight - 1, (int)std::floor(std::max(y[0], std::max(y[1], y[2]))) - 1);
+
+	// the edge functions are the weights of the opposite corners, and
+	// they and the depth change by a fixed step for each pixel
+	float stepX[3];
+	float stepY[3];
+	for (int i = 0; i < 3; i++)
+	{
+		int from = (i + 1) % 3;
+		int to = (i + 2) % 3;
+		stepX[i] = -sign * (y[to] - y[from]);
+		stepY[i] = sign * (x[to] - x[from]);
+	}
+	float depthStepX = ((stepX[0] * z[0]) + (stepX[1] * z[1]) + (stepX[2] * z[2])) * inverseArea;
+	float depthStepY = ((stepY[0] * z[0]) + (stepY[1] * z[1]) + (stepY[2] * z[2])) * inverseArea;
+	float farthestStep = std::max(depthStepX, 0.0f) + std::max(depthStepY, 0.0f);
+
+	std::vector<float>& depth = m_levels[0];
+	for (int py = minY; py <= maxY; py++)
+	{
+		for (int px = minX; px <= maxX; px++)
+		{
+			// weights at the lower left corner of the pixel, and the
+			// smallest of each over its four corners
+			float weight[3];
+			bool bCovered = true;
+			for (int i = 0; (i < 3) && (bCovered == true); i++)
+			{
+				int from = (i + 1) % 3;
+				weight[i] = (stepX[i] * (px - x[from])) + (stepY[i] * (py - y[from]));
+				bCovered = (weight[i] + std::min(stepX[i], 0.0f) + std::min(stepY[i], 0.0f)) >= 0.0f;
+			}
+			if (bCovered == false)
+			{
+				continue;
+			}
+
+			float cornerDepth = ((weight[0] * z[0]) + (weight[1] * z[1]) + (weight[2] * z[2])) * inverseArea;
+			float& pixel = depth[(py * g_DepthWidth) + px];
+			pixel = std::min(pixel, cornerDepth + farthestStep);
+		}
+	}
+}
+
+/***********************************************************
+ *  BuildPyramid()
+ *
+ *  This method is used for filling each level of the depth
+ *  pyramid with the farthest depth of the 2 by 2 block of
+ *  the level above that each of its texels covers.
+ ***********************************************************/
+void OcclusionCuller::BuildPyramid()
+{
+	for (size_t level = 1; level < m_levels.size(); level++)
+	{
+		const std::vector<float>& source = m_levels[level - 1];
+		const int sourceWidth = m_levelWidths[level - 1];
+		const int sourceHeight = m_levelHeights[level - 1];
+		std::vector<float>& target = m_levels[level];
+		const int width = m_levelWidths[level];
+		const int height = m_levelHeights[level];
+
+		for (int y = 0; y < height; y++)
+		{
+			int y0 = std::min(y * 2, sourceHeight - 1);
+			int y1 = std::min((y * 2) + 1, sourceHeight - 1);
+			for (int x = 0; x < width; x++)
+			{
+				int x0 = std::min(x * 2, sourceWidth - 1);
+				int x1 = std::min((x * 2) + 1, sourceWidth - 1);
+				target[(y * width) + x] = std::max(
+					std::max(source[(y0 * sourceWidth) + x0], source[(y0 * sourceWidth) + x1]),
+					std::max(source[(y1 * sourceWidth) + x0], source[(y1 * sourceWidth) + x1]));
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  IsOccluded()
+ *
+ *  This method is used for checking whether a sphere is
+ *  hidden.  The box around the sphere in view space is
+ *  projected, and the sphere is hidden when the depth of its
+ *  nearest corner is behind the farthest depth of the
+ *  pyramid texels under the screen rectangle of the box.
+ *  Spheres that reach behind the near plane are visible.
+ ***********************************************************/
+bool OcclusionCuller::IsOccluded(const glm::vec4& sphere)
+{
+	m_stats.objectsTested++;
+
+	glm::vec4 center = m_view * glm::vec4(sphere.x, sphere.y, sphere.z, 1.0f);
+	float minX = 0.0f;
+	float maxX = 0.0f;
+	float minY = 0.0f;
+	float maxY = 0.0f;
+	float minZ = 0.0f;
+
+	for (int corner = 0; corner < 8; corner++)
+	{
+		glm::vec4 offset(
+			(corner & 1) ? sphere.w : -sphere.w,
+			(corner & 2) ? sphere.w : -sphere.w,
+			(corner & 4) ? sphere.w : -sphere.w,
+			0.0f);
+		glm::vec4 clip = m_projection * (center + offset);
+		if ((clip.w <= 0.0f) || (clip.z < -clip.w))
+		{
+			return(false);
+		}
+
+		float x = ((clip.x / clip.w) * 0.5f + 0.5f) * g_DepthWidth;
+		float y = ((clip.y / clip.w) * 0.5f + 0.5f) * g_DepthHeight;
+		float z = clip.z / clip.w;
+		minX = (corner == 0) ? x : std::min(minX, x);
+		maxX = (corner == 0) ? x : std::max(maxX, x);
+		minY = (corner == 0) ? y : std::min(minY, y);
+		maxY = (corner == 0) ? y : std::max(maxY, y);
+		minZ = (corner == 0) ? z : std::min(minZ, z);
+	}
+
+	// every pixel that the rectangle touches, clamped to the screen
+	int x0 = std::max(0, (int)std::floor(minX));
+	int x1 = std::min(g_DepthWidth - 1, (int)std::floor(maxX));
+	int y0 = std::max(0, (int)std::floor(minY));
+	int y1 = std::min(g_DepthHeight - 1, (int)std::floor(maxY));
+	if ((x0 > x1) || (y0 > y1))
+	{
+		return(false);
+	}
+
+	// go down the pyramid until the rectangle covers at most two
+	// texels each way
+	size_t level = 0;
+	while (((x1 - x0) > 1) || ((y1 - y0) > 1))
+	{
+		if (level + 1 >= m_levels.size())
+		{
+			break;
+		}
+		x0 /= 2;
+		x1 /= 2;
+		y0 /= 2;
+		y1 /= 2;
+		level++;
+	}
+
+	const std::vector<float>& depth = m_levels[level];
+	const int width = m_levelWidths[level];
+	for (int y = y0; y <= y1; y++)
+	{
+		for (int x = x0; x <= x1; x++)
+		{
+			if (depth[(y * width) + x] >= minZ)
+			{
+				return(false);
+			}
+		}
+	}
+
+	m_stats.objectsOccluded++;
+	return(true);
+}
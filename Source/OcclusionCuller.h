@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculler.h
+// ============
+// reject the scene objects that are hidden behind large occluders
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShapeGeometry.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// counts of the occlusion culling of a frame
+struct OCCLUSION_STATS
+{
+	// objects drawn into the depth buffer, and their triangles
+	int occluders;
+	int occluderTriangles;
+	// bounding spheres tested against the depth buffer, and the ones
+	// that were found hidden
+	int objectsTested;
+	int objectsOccluded;
+};
+
+/***********************************************************
+ *  OcclusionCuller
+ *
+ *  This class contains a small depth buffer that the large
+ *  objects in front of the camera are drawn into in software
+ *  at the start of every frame, and a pyramid of the farthest
+ *  depth of each block of it.  A bounding sphere is hidden
+ *  when the nearest point of its box is behind the farthest
+ *  depth of every pixel that the box covers on the screen,
+ *  and the pyramid level where the box covers at most two by
+ *  two texels answers that with a few reads.  Only the shapes
+ *  with flat sides are occluders, since their triangles are
+ *  the same at every level of detail, so a round shape drawn
+ *  at a coarse level can never hide more than it covers.  It
+ *  makes no OpenGL calls, so it runs on the update thread.
+ ***********************************************************/
+class OcclusionCuller
+{
+public:
+	// constructor - builds the triangles of the occluder shapes
+	OcclusionCuller();
+
+	// clear the depth buffer for the view of a new frame
+	void BeginFrame(const glm::mat4& view, const glm::mat4& projection);
+	// check whether a shape can be used as an occluder
+	bool IsOccluderShape(uint32_t mesh) const { return !m_shapes[mesh].indices.empty(); }
+	// draw a shape with its world transform into the depth buffer
+	void AddOccluder(uint32_t mesh, const glm::mat4& transform);
+	// build the depth pyramid, after the occluders have been added
+	void BuildPyramid();
+	// check whether a world space sphere, with the center in xyz and
+	// the radius in w, is hidden behind the occluders
+	bool IsOccluded(const glm::vec4& sphere);
+
+	// get the counts of the current frame
+	const OCCLUSION_STATS& GetStats() const { return m_stats; }
+
+private:
+	// triangles of the shapes that can be occluders, and none for the
+	// round shapes
+	SHAPE_GEOMETRY m_shapes[SCENE_MESH_COUNT];
+	glm::mat4 m_view;
+	glm::mat4 m_projection;
+	glm::mat4 m_viewProjection;
+	// normalized depth of the nearest occluder at each pixel, then
+	// the farthest depth of each 2 by 2 block of the level above
+	std::vector<std::vector<float> > m_levels;
+	std::vector<int> m_levelWidths;
+	std::vector<int> m_levelHeights;
+	// clip space corners of the occluder being drawn
+	std::vector<glm::vec4> m_clipVertices;
+	OCCLUSION_STATS m_stats;
+
+	// draw a clip space triangle into the depth buffer
+	void RasterizeTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+};
@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.cpp
+// ============
+// collect draw packets and sort them to minimize state changes
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <new>
+
+// declaration of global variables
+namespace
+{
+	// bit layout of the state key, from most to least significant:
+	//   translucent (1) | cull mode (2) | texture array (12) | mesh (4) |
+	//   level of detail (2) | material (11)
+	// the texture array and material handles are stored plus one, so
+	// handles past 4094 texture arrays and 2046 materials no longer fit
+	// and all share the largest value of their field
+	const uint32_t g_TranslucentShift = 31;
+	const uint32_t g_CullShift = 29;
+	const uint32_t g_TextureShift = 17;
+	const uint32_t g_MeshShift = 13;
+	const uint32_t g_LodShift = 11;
+	const uint32_t g_MaterialShift = 0;
+	const uint32_t g_TextureMask = 0xFFF;
+	const uint32_t g_MaterialMask = 0x7FF;
+	const uint32_t g_MeshMask = 0xF;
+	const uint32_t g_LodMask = 0x3;
+}
+
+/***********************************************************
+ *  RenderQueue()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderQueue::RenderQueue()
+{
+	Clear();
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the packets from
+ *  the queue, along with the room for them, before the arena
+ *  that held them is reset or goes away.
+ ***********************************************************/
+void RenderQueue::Clear()
+{
+	m_packets = NULL;
+	m_count = 0;
+	m_capacity = 0;
+	m_sortKeys = NULL;
+}
+
+/***********************************************************
+ *  Begin()
+ *
+ *  This method is used for emptying the queue for a new
+ *  frame, with room for up to the passed in number of
+ *  packets and their sort keys in the arena of the frame.
+ ***********************************************************/
+void RenderQueue::Begin(FrameArena& arena, int capacity)
+{
+	m_packets = arena.AllocateArray<DRAW_PACKET>(capacity);
+	m_sortKeys = arena.AllocateArray<uint64_t>(capacity);
+	m_count = 0;
+	m_capacity = std::max(0, capacity);
+}
+
+/***********************************************************
+ *  Submit()
+ *
+ *  This method is used for adding a draw packet to the queue.
+ ***********************************************************/
+bool RenderQueue::Submit(const DRAW_PACKET& packet)
+{
+	if (m_count >= m_capacity)
+	{
+		return false;
+	}
+
+	new (&m_packets[m_count]) DRAW_PACKET(packet);
+	m_count++;
+	return true;
+}
+
+/***********************************************************
+ *  Sort()
+ *
+ *  This method is used for sorting the packets by their state
+ *  key.  Only the keys are sorted, and the packet index in
+ *  the low bits keeps equal states in submission order.
+ ***********************************************************/
+void RenderQueue::Sort()
+{
+	for (int i = 0; i < m_count; i++)
+	{
+		m_sortKeys[i] = ((uint64_t)MakeStateKey(m_packets[i]) << 32) | (uint32_t)i;
+	}
+
+	std::sort(m_sortKeys, m_sortKeys + m_count);
+}
+
+/***********************************************************
+ *  MakeStateKey()
+ *
+ *  This method is used for packing the state of a packet into
+ *  a key where the most expensive state to change is in the
+ *  highest bits.  The material is read per instance, so it
+ *  only keeps the instances of a shape in a steady order.
+ *  Handles too large for their field are clamped to its
+ *  largest value instead of wrapping around onto the handles
+ *  of others, so those packets stay together after the rest,
+ *  in the order they were submitted.  Translucent packets
+ *  only get the top bit so that they keep their submission
+ *  order.
+ ***********************************************************/
+uint32_t RenderQueue::MakeStateKey(const DRAW_PACKET& packet)
+{
+	if (packet.color.a < 1.0f)
+	{
+		return(1u << g_TranslucentShift);
+	}
+
+	// none is stored as zero, so the handles are offset by one
+	uint32_t texture = std::min((uint32_t)(packet.textureArray + 1), g_TextureMask);
+	uint32_t material = std::min((uint32_t)(packet.material + 1), g_MaterialMask);
+
+	return((packet.cullMode << g_CullShift) |
+		(texture << g_TextureShift) |
+		((packet.mesh & g_MeshMask) << g_MeshShift) |
+		((packet.lod & g_LodMask) << g_LodShift) |
+		(material << g_MaterialShift));
+}
@@ -0,0 +1,115 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.h
+// ============
+// collect draw packets and sort them to minimize state changes
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FrameArena.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+// raster state of a draw packet
+enum DRAW_CULL_MODE
+{
+	DRAW_CULL_NONE = 0,
+	DRAW_CULL_BACK,
+	DRAW_CULL_FRONT
+};
+
+// everything needed for issuing one draw
+struct DRAW_PACKET
+{
+	uint32_t mesh;
+	// level of detail of the shape
+	uint32_t lod;
+	// texture loader handle, and the texture array and layer that it
+	// is drawn from, filled in on the OpenGL thread before sorting
+	int texture;
+	// texture array and layer, and material handle, or -1 for none
+	int textureArray;
+	int textureLayer;
+	int material;
+	uint32_t cullMode;
+	glm::vec4 color;
+	glm::vec2 uvScale;
+	glm::mat4 transform;
+};
+
+// counts of the state changes of one flushed queue
+struct RENDER_QUEUE_STATS
+{
+	int draws;
+	// instanced draws that the packets were grouped into, and the
+	// multi-draw calls that submitted them
+	int drawCalls;
+	int multiDraws;
+	// triangles of all of the instances together
+	int triangles;
+	// state changes that were sent to OpenGL
+	int stateChanges;
+	// state changes skipped because the value was already set
+	int stateChangesAvoided;
+	// world transforms that had to be recalculated for the frame
+	int transformUpdates;
+	// drawable objects inside and outside of the view frustum, and
+	// the ones inside that were hidden behind other objects
+	int objectsVisible;
+	int objectsCulled;
+	int objectsOccluded;
+};
+
+/***********************************************************
+ *  RenderQueue
+ *
+ *  This class collects the draw packets of a frame and sorts
+ *  them by a key packed from their state, so that draws with
+ *  the same raster state, texture array and shape end up
+ *  next to each other.  Translucent packets are kept in the order
+ *  they were submitted and are drawn after everything else.
+ *  The keys are packed when sorting, so a packet can still be
+ *  changed after it was submitted.  The packets and keys live
+ *  in the arena of the frame, which has to hold room for every
+ *  packet before the first one is submitted.
+ ***********************************************************/
+class RenderQueue
+{
+public:
+	// constructor
+	RenderQueue();
+
+	// remove all packets and their memory
+	void Clear();
+	// remove all packets, and make room for the passed in number of
+	// packets in the arena of the frame
+	void Begin(FrameArena& arena, int capacity);
+	// add a packet to the queue, returns false when it is full
+	bool Submit(const DRAW_PACKET& packet);
+	// sort the packets by their state key
+	void Sort();
+
+	// get the number of packets in the queue
+	int GetCount() const { return m_count; }
+	// get a packet in submission order, which can be changed until
+	// Sort() is called
+	DRAW_PACKET& GetPacket(int index) { return m_packets[index]; }
+	// get a packet in sorted order, after Sort() was called
+	const DRAW_PACKET& GetSorted(int index) const
+	{
+		return m_packets[(uint32_t)(m_sortKeys[index] & 0xFFFFFFFFu)];
+	}
+
+private:
+	// submitted packets, in submission order, and the room for them
+	DRAW_PACKET* m_packets;
+	int m_count;
+	int m_capacity;
+	// state key in the upper 32 bits and packet index in the lower
+	uint64_t* m_sortKeys;
+
+	// pack the state of a packet into its sort key
+	static uint32_t MakeStateKey(const DRAW_PACKET& packet);
+};
@@ -0,0 +1,853 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.cpp
+// ============
+// load scene descriptions from text files and cooked binary files
+//
+//  Scenes are authored as text (see Scenes/desk.scene for the format)
+//  and cooked on first load into a binary file next to the text file.
+//  The cooked file is memory mapped and its object table is used by the
+//  renderer as-is.  The cooked layout is little-endian only.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneFile.h"
+#include "TagRegistry.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// declaration of global variables
+namespace
+{
+	// identifies cooked scene files and their layout version
+	const char g_CookedMagic[4] = { 'S', 'C', 'N', 'B' };
+	const uint32_t g_CookedVersion = 4;
+	// cooked files are named after the text file with this appended
+	const std::string g_CookedSuffix = "bin";
+	const std::string g_CookedExtension = ".scenebin";
+
+	static_assert(sizeof(SCENE_OBJECT) == 72, "cooked object layout changed");
+	static_assert(sizeof(SCENE_MATERIAL_RECORD) == 48, "cooked material layout changed");
+	static_assert(sizeof(SCENE_LIGHT_RECORD) == 64, "cooked light layout changed");
+	static_assert(sizeof(SCENE_FILE_HEADER) == 64, "cooked header layout changed");
+
+	/***********************************************************
+	 *  ParseFloats()
+	 *
+	 *  Parse a comma separated list of exactly count numbers.
+	 ***********************************************************/
+	bool ParseFloats(const std::string& text, float* values, int count)
+	{
+		const char* cursor = text.c_str();
+
+		for (int i = 0; i < count; i++)
+		{
+			char* end = NULL;
+			values[i] = std::strtof(cursor, &end);
+			if (end == cursor)
+			{
+				return false;
+			}
+			cursor = end;
+
+			// values are separated by commas and the list must end after the last
+			if (i + 1 < count)
+			{
+				if (*cursor != ',')
+					return false;
+				cursor++;
+			}
+		}
+
+		return(*cursor == '\0');
+	}
+
+	/***********************************************************
+	 *  AppendRecords()
+	 *
+	 *  Append a table of records to the cooked data, aligned
+	 *  to four bytes, and return its offset.
+	 ***********************************************************/
+	template <typename T>
+	uint32_t AppendRecords(std::vector<unsigned char>& cooked, const T* records, size_t count)
+	{
+		while ((cooked.size() % 4) != 0)
+		{
+			cooked.push_back(0);
+		}
+
+		uint32_t offset = (uint32_t)cooked.size();
+		const unsigned char* bytes = (const unsigned char*)records;
+		cooked.insert(cooked.end(), bytes, bytes + (count * sizeof(T)));
+
+		return(offset);
+	}
+
+	/***********************************************************
+	 *  TableFits()
+	 *
+	 *  Check that a table of records lies inside the data.
+	 ***********************************************************/
+	bool TableFits(uint32_t offset, uint32_t count, size_t recordSize, size_t dataSize)
+	{
+		return((offset % 4) == 0) &&
+			(offset <= dataSize) &&
+			(count <= (dataSize - offset) / recordSize);
+	}
+}
+
+/***********************************************************
+ *  SceneFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneFile::SceneFile()
+{
+	m_header = NULL;
+	m_textures = NULL;
+	m_materials = NULL;
+	m_objects = NULL;
+	m_lights = NULL;
+	m_strings = NULL;
+}
+
+/***********************************************************
+ *  ~SceneFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneFile::~SceneFile()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for loading a scene.  When the cooked
+ *  file next to the text file was cooked from the same text
+ *  it is mapped and used directly, otherwise the text file
+ *  is parsed and cooked again.  A cooked file can also be
+ *  loaded on its own.
+ ***********************************************************/
+bool SceneFile::Load(const char* filename)
+{
+	Close();
+
+	std::string sourceFilename = filename;
+	std::string cookedFilename = sourceFilename + g_CookedSuffix;
+
+	// a cooked file was passed in, so there is no text to check against
+	if (IsCookedFile(sourceFilename))
+	{
+		cookedFilename = sourceFilename;
+		sourceFilename.clear();
+	}
+
+	// the text is hashed rather than stamped, since an edit that keeps
+	// the size can land within the resolution of the modified time
+	uint64_t sourceSize = 0;
+	uint64_t sourceHash = 0;
+	bool bHasSource = false;
+	if (sourceFilename.empty() == false)
+	{
+		MappedFile sourceFile;
+		if (sourceFile.Open(sourceFilename.c_str()))
+		{
+			sourceSize = sourceFile.GetSize();
+			sourceHash = MappedFile::HashData(sourceFile.GetData(), sourceFile.GetSize());
+			bHasSource = true;
+		}
+	}
+
+	// try the cooked file first, it is only stale if the text changed
+	if (m_mappedFile.Open(cookedFilename.c_str()))
+	{
+		if (AttachCooked(m_mappedFile.GetData(), m_mappedFile.GetSize()) &&
+			((bHasSource == false) ||
+			((m_header->sourceSize == sourceSize) && (m_header->sourceHash == sourceHash))))
+		{
+			std::cout << "Loaded cooked scene:" << cookedFilename << ", objects:" << GetObjectCount() << std::endl;
+			return true;
+		}
+		Close();
+	}
+
+	if (bHasSource == false)
+	{
+		std::cout << "Could not load scene:" << filename << std::endl;
+		return false;
+	}
+
+	SCENE_SOURCE source;
+	if (ParseText(sourceFilename.c_str(), source) == false)
+	{
+		return false;
+	}
+
+	Cook(source, sourceSize, sourceHash, m_cookedData);
+
+	// save the cooked scene for the next run, failing to is not fatal
+	if (MappedFile::SaveFile(cookedFilename.c_str(), m_cookedData.data(), m_cookedData.size()) == false)
+	{
+		std::cout << "Could not save cooked scene:" << cookedFilename << std::endl;
+	}
+
+	if (AttachCooked(m_cookedData.data(), m_cookedData.size()) == false)
+	{
+		Close();
+		return false;
+	}
+
+	std::cout << "Cooked scene:" << sourceFilename << ", objects:" << GetObjectCount() << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  LoadText()
+ *
+ *  This method is used for loading a scene from its text
+ *  file without reading or writing the cooked file, so that
+ *  a scene that changed can be compared with the one that is
+ *  in use, which may be mapped from the cooked file.
+ ***********************************************************/
+bool SceneFile::LoadText(const char* filename)
+{
+	Close();
+
+	uint64_t sourceSize = 0;
+	uint64_t sourceHash = 0;
+	{
+		MappedFile sourceFile;
+		if (sourceFile.Open(filename) == false)
+		{
+			std::cout << "Could not load scene:" << filename << std::endl;
+			return false;
+		}
+		sourceSize = sourceFile.GetSize();
+		sourceHash = MappedFile::HashData(sourceFile.GetData(), sourceFile.GetSize());
+	}
+
+	SCENE_SOURCE source;
+	if (ParseText(filename, source) == false)
+	{
+		return false;
+	}
+
+	Cook(source, sourceSize, sourceHash, m_cookedData);
+	if (AttachCooked(m_cookedData.data(), m_cookedData.size()) == false)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  LoadSource()
+ *
+ *  This method is used for loading a scene description that
+ *  was built in memory.  It is cooked in memory like a text
+ *  file that changed, and there is no file to save it to.
+ ***********************************************************/
+bool SceneFile::LoadSource(const SCENE_SOURCE& source)
+{
+	Close();
+
+	Cook(source, 0, 0, m_cookedData);
+	if (AttachCooked(m_cookedData.data(), m_cookedData.size()) == false)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for releasing the scene data.
+ ***********************************************************/
+void SceneFile::Close()
+{
+	m_header = NULL;
+	m_textures = NULL;
+	m_materials = NULL;
+	m_objects = NULL;
+	m_lights = NULL;
+	m_strings = NULL;
+	m_mappedFile.Close();
+	m_cookedData.clear();
+}
+
+/***********************************************************
+ *  IsCookedFile()
+ *
+ *  This method is used for checking whether a file name ends
+ *  with the extension of the cooked scene files.
+ ***********************************************************/
+bool SceneFile::IsCookedFile(const std::string& filename)
+{
+	return((filename.size() > g_CookedExtension.size()) &&
+		(filename.compare(filename.size() - g_CookedExtension.size(),
+			g_CookedExtension.size(), g_CookedExtension) == 0));
+}
+
+/***********************************************************
+ *  ParseText()
+ *
+ *  This method is used for parsing a scene text file.  Each
+ *  line holds one texture, material, group, object or light, and the
+ *  values are given as key=value pairs separated by spaces.
+ ***********************************************************/
+bool SceneFile::ParseText(const char* filename, SCENE_SOURCE& source)
+{
+	std::ifstream input(filename);
+	if (!input.is_open())
+	{
+		std::cout << "Could not open scene:" << filename << std::endl;
+		return false;
+	}
+
+	TagRegistry textureTags;
+	TagRegistry materialTags;
+	// object names, and the object that each name handle belongs to
+	TagRegistry objectNames;
+	std::vector<int> namedObjects;
+	// tags referenced by objects are resolved once the whole file is read
+	std::vector<std::string> objectTextures;
+	std::vector<std::string> objectMaterials;
+	std::vector<int> objectLines;
+
+	std::string line;
+	int lineNumber = 0;
+	bool bResult = true;
+
+	while (std::getline(input, line) && bResult)
+	{
+		lineNumber++;
+
+		// strip comments
+		size_t comment = line.find('#');
+		if (comment != std::string::npos)
+		{
+			line.erase(comment);
+		}
+
+		std::istringstream tokens(line);
+		std::string kind;
+		if (!(tokens >> kind))
+		{
+			continue;
+		}
+
+		std::string error;
+
+		if (kind == "texture")
+		{
+			std::string tag;
+			std::string path;
+			if (!(tokens >> tag >> path))
+			{
+				error = "texture needs a tag and a file";
+			}
+			else if (textureTags.Intern(tag) < (int)source.textureTags.size())
+			{
+				error = "texture is defined twice:" + tag;
+			}
+			else
+			{
+				source.textureTags.push_back(tag);
+				source.texturePaths.push_back(path);
+			}
+		}
+		else if (kind == "material")
+		{
+			std::string tag;
+			SCENE_MATERIAL_RECORD material;
+			std::memset(&material, 0, sizeof(material));
+			material.shininess = 1.0f;
+
+			std::string value;
+			if (!(tokens >> tag))
+			{
+				error = "material needs a tag";
+			}
+			while (error.empty() && (tokens >> value))
+			{
+				size_t split = value.find('=');
+				std::string key = value.substr(0, split);
+				std::string text = (split == std::string::npos) ? "" : value.substr(split + 1);
+				bool bValid = false;
+
+				if (key == "ambientColor")
+					bValid = ParseFloats(text, material.ambientColor, 3);
+				else if (key == "ambientStrength")
+					bValid = ParseFloats(text, &material.ambientStrength, 1);
+				else if (key == "diffuseColor")
+					bValid = ParseFloats(text, material.diffuseColor, 3);
+				else if (key == "specularColor")
+					bValid = ParseFloats(text, material.specularColor, 3);
+				else if (key == "shininess")
+					bValid = ParseFloats(text, &material.shininess, 1);
+
+				if (bValid == false)
+				{
+					error = "invalid material value:" + value;
+				}
+			}
+
+			if (error.empty())
+			{
+				if (materialTags.Intern(tag) < (int)source.materialTags.size())
+				{
+					error = "material is defined twice:" + tag;
+				}
+				else
+				{
+					source.materialTags.push_back(tag);
+					source.materials.push_back(material);
+				}
+			}
+		}
+		else if ((kind == "object") || (kind == "group"))
+		{
+			bool bGroup = (kind == "group");
+			SCENE_OBJECT object;
+			std::memset(&object, 0, sizeof(object));
+			object.texture = -1;
+			object.material = -1;
+			object.color[0] = object.color[1] = object.color[2] = object.color[3] = 255;
+			object.uvScale[0] = object.uvScale[1] = 1.0f;
+			object.scale[0] = object.scale[1] = object.scale[2] = 1.0f;
+			object.parent = -1;
+
+			std::string textureTag;
+			std::string materialTag;
+			std::string meshName;
+			std::string name;
+			std::string value;
+
+			if (bGroup)
+			{
+				// groups are named by their first value instead of a mesh
+				object.flags |= SCENE_OBJECT_GROUP;
+				if (!(tokens >> name))
+				{
+					error = "group needs a name";
+				}
+			}
+			else if (!(tokens >> meshName))
+			{
+				error = "object needs a mesh";
+			}
+			else
+			{
+				object.mesh = SCENE_MESH_COUNT;
+				for (int mesh = 0; mesh < SCENE_MESH_COUNT; mesh++)
+				{
+					if (meshName == ShapeGeometry::GetMeshName(mesh))
+						object.mesh = mesh;
+				}
+				if (object.mesh == SCENE_MESH_COUNT)
+				{
+					error = "unknown mesh:" + meshName;
+				}
+			}
+
+			while (error.empty() && (tokens >> value))
+			{
+				size_t split = value.find('=');
+				std::string key = value.substr(0, split);
+				std::string text = (split == std::string::npos) ? "" : value.substr(split + 1);
+				bool bValid = false;
+
+				if (key == "scale")
+					bValid = ParseFloats(text, object.scale, 3);
+				else if (key == "rotation")
+					bValid = ParseFloats(text, object.rotation, 3);
+				else if (key == "position")
+					bValid = ParseFloats(text, object.position, 3);
+				else if (key == "parent")
+				{
+					// the parent has to be defined before its children
+					int handle = objectNames.Find(text);
+					if (handle != TagRegistry::INVALID_TAG)
+						object.parent = namedObjects[handle];
+					bValid = (handle != TagRegistry::INVALID_TAG);
+				}
+				else if (bGroup)
+					bValid = false;
+				else if (key == "name")
+				{
+					name = text;
+					bValid = (text.empty() == false);
+				}
+				else if (key == "uvScale")
+					bValid = ParseFloats(text, object.uvScale, 2);
+				else if (key == "color")
+				{
+					// red, green and blue from 0 to 255, with an optional alpha
+					float color[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+					bValid = ParseFloats(text, color, 3) || ParseFloats(text, color, 4);
+					for (int i = 0; i < 4; i++)
+					{
+						object.color[i] = (uint8_t)std::max(0.0f, std::min(255.0f, color[i]));
+					}
+				}
+				else if (key == "texture")
+				{
+					textureTag = text;
+					bValid = (text.empty() == false);
+				}
+				else if (key == "material")
+				{
+					materialTag = text;
+					bValid = (text.empty() == false);
+				}
+				else if (key == "cull")
+				{
+					bValid = true;
+					if (text == "front")
+						object.flags |= SCENE_OBJECT_CULL_FRONT;
+					else if (text == "back")
+						object.flags |= SCENE_OBJECT_CULL_BACK;
+					else if (text != "none")
+						bValid = false;
+				}
+
+				if (bValid == false)
+				{
+					error = "invalid object value:" + value;
+				}
+			}
+
+			if (error.empty() && (name.empty() == false))
+			{
+				if (objectNames.Intern(name) < (int)namedObjects.size())
+				{
+					error = "name is used twice:" + name;
+				}
+				else
+				{
+					namedObjects.push_back((int)source.objects.size());
+				}
+			}
+
+			if (error.empty())
+			{
+				source.objects.push_back(object);
+				source.objectNames.push_back(name);
+				objectTextures.push_back(textureTag);
+				objectMaterials.push_back(materialTag);
+				objectLines.push_back(lineNumber);
+			}
+		}
+		else if (kind == "light")
+		{
+			SCENE_LIGHT_RECORD light;
+			std::memset(&light, 0, sizeof(light));
+			light.focalStrength = 1.0f;
+			light.parent = -1;
+
+			std::string value;
+			while (error.empty() && (tokens >> value))
+			{
+				size_t split = value.find('=');
+				std::string key = value.substr(0, split);
+				std::string text = (split == std::string::npos) ? "" : value.substr(split + 1);
+				bool bValid = false;
+
+				if (key == "position")
+					bValid = ParseFloats(text, light.position, 3);
+				else if (key == "radius")
+					bValid = ParseFloats(text, &light.radius, 1) && (light.radius >= 0.0f);
+				else if (key == "ambientColor")
+					bValid = ParseFloats(text, light.ambientColor, 3);
+				else if (key == "diffuseColor")
+					bValid = ParseFloats(text, light.diffuseColor, 3);
+				else if (key == "specularColor")
+					bValid = ParseFloats(text, light.specularColor, 3);
+				else if (key == "focalStrength")
+					bValid = ParseFloats(text, &light.focalStrength, 1);
+				else if (key == "specularIntensity")
+					bValid = ParseFloats(text, &light.specularIntensity, 1);
+				else if (key == "parent")
+				{
+					int handle = objectNames.Find(text);
+					if (handle != TagRegistry::INVALID_TAG)
+						light.parent = namedObjects[handle];
+					bValid = (handle != TagRegistry::INVALID_TAG);
+				}
+
+				if (bValid == false)
+				{
+					error = "invalid light value:" + value;
+				}
+			}
+
+			if (error.empty())
+			{
+				source.lights.push_back(light);
+			}
+		}
+		else
+		{
+			error = "unknown entry:" + kind;
+		}
+
+		if (error.empty() == false)
+		{
+			std::cout << filename << ":" << lineNumber << ": " << error << std::endl;
+			bResult = false;
+		}
+	}
+
+	// resolve the texture and material tags of the objects into
+	// indexes of the texture and material tables
+	for (size_t i = 0; (i < source.objects.size()) && bResult; i++)
+	{
+		if (objectTextures[i].empty() == false)
+		{
+			source.objects[i].texture = textureTags.Find(objectTextures[i]);
+			if (source.objects[i].texture < 0)
+			{
+				std::cout << filename << ":" << objectLines[i] << ": unknown texture:" << objectTextures[i] << std::endl;
+				bResult = false;
+			}
+		}
+		if (objectMaterials[i].empty() == false)
+		{
+			source.objects[i].material = materialTags.Find(objectMaterials[i]);
+			if (source.objects[i].material < 0)
+			{
+				std::cout << filename << ":" << objectLines[i] << ": unknown material:" << objectMaterials[i] << std::endl;
+				bResult = false;
+			}
+		}
+	}
+
+	return(bResult);
+}
+
+/***********************************************************
+ *  Cook()
+ *
+ *  This method is used for building the cooked layout of a
+ *  parsed scene: the header, the texture, material, object
+ *  and light tables, and finally the string table.
+ ***********************************************************/
+void SceneFile::Cook(const SCENE_SOURCE& source, uint64_t sourceSize,
+	uint64_t sourceHash, std::vector<unsigned char>& cooked)
+{
+	// the string table starts with the empty string used by unnamed objects
+	std::string strings(1, '\0');
+	auto addString = [&strings](const std::string& text)
+	{
+		uint32_t offset = (uint32_t)strings.size();
+		strings.append(text);
+		strings.push_back('\0');
+		return offset;
+	};
+
+	std::vector<SCENE_TEXTURE_RECORD> textures(source.textureTags.size());
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		textures[i].tagOffset = addString(source.textureTags[i]);
+		textures[i].pathOffset = addString(source.texturePaths[i]);
+	}
+
+	std::vector<SCENE_MATERIAL_RECORD> materials = source.materials;
+	for (size_t i = 0; i < materials.size(); i++)
+	{
+		materials[i].tagOffset = addString(source.materialTags[i]);
+	}
+
+	std::vector<SCENE_OBJECT> objects = source.objects;
+	for (size_t i = 0; i < objects.size(); i++)
+	{
+		objects[i].nameOffset = ((i >= source.objectNames.size()) || source.objectNames[i].empty()) ?
+			0 : addString(source.objectNames[i]);
+	}
+
+	SCENE_FILE_HEADER header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, g_CookedMagic, sizeof(header.magic));
+	header.version = g_CookedVersion;
+	header.sourceSize = sourceSize;
+	header.sourceHash = sourceHash;
+
+	cooked.clear();
+	cooked.resize(sizeof(header));
+	header.textureCount = (uint32_t)textures.size();
+	header.textureOffset = AppendRecords(cooked, textures.data(), textures.size());
+	header.materialCount = (uint32_t)materials.size();
+	header.materialOffset = AppendRecords(cooked, materials.data(), materials.size());
+	header.objectCount = (uint32_t)objects.size();
+	header.objectOffset = AppendRecords(cooked, objects.data(), objects.size());
+	header.lightCount = (uint32_t)source.lights.size();
+	header.lightOffset = AppendRecords(cooked, source.lights.data(), source.lights.size());
+	header.stringSize = (uint32_t)strings.size();
+	header.stringOffset = AppendRecords(cooked, strings.data(), strings.size());
+
+	std::memcpy(cooked.data(), &header, sizeof(header));
+}
+
+/***********************************************************
+ *  AttachCooked()
+ *
+ *  This method is used for checking that cooked data is
+ *  complete and consistent, and then pointing the tables
+ *  directly into it.  Nothing is copied or parsed.
+ ***********************************************************/
+bool SceneFile::AttachCooked(const unsigned char* data, size_t size)
+{
+	if ((NULL == data) || (size < sizeof(SCENE_FILE_HEADER)))
+	{
+		return false;
+	}
+
+	const SCENE_FILE_HEADER* header = (const SCENE_FILE_HEADER*)data;
+	if ((std::memcmp(header->magic, g_CookedMagic, sizeof(header->magic)) != 0) ||
+		(header->version != g_CookedVersion))
+	{
+		return false;
+	}
+
+	if (!TableFits(header->textureOffset, header->textureCount, sizeof(SCENE_TEXTURE_RECORD), size) ||
+		!TableFits(header->materialOffset, header->materialCount, sizeof(SCENE_MATERIAL_RECORD), size) ||
+		!TableFits(header->objectOffset, header->objectCount, sizeof(SCENE_OBJECT), size) ||
+		!TableFits(header->lightOffset, header->lightCount, sizeof(SCENE_LIGHT_RECORD), size) ||
+		!TableFits(header->stringOffset, header->stringSize, 1, size) ||
+		(header->stringSize == 0) ||
+		(data[header->stringOffset + header->stringSize - 1] != '\0'))
+	{
+		std::cout << "Cooked scene data is damaged" << std::endl;
+		return false;
+	}
+
+	const SCENE_TEXTURE_RECORD* textures = (const SCENE_TEXTURE_RECORD*)(data + header->textureOffset);
+	const SCENE_MATERIAL_RECORD* materials = (const SCENE_MATERIAL_RECORD*)(data + header->materialOffset);
+	const SCENE_OBJECT* objects = (const SCENE_OBJECT*)(data + header->objectOffset);
+	const SCENE_LIGHT_RECORD* lights = (const SCENE_LIGHT_RECORD*)(data + header->lightOffset);
+
+	// every reference has to stay inside of its table
+	bool bValid = true;
+	for (uint32_t i = 0; i < header->textureCount; i++)
+	{
+		bValid = bValid && (textures[i].tagOffset < header->stringSize) &&
+			(textures[i].pathOffset < header->stringSize);
+	}
+	for (uint32_t i = 0; i < header->materialCount; i++)
+	{
+		bValid = bValid && (materials[i].tagOffset < header->stringSize);
+	}
+	for (uint32_t i = 0; i < header->objectCount; i++)
+	{
+		bValid = bValid && (objects[i].mesh < SCENE_MESH_COUNT) &&
+			(objects[i].texture >= -1) && (objects[i].texture < (int32_t)header->textureCount) &&
+			(objects[i].material >= -1) && (objects[i].material < (int32_t)header->materialCount) &&
+			(objects[i].parent >= -1) && (objects[i].parent < (int32_t)i) &&
+			(objects[i].nameOffset < header->stringSize);
+	}
+	for (uint32_t i = 0; i < header->lightCount; i++)
+	{
+		bValid = bValid && (lights[i].parent >= -1) &&
+			(lights[i].parent < (int32_t)header->objectCount);
+	}
+	if (bValid == false)
+	{
+		std::cout << "Cooked scene data is damaged" << std::endl;
+		return false;
+	}
+
+	m_header = header;
+	m_textures = textures;
+	m_materials = materials;
+	m_objects = objects;
+	m_lights = lights;
+	m_strings = (const char*)(data + header->stringOffset);
+
+	return true;
+}
+
+/***********************************************************
+ *  GetTextureCount() / GetTextureTag() / GetTexturePath()
+ *
+ *  These methods return the textures used by the scene.
+ ***********************************************************/
+int SceneFile::GetTextureCount() const
+{
+	return (NULL == m_header) ? 0 : (int)m_header->textureCount;
+}
+
+const char* SceneFile::GetTextureTag(int index) const
+{
+	return m_strings + m_textures[index].tagOffset;
+}
+
+const char* SceneFile::GetTexturePath(int index) const
+{
+	return m_strings + m_textures[index].pathOffset;
+}
+
+/***********************************************************
+ *  GetMaterialCount() / GetMaterial() / GetMaterialTag()
+ *
+ *  These methods return the materials used by the scene.
+ ***********************************************************/
+int SceneFile::GetMaterialCount() const
+{
+	return (NULL == m_header) ? 0 : (int)m_header->materialCount;
+}
+
+const SCENE_MATERIAL_RECORD& SceneFile::GetMaterial(int index) const
+{
+	return m_materials[index];
+}
+
+const char* SceneFile::GetMaterialTag(int index) const
+{
+	return m_strings + m_materials[index].tagOffset;
+}
+
+/***********************************************************
+ *  GetObjectCount() / GetObjects() / GetObjectName()
+ *
+ *  These methods return the object table of the scene.
+ ***********************************************************/
+int SceneFile::GetObjectCount() const
+{
+	return (NULL == m_header) ? 0 : (int)m_header->objectCount;
+}
+
+const SCENE_OBJECT* SceneFile::GetObjects() const
+{
+	return m_objects;
+}
+
+const char* SceneFile::GetObjectName(int index) const
+{
+	return m_strings + m_objects[index].nameOffset;
+}
+
+/***********************************************************
+ *  GetLightCount() / GetLight()
+ *
+ *  These methods return the light table of the scene.
+ ***********************************************************/
+int SceneFile::GetLightCount() const
+{
+	return (NULL == m_header) ? 0 : (int)m_header->lightCount;
+}
+
+const SCENE_LIGHT_RECORD& SceneFile::GetLight(int index) const
+{
+	return m_lights[index];
+}
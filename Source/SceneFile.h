@@ -0,0 +1,186 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.h
+// ============
+// load scene descriptions from text files and cooked binary files
+//
+//  Scenes are authored as text (see Scenes/desk.scene for the format)
+//  and cooked on first load into a binary file next to the text file.
+//  The cooked file is memory mapped and its object table is used by the
+//  renderer as-is.  The cooked layout is little-endian only.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MappedFile.h"
+#include "ShapeGeometry.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// raster state flags of scene objects
+enum SCENE_OBJECT_FLAGS
+{
+	SCENE_OBJECT_CULL_FRONT = 0x1,
+	SCENE_OBJECT_CULL_BACK = 0x2,
+	// groups only carry a transform for their children, and are not drawn
+	SCENE_OBJECT_GROUP = 0x4
+};
+
+// texture record - the tag and path are string table offsets
+struct SCENE_TEXTURE_RECORD
+{
+	uint32_t tagOffset;
+	uint32_t pathOffset;
+};
+
+// material record - the tag is a string table offset
+struct SCENE_MATERIAL_RECORD
+{
+	uint32_t tagOffset;
+	float ambientColor[3];
+	float ambientStrength;
+	float diffuseColor[3];
+	float specularColor[3];
+	float shininess;
+};
+
+// object record - the texture and material are indexes into the
+// texture and material tables of the same file, or -1 for none
+struct SCENE_OBJECT
+{
+	uint32_t mesh;
+	int32_t texture;
+	int32_t material;
+	uint32_t flags;
+	uint8_t color[4];
+	float uvScale[2];
+	float scale[3];
+	float rotation[3];
+	float position[3];
+	// index of the parent object, which always comes first, or -1
+	int32_t parent;
+	// string table offset of the name, empty for unnamed objects
+	uint32_t nameOffset;
+};
+
+// light record - a light with a radius of 0 reaches the whole scene,
+// other lights fade out to nothing at their radius
+struct SCENE_LIGHT_RECORD
+{
+	float position[3];
+	float radius;
+	float ambientColor[3];
+	float diffuseColor[3];
+	float specularColor[3];
+	float focalStrength;
+	float specularIntensity;
+	// index of the object that the light moves with, or -1, in which
+	// case the position is in world space
+	int32_t parent;
+};
+
+// header at the start of a cooked scene file
+struct SCENE_FILE_HEADER
+{
+	char magic[4];
+	uint32_t version;
+	// size and contents hash of the text file it was cooked from
+	uint64_t sourceSize;
+	uint64_t sourceHash;
+	// byte offsets of the tables from the start of the file
+	uint32_t textureCount;
+	uint32_t textureOffset;
+	uint32_t materialCount;
+	uint32_t materialOffset;
+	uint32_t objectCount;
+	uint32_t objectOffset;
+	uint32_t lightCount;
+	uint32_t lightOffset;
+	uint32_t stringOffset;
+	uint32_t stringSize;
+};
+
+// a scene description before it is cooked, parsed from a text file
+// or generated - the string offsets of its records are filled in when
+// it is cooked
+struct SCENE_SOURCE
+{
+	std::vector<std::string> textureTags;
+	std::vector<std::string> texturePaths;
+	std::vector<std::string> materialTags;
+	std::vector<SCENE_MATERIAL_RECORD> materials;
+	std::vector<SCENE_OBJECT> objects;
+	// names of the objects, where the objects past the end are unnamed
+	std::vector<std::string> objectNames;
+	std::vector<SCENE_LIGHT_RECORD> lights;
+};
+
+/***********************************************************
+ *  SceneFile
+ *
+ *  This class contains the code for loading a scene, either
+ *  by mapping an up to date cooked file directly, or by
+ *  parsing the text file and cooking it for the next run.
+ ***********************************************************/
+class SceneFile
+{
+public:
+	// constructor
+	SceneFile();
+	// destructor
+	~SceneFile();
+
+	// load the passed in scene text file or cooked file
+	bool Load(const char* filename);
+	// parse a scene text file and cook it in memory only, leaving the
+	// cooked file alone, such as while another scene has it mapped
+	bool LoadText(const char* filename);
+	// cook a scene description that was built in memory, such as a
+	// generated scene, without any file
+	bool LoadSource(const SCENE_SOURCE& source);
+	// release the loaded scene data
+	void Close();
+	// check whether a file name is the name of a cooked scene file
+	static bool IsCookedFile(const std::string& filename);
+
+	// textures used by the scene
+	int GetTextureCount() const;
+	const char* GetTextureTag(int index) const;
+	const char* GetTexturePath(int index) const;
+
+	// materials used by the scene
+	int GetMaterialCount() const;
+	const SCENE_MATERIAL_RECORD& GetMaterial(int index) const;
+	const char* GetMaterialTag(int index) const;
+
+	// objects of the scene, in the order they were authored
+	int GetObjectCount() const;
+	const SCENE_OBJECT* GetObjects() const;
+	const char* GetObjectName(int index) const;
+
+	// lights of the scene, in the order they were authored
+	int GetLightCount() const;
+	const SCENE_LIGHT_RECORD& GetLight(int index) const;
+
+private:
+	// cooked file that is mapped into memory
+	MappedFile m_mappedFile;
+	// freshly cooked data, used when it can't be written to a file
+	std::vector<unsigned char> m_cookedData;
+	// tables inside of the cooked data
+	const SCENE_FILE_HEADER* m_header;
+	const SCENE_TEXTURE_RECORD* m_textures;
+	const SCENE_MATERIAL_RECORD* m_materials;
+	const SCENE_OBJECT* m_objects;
+	const SCENE_LIGHT_RECORD* m_lights;
+	const char* m_strings;
+
+	// parse a scene text file
+	static bool ParseText(const char* filename, SCENE_SOURCE& source);
+	// build the cooked binary layout of a parsed scene
+	static void Cook(const SCENE_SOURCE& source, uint64_t sourceSize,
+		uint64_t sourceHash, std::vector<unsigned char>& cooked);
+	// check the cooked data and point the tables into it
+	bool AttachCooked(const unsigned char* data, size_t size);
+};
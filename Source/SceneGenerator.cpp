@@ -0,0 +1,162 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegenerator.cpp
+// ============
+// fill a scene with randomly placed shapes for measuring how rendering scales
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// corners of the field that the objects are spread over, in front
+	// of and below the starting camera
+	const float g_FieldMin[3] = { -40.0f, 0.0f, -80.0f };
+	const float g_FieldMax[3] = { 40.0f, 12.0f, 6.0f };
+	// size of an object as a fraction of the room that each object
+	// has in the field, and the largest size of a sparse scene
+	const float g_MinObjectSize = 0.3f;
+	const float g_MaxObjectSize = 0.8f;
+	const float g_SizeLimit = 3.0f;
+	// share of the objects that are textured, when there are textures
+	const float g_TexturedFraction = 0.75f;
+	// darkest value of a random color channel
+	const int g_MinColor = 64;
+}
+
+const int SceneGenerator::MAX_OBJECTS;
+
+/***********************************************************
+ *  SceneGenerator()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneGenerator::SceneGenerator(uint32_t seed)
+{
+	// the generator never leaves zero, so that seed is moved
+	m_state = (seed == 0) ? 0x9E3779B9u : seed;
+}
+
+/***********************************************************
+ *  Generate()
+ *
+ *  This method is used for building the description of a
+ *  generated scene.  Lights that move with an object of the
+ *  base scene are left out, since its objects are not.  The
+ *  objects have no parents or names, so the scene graph is
+ *  flat and the cooked string table stays small.
+ ***********************************************************/
+bool SceneGenerator::Generate(const SceneFile& baseScene, int objectCount, SCENE_SOURCE& source)
+{
+	if ((objectCount < 1) || (objectCount > MAX_OBJECTS))
+	{
+		std::cout << "Generated scenes have from 1 to " << MAX_OBJECTS << " objects, not " << objectCount << std::endl;
+		return false;
+	}
+
+	source = SCENE_SOURCE();
+
+	for (int i = 0; i < baseScene.GetTextureCount(); i++)
+	{
+		source.textureTags.push_back(baseScene.GetTextureTag(i));
+		source.texturePaths.push_back(baseScene.GetTexturePath(i));
+	}
+	for (int i = 0; i < baseScene.GetMaterialCount(); i++)
+	{
+		source.materialTags.push_back(baseScene.GetMaterialTag(i));
+		source.materials.push_back(baseScene.GetMaterial(i));
+	}
+	for (int i = 0; i < baseScene.GetLightCount(); i++)
+	{
+		if (baseScene.GetLight(i).parent < 0)
+		{
+			source.lights.push_back(baseScene.GetLight(i));
+		}
+	}
+
+	// the edge of the cube of room that each object has in the field
+	float fieldVolume = 1.0f;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		fieldVolume *= g_FieldMax[axis] - g_FieldMin[axis];
+	}
+	const float spacing = std::cbrt(fieldVolume / objectCount);
+	const float minSize = std::min(g_SizeLimit, spacing * g_MinObjectSize);
+	const float maxSize = std::min(g_SizeLimit, spacing * g_MaxObjectSize);
+
+	const int textureCount = (int)source.textureTags.size();
+	const int materialCount = (int)source.materials.size();
+
+	source.objects.resize(objectCount);
+	for (int i = 0; i < objectCount; i++)
+	{
+		SCENE_OBJECT& object = source.objects[i];
+		object.mesh = (uint32_t)RandomIndex(SCENE_MESH_COUNT);
+		object.texture = -1;
+		if ((textureCount > 0) && (RandomFloat(0.0f, 1.0f) < g_TexturedFraction))
+		{
+			object.texture = RandomIndex(textureCount);
+		}
+		object.material = (materialCount > 0) ? RandomIndex(materialCount) : -1;
+		object.flags = 0;
+		for (int channel = 0; channel < 3; channel++)
+		{
+			object.color[channel] = (uint8_t)(g_MinColor + RandomIndex(256 - g_MinColor));
+		}
+		object.color[3] = 255;
+		object.uvScale[0] = 1.0f;
+		object.uvScale[1] = 1.0f;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			object.scale[axis] = RandomFloat(minSize, maxSize);
+			object.rotation[axis] = RandomFloat(0.0f, 360.0f);
+			object.position[axis] = RandomFloat(g_FieldMin[axis], g_FieldMax[axis]);
+		}
+		object.parent = -1;
+		object.nameOffset = 0;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  NextRandom()
+ *
+ *  This method is used for stepping the xorshift generator
+ *  and returning its new state.
+ ***********************************************************/
+uint32_t SceneGenerator::NextRandom()
+{
+	m_state ^= m_state << 13;
+	m_state ^= m_state >> 17;
+	m_state ^= m_state << 5;
+	return(m_state);
+}
+
+/***********************************************************
+ *  RandomFloat()
+ *
+ *  This method is used for getting a random number from the
+ *  minimum up to the maximum, made from the top 24 bits of
+ *  the generator so that every step is exact in a float.
+ ***********************************************************/
+float SceneGenerator::RandomFloat(float minimum, float maximum)
+{
+	float fraction = (NextRandom() >> 8) * (1.0f / 16777216.0f);
+	return(minimum + ((maximum - minimum) * fraction));
+}
+
+/***********************************************************
+ *  RandomIndex()
+ *
+ *  This method is used for getting a random index from zero
+ *  up to the passed in count.
+ ***********************************************************/
+int SceneGenerator::RandomIndex(int count)
+{
+	return((int)(((uint64_t)NextRandom() * (uint64_t)count) >> 32));
+}
@@ -0,0 +1,53 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegenerator.h
+// ============
+// fill a scene with randomly placed shapes for measuring how rendering scales
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneFile.h"
+
+#include <cstdint>
+
+/***********************************************************
+ *  SceneGenerator
+ *
+ *  This class contains the code for building a scene of any
+ *  number of objects, from a thousand to a million, to find
+ *  out where the time of a frame stops growing in proportion
+ *  to the number of objects.  The textures, materials and
+ *  world lights are taken from a base scene, and every
+ *  object gets a random shape, transform, color, texture and
+ *  material.  The objects are spread over a field in front
+ *  of the starting camera that is the same for every count,
+ *  and are made smaller as there are more of them, so they
+ *  keep about the same share of the field.  The numbers come
+ *  from a generator of its own rather than the standard
+ *  library's distributions, so the same seed places the same
+ *  scene on every platform.
+ ***********************************************************/
+class SceneGenerator
+{
+public:
+	// most objects that a scene is generated with
+	static const int MAX_OBJECTS = 1048576;
+
+	// constructor - the same seed always generates the same scene
+	SceneGenerator(uint32_t seed);
+
+	// fill the passed in description with the textures, materials and
+	// world lights of the base scene, and the number of random objects
+	bool Generate(const SceneFile& baseScene, int objectCount, SCENE_SOURCE& source);
+
+private:
+	// state of the random number generator, never zero
+	uint32_t m_state;
+
+	// get the next random number
+	uint32_t NextRandom();
+	// get a random number from the minimum up to the maximum
+	float RandomFloat(float minimum, float maximum);
+	// get a random index below the count
+	int RandomIndex(int count);
+};
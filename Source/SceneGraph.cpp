@@ -0,0 +1,184 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.cpp
+// ============
+// keep the world transforms of a hierarchy of scene nodes up to date
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneGraph.h"
+
+#include <algorithm>
+
+/***********************************************************
+ *  SceneGraph()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneGraph::SceneGraph()
+{
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the nodes.
+ ***********************************************************/
+void SceneGraph::Clear()
+{
+	m_nodes.clear();
+	m_localValues.Resize(0);
+	m_localTransforms.clear();
+	m_worldTransforms.clear();
+	m_dirtyNodes.clear();
+}
+
+/***********************************************************
+ *  AddNode()
+ *
+ *  This method is used for adding a node below the passed in
+ *  parent.  The parent has to be added first, which keeps
+ *  every parent ahead of its children in the node list.  The
+ *  local and world transforms are ready after the next
+ *  update.
+ ***********************************************************/
+int SceneGraph::AddNode(int parent, const glm::vec3& scale,
+	const glm::vec3& rotationDegrees, const glm::vec3& position)
+{
+	int node = (int)m_nodes.size();
+
+	if ((parent < NO_PARENT) || (parent >= node))
+	{
+		parent = NO_PARENT;
+	}
+
+	SCENE_NODE sceneNode;
+	sceneNode.parent = parent;
+	sceneNode.firstChild = -1;
+	sceneNode.lastChild = -1;
+	sceneNode.nextSibling = -1;
+	sceneNode.bDirty = true;
+	m_nodes.push_back(sceneNode);
+
+	// append to the list of children of the parent
+	if (parent != NO_PARENT)
+	{
+		SCENE_NODE& parentNode = m_nodes[parent];
+		if (parentNode.lastChild < 0)
+			parentNode.firstChild = node;
+		else
+			m_nodes[parentNode.lastChild].nextSibling = node;
+		parentNode.lastChild = node;
+	}
+
+	m_localValues.Resize(node + 1);
+	m_localValues.SetTransform(node, scale, rotationDegrees, position);
+	m_localTransforms.push_back(glm::mat4(1.0f));
+	m_worldTransforms.push_back(glm::mat4(1.0f));
+	m_dirtyNodes.push_back(node);
+
+	return(node);
+}
+
+/***********************************************************
+ *  SetLocalTransform()
+ *
+ *  This method is used for changing the transform of a node
+ *  relative to its parent.  The node and everything attached
+ *  to it are moved on the next update.
+ ***********************************************************/
+void SceneGraph::SetLocalTransform(int node, const glm::vec3& scale,
+	const glm::vec3& rotationDegrees, const glm::vec3& position)
+{
+	if ((node < 0) || (node >= (int)m_nodes.size()))
+	{
+		return;
+	}
+
+	m_localValues.SetTransform(node, scale, rotationDegrees, position);
+	if (m_nodes[node].bDirty == false)
+	{
+		m_nodes[node].bDirty = true;
+		m_dirtyNodes.push_back(node);
+	}
+}
+
+/***********************************************************
+ *  UpdateWorldTransforms()
+ *
+ *  This method is used for recalculating the world transforms
+ *  of the nodes that changed and of everything below them.
+ *  The local transforms of the changed nodes are calculated
+ *  first, a run of neighbouring nodes at a time, so a scene
+ *  where most objects move is one long batch.  The changed
+ *  nodes are then visited parents first, so a node that was
+ *  already updated with a changed parent is skipped when its
+ *  own turn comes.  Nothing is done when no node changed
+ *  since the last update.
+ ***********************************************************/
+int SceneGraph::UpdateWorldTransforms()
+{
+	if (m_dirtyNodes.empty())
+	{
+		return(0);
+	}
+
+	int updated = 0;
+	std::sort(m_dirtyNodes.begin(), m_dirtyNodes.end());
+
+	size_t runStart = 0;
+	for (size_t i = 1; i <= m_dirtyNodes.size(); i++)
+	{
+		if ((i == m_dirtyNodes.size()) || (m_dirtyNodes[i] != m_dirtyNodes[i - 1] + 1))
+		{
+			m_localValues.BuildMatrices(m_dirtyNodes[runStart],
+				(int)(i - runStart), m_localTransforms.data());
+			runStart = i;
+		}
+	}
+
+	for (size_t i = 0; i < m_dirtyNodes.size(); i++)
+	{
+		int root = m_dirtyNodes[i];
+		if (m_nodes[root].bDirty == false)
+		{
+			continue;
+		}
+
+		m_updateStack.clear();
+		m_updateStack.push_back(root);
+		while (m_updateStack.empty() == false)
+		{
+			int node = m_updateStack.back();
+			m_updateStack.pop_back();
+
+			SCENE_NODE& sceneNode = m_nodes[node];
+			if (sceneNode.parent == NO_PARENT)
+				m_worldTransforms[node] = m_localTransforms[node];
+			else
+				m_worldTransforms[node] = m_worldTransforms[sceneNode.parent] * m_localTransforms[node];
+			sceneNode.bDirty = false;
+			updated++;
+
+			for (int child = sceneNode.firstChild; child >= 0; child = m_nodes[child].nextSibling)
+			{
+				m_updateStack.push_back(child);
+			}
+		}
+	}
+
+	m_dirtyNodes.clear();
+
+	return(updated);
+}
+
+/***********************************************************
+ *  BuildLocalTransform()
+ *
+ *  This method is used for calculating a transform matrix
+ *  from the passed in scale, rotations in degrees around the
+ *  X, Y and Z axes, and position, the same way as the nodes.
+ ***********************************************************/
+glm::mat4 SceneGraph::BuildLocalTransform(const glm::vec3& scale,
+	const glm::vec3& rotationDegrees, const glm::vec3& position)
+{
+	return(TransformBatch::BuildMatrix(scale, rotationDegrees, position));
+}
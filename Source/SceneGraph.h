@@ -0,0 +1,87 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.h
+// ============
+// keep the world transforms of a hierarchy of scene nodes up to date
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "TransformBatch.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  SceneGraph
+ *
+ *  This class contains the local and world transforms of the
+ *  scene nodes.  A node's world transform is its parent's
+ *  world transform times its own local transform.  The
+ *  matrices are cached and only the nodes whose local
+ *  transform changed, along with everything attached below
+ *  them, are recalculated, so static nodes cost nothing.
+ *  The local matrices of the changed nodes are calculated
+ *  together by a transform batch before they are passed
+ *  down.  Parents are always added before their children.
+ ***********************************************************/
+class SceneGraph
+{
+public:
+	// node index for nodes without a parent
+	static const int NO_PARENT = -1;
+
+	// constructor
+	SceneGraph();
+
+	// remove all of the nodes
+	void Clear();
+	// add a node below the passed in parent, and return its index
+	int AddNode(int parent, const glm::vec3& scale,
+		const glm::vec3& rotationDegrees, const glm::vec3& position);
+	// change the local transform of a node
+	void SetLocalTransform(int node, const glm::vec3& scale,
+		const glm::vec3& rotationDegrees, const glm::vec3& position);
+
+	// recalculate the world transforms of the nodes that moved,
+	// and return the number of world transforms that changed
+	int UpdateWorldTransforms();
+
+	// split the local transforms of large updates between this
+	// many threads besides the calling thread
+	void SetWorkerCount(int workerCount) { m_localValues.SetWorkerCount(workerCount); }
+
+	// get the number of nodes
+	int GetNodeCount() const { return (int)m_nodes.size(); }
+	// get the parent of a node, or NO_PARENT
+	int GetParent(int node) const { return m_nodes[node].parent; }
+	// get the world transform of a node, after the last update
+	const glm::mat4& GetWorldTransform(int node) const { return m_worldTransforms[node]; }
+
+	// calculate a transform from scale, rotation and position
+	static glm::mat4 BuildLocalTransform(const glm::vec3& scale,
+		const glm::vec3& rotationDegrees, const glm::vec3& position);
+
+private:
+	struct SCENE_NODE
+	{
+		int parent;
+		// children are linked from the first child through its siblings
+		int firstChild;
+		int lastChild;
+		int nextSibling;
+		// set when the local transform changed since the last update
+		bool bDirty;
+	};
+
+	std::vector<SCENE_NODE> m_nodes;
+	// scale, rotation and position of each node, which the local
+	// transforms are calculated from
+	TransformBatch m_localValues;
+	std::vector<glm::mat4> m_localTransforms;
+	std::vector<glm::mat4> m_worldTransforms;
+	// nodes whose local transform changed since the last update
+	std::vector<int> m_dirtyNodes;
+	// nodes still to visit while updating, kept between updates
+	std::vector<int> m_updateStack;
+};
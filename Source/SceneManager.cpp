@@ -8,22 +8,34 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SceneManager.h"
-
-#ifndef STB_IMAGE_IMPLEMENTATION
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-#endif
+#include "GLStateCache.h"
+#include "SceneGenerator.h"
 
 #include <glm/gtx/transform.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
 // declaration of global variables
 namespace
 {
-	const char* g_ModelName = "model";
-	const char* g_ColorValueName = "objectColor";
+	const char* g_UseInstancingName = "bUseInstancing";
 	const char* g_TextureValueName = "objectTexture";
 	const char* g_UseTextureName = "bUseTexture";
 	const char* g_UseLightingName = "bUseLighting";
+
+	// decoded textures uploaded per frame, so a burst of finished
+	// decodes does not cause a long frame
+	const int g_TextureUploadsPerFrame = 2;
+	// storage buffer binding of the materials, matching the shaders -
+	// the lights use the bindings below it
+	const GLuint g_MaterialBinding = 3;
+	// fraction of the screen height that an object has to cover to be
+	// drawn into the occlusion depth buffer - smaller objects hide
+	// too little to be worth their triangles
+	const float g_MinOccluderSize = 0.1f;
 }
 
 /***********************************************************
@@ -34,7 +46,34 @@ namespace
 SceneManager::SceneManager(ShaderManager *pShaderManager)
 {
 	m_pShaderManager = pShaderManager;
-	m_basicMeshes = new ShapeMeshes();
+	m_pUniforms = NULL;
+	m_pProfiler = NULL;
+	m_basicMeshes = new InstancedMeshes();
+	m_textureLoader = new TextureLoader();
+	m_lightClusters = new LightClusters();
+	m_materialBuffer = 0;
+	m_bMaterialsDirty = true;
+	m_renderStats.draws = 0;
+	m_renderStats.drawCalls = 0;
+	m_renderStats.multiDraws = 0;
+	m_renderStats.triangles = 0;
+	m_renderStats.stateChanges = 0;
+	m_renderStats.stateChangesAvoided = 0;
+	m_renderStats.transformUpdates = 0;
+	m_renderStats.objectsVisible = 0;
+	m_renderStats.objectsCulled = 0;
+	m_renderStats.objectsOccluded = 0;
+	m_arenaStats = FRAME_ARENA_STATS();
+	m_bFrustumCulling = false;
+	m_bOcclusionCulling = true;
+	m_bCullBoundsDirty = true;
+	m_bLightsDirty = false;
+	m_lightStats.lights = 0;
+	m_lightStats.globalLights = 0;
+	m_lightStats.lightsVisible = 0;
+	m_lightStats.clusterLights = 0;
+	m_lightStats.maxClusterLights = 0;
+	SetFrameCount(1);
 }
 
 /***********************************************************
@@ -46,102 +85,105 @@ SceneManager::~SceneManager()
 {
 	// free up the allocated memory
 	m_pShaderManager = NULL;
+	m_pUniforms = NULL;
+	// free the textures before stopping the loader that owns them
+	DestroyGLTextures();
+	if (NULL != m_textureLoader)
+	{
+		delete m_textureLoader;
+		m_textureLoader = NULL;
+	}
+	if (NULL != m_lightClusters)
+	{
+		delete m_lightClusters;
+		m_lightClusters = NULL;
+	}
 	if (NULL != m_basicMeshes)
 	{
 		delete m_basicMeshes;
 		m_basicMeshes = NULL;
 	}
+	if (m_materialBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_materialBuffer);
+		m_materialBuffer = 0;
+	}
 	// clear the collection of defined materials
 	m_objectMaterials.clear();
+	m_materialTags.Clear();
+	m_textureTags.Clear();
+	m_objectNames.Clear();
 }
 
 /***********************************************************
- *  CreateGLTexture()
+ *  ResolveShaderUniforms()
  *
- *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
+ *  This method is used for looking up the locations of the
+ *  uniforms that are set for every draw, once after the
+ *  shaders are loaded, instead of by name on every call.
  ***********************************************************/
-bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
+void SceneManager::ResolveShaderUniforms()
 {
-	int width = 0;
-	int height = 0;
-	int colorChannels = 0;
-	GLuint textureID = 0;
-
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
-
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
-
-	// if the image was successfully read from the image file
-	if (image)
-	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
-
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
-		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
-		}
-
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+	m_pUniforms = ShaderUniforms::ForCurrentProgram();
+	if (NULL == m_pUniforms)
+	{
+		return;
+	}
 
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
+	m_uniforms.useInstancing = m_pUniforms->Resolve<bool>(g_UseInstancingName);
+	m_uniforms.objectTexture = m_pUniforms->Resolve<int>(g_TextureValueName);
+	m_uniforms.useTexture = m_pUniforms->Resolve<bool>(g_UseTextureName);
+}
 
-		return true;
+/***********************************************************
+ *  CreateGLTexture()
+ *
+ *  This method is used for loading textures from image files
+ *  into the next available texture slot.  The image is decoded
+ *  and uploaded into a texture array layer in the background,
+ *  and the texture shows a placeholder color until then, so
+ *  the first frames of the scene can be drawn while the
+ *  textures still load.  There is no limit on the number of
+ *  slots, since the textures don't each need a texture unit.
+ ***********************************************************/
+bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
+{
+	TEXTURE_INFO texture;
+	texture.handle = m_textureLoader->Request(filename);
+	texture.tag = tag;
+
+	// register the loaded texture and associate it with the special tag string,
+	// the interned tag handle is the slot that the texture is loaded into
+	int textureSlot = m_textureTags.Intern(tag);
+	if (textureSlot < (int)m_textureIDs.size())
+	{
+		// the tag was loaded before, so replace the previous texture
+		m_textureLoader->Release(m_textureIDs[textureSlot].handle);
+		m_textureIDs[textureSlot] = texture;
+	}
+	else
+	{
+		m_textureIDs.push_back(texture);
 	}
 
-	std::cout << "Could not load image:" << filename << std::endl;
-
-	// Error loading the image
-	return false;
+	return true;
 }
 
 /***********************************************************
  *  BindGLTextures()
  *
- *  This method is used for binding the loaded textures to
- *  OpenGL texture memory slots.  There are up to 16 slots.
+ *  This method is used for binding the texture arrays that
+ *  hold the loaded textures to OpenGL texture units.  Each
+ *  array stays bound to its unit, and arrays that are created
+ *  or grow later are bound the first time they are drawn.
  ***********************************************************/
 void SceneManager::BindGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
+	TextureArrays& textureArrays = m_textureLoader->GetTextureArrays();
+
+	for (int i = 0; i < textureArrays.GetArrayCount(); i++)
 	{
-		// bind textures on corresponding texture units
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
+		textureArrays.Bind(i);
 	}
 }
 
@@ -149,534 +191,1100 @@ void SceneManager::BindGLTextures()
  *  DestroyGLTextures()
  *
  *  This method is used for freeing the memory in all the
- *  used texture memory slots.
+ *  used texture slots.
  ***********************************************************/
 void SceneManager::DestroyGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
+	for (size_t i = 0; i < m_textureIDs.size(); i++)
 	{
-		glGenTextures(1, &m_textureIDs[i].ID);
+		m_textureLoader->Release(m_textureIDs[i].handle);
 	}
+	m_textureIDs.clear();
+	m_textureTags.Clear();
 }
 
 /***********************************************************
- *  FindTextureID()
+ *  FindTextureSlot()
  *
- *  This method is used for getting an ID for the previously
+ *  This method is used for getting a slot index for the previously
  *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
+int SceneManager::FindTextureSlot(const std::string& tag) const
+{
+	return(m_textureTags.Find(tag));
+}
+
+/***********************************************************
+ *  AddObjectMaterial()
+ *
+ *  This method is used for adding a material to the defined
+ *  materials list.  A material with a tag that was already
+ *  defined replaces the previous definition.
+ ***********************************************************/
+void SceneManager::AddObjectMaterial(const OBJECT_MATERIAL& material)
 {
-	int textureID = -1;
-	int index = 0;
-	bool bFound = false;
+	// the interned tag handle is the index into the materials list
+	int materialHandle = m_materialTags.Intern(material.tag);
 
-	while ((index < m_loadedTextures) && (bFound == false))
+	if (materialHandle < (int)m_objectMaterials.size())
+	{
+		m_objectMaterials[materialHandle] = material;
+	}
+	else
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
+		m_objectMaterials.push_back(material);
+	}
+	m_bMaterialsDirty = true;
+}
+
+/***********************************************************
+ *  FindMaterial()
+ *
+ *  This method is used for getting the handle of a material
+ *  from the previously defined materials list that is
+ *  associated with the passed in tag.
+ ***********************************************************/
+int SceneManager::FindMaterial(const std::string& tag) const
+{
+	return(m_materialTags.Find(tag));
+}
+
+/***********************************************************
+ *  UploadMaterials()
+ *
+ *  This method is used for packing every defined material
+ *  into the material buffer, when one was added or changed
+ *  since the last upload, so the draws only have to pass
+ *  the index of their material.  The buffer is bound every
+ *  time, in case its binding was taken over in between.
+ ***********************************************************/
+void SceneManager::UploadMaterials()
+{
+	if (m_materialBuffer == 0)
+	{
+		glGenBuffers(1, &m_materialBuffer);
+		m_bMaterialsDirty = true;
+	}
+
+	if ((m_bMaterialsDirty == true) && (m_objectMaterials.empty() == false))
+	{
+		std::vector<GPU_MATERIAL> materials(m_objectMaterials.size());
+		for (size_t i = 0; i < m_objectMaterials.size(); i++)
 		{
-			textureID = m_textureIDs[index].ID;
-			bFound = true;
+			const OBJECT_MATERIAL& material = m_objectMaterials[i];
+			materials[i].ambientColor = glm::vec4(material.ambientColor, material.ambientStrength);
+			materials[i].diffuseColor = glm::vec4(material.diffuseColor, material.shininess);
+			materials[i].specularColor = glm::vec4(material.specularColor, 0.0f);
 		}
-		else
-			index++;
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_materialBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, materials.size() * sizeof(GPU_MATERIAL),
+			materials.data(), GL_STATIC_DRAW);
+		m_bMaterialsDirty = false;
+	}
+	else if (m_bMaterialsDirty == true)
+	{
+		// an empty buffer can't be bound, so it holds one unused material
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_materialBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GPU_MATERIAL), NULL, GL_STATIC_DRAW);
+		m_bMaterialsDirty = false;
 	}
 
-	return(textureID);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, g_MaterialBinding, m_materialBuffer);
 }
 
+/**************************************************************/
+/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
+/*** preparing and rendering their own 3D replicated scenes.***/
+/*** Please refer to the code in the OpenGL sample project  ***/
+/*** for assistance.                                        ***/
+/**************************************************************/
+
 /***********************************************************
- *  FindTextureSlot()
+*  DefineObjectMaterials()
+*
+*  This method is used for configuring the various material
+*  settings for all of the objects within the 3D scene, from
+*  the materials listed in the loaded scene file.
+***********************************************************/
+void SceneManager::DefineObjectMaterials()
+{
+	m_sceneMaterials.clear();
+
+	for (int i = 0; i < m_sceneFile.GetMaterialCount(); i++)
+	{
+		const SCENE_MATERIAL_RECORD& record = m_sceneFile.GetMaterial(i);
+		OBJECT_MATERIAL material;
+
+		material.tag = m_sceneFile.GetMaterialTag(i);
+		material.ambientColor = glm::vec3(record.ambientColor[0], record.ambientColor[1], record.ambientColor[2]);
+		material.ambientStrength = record.ambientStrength;
+		material.diffuseColor = glm::vec3(record.diffuseColor[0], record.diffuseColor[1], record.diffuseColor[2]);
+		material.specularColor = glm::vec3(record.specularColor[0], record.specularColor[1], record.specularColor[2]);
+		material.shininess = record.shininess;
+		AddObjectMaterial(material);
+
+		// the scene objects refer to materials by their index in the file
+		m_sceneMaterials.push_back(FindMaterial(material.tag));
+	}
+}
+
+/***********************************************************
+ *  SetupSceneLights()
  *
- *  This method is used for getting a slot index for the previously
- *  loaded texture bitmap associated with the passed in tag.
+ *  This method is called to add and configure the light
+ *  sources for the 3D scene, from the lights listed in the
+ *  loaded scene file.  There is no limit on the number of
+ *  lights, since the lights with a radius are only looked at
+ *  by the fragments that they can reach.
  ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
+void SceneManager::SetupSceneLights()
 {
-	int textureSlot = -1;
-	int index = 0;
-	bool bFound = false;
+	m_lightClusters->ClearLights();
 
-	while ((index < m_loadedTextures) && (bFound == false))
+	for (int i = 0; i < m_sceneFile.GetLightCount(); i++)
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
+		const SCENE_LIGHT_RECORD& record = m_sceneFile.GetLight(i);
+		LIGHT_SOURCE light;
+
+		light.position = glm::vec3(record.position[0], record.position[1], record.position[2]);
+		light.radius = record.radius;
+		light.ambientColor = glm::vec3(record.ambientColor[0], record.ambientColor[1], record.ambientColor[2]);
+		light.diffuseColor = glm::vec3(record.diffuseColor[0], record.diffuseColor[1], record.diffuseColor[2]);
+		light.specularColor = glm::vec3(record.specularColor[0], record.specularColor[1], record.specularColor[2]);
+		light.focalStrength = record.focalStrength;
+		light.specularIntensity = record.specularIntensity;
+
+		// the handle of each light is its index in the file
+		m_lightClusters->AddLight(light);
+	}
+
+	// the lights attached to objects are placed once the objects are
+	m_bLightsDirty = true;
+
+	// without any light sources the display window would be black,
+	// so the scene is only lit when the scene file has lights
+	m_pShaderManager->setBoolValue(g_UseLightingName, m_lightClusters->GetLightCount() > 0);
+}
+
+/***********************************************************
+ *  PrepareScene()
+ *
+ *  This method is used for preparing the 3D scene by loading
+ *  the scene file, and then the shapes and textures that it
+ *  uses in memory to support the 3D scene rendering
+ ***********************************************************/
+bool SceneManager::PrepareScene(const char* sceneFilename)
+{
+	// load the textures, materials and objects of the scene
+	if (m_sceneFile.Load(sceneFilename) == false)
+	{
+		return false;
+	}
+
+	return(PrepareLoadedScene());
+}
+
+/***********************************************************
+ *  PrepareGeneratedScene()
+ *
+ *  This method is used for preparing a scene of randomly
+ *  placed objects, with the textures, materials and lights of
+ *  the base scene file, for measuring how the rendering
+ *  scales with the number of objects.
+ ***********************************************************/
+bool SceneManager::PrepareGeneratedScene(const char* baseSceneFilename,
+	int objectCount, uint32_t seed)
+{
+	SceneFile baseScene;
+	if (baseScene.Load(baseSceneFilename) == false)
+	{
+		return false;
+	}
+
+	SCENE_SOURCE source;
+	SceneGenerator generator(seed);
+	if ((generator.Generate(baseScene, objectCount, source) == false) ||
+		(m_sceneFile.LoadSource(source) == false))
+	{
+		return false;
+	}
+
+	std::cout << "Generated scene:" << baseSceneFilename << ", objects:" << objectCount
+		<< ", seed:" << seed << std::endl;
+
+	return(PrepareLoadedScene());
+}
+
+/***********************************************************
+ *  PrepareLoadedScene()
+ *
+ *  This method is used for loading the shapes and textures
+ *  that the loaded scene file uses, and placing its objects
+ *  and lights.
+ ***********************************************************/
+bool SceneManager::PrepareLoadedScene()
+{
+	// look up the per-draw shader uniforms once
+	ResolveShaderUniforms();
+
+	// Load textures - the scene objects refer to textures by their
+	// index in the file, so remember which slot each one is loaded in
+	m_sceneTextureSlots.clear();
+	for (int i = 0; i < m_sceneFile.GetTextureCount(); i++)
+	{
+		CreateGLTexture(m_sceneFile.GetTexturePath(i), m_sceneFile.GetTextureTag(i));
+		m_sceneTextureSlots.push_back(FindTextureSlot(m_sceneFile.GetTextureTag(i)));
+	}
+
+	// Bind the texture arrays to texture units
+	BindGLTextures();
+
+	// define the materials that will be used for the objects
+	DefineObjectMaterials();
+
+	// place the objects, which never move unless they are changed
+	BuildSceneGraph();
+
+  // add and define the light sources for the scene
+	SetupSceneLights();
+
+	// only one instance of a particular mesh needs to be
+	// loaded in memory no matter how many times it is drawn
+	// in the rendered 3D scene
+	m_basicMeshes->LoadMeshes();
+
+	return true;
+}
+
+/***********************************************************
+ *  IsSameBatch()
+ *
+ *  This method is used for checking whether two packets that
+ *  are next to each other in sorted order use the same shape,
+ *  level of detail and state, so that they can be drawn as
+ *  instances of one draw call.  The color, transform, texture
+ *  mapping scale, texture layer and material are per
+ *  instance, so textures that share a texture array and any
+ *  mix of materials can be drawn together.
+ ***********************************************************/
+bool SceneManager::IsSameBatch(const DRAW_PACKET& first, const DRAW_PACKET& second)
+{
+	return((first.mesh == second.mesh) &&
+		(first.lod == second.lod) &&
+		(first.textureArray == second.textureArray) &&
+		(first.cullMode == second.cullMode));
+}
+
+/***********************************************************
+ *  FlushRenderQueue()
+ *
+ *  This method is used for sorting the queued draw packets
+ *  by their state and drawing them.  Runs of packets with the
+ *  same shape and state are drawn as instances of a single
+ *  indirect draw, and the draws that share the raster state
+ *  and texture array are submitted together with one
+ *  multi-draw call, whatever their shape and material.  The
+ *  state left by the previous call is tracked, so only the
+ *  values that differ are sent to the shader.
+ ***********************************************************/
+void SceneManager::FlushRenderQueue(SCENE_FRAME& frame)
+{
+	RenderQueue& renderQueue = frame.renderQueue;
+	RENDER_QUEUE_STATS stats;
+	stats.draws = renderQueue.GetCount();
+	stats.drawCalls = 0;
+	stats.multiDraws = 0;
+	stats.triangles = 0;
+	stats.stateChanges = 0;
+	stats.stateChangesAvoided = 0;
+	stats.transformUpdates = frame.transformUpdates;
+	stats.objectsVisible = frame.objectsVisible;
+	stats.objectsCulled = frame.objectsCulled;
+	stats.objectsOccluded = frame.objectsOccluded;
+
+	if ((NULL == m_pUniforms) || (stats.draws == 0))
+	{
+		m_renderStats = stats;
+		m_arenaStats = frame.arena.GetStats();
+		return;
+	}
+
+	{
+		ProfileZone zone(m_pProfiler, "sort");
+		renderQueue.Sort();
+	}
+
+	// the instances are uploaded in sorted order, so each run of
+	// packets is a range of the instance buffer
+	{
+		ProfileZone zone(m_pProfiler, "instanceUpload");
+		MESH_INSTANCE* instances = frame.arena.AllocateArray<MESH_INSTANCE>(stats.draws);
+		for (int i = 0; i < stats.draws; i++)
 		{
-			textureSlot = index;
-			bFound = true;
+			const DRAW_PACKET& packet = renderQueue.GetSorted(i);
+			instances[i].model = packet.transform;
+			instances[i].color = packet.color;
+			instances[i].uvScale = packet.uvScale;
+			instances[i].textureLayer = (float)packet.textureLayer;
+			instances[i].material = (float)packet.material;
 		}
+		m_basicMeshes->UploadInstances(instances, stats.draws);
+	}
+
+	// indirect commands of the runs of packets, and the first sorted
+	// packet of each run - there are never more runs than packets
+	DRAW_ELEMENTS_INDIRECT_COMMAND* drawCommands =
+		frame.arena.AllocateArray<DRAW_ELEMENTS_INDIRECT_COMMAND>(stats.draws);
+	int* drawPackets = frame.arena.AllocateArray<int>(stats.draws);
+
+	// one indirect command for each run of packets that share a shape,
+	// level of detail and state - the material of each packet travels
+	// with its instance, so runs of different materials merge
+	{
+		ProfileZone zone(m_pProfiler, "drawUpload");
+
+		int first = 0;
+		while (first < stats.draws)
+		{
+			const DRAW_PACKET& packet = renderQueue.GetSorted(first);
+
+			int count = 1;
+			while (((first + count) < stats.draws) &&
+				IsSameBatch(packet, renderQueue.GetSorted(first + count)))
+			{
+				count++;
+			}
+
+			drawCommands[stats.drawCalls] = m_basicMeshes->GetDrawCommand(packet.mesh, packet.lod, first, count);
+			drawPackets[stats.drawCalls] = first;
+			stats.drawCalls++;
+			stats.triangles += (m_basicMeshes->GetIndexCount(packet.mesh, packet.lod) / 3) * count;
+
+			first += count;
+		}
+		m_basicMeshes->UploadDraws(drawCommands, stats.drawCalls);
+	}
+	m_pUniforms->Set(m_uniforms.useInstancing, true);
+
+	// raster state goes through the state cache, which also skips
+	// whatever the last frame left set
+	GLStateCache& stateCache = GLStateCache::Current();
+
+	// state set by the previous call - nothing is known before the first
+	bool bFirst = true;
+	uint32_t cullMode = DRAW_CULL_NONE;
+	int textureArray = -1;
+
+	auto countChange = [&stats](bool bChanged)
+	{
+		if (bChanged)
+			stats.stateChanges++;
 		else
-			index++;
+			stats.stateChangesAvoided++;
+	};
+
+	int firstDraw = 0;
+	while (firstDraw < stats.drawCalls)
+	{
+		const DRAW_PACKET& packet = renderQueue.GetSorted(drawPackets[firstDraw]);
+		bool bChanged = false;
+
+		// find the end of the run of draws that share the raster state
+		// and texture array, which can go out with one call
+		int drawCount = 1;
+		while ((firstDraw + drawCount) < stats.drawCalls)
+		{
+			const DRAW_PACKET& next = renderQueue.GetSorted(drawPackets[firstDraw + drawCount]);
+			if ((next.cullMode != packet.cullMode) || (next.textureArray != packet.textureArray))
+			{
+				break;
+			}
+			drawCount++;
+		}
+
+		// time each call, with the draws and state it was made with
+		char detail[64] = "";
+		if (NULL != m_pProfiler)
+		{
+			int lastPacket = (firstDraw + drawCount < stats.drawCalls) ?
+				drawPackets[firstDraw + drawCount] : stats.draws;
+			std::snprintf(detail, sizeof(detail), "%d draws, %d instances, texture array %d",
+				drawCount, lastPacket - drawPackets[firstDraw], packet.textureArray);
+		}
+		ProfileZone zone(m_pProfiler, "multiDraw", detail);
+
+		// raster state
+		bChanged = bFirst || (packet.cullMode != cullMode);
+		if (bChanged)
+		{
+			stateCache.SetEnabled(GL_CULL_FACE, packet.cullMode != DRAW_CULL_NONE);
+			if (packet.cullMode != DRAW_CULL_NONE)
+			{
+				stateCache.CullFace((packet.cullMode == DRAW_CULL_FRONT) ? GL_FRONT : GL_BACK);
+			}
+			cullMode = packet.cullMode;
+		}
+		countChange(bChanged);
+
+		// texture array, which also decides whether the texture is used
+		// at all - the arrays stay bound to their units, so only the
+		// sampler changes, and the layer comes from the instance buffer
+		bChanged = bFirst || (packet.textureArray != textureArray);
+		if (bChanged)
+		{
+			m_pUniforms->Set(m_uniforms.useTexture, packet.textureArray >= 0);
+			if (packet.textureArray >= 0)
+			{
+				m_pUniforms->Set(m_uniforms.objectTexture,
+					m_textureLoader->GetTextureArrays().Bind(packet.textureArray));
+			}
+			textureArray = packet.textureArray;
+		}
+		countChange(bChanged);
+
+		// the transforms, colors and material indices come from the
+		// instance buffer, and the materials from the material buffer
+		// at binding 3, at the index of each instance
+		m_basicMeshes->MultiDrawIndirect(firstDraw, drawCount);
+		stats.multiDraws++;
+
+		firstDraw += drawCount;
+		bFirst = false;
 	}
 
-	return(textureSlot);
+	// leave face culling off and the uniforms in use for anything
+	// drawn after the scene
+	stateCache.Disable(GL_CULL_FACE);
+	m_pUniforms->Set(m_uniforms.useInstancing, false);
+
+	m_renderStats = stats;
+	m_arenaStats = frame.arena.GetStats();
 }
 
 /***********************************************************
- *  FindMaterial()
+ *  SetFrameCount()
  *
- *  This method is used for getting a material from the previously
- *  defined materials list that is associated with the passed in tag.
+ *  This method is used for setting the number of frame states
+ *  that are updated and rendered in turn.  It has to be set
+ *  before any frame is updated, and not changed while a frame
+ *  is being rendered.
  ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
+void SceneManager::SetFrameCount(int frameCount)
 {
-	if (m_objectMaterials.size() == 0)
+	m_frames.resize(std::max(1, frameCount));
+	for (size_t i = 0; i < m_frames.size(); i++)
 	{
-		return(false);
+		m_frames[i].renderQueue.Clear();
+		m_frames[i].visibleSpheres = NULL;
+		m_frames[i].visibleCount = 0;
+		m_frames[i].transformUpdates = 0;
+		m_frames[i].objectsVisible = 0;
+		m_frames[i].objectsCulled = 0;
+		m_frames[i].objectsOccluded = 0;
 	}
+	m_lightClusters->SetFrameCount((int)m_frames.size());
+}
+
+/***********************************************************
+ *  UpdateScene()
+ *
+ *  This method is used for updating a frame state with the
+ *  draw packets of the objects inside the view frustum.  The
+ *  texture layers are only looked up when the frame is drawn,
+ *  so nothing here touches OpenGL or the texture loader, and
+ *  it can run on another thread while a frame is rendered.
+ *  The arena of the frame state is reset first, since the
+ *  last frame drawn from it is done with its memory.
+ ***********************************************************/
+void SceneManager::UpdateScene(int frame)
+{
+	SCENE_FRAME& sceneFrame = m_frames[frame];
+
+	sceneFrame.renderQueue.Clear();
+	sceneFrame.visibleSpheres = NULL;
+	sceneFrame.visibleCount = 0;
+	sceneFrame.arena.Reset();
 
-	int index = 0;
-	bool bFound = false;
-	while ((index < m_objectMaterials.size()) && (bFound == false))
 	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
+		ProfileZone zone(m_pProfiler, "transforms");
+		sceneFrame.transformUpdates = m_sceneGraph.UpdateWorldTransforms();
+		if ((sceneFrame.transformUpdates > 0) || (m_bCullBoundsDirty == true))
 		{
-			bFound = true;
-			material.ambientColor = m_objectMaterials[index].ambientColor;
-			material.ambientStrength = m_objectMaterials[index].ambientStrength;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
+			UpdateCullBounds();
 		}
-		else
+		if ((sceneFrame.transformUpdates > 0) || (m_bLightsDirty == true))
 		{
-			index++;
+			PlaceSceneLights();
 		}
 	}
 
-	return(true);
+	{
+		ProfileZone zone(m_pProfiler, "lightBinning");
+		if (m_bFrustumCulling == true)
+			m_lightClusters->Update(frame, m_viewMatrix, m_projectionMatrix);
+		else
+			m_lightClusters->Update(frame);
+	}
+
+	{
+		ProfileZone zone(m_pProfiler, "cull");
+		CullSceneObjects(sceneFrame);
+	}
+
+	ProfileZone zone(m_pProfiler, "submit");
+	SubmitVisibleObjects(sceneFrame);
 }
 
 /***********************************************************
- *  SetTransformations()
+ *  RenderScene()
  *
- *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
+ *  This method is used for drawing a frame state that was
+ *  updated before, on the thread that owns the context, in
+ *  the order of its draw packets that needs the fewest state
+ *  changes.
  ***********************************************************/
-void SceneManager::SetTransformations(
-	glm::vec3 scaleXYZ,
-	float XrotationDegrees,
-	float YrotationDegrees,
-	float ZrotationDegrees,
-	glm::vec3 positionXYZ)
+void SceneManager::RenderScene(int frame)
 {
-	// variables for this method
-	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
+	SCENE_FRAME& sceneFrame = m_frames[frame];
 
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
+	// swap in the textures that finished loading since the last frame
+	{
+		ProfileZone zone(m_pProfiler, "textureUploads");
+		m_textureLoader->ProcessUploads(g_TextureUploadsPerFrame);
+		ResolveTextureLocations(sceneFrame.renderQueue);
+	}
 
-	modelView = translation * rotationX * rotationY * rotationZ * scale;
+	{
+		ProfileZone zone(m_pProfiler, "lightUpload");
+		m_lightClusters->Upload(frame);
+		m_lightStats = m_lightClusters->GetStats(frame);
+	}
 
-	if (NULL != m_pShaderManager)
 	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
+		ProfileZone zone(m_pProfiler, "materialUpload");
+		UploadMaterials();
 	}
+
+	ProfileZone zone(m_pProfiler, "flush");
+	FlushRenderQueue(sceneFrame);
 }
 
-/**************************************************************/
-/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
-/*** preparing and rendering their own 3D replicated scenes.***/
-/*** Please refer to the code in the OpenGL sample project  ***/
-/*** for assistance.                                        ***/
-/**************************************************************/
+/***********************************************************
+ *  ResolveTextureLocations()
+ *
+ *  This method is used for filling in the texture array and
+ *  layer that each queued packet is drawn from.  Textures
+ *  that are still loading are drawn from the placeholder.
+ ***********************************************************/
+void SceneManager::ResolveTextureLocations(RenderQueue& renderQueue)
+{
+	for (int i = 0; i < renderQueue.GetCount(); i++)
+	{
+		DRAW_PACKET& packet = renderQueue.GetPacket(i);
+		if (packet.texture >= 0)
+		{
+			const TEXTURE_LOCATION& location = m_textureLoader->GetLocation(packet.texture);
+			packet.textureArray = location.array;
+			packet.textureLayer = location.layer;
+		}
+	}
+}
 
 /***********************************************************
- *  SetShaderColor()
+ *  SubmitVisibleObjects()
  *
- *  This method is used for setting the passed in color
- *  into the shader for the next draw command
+ *  This method is used for turning the scene objects that
+ *  passed the frustum culling into draw packets.
+ ***********************************************************/
+void SceneManager::SubmitVisibleObjects(SCENE_FRAME& frame)
+{
+	const SCENE_OBJECT* objects = m_sceneFile.GetObjects();
+
+	frame.renderQueue.Begin(frame.arena, frame.visibleCount);
+
+	for (int v = 0; v < frame.visibleCount; v++)
+	{
+		const int sphere = frame.visibleSpheres[v];
+		const int i = m_cullObjects[sphere];
+		const SCENE_OBJECT& object = objects[i];
+		DRAW_PACKET packet;
+
+		packet.mesh = object.mesh;
+		packet.lod = SelectObjectLod(sphere, object.mesh);
+		packet.texture = -1;
+		packet.textureArray = -1;
+		packet.textureLayer = -1;
+		if (object.texture >= 0)
+		{
+			packet.texture = m_textureIDs[m_sceneTextureSlots[object.texture]].handle;
+		}
+		packet.material = (object.material >= 0) ? m_sceneMaterials[object.material] : -1;
+		// some objects cull faces, such as the top of the coffee cup
+		packet.cullMode = DRAW_CULL_NONE;
+		if (object.flags & SCENE_OBJECT_CULL_FRONT)
+			packet.cullMode = DRAW_CULL_FRONT;
+		else if (object.flags & SCENE_OBJECT_CULL_BACK)
+			packet.cullMode = DRAW_CULL_BACK;
+
+		packet.color = glm::vec4(
+			object.color[0] / 255.0f,
+			object.color[1] / 255.0f,
+			object.color[2] / 255.0f,
+			object.color[3] / 255.0f);
+		packet.uvScale = glm::vec2(object.uvScale[0], object.uvScale[1]);
+		packet.transform = m_sceneGraph.GetWorldTransform(i);
+
+		frame.renderQueue.Submit(packet);
+	}
+}
+
+/***********************************************************
+ *  BuildSceneGraph()
  *
- *  Converted to RGBA because thats what I'm use to :)
+ *  This method is used for adding a scene node for every
+ *  object of the loaded scene, attached to the node of its
+ *  parent object, and for remembering the named objects.
  ***********************************************************/
-void SceneManager::SetShaderColor(int r, int g, int b, int a = 255)
+void SceneManager::BuildSceneGraph()
 {
-	float redColorValue = std::max(0, std::min(255, r));
-	float greenColorValue = std::max(0, std::min(255, g));
-	float blueColorValue = std::max(0, std::min(255, b));
-	float alphaValue = std::max(0, std::min(255, a));
+	const SCENE_OBJECT* objects = m_sceneFile.GetObjects();
+	const int objectCount = m_sceneFile.GetObjectCount();
+
+	m_sceneGraph.Clear();
+	m_objectNames.Clear();
+	m_namedObjects.clear();
+	m_cullObjects.clear();
+	m_sphereLods.clear();
+	m_bCullBoundsDirty = true;
+
+	for (int i = 0; i < objectCount; i++)
+	{
+		const SCENE_OBJECT& object = objects[i];
 
-	// variables for this method
-	glm::vec4 currentColor;
+		// the node of each object has the same index as the object
+		m_sceneGraph.AddNode(object.parent,
+			glm::vec3(object.scale[0], object.scale[1], object.scale[2]),
+			glm::vec3(object.rotation[0], object.rotation[1], object.rotation[2]),
+			glm::vec3(object.position[0], object.position[1], object.position[2]));
 
-	currentColor.r = redColorValue / 255.0f;
-	currentColor.g = greenColorValue / 255.0f;
-	currentColor.b = blueColorValue / 255.0f;
-	currentColor.a = alphaValue / 255.0f;
+		const char* name = m_sceneFile.GetObjectName(i);
+		if ((name[0] != '\0') && (m_objectNames.Intern(name) == (int)m_namedObjects.size()))
+		{
+			m_namedObjects.push_back(i);
+		}
 
-	if (NULL != m_pShaderManager)
+		// groups only move the objects attached to them, so they
+		// are never drawn and need no bounds
+		if ((object.flags & SCENE_OBJECT_GROUP) == 0)
+		{
+			m_cullObjects.push_back(i);
+		}
+	}
+}
+
+/***********************************************************
+ *  UpdateCullBounds()
+ *
+ *  This method is used for placing the bounding sphere of
+ *  every drawable object around its shape, at its current
+ *  world transform.  It is only needed when something moved.
+ ***********************************************************/
+void SceneManager::UpdateCullBounds()
+{
+	const SCENE_OBJECT* objects = m_sceneFile.GetObjects();
+	const int sphereCount = (int)m_cullObjects.size();
+
+	m_frustumCuller.Resize(sphereCount);
+	// new objects start out at the finest level of detail
+	m_sphereLods.resize(sphereCount, 0);
+	for (int s = 0; s < sphereCount; s++)
+	{
+		const int i = m_cullObjects[s];
+		m_frustumCuller.SetSphere(s, m_sceneGraph.GetWorldTransform(i),
+			m_basicMeshes->GetBoundingSphere(objects[i].mesh));
+	}
+
+	m_bCullBoundsDirty = false;
+}
+
+/***********************************************************
+ *  CullSceneObjects()
+ *
+ *  This method is used for finding the bounding spheres of
+ *  the drawable objects that are inside the view frustum,
+ *  and not hidden behind other objects.  Every object is
+ *  visible until a view has been set.
+ ***********************************************************/
+void SceneManager::CullSceneObjects(SCENE_FRAME& frame)
+{
+	const int sphereCount = m_frustumCuller.GetCount();
+
+	// room for every sphere, whatever the culling finds
+	frame.visibleSpheres = frame.arena.AllocateArray<int>(sphereCount);
+	if (m_bFrustumCulling == true)
+	{
+		frame.visibleCount = m_frustumCuller.Cull(m_frustumPlanes, frame.visibleSpheres);
+	}
+	else
+	{
+		for (int s = 0; s < sphereCount; s++)
+		{
+			frame.visibleSpheres[s] = s;
+		}
+		frame.visibleCount = sphereCount;
+	}
+
+	frame.objectsCulled = sphereCount - frame.visibleCount;
+	frame.objectsOccluded = 0;
+	if ((m_bFrustumCulling == true) && (m_bOcclusionCulling == true))
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
+		ProfileZone zone(m_pProfiler, "occlusion");
+		OccludeSceneObjects(frame);
 	}
+	frame.objectsVisible = frame.visibleCount;
 }
 
 /***********************************************************
- *  SetShaderTexture()
+ *  OccludeSceneObjects()
  *
- *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
+ *  This method is used for removing the visible spheres that
+ *  are hidden.  The visible objects that can be occluders and
+ *  cover enough of the screen are drawn into the depth buffer
+ *  first, and then every visible sphere is tested against it,
+ *  including the occluders, which can be hidden by others.
  ***********************************************************/
-void SceneManager::SetShaderTexture(
-	std::string textureTag)
+void SceneManager::OccludeSceneObjects(SCENE_FRAME& frame)
 {
-	if (NULL != m_pShaderManager)
+	const SCENE_OBJECT* objects = m_sceneFile.GetObjects();
+
+	m_occlusionCuller.BeginFrame(m_viewMatrix, m_projectionMatrix);
+	for (int v = 0; v < frame.visibleCount; v++)
+	{
+		const int sphere = frame.visibleSpheres[v];
+		const int i = m_cullObjects[sphere];
+		if ((IsOccluder(objects[i]) == true) && (GetScreenSize(sphere) >= g_MinOccluderSize))
+		{
+			m_occlusionCuller.AddOccluder(objects[i].mesh, m_sceneGraph.GetWorldTransform(i));
+		}
+	}
+	if (m_occlusionCuller.GetStats().occluders == 0)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
+		return;
+	}
+	m_occlusionCuller.BuildPyramid();
 
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+	int visibleCount = 0;
+	for (int v = 0; v < frame.visibleCount; v++)
+	{
+		const int sphere = frame.visibleSpheres[v];
+		if (m_occlusionCuller.IsOccluded(m_frustumCuller.GetSphere(sphere)) == false)
+		{
+			frame.visibleSpheres[visibleCount++] = sphere;
+		}
 	}
+	frame.objectsOccluded = frame.visibleCount - visibleCount;
+	frame.visibleCount = visibleCount;
 }
 
 /***********************************************************
- *  SetTextureUVScale()
+ *  IsOccluder()
  *
- *  This method is used for setting the texture UV scale
- *  values into the shader.
+ *  This method is used for checking whether an object can be
+ *  drawn into the occlusion depth buffer.  It has to have a
+ *  shape with flat sides, and be solid - translucent objects
+ *  and objects with a culled side can be seen through.
  ***********************************************************/
-void SceneManager::SetTextureUVScale(float u, float v)
+bool SceneManager::IsOccluder(const SCENE_OBJECT& object) const
 {
-	if (NULL != m_pShaderManager)
+	return((m_occlusionCuller.IsOccluderShape(object.mesh) == true) &&
+		(object.color[3] == 255) &&
+		((object.flags & (SCENE_OBJECT_CULL_FRONT | SCENE_OBJECT_CULL_BACK)) == 0));
+}
+
+/***********************************************************
+ *  GetScreenSize()
+ *
+ *  This method is used for getting the fraction of the screen
+ *  height that a sphere covers in the current view, which is
+ *  the whole screen when the camera is inside of it.
+ ***********************************************************/
+float SceneManager::GetScreenSize(int sphere) const
+{
+	// the w of the center in clip space is its depth for perspective
+	// projections, and one for orthographic projections
+	glm::vec4 bounds = m_frustumCuller.GetSphere(sphere);
+	glm::vec4 center = m_projectionMatrix * (m_viewMatrix * glm::vec4(bounds.x, bounds.y, bounds.z, 1.0f));
+	float screenSize = 1.0f;
+	if (center.w > bounds.w)
 	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
+		screenSize = bounds.w * std::fabs(m_projectionMatrix[1][1]) / center.w;
 	}
+
+	return(screenSize);
 }
 
 /***********************************************************
- *  SetShaderMaterial()
+ *  SelectObjectLod()
  *
- *  This method is used for passing the material values
- *  into the shader.
+ *  This method is used for picking the level of detail of the
+ *  object of a visible sphere, from the fraction of the
+ *  screen height that the sphere covers in the current view.
+ *  Objects are drawn at the finest level until a view has
+ *  been set, and when the camera is inside their sphere.
  ***********************************************************/
-void SceneManager::SetShaderMaterial(
-	std::string materialTag)
+uint32_t SceneManager::SelectObjectLod(int sphere, uint32_t mesh)
 {
-	if (m_objectMaterials.size() > 0)
+	if (m_bFrustumCulling == false)
 	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
+		return(0);
+	}
+
+	m_sphereLods[sphere] = m_basicMeshes->SelectLod(mesh, GetScreenSize(sphere), m_sphereLods[sphere]);
+
+	return(m_sphereLods[sphere]);
+}
 
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
+/***********************************************************
+ *  PlaceSceneLights()
+ *
+ *  This method is used for placing the lights that are
+ *  attached to objects at the world transform of the object.
+ ***********************************************************/
+void SceneManager::PlaceSceneLights()
+{
+	for (int i = 0; i < m_sceneFile.GetLightCount(); i++)
+	{
+		const SCENE_LIGHT_RECORD& record = m_sceneFile.GetLight(i);
+		if (record.parent >= 0)
 		{
-			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
-			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+			glm::vec4 position = m_sceneGraph.GetWorldTransform(record.parent) *
+				glm::vec4(record.position[0], record.position[1], record.position[2], 1.0f);
+			m_lightClusters->SetLightPosition(i, glm::vec3(position.x, position.y, position.z));
 		}
 	}
+
+	m_bLightsDirty = false;
 }
 
 /***********************************************************
-*  DefineObjectMaterials()
-*
-*  This method is used for configuring the various material
-*  settings for all of the objects within the 3D scene.
-***********************************************************/
-void SceneManager::DefineObjectMaterials()
+ *  SetViewFrustum()
+ *
+ *  This method is used for setting the view and projection
+ *  of the frame, so that the objects outside of the view
+ *  frustum are not drawn, and the lights are binned into the
+ *  clusters of the view.  Until a view is set, every light
+ *  is put in every cluster.
+ ***********************************************************/
+void SceneManager::SetViewFrustum(const glm::mat4& view, const glm::mat4& projection)
 {
-	/*** STUDENTS - add the code BELOW for defining object materials. ***/
-	/*** There is no limit to the number of object materials that can ***/
-	/*** be defined. Refer to the code in the OpenGL Sample for help  ***/
-
-  OBJECT_MATERIAL porcelain;
-
-  porcelain.tag = "porcelain";
-  porcelain.ambientColor = glm::vec3(0.25f, 0.25f, 0.3f);
-  porcelain.ambientStrength = 0.15f;
-  porcelain.diffuseColor = glm::vec3(0.9f, 0.9f, 0.9f);
-  porcelain.specularColor = glm::vec3(0.7f, 0.7f, 0.7f);
-  porcelain.shininess = 50.0f;
-  m_objectMaterials.push_back(porcelain);
-
-  OBJECT_MATERIAL gold;
-	gold.tag = "gold";
-	gold.ambientColor = glm::vec3(0.247f, 0.199f, 0.074f);
-	gold.ambientStrength = 0.3f;
-	gold.diffuseColor = glm::vec3(0.751f, 0.606f, 0.226f);
-	gold.specularColor = glm::vec3(0.628f, 0.556f, 0.366f);
-	gold.shininess = 51.2f;
-	m_objectMaterials.push_back(gold);
-
-	OBJECT_MATERIAL silver;
-	silver.tag = "silver";
-	silver.ambientColor = glm::vec3(0.192f, 0.192f, 0.192f);
-	silver.ambientStrength = 0.25f;
-	silver.diffuseColor = glm::vec3(0.507f, 0.507f, 0.507f);
-	silver.specularColor = glm::vec3(0.508f, 0.508f, 0.508f);
-	silver.shininess = 51.2f;
-	m_objectMaterials.push_back(silver);
-
-	OBJECT_MATERIAL bronze;
-	bronze.tag = "bronze";
-	bronze.ambientColor = glm::vec3(0.2125f, 0.1275f, 0.054f);
-	bronze.ambientStrength = 0.25f;
-	bronze.diffuseColor = glm::vec3(0.714f, 0.4284f, 0.18144f);
-	bronze.specularColor = glm::vec3(0.393f, 0.271f, 0.166f);
-	bronze.shininess = 25.6f;
-	m_objectMaterials.push_back(bronze);
+	m_frustumPlanes = FrustumCuller::ExtractPlanes(projection * view);
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+	m_bFrustumCulling = true;
 }
 
 /***********************************************************
- *  SetupSceneLights()
+ *  SetOcclusionCulling()
  *
- *  This method is called to add and configure the light
- *  sources for the 3D scene.  There are up to 4 light sources.
+ *  This method is used for choosing whether the objects that
+ *  are hidden behind large solid objects are skipped.  It
+ *  only has an effect once a view has been set.
  ***********************************************************/
-void SceneManager::SetupSceneLights()
+void SceneManager::SetOcclusionCulling(bool bEnabled)
+{
+	m_bOcclusionCulling = bEnabled;
+}
+
+/***********************************************************
+ *  SetProfiler()
+ *
+ *  This method is used for timing the sections of the scene
+ *  rendering and each draw group as zones of the passed in
+ *  profiler.
+ ***********************************************************/
+void SceneManager::SetProfiler(FrameProfiler* pProfiler)
 {
-	// this line of code is NEEDED for telling the shaders to render 
-	// the 3D scene with custom lighting, if no light sources have
-	// been added then the display window will be black - to use the 
-	// default OpenGL lighting then comment out the following line
-	//m_pShaderManager->setBoolValue(g_UseLightingName, true);
+	m_pProfiler = pProfiler;
+}
 
-	/*** STUDENTS - add the code BELOW for setting up light sources ***/
-	/*** Up to four light sources can be defined. Refer to the code ***/
-	/*** in the OpenGL Sample for help                              ***/
+/***********************************************************
+ *  SetTransformThreads()
+ *
+ *  This method is used for calculating the local transforms
+ *  of large updates of the scene graph on extra threads.
+ ***********************************************************/
+void SceneManager::SetTransformThreads(int threadCount)
+{
+	m_sceneGraph.SetWorkerCount(threadCount);
+}
 
-  m_pShaderManager->setVec3Value("lightSources[0].position", 3.0f, 14.0f, 0.0f);
-  m_pShaderManager->setVec3Value("lightSources[0].ambientColor", 0.85f, 0.75f, 0.65f);
-  m_pShaderManager->setVec3Value("lightSources[0].diffuseColor", 0.95f, 0.85f, 0.75f);
-  m_pShaderManager->setVec3Value("lightSources[0].specularColor", 0.95f, 0.85f, 0.75f);
-  m_pShaderManager->setFloatValue("lightSources[0].focalStrength", 32.0f);
-  m_pShaderManager->setFloatValue("lightSources[0].specularIntensity", 0.05f);
+/***********************************************************
+ *  FinishTextureLoads()
+ *
+ *  This method is used for waiting until every texture of
+ *  the scene has been decoded and uploaded.
+ ***********************************************************/
+void SceneManager::FinishTextureLoads()
+{
+	m_textureLoader->FinishAll();
+}
 
-  m_pShaderManager->setVec3Value("lightSources[1].position", -5.0f, 10.0f, 5.0f);
-  m_pShaderManager->setVec3Value("lightSources[1].ambientColor", 0.0f, 0.0f, 0.0f);
-  m_pShaderManager->setVec3Value("lightSources[1].diffuseColor", 0.75f, 0.75f, 0.85f);
-  m_pShaderManager->setVec3Value("lightSources[1].specularColor", 0.0f, 0.0f, 0.0f);
-  m_pShaderManager->setFloatValue("lightSources[1].focalStrength", 1.0f);
-  m_pShaderManager->setFloatValue("lightSources[1].specularIntensity", 0.1f);
+/***********************************************************
+ *  SetTextureCompression()
+ *
+ *  This method is used for choosing whether the textures of
+ *  the scene are cooked and loaded block compressed, which
+ *  uses less GPU memory at some cost in quality.
+ ***********************************************************/
+void SceneManager::SetTextureCompression(bool bCompress)
+{
+	m_textureLoader->SetCompression(bCompress);
+}
 
+/***********************************************************
+ *  ReloadShaderUniforms()
+ *
+ *  This method is used for looking up the per-draw uniforms
+ *  of the shader program in use again, after the shaders were
+ *  changed and linked into a new program, and for setting
+ *  the uniforms that are only set once into it.
+ ***********************************************************/
+void SceneManager::ReloadShaderUniforms()
+{
+	ResolveShaderUniforms();
 
-  // Enable lighting in the shader
-  m_pShaderManager->setBoolValue("bUseLighting", true);
+	m_pShaderManager->setBoolValue(g_UseLightingName, m_lightClusters->GetLightCount() > 0);
 }
 
 /***********************************************************
- *  PrepareScene()
+ *  ReloadTextureFile()
  *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene 
- *  rendering
+ *  This method is used for loading the scene textures that
+ *  are made from a file again, after the file changed.  Each
+ *  texture keeps its handle and shows its old image until the
+ *  new one has been uploaded.
  ***********************************************************/
-void SceneManager::PrepareScene()
+int SceneManager::ReloadTextureFile(const std::string& filename)
 {
-  
-	// Load textures
-	CreateGLTexture("Textures/floor.jpg", "floor");
-	CreateGLTexture("Textures/coffee_body.jpg", "coffeeBody");
-	CreateGLTexture("Textures/coffee_liquid.jpg", "coffeeLiquid");
-	CreateGLTexture("Textures/laptop.jpg", "laptop");
-	CreateGLTexture("Textures/mouse.jpg", "mouse");
+	int reloaded = 0;
 
-	// Bind the textures to texture slots
-	BindGLTextures();
+	for (int i = 0; i < m_sceneFile.GetTextureCount(); i++)
+	{
+		if (filename == m_sceneFile.GetTexturePath(i))
+		{
+			m_textureLoader->Reload(m_textureIDs[m_sceneTextureSlots[i]].handle, filename);
+			reloaded++;
+		}
+	}
 
-  // add and define the light sources for the scene
-	SetupSceneLights();
+	return(reloaded);
+}
 
-	// only one instance of a particular mesh needs to be
-	// loaded in memory no matter how many times it is drawn
-	// in the rendered 3D scene
+/***********************************************************
+ *  ReloadMaterials()
+ *
+ *  This method is used for parsing the scene text file again
+ *  after it changed, and copying the values of the materials
+ *  that differ into the defined materials, which are packed
+ *  into the material buffer again when the next frame is
+ *  drawn.  Only existing materials are changed, since the
+ *  objects and lights are used by the update of the frames
+ *  and are left as they were loaded.
+ ***********************************************************/
+int SceneManager::ReloadMaterials(const char* sceneFilename)
+{
+	SceneFile changedScene;
+	int changed = 0;
+
+	if (changedScene.LoadText(sceneFilename) == false)
+	{
+		return(0);
+	}
+
+	for (int i = 0; i < changedScene.GetMaterialCount(); i++)
+	{
+		int materialHandle = FindMaterial(changedScene.GetMaterialTag(i));
+		if (materialHandle < 0)
+		{
+			std::cout << "Restart to use the new material:" << changedScene.GetMaterialTag(i) << std::endl;
+			continue;
+		}
+
+		const SCENE_MATERIAL_RECORD& record = changedScene.GetMaterial(i);
+		OBJECT_MATERIAL& material = m_objectMaterials[materialHandle];
+		glm::vec3 ambientColor(record.ambientColor[0], record.ambientColor[1], record.ambientColor[2]);
+		glm::vec3 diffuseColor(record.diffuseColor[0], record.diffuseColor[1], record.diffuseColor[2]);
+		glm::vec3 specularColor(record.specularColor[0], record.specularColor[1], record.specularColor[2]);
+		if ((material.ambientColor == ambientColor) &&
+			(material.ambientStrength == record.ambientStrength) &&
+			(material.diffuseColor == diffuseColor) &&
+			(material.specularColor == specularColor) &&
+			(material.shininess == record.shininess))
+		{
+			continue;
+		}
+
+		material.ambientColor = ambientColor;
+		material.ambientStrength = record.ambientStrength;
+		material.diffuseColor = diffuseColor;
+		material.specularColor = specularColor;
+		material.shininess = record.shininess;
+		changed++;
+	}
+
+	if (changed > 0)
+	{
+		m_bMaterialsDirty = true;
+	}
 
-  
-  m_basicMeshes->LoadBoxMesh();
-  m_basicMeshes->LoadConeMesh();
-  m_basicMeshes->LoadCylinderMesh();
-  m_basicMeshes->LoadPlaneMesh();
-  m_basicMeshes->LoadPrismMesh();
-  m_basicMeshes->LoadSphereMesh();
-  m_basicMeshes->LoadTaperedCylinderMesh();
-  m_basicMeshes->LoadTorusMesh();
+	return(changed);
 }
 
 /***********************************************************
- *  RenderScene()
+ *  FindSceneObject()
+ *
+ *  This method is used for finding a scene object or group
+ *  by the name it was given in the scene file.
+ ***********************************************************/
+int SceneManager::FindSceneObject(const std::string& name) const
+{
+	int handle = m_objectNames.Find(name);
+
+	return (handle == TagRegistry::INVALID_TAG) ? -1 : m_namedObjects[handle];
+}
+
+/***********************************************************
+ *  SetObjectTransform()
+ *
+ *  This method is used for moving a scene object or group
+ *  relative to its parent.  Everything attached to it moves
+ *  along on the next rendered frame.
+ ***********************************************************/
+void SceneManager::SetObjectTransform(int object, glm::vec3 scaleXYZ,
+	glm::vec3 rotationDegrees, glm::vec3 positionXYZ)
+{
+	m_sceneGraph.SetLocalTransform(object, scaleXYZ, rotationDegrees, positionXYZ);
+}
+
+/***********************************************************
+ *  GetRenderStats()
+ *
+ *  This method is used for getting the draw and state change
+ *  counts of the last rendered frame.
+ ***********************************************************/
+const RENDER_QUEUE_STATS& SceneManager::GetRenderStats() const
+{
+	return(m_renderStats);
+}
+
+/***********************************************************
+ *  GetLightStats()
  *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
- ***********************************************************/
-void SceneManager::RenderScene()
-{
-	//================================================================//
-	//= Floor Plane                       						               =//
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		glm::vec3(20.0f, 1.0f, 10.0f), // XYZ Scale
-		0.0f, 0.0f, 0.0f,              // XYZ Rotation
-		glm::vec3(0.0f, 0.0f, 0.0f)    // XYZ Position
-  );
-
-	// set the color values into the shader
-	SetShaderColor(255, 255, 255);
-
-  // set the texture into the shader
-  SetShaderTexture("floor");
-
-  // set the material into the shader
-  SetShaderMaterial("porcelain");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
-	//================================================================//
-
-	//================================================================//
-	//= Coffee Cup Body                   						               =//
-  glEnable(GL_CULL_FACE); // Enable face culling
-  glCullFace(GL_FRONT);   // Cull the front face to remove the top surface
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		glm::vec3(1.0f, 4.0f, 1.0f),   // XYZ Scale
-		0.0f, 0.0f, 0.0f,              // XYZ Rotation
-		glm::vec3(0.0f, 0.0f, 0.0f)    // XYZ Position
-  );
-
-	// set the color values into the shader
-	SetShaderColor(221, 204, 176);
-
-  // set the texture into the shader
-	SetShaderTexture("coffeeBody");
-
-  // set the material into the shader
-  SetShaderMaterial("porcelain");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawCylinderMesh();
-  glDisable(GL_CULL_FACE); // Redisbale face culling
-	//=================================================================//
-  
-	//================================================================//
-	//= Coffee                             						               =//
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		glm::vec3(0.9f, 3.5f, 0.9f),   // XYZ Scale
-		0.0f, 0.0f, 0.0f,              // XYZ Rotation
-		glm::vec3(0.0f, 0.0f, 0.0f)    // XYZ Position
-  );
-
-	// set the color values into the shader
-	SetShaderColor(108, 88, 76);
-
-  // set the texture into the shader
-	SetShaderTexture("coffeeLiquid");
-
-  // set the material into the shader
-  SetShaderMaterial("porcelain");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawCylinderMesh();
-	//=================================================================//
-
-	//================================================================//
-	//= Coffee Cup Handle                 						               =//
-	SetTransformations(
-		glm::vec3(0.6f, 1.0f, 0.4f),     // XYZ Scale
-		0.0f, glm::radians(90.0f), 0.0f, // XYZ Rotation 
-                                     //   (with a 90° radian for the Y)
-		glm::vec3(0.8f, 2.0f, 0.0f)      // XYZ Position
-  );
-
-	// set the color values into the shader
-	SetShaderColor(221, 204, 176);
-
-  // set the material into the shader
-  SetShaderMaterial("porcelain");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTorusMesh();
-	//=================================================================//
-
-	//================================================================//
-	//= Laptop                            						               =//
-	SetTransformations(
-		glm::vec3(12.0f, 0.75f, 6.0f), // XYZ Scale
-		0.0f, 35.0f, 0.0f,             // XYZ Rotation
-		glm::vec3(-8.0f, 0.0f, 0.0f)   // XYZ Position
-  );
-
-	// set the color values into the shader
-	SetShaderColor(206, 212, 218);
-
-  // set the material into the shader
-  SetShaderMaterial("silver");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-	//=================================================================//
-  
-	//================================================================//
-	//= Laptop Top                         						               =//
-	SetTransformations(
-		glm::vec3(6.0f, 0.75f, 3.0f),  // XYZ Scale
-		0.0f, 35.0f, 0.0f,             // XYZ Rotation
-		glm::vec3(-8.0f, 0.40f, 0.0f)  // XYZ Position
-  );
-
-	// set the color values into the shader
-	SetShaderColor(206, 212, 218);
-
-  // set the texture into the shader
-  //   ( I've since stickered my laptop since taking that first picture )
-	SetShaderTexture("laptop");
-
-  // set the material into the shader
-  SetShaderMaterial("silver");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
-	//=================================================================//
-
-	//================================================================//
-	//= Mouse                             						               =//
-	SetTransformations(
-		glm::vec3(1.0f, 0.75f, 2.0f),  // XYZ Scale
-		0.0f, 35.0f, 0.0f,             // XYZ Rotation
-		glm::vec3(4.0f, 0.0f, 0.0f)    // XYZ Position
-  );
-
-	// set the color values into the shader
-	SetShaderColor(100, 100, 100);
-
-  // set the texture into the shader
-	SetShaderTexture("mouse");
-
-  // set the material into the shader
-  SetShaderMaterial("gold");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawSphereMesh();
-	//=================================================================//
-
-	//================================================================//
-	//= Remote                            						               =//
-	SetTransformations(
-		glm::vec3(1.0f, 0.45f, 4.0f),   // XYZ Scale
-		0.0f, 35.0f, 0.0f,              // XYZ Rotation
-		glm::vec3(-4.0f, 0.75f, -3.0f)  // XYZ Position
-  );
-
-	// set the color values into the shader
-	SetShaderColor(0, 0, 0);
-
-  // set the material into the shader
-  SetShaderMaterial("bronze");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-	//=================================================================//
+ *  This method is used for getting the light counts of the
+ *  last rendered frame.
+ ***********************************************************/
+const LIGHT_CLUSTER_STATS& SceneManager::GetLightStats() const
+{
+	return(m_lightStats);
 }
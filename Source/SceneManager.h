@@ -10,7 +10,18 @@
 #pragma once
 
 #include "ShaderManager.h"
-#include "ShapeMeshes.h"
+#include "InstancedMeshes.h"
+#include "ShaderUniforms.h"
+#include "TagRegistry.h"
+#include "SceneFile.h"
+#include "SceneGraph.h"
+#include "RenderQueue.h"
+#include "FrameArena.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+#include "LightClusters.h"
+#include "FrameProfiler.h"
+#include "TextureLoader.h"
 
 #include <string>
 #include <vector>
@@ -19,7 +30,11 @@
  *  SceneManager
  *
  *  This class contains the code for preparing and rendering
- *  3D scenes, including the shader settings.
+ *  3D scenes, including the shader settings.  A frame is
+ *  updated into one of several frame states, without making
+ *  any OpenGL calls, and rendered from that state later on the
+ *  thread that owns the context, so the next frame can be
+ *  updated while the last one is still being rendered.
  ***********************************************************/
 class SceneManager
 {
@@ -32,7 +47,8 @@ public:
 	struct TEXTURE_INFO
 	{
 		std::string tag;
-		uint32_t ID;
+		// handle of the texture in the texture loader
+		int handle;
 	};
 
 	struct OBJECT_MATERIAL
@@ -45,60 +61,209 @@ public:
 		std::string tag;
 	};
 
+	// handles to the shader uniforms that are set for every draw
+	struct SHADER_UNIFORMS
+	{
+		UniformHandle<bool> useInstancing;
+		UniformHandle<int> objectTexture;
+		UniformHandle<bool> useTexture;
+	};
+
 private:
+	// a material as the shaders read it from the material buffer,
+	// laid out as std430
+	struct GPU_MATERIAL
+	{
+		// ambient color in rgb and ambient strength in w
+		glm::vec4 ambientColor;
+		// diffuse color in rgb and shininess in w
+		glm::vec4 diffuseColor;
+		glm::vec4 specularColor;
+	};
+
+	// everything the update of a frame hands over to its rendering
+	struct SCENE_FRAME
+	{
+		// memory of everything below that only lasts for the frame,
+		// which its update and rendering both allocate from
+		FrameArena arena;
+		RenderQueue renderQueue;
+		// spheres found visible by the culling, in the arena
+		int* visibleSpheres;
+		int visibleCount;
+		int transformUpdates;
+		int objectsVisible;
+		int objectsCulled;
+		int objectsOccluded;
+	};
+
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
-	// pointer to basic shapes object
-	ShapeMeshes* m_basicMeshes;
-  // total number of loaded textures
-	int m_loadedTextures;
-	// loaded textures info
-	TEXTURE_INFO m_textureIDs[16];
-	// defined object materials
+	// resolved uniforms of the shader program in use
+	ShaderUniforms* m_pUniforms;
+	// times the sections of the rendered frames, when profiling
+	FrameProfiler* m_pProfiler;
+	SHADER_UNIFORMS m_uniforms;
+	// pointer to basic shapes object, drawn with instancing
+	InstancedMeshes* m_basicMeshes;
+	// decodes and uploads the textures in the background
+	TextureLoader* m_textureLoader;
+	// bins the lights into the clusters of the view every frame
+	LightClusters* m_lightClusters;
+	// loaded textures info, indexed by texture slot
+	std::vector<TEXTURE_INFO> m_textureIDs;
+	// defined object materials, and the storage buffer that the
+	// shaders read them from at the index of their handle, which is
+	// uploaded again before the next draw once a material changed
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	GLuint m_materialBuffer;
+	bool m_bMaterialsDirty;
+	// handles of the texture and material tags - a texture handle
+	// is its slot and a material handle is its index in the list
+	TagRegistry m_textureTags;
+	TagRegistry m_materialTags;
+	// loaded scene description, with the texture slots and material
+	// handles of the textures and materials listed in the scene file
+	SceneFile m_sceneFile;
+	std::vector<int> m_sceneTextureSlots;
+	std::vector<int> m_sceneMaterials;
+	// cached transforms of the scene objects, one node per object,
+	// and the objects that can be found by name
+	SceneGraph m_sceneGraph;
+	TagRegistry m_objectNames;
+	std::vector<int> m_namedObjects;
+	// frame states that are updated and rendered in turn, and the
+	// state change counts and arena use of the last rendered frame
+	std::vector<SCENE_FRAME> m_frames;
+	RENDER_QUEUE_STATS m_renderStats;
+	FRAME_ARENA_STATS m_arenaStats;
+	// world bounding spheres of the drawable objects, and the object
+	// of each sphere
+	FrustumCuller m_frustumCuller;
+	std::vector<int> m_cullObjects;
+	// level of detail that each sphere's object was last drawn with
+	std::vector<uint32_t> m_sphereLods;
+	// planes of the view frustum, and the view and projection that
+	// the lights are binned for, once a view has been set
+	FRUSTUM_PLANES m_frustumPlanes;
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	bool m_bFrustumCulling;
+	// depth buffer of the large objects in view, which hides the
+	// objects behind them once a view has been set
+	OcclusionCuller m_occlusionCuller;
+	bool m_bOcclusionCulling;
+	// whether the spheres have to be placed again
+	bool m_bCullBoundsDirty;
+	// whether the lights attached to objects have to be placed again,
+	// and the light counts of the last rendered frame
+	bool m_bLightsDirty;
+	LIGHT_CLUSTER_STATS m_lightStats;
+
+	// resolve the handles of the per-draw shader uniforms
+	void ResolveShaderUniforms();
 
 	// load texture images and convert to OpenGL texture data
 	bool CreateGLTexture(const char* filename, std::string tag);
-	// bind loaded OpenGL textures to slots in memory
+	// bind the texture arrays of the loaded textures to texture units
 	void BindGLTextures();
 	// free the loaded OpenGL textures
 	void DestroyGLTextures();
-	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
-	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
-
-	// set the transformation values 
-	// into the transform buffer
-	void SetTransformations(
-		glm::vec3 scaleXYZ,
-		float XrotationDegrees,
-		float YrotationDegrees,
-		float ZrotationDegrees,
-		glm::vec3 positionXYZ);
-
-	// set the color values into the shader
-	void SetShaderColor(int r, int g, int b, int a);
-
-	// set the texture data into the shader
-	void SetShaderTexture(
-		std::string textureTag);
-
-	// set the UV scale for the texture mapping
-	void SetTextureUVScale(
-		float u, float v);
-
-	// set the object material into the shader
-	void SetShaderMaterial(
-		std::string materialTag);
+	// find the slot of a loaded texture by tag
+	int FindTextureSlot(const std::string& tag) const;
+	// add a material, replacing any material with the same tag
+	void AddObjectMaterial(const OBJECT_MATERIAL& material);
+	// find a defined material handle by tag
+	int FindMaterial(const std::string& tag) const;
+	// upload the defined materials into the material buffer if any of
+	// them changed, and bind it for the shaders
+	void UploadMaterials();
+
+	// check whether two sorted packets can be drawn as instances
+	// of the same draw call
+	static bool IsSameBatch(const DRAW_PACKET& first, const DRAW_PACKET& second);
+	// look up the texture array layers of the queued draw packets
+	void ResolveTextureLocations(RenderQueue& renderQueue);
+	// sort and draw the queued draw packets of a frame
+	void FlushRenderQueue(SCENE_FRAME& frame);
+	// load the shapes and textures of the loaded scene file, and place
+	// its objects and lights
+	bool PrepareLoadedScene();
+	// add a scene node for every object of the loaded scene
+	void BuildSceneGraph();
+	// place the bounding spheres of the drawable objects in the world
+	void UpdateCullBounds();
+	// find the drawable objects that are inside the view frustum
+	void CullSceneObjects(SCENE_FRAME& frame);
+	// remove the visible objects that are hidden behind occluders
+	void OccludeSceneObjects(SCENE_FRAME& frame);
+	// check whether a scene object can hide the objects behind it
+	bool IsOccluder(const SCENE_OBJECT& object) const;
+	// add a draw packet for every visible object to the render queue
+	void SubmitVisibleObjects(SCENE_FRAME& frame);
+	// move the lights that are attached to objects along with them
+	void PlaceSceneLights();
+	// get the fraction of the screen height that a sphere covers
+	float GetScreenSize(int sphere) const;
+	// pick the level of detail of an object from its size on the screen
+	uint32_t SelectObjectLod(int sphere, uint32_t mesh);
 
 public:
 
 	// The following methods are for the students to 
 	// customize for their own 3D scene
-	void PrepareScene();
-	void RenderScene();
+	bool PrepareScene(const char* sceneFilename);
+	// prepare a scene of randomly placed objects, with the textures,
+	// materials and lights of the base scene file
+	bool PrepareGeneratedScene(const char* baseSceneFilename, int objectCount, uint32_t seed);
+
+	// set the number of frame states, before updating any frame
+	void SetFrameCount(int frameCount);
+	// update a frame state from the scene and the view frustum,
+	// without any OpenGL calls
+	void UpdateScene(int frame);
+	// draw an updated frame state, on the thread with the context
+	void RenderScene(int frame);
+
+	// draw and state change counts of the last rendered frame
+	const RENDER_QUEUE_STATS& GetRenderStats() const;
+	// light counts of the last rendered frame
+	const LIGHT_CLUSTER_STATS& GetLightStats() const;
+	// memory that the last rendered frame took from its arena
+	const FRAME_ARENA_STATS& GetArenaStats() const { return m_arenaStats; }
+	// skip the objects outside of the view from now on, and bin the
+	// lights into the clusters of the view
+	void SetViewFrustum(const glm::mat4& view, const glm::mat4& projection);
+	// skip the objects hidden behind large objects, once a view is set
+	void SetOcclusionCulling(bool bEnabled);
+	// time the sections of the scene rendering, or stop with NULL
+	void SetProfiler(FrameProfiler* pProfiler);
+	// split the object transforms that move in a frame between this
+	// many threads besides the update thread
+	void SetTransformThreads(int threadCount);
+
+	// wait until every texture of the scene has been loaded
+	void FinishTextureLoads();
+	// store the scene textures block compressed, set before preparing
+	void SetTextureCompression(bool bCompress);
+
+	// the loaded scene, for the files that it was made from
+	const SceneFile& GetSceneFile() const { return m_sceneFile; }
+	// look up the shader uniforms again, after the shader program in
+	// use was replaced
+	void ReloadShaderUniforms();
+	// load the scene textures made from a changed file again, and
+	// return how many there are
+	int ReloadTextureFile(const std::string& filename);
+	// take the changed materials from the scene text file, and return
+	// how many were changed
+	int ReloadMaterials(const char* sceneFilename);
+
+	// find a scene object or group by name, or -1 if there is none
+	int FindSceneObject(const std::string& name) const;
+	// move a scene object or group, along with everything attached to it
+	void SetObjectTransform(int object, glm::vec3 scaleXYZ,
+		glm::vec3 rotationDegrees, glm::vec3 positionXYZ);
 
 	// pre-set light sources for 3D scene
 	void SetupSceneLights();
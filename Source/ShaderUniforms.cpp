@@ -0,0 +1,213 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderuniforms.cpp
+// ============
+// resolve shader uniform locations once and set values through handles
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderUniforms.h"
+#include "GLStateCache.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// cached uniforms for each shader program that has been used
+	std::unordered_map<GLuint, ShaderUniforms*> g_ProgramUniforms;
+	// highest uniform location whose value is kept - drivers hand out
+	// small locations, and a larger one is simply always set
+	const GLint g_MaxKeptLocation = 1024;
+}
+
+/***********************************************************
+ *  ShaderUniforms()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderUniforms::ShaderUniforms(GLuint programID)
+{
+	m_programID = programID;
+}
+
+/***********************************************************
+ *  ForCurrentProgram()
+ *
+ *  This method is used for getting the cached uniforms of
+ *  the shader program that is currently in use, creating
+ *  the cache the first time the program is seen.
+ ***********************************************************/
+ShaderUniforms* ShaderUniforms::ForCurrentProgram()
+{
+	GLint programID = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &programID);
+
+	if (0 == programID)
+	{
+		std::cout << "No shader program is in use for resolving uniforms" << std::endl;
+		return NULL;
+	}
+
+	ShaderUniforms*& uniforms = g_ProgramUniforms[(GLuint)programID];
+	if (NULL == uniforms)
+	{
+		uniforms = new ShaderUniforms((GLuint)programID);
+	}
+
+	return(uniforms);
+}
+
+/***********************************************************
+ *  Release()
+ *
+ *  This method is used for freeing the cached uniforms of
+ *  one shader program, before the program is deleted.
+ ***********************************************************/
+void ShaderUniforms::Release(GLuint programID)
+{
+	auto found = g_ProgramUniforms.find(programID);
+	if (found != g_ProgramUniforms.end())
+	{
+		delete found->second;
+		g_ProgramUniforms.erase(found);
+	}
+}
+
+/***********************************************************
+ *  ReleaseAll()
+ *
+ *  This method is used for freeing the cached uniforms of
+ *  every shader program.
+ ***********************************************************/
+void ShaderUniforms::ReleaseAll()
+{
+	for (auto& entry : g_ProgramUniforms)
+	{
+		delete entry.second;
+	}
+	g_ProgramUniforms.clear();
+}
+
+/***********************************************************
+ *  FindLocation()
+ *
+ *  This method is used for getting the location of a named
+ *  uniform.  The driver is only asked the first time a name
+ *  is resolved, since this involves a string lookup.
+ ***********************************************************/
+GLint ShaderUniforms::FindLocation(const char* name)
+{
+	auto found = m_locations.find(name);
+	if (found != m_locations.end())
+	{
+		return(found->second);
+	}
+
+	GLint location = glGetUniformLocation(m_programID, name);
+	if (location < 0)
+	{
+		// not an error, the compiler removes uniforms that are unused
+		std::cout << "Shader uniform is not active:" << name << std::endl;
+	}
+	m_locations[name] = location;
+
+	return(location);
+}
+
+/***********************************************************
+ *  ForgetValues()
+ *
+ *  This method is used for forgetting the values that were
+ *  set into the uniforms, so that each one is sent again.
+ ***********************************************************/
+void ShaderUniforms::ForgetValues()
+{
+	m_values.clear();
+}
+
+/***********************************************************
+ *  UpdateValue()
+ *
+ *  This method is used for comparing a value with the one
+ *  that was last set into the uniform at the passed in
+ *  location, and keeping it when it differs.  Each check is
+ *  counted in the state cache.
+ ***********************************************************/
+bool ShaderUniforms::UpdateValue(GLint location, const void* value, size_t size)
+{
+	if ((location > g_MaxKeptLocation) || (size > sizeof(UNIFORM_VALUE::data)))
+	{
+		GLStateCache::Current().CountUniform(true);
+		return(true);
+	}
+
+	if ((size_t)location >= m_values.size())
+	{
+		UNIFORM_VALUE unknown;
+		unknown.bKnown = false;
+		m_values.resize(location + 1, unknown);
+	}
+
+	UNIFORM_VALUE& kept = m_values[location];
+	bool bChanged = (kept.bKnown == false) || (std::memcmp(kept.data, value, size) != 0);
+	if (bChanged)
+	{
+		std::memcpy(kept.data, value, size);
+		kept.bKnown = true;
+	}
+
+	GLStateCache::Current().CountUniform(bChanged);
+	return(bChanged);
+}
+
+/***********************************************************
+ *  Set()
+ *
+ *  These methods are used for setting the passed in values
+ *  into the resolved uniforms of the program in use, unless
+ *  the uniform already holds the value.
+ ***********************************************************/
+void ShaderUniforms::Set(UniformHandle<bool> handle, bool value)
+{
+	GLint data = (GLint)value;
+	if (handle.IsValid() && UpdateValue(handle.location, &data, sizeof(data)))
+		glUniform1i(handle.location, data);
+}
+
+void ShaderUniforms::Set(UniformHandle<int> handle, int value)
+{
+	if (handle.IsValid() && UpdateValue(handle.location, &value, sizeof(value)))
+		glUniform1i(handle.location, value);
+}
+
+void ShaderUniforms::Set(UniformHandle<float> handle, float value)
+{
+	if (handle.IsValid() && UpdateValue(handle.location, &value, sizeof(value)))
+		glUniform1f(handle.location, value);
+}
+
+void ShaderUniforms::Set(UniformHandle<glm::vec2> handle, const glm::vec2& value)
+{
+	if (handle.IsValid() && UpdateValue(handle.location, glm::value_ptr(value), sizeof(GLfloat) * 2))
+		glUniform2fv(handle.location, 1, glm::value_ptr(value));
+}
+
+void ShaderUniforms::Set(UniformHandle<glm::vec3> handle, const glm::vec3& value)
+{
+	if (handle.IsValid() && UpdateValue(handle.location, glm::value_ptr(value), sizeof(GLfloat) * 3))
+		glUniform3fv(handle.location, 1, glm::value_ptr(value));
+}
+
+void ShaderUniforms::Set(UniformHandle<glm::vec4> handle, const glm::vec4& value)
+{
+	if (handle.IsValid() && UpdateValue(handle.location, glm::value_ptr(value), sizeof(GLfloat) * 4))
+		glUniform4fv(handle.location, 1, glm::value_ptr(value));
+}
+
+void ShaderUniforms::Set(UniformHandle<glm::mat4> handle, const glm::mat4& value)
+{
+	if (handle.IsValid() && UpdateValue(handle.location, glm::value_ptr(value), sizeof(GLfloat) * 16))
+		glUniformMatrix4fv(handle.location, 1, GL_FALSE, glm::value_ptr(value));
+}
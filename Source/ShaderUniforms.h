@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderuniforms.h
+// ============
+// resolve shader uniform locations once and set values through handles
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  UniformHandle
+ *
+ *  A resolved uniform location, typed by the value that the
+ *  uniform holds so that the matching setter is used.
+ ***********************************************************/
+template <typename T>
+struct UniformHandle
+{
+	GLint location;
+
+	UniformHandle() : location(-1) {}
+	bool IsValid() const { return location >= 0; }
+};
+
+/***********************************************************
+ *  ShaderUniforms
+ *
+ *  This class contains the uniform locations of one shader
+ *  program.  Names are looked up in the driver only the first
+ *  time they are resolved, and the values are then set on
+ *  the program in use through the returned handles.  The last
+ *  value set into each uniform is kept, and setting the same
+ *  value again is skipped, so a uniform that is set on every
+ *  draw only reaches the driver when it changes.
+ ***********************************************************/
+class ShaderUniforms
+{
+public:
+	// get the cached uniforms for the shader program in use
+	static ShaderUniforms* ForCurrentProgram();
+	// free the cached uniforms of a shader program that is deleted,
+	// since its name can be handed out again to a new program
+	static void Release(GLuint programID);
+	// free the cached uniforms for all shader programs
+	static void ReleaseAll();
+
+	// resolve the named uniform into a typed handle
+	template <typename T>
+	UniformHandle<T> Resolve(const char* name)
+	{
+		UniformHandle<T> handle;
+		handle.location = FindLocation(name);
+		return handle;
+	}
+
+	// set the values of resolved uniforms in the shader
+	void Set(UniformHandle<bool> handle, bool value);
+	void Set(UniformHandle<int> handle, int value);
+	void Set(UniformHandle<float> handle, float value);
+	void Set(UniformHandle<glm::vec2> handle, const glm::vec2& value);
+	void Set(UniformHandle<glm::vec3> handle, const glm::vec3& value);
+	void Set(UniformHandle<glm::vec4> handle, const glm::vec4& value);
+	void Set(UniformHandle<glm::mat4> handle, const glm::mat4& value);
+
+	// get the shader program that the uniforms belong to
+	GLuint GetProgramID() const { return m_programID; }
+	// forget the kept values, such as after the uniforms were set
+	// without these handles or the program was linked again
+	void ForgetValues();
+
+private:
+	// constructor
+	ShaderUniforms(GLuint programID);
+
+	// look up the location of a uniform by name, once per name
+	GLint FindLocation(const char* name);
+
+	// shader program that the uniforms belong to
+	GLuint m_programID;
+	// uniform locations that have been looked up by name
+	std::unordered_map<std::string, GLint> m_locations;
+
+	// the last value set into a uniform, as raw bytes
+	struct UNIFORM_VALUE
+	{
+		bool bKnown;
+		GLfloat data[16];
+	};
+	// kept values, indexed by uniform location
+	std::vector<UNIFORM_VALUE> m_values;
+
+	// check a value against the kept one, and keep it if it differs -
+	// returns true when it has to be sent to the shader
+	bool UpdateValue(GLint location, const void* value, size_t size);
+};
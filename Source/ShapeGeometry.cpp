@@ -0,0 +1,416 @@
+///////////////////////////////////////////////////////////////////////////////
+// shapegeometry.cpp
+// ============
+// generate the vertices and indices of the basic 3D shapes
+//
+//  The shapes follow the same conventions as the course ShapeMeshes:
+//  the box and prism are centered on the origin with a size of one,
+//  the plane lies on XZ from -1 to 1, the cylinder, cone and tapered
+//  cylinder stand on XZ from a height of 0 to 1 with a radius of 1,
+//  the sphere has a radius of 1, and the torus lies on XY.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShapeGeometry.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	const float g_Pi = 3.14159265358979f;
+	// radius of the torus ring and of its tube
+	const float g_TorusRadius = 1.0f;
+	const float g_TorusTubeRadius = 0.2f;
+	// names of the shapes in the scene files, by SCENE_MESH value
+	const char* g_MeshNames[SCENE_MESH_COUNT] = {
+		"box", "cone", "cylinder", "plane",
+		"prism", "sphere", "taperedCylinder", "torus" };
+
+	/***********************************************************
+	 *  AddVertex()
+	 *
+	 *  Append a vertex and return its index.
+	 ***********************************************************/
+	uint32_t AddVertex(SHAPE_GEOMETRY& geometry,
+		float x, float y, float z,
+		float nx, float ny, float nz,
+		float u, float v)
+	{
+		SHAPE_VERTEX vertex = { { x, y, z }, { nx, ny, nz }, { u, v } };
+		geometry.vertices.push_back(vertex);
+		return (uint32_t)(geometry.vertices.size() - 1);
+	}
+
+	/***********************************************************
+	 *  AddTriangle()
+	 *
+	 *  Append a triangle, counter-clockwise seen from outside.
+	 ***********************************************************/
+	void AddTriangle(SHAPE_GEOMETRY& geometry, uint32_t a, uint32_t b, uint32_t c)
+	{
+		geometry.indices.push_back(a);
+		geometry.indices.push_back(b);
+		geometry.indices.push_back(c);
+	}
+
+	/***********************************************************
+	 *  AddQuad()
+	 *
+	 *  Append a flat rectangle around the center point, spanned
+	 *  by the two half-size axes.  The cross product of the
+	 *  axes is the direction that the rectangle faces.
+	 ***********************************************************/
+	void AddQuad(SHAPE_GEOMETRY& geometry, const float center[3],
+		const float uAxis[3], const float vAxis[3], const float normal[3])
+	{
+		const float corners[4][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+		uint32_t first = 0;
+
+		for (int i = 0; i < 4; i++)
+		{
+			float su = corners[i][0];
+			float sv = corners[i][1];
+			uint32_t index = AddVertex(geometry,
+				center[0] + (su * uAxis[0]) + (sv * vAxis[0]),
+				center[1] + (su * uAxis[1]) + (sv * vAxis[1]),
+				center[2] + (su * uAxis[2]) + (sv * vAxis[2]),
+				normal[0], normal[1], normal[2],
+				(su + 1.0f) * 0.5f, (sv + 1.0f) * 0.5f);
+			if (i == 0)
+				first = index;
+		}
+
+		AddTriangle(geometry, first, first + 1, first + 2);
+		AddTriangle(geometry, first, first + 2, first + 3);
+	}
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for building the triangles of the
+ *  passed in shape.  Round shapes use the passed in number
+ *  of slices, so that several levels of detail can be built.
+ ***********************************************************/
+void ShapeGeometry::Build(uint32_t mesh, int slices, SHAPE_GEOMETRY& geometry)
+{
+	geometry.vertices.clear();
+	geometry.indices.clear();
+	slices = std::max(3, slices);
+
+	switch (mesh)
+	{
+	case SCENE_MESH_BOX:
+		BuildBox(geometry);
+		break;
+	case SCENE_MESH_CONE:
+		BuildRevolved(slices, 1.0f, 0.0f, false, geometry);
+		break;
+	case SCENE_MESH_CYLINDER:
+		BuildRevolved(slices, 1.0f, 1.0f, true, geometry);
+		break;
+	case SCENE_MESH_PLANE:
+		BuildPlane(geometry);
+		break;
+	case SCENE_MESH_PRISM:
+		BuildPrism(geometry);
+		break;
+	case SCENE_MESH_SPHERE:
+		BuildSphere(slices, geometry);
+		break;
+	case SCENE_MESH_TAPERED_CYLINDER:
+		BuildRevolved(slices, 1.0f, 0.5f, true, geometry);
+		break;
+	case SCENE_MESH_TORUS:
+		BuildTorus(slices, geometry);
+		break;
+	}
+}
+
+/***********************************************************
+ *  GetMeshName()
+ *
+ *  This method is used for getting the name that the passed
+ *  in shape is written with in scene files.
+ ***********************************************************/
+const char* ShapeGeometry::GetMeshName(uint32_t mesh)
+{
+	return (mesh < SCENE_MESH_COUNT) ? g_MeshNames[mesh] : "unknown";
+}
+
+/***********************************************************
+ *  IsRound()
+ *
+ *  This method is used for checking whether the passed in
+ *  shape is built from slices, so that fewer slices make it
+ *  cheaper to draw.  The flat shapes are always the same.
+ ***********************************************************/
+bool ShapeGeometry::IsRound(uint32_t mesh)
+{
+	return((mesh != SCENE_MESH_BOX) && (mesh != SCENE_MESH_PLANE) &&
+		(mesh != SCENE_MESH_PRISM) && (mesh < SCENE_MESH_COUNT));
+}
+
+/***********************************************************
+ *  GetLodSlices()
+ *
+ *  This method is used for getting the number of slices that
+ *  a level of detail is built with.  Every level has half the
+ *  slices of the level before, but never fewer than the
+ *  fewest slices, or more than the slices of level 0.
+ ***********************************************************/
+int ShapeGeometry::GetLodSlices(int slices, int lod)
+{
+	return(std::min(slices, std::max(MIN_LOD_SLICES, slices >> lod)));
+}
+
+/***********************************************************
+ *  BuildBox()
+ *
+ *  This method is used for building a cube with a size of
+ *  one, with separate vertices for each face.
+ ***********************************************************/
+void ShapeGeometry::BuildBox(SHAPE_GEOMETRY& geometry)
+{
+	// normal, then the two axes of each face
+	const float faces[6][3][3] = {
+		{ {  1, 0, 0 }, { 0, 0, -1 }, { 0, 1,  0 } },
+		{ { -1, 0, 0 }, { 0, 0,  1 }, { 0, 1,  0 } },
+		{ { 0,  1, 0 }, { 1, 0,  0 }, { 0, 0, -1 } },
+		{ { 0, -1, 0 }, { 1, 0,  0 }, { 0, 0,  1 } },
+		{ { 0, 0,  1 }, { 1, 0,  0 }, { 0, 1,  0 } },
+		{ { 0, 0, -1 }, { -1, 0, 0 }, { 0, 1,  0 } } };
+
+	for (int face = 0; face < 6; face++)
+	{
+		float center[3];
+		float uAxis[3];
+		float vAxis[3];
+		for (int i = 0; i < 3; i++)
+		{
+			center[i] = faces[face][0][i] * 0.5f;
+			uAxis[i] = faces[face][1][i] * 0.5f;
+			vAxis[i] = faces[face][2][i] * 0.5f;
+		}
+		AddQuad(geometry, center, uAxis, vAxis, faces[face][0]);
+	}
+}
+
+/***********************************************************
+ *  BuildPlane()
+ *
+ *  This method is used for building a flat square on XZ
+ *  from -1 to 1, facing up.
+ ***********************************************************/
+void ShapeGeometry::BuildPlane(SHAPE_GEOMETRY& geometry)
+{
+	const float center[3] = { 0, 0, 0 };
+	const float uAxis[3] = { 1, 0, 0 };
+	const float vAxis[3] = { 0, 0, -1 };
+	const float normal[3] = { 0, 1, 0 };
+
+	AddQuad(geometry, center, uAxis, vAxis, normal);
+}
+
+/***********************************************************
+ *  BuildPrism()
+ *
+ *  This method is used for building a triangular prism with
+ *  a size of one, standing on its triangular end.
+ ***********************************************************/
+void ShapeGeometry::BuildPrism(SHAPE_GEOMETRY& geometry)
+{
+	// corners of the triangle on XZ, counter-clockwise seen from above
+	const float corners[3][2] = { { -0.5f, 0.5f }, { 0.5f, 0.5f }, { 0.0f, -0.5f } };
+
+	// top and bottom triangles
+	uint32_t top = (uint32_t)geometry.vertices.size();
+	for (int i = 0; i < 3; i++)
+	{
+		AddVertex(geometry, corners[i][0], 0.5f, corners[i][1], 0, 1, 0,
+			corners[i][0] + 0.5f, 0.5f - corners[i][1]);
+	}
+	AddTriangle(geometry, top, top + 1, top + 2);
+
+	uint32_t bottom = (uint32_t)geometry.vertices.size();
+	for (int i = 0; i < 3; i++)
+	{
+		AddVertex(geometry, corners[i][0], -0.5f, corners[i][1], 0, -1, 0,
+			corners[i][0] + 0.5f, corners[i][1] + 0.5f);
+	}
+	AddTriangle(geometry, bottom, bottom + 2, bottom + 1);
+
+	// one rectangle for each edge of the triangle
+	for (int i = 0; i < 3; i++)
+	{
+		const float* p = corners[i];
+		const float* q = corners[(i + 1) % 3];
+		float edgeX = q[0] - p[0];
+		float edgeZ = q[1] - p[1];
+		float length = std::sqrt((edgeX * edgeX) + (edgeZ * edgeZ));
+
+		// the edge direction crossed with up points out of the prism
+		const float center[3] = { (p[0] + q[0]) * 0.5f, 0.0f, (p[1] + q[1]) * 0.5f };
+		const float uAxis[3] = { edgeX * 0.5f, 0.0f, edgeZ * 0.5f };
+		const float vAxis[3] = { 0.0f, 0.5f, 0.0f };
+		const float normal[3] = { -edgeZ / length, 0.0f, edgeX / length };
+		AddQuad(geometry, center, uAxis, vAxis, normal);
+	}
+}
+
+/***********************************************************
+ *  BuildSphere()
+ *
+ *  This method is used for building a sphere with a radius
+ *  of one from rings of latitude.
+ ***********************************************************/
+void ShapeGeometry::BuildSphere(int slices, SHAPE_GEOMETRY& geometry)
+{
+	int stacks = std::max(2, slices / 2);
+	uint32_t first = (uint32_t)geometry.vertices.size();
+
+	// rows go from the top of the sphere to the bottom
+	for (int row = 0; row <= stacks; row++)
+	{
+		float latitude = g_Pi * row / stacks;
+		for (int column = 0; column <= slices; column++)
+		{
+			float longitude = 2.0f * g_Pi * column / slices;
+			float x = std::sin(latitude) * std::sin(longitude);
+			float y = std::cos(latitude);
+			float z = std::sin(latitude) * std::cos(longitude);
+			AddVertex(geometry, x, y, z, x, y, z,
+				(float)column / slices, 1.0f - ((float)row / stacks));
+		}
+	}
+
+	uint32_t rowSize = (uint32_t)slices + 1;
+	for (int row = 0; row < stacks; row++)
+	{
+		for (int column = 0; column < slices; column++)
+		{
+			uint32_t topLeft = first + (row * rowSize) + column;
+			uint32_t bottomLeft = topLeft + rowSize;
+
+			// the rows at the poles are a single point, so the
+			// triangle touching the pole twice is left out
+			if (row != (stacks - 1))
+				AddTriangle(geometry, bottomLeft, bottomLeft + 1, topLeft + 1);
+			if (row != 0)
+				AddTriangle(geometry, bottomLeft, topLeft + 1, topLeft);
+		}
+	}
+}
+
+/***********************************************************
+ *  BuildTorus()
+ *
+ *  This method is used for building a ring around the Z axis,
+ *  lying on XY.
+ ***********************************************************/
+void ShapeGeometry::BuildTorus(int slices, SHAPE_GEOMETRY& geometry)
+{
+	int sides = std::max(3, slices / 2);
+	uint32_t first = (uint32_t)geometry.vertices.size();
+
+	for (int ring = 0; ring <= slices; ring++)
+	{
+		float ringAngle = 2.0f * g_Pi * ring / slices;
+		float ringX = std::cos(ringAngle);
+		float ringY = std::sin(ringAngle);
+
+		for (int side = 0; side <= sides; side++)
+		{
+			float tubeAngle = 2.0f * g_Pi * side / sides;
+			float nx = std::cos(tubeAngle) * ringX;
+			float ny = std::cos(tubeAngle) * ringY;
+			float nz = std::sin(tubeAngle);
+			AddVertex(geometry,
+				(g_TorusRadius * ringX) + (g_TorusTubeRadius * nx),
+				(g_TorusRadius * ringY) + (g_TorusTubeRadius * ny),
+				g_TorusTubeRadius * nz,
+				nx, ny, nz,
+				(float)ring / slices, (float)side / sides);
+		}
+	}
+
+	uint32_t ringSize = (uint32_t)sides + 1;
+	for (int ring = 0; ring < slices; ring++)
+	{
+		for (int side = 0; side < sides; side++)
+		{
+			uint32_t a = first + (ring * ringSize) + side;
+			uint32_t b = a + ringSize;
+			AddTriangle(geometry, a, b, b + 1);
+			AddTriangle(geometry, a, b + 1, a + 1);
+		}
+	}
+}
+
+/***********************************************************
+ *  BuildRevolved()
+ *
+ *  This method is used for building the round shapes that
+ *  stand on XZ from a height of 0 to 1, where the radius
+ *  changes from the bottom to the top.
+ ***********************************************************/
+void ShapeGeometry::BuildRevolved(int slices, float bottomRadius, float topRadius,
+	bool bTopCap, SHAPE_GEOMETRY& geometry)
+{
+	// the side normals lean up when the shape narrows towards the top
+	float slope = bottomRadius - topRadius;
+	float normalScale = 1.0f / std::sqrt(1.0f + (slope * slope));
+
+	uint32_t first = (uint32_t)geometry.vertices.size();
+	for (int column = 0; column <= slices; column++)
+	{
+		float angle = 2.0f * g_Pi * column / slices;
+		float s = std::sin(angle);
+		float c = std::cos(angle);
+		float u = (float)column / slices;
+
+		AddVertex(geometry, bottomRadius * s, 0.0f, bottomRadius * c,
+			s * normalScale, slope * normalScale, c * normalScale, u, 0.0f);
+		AddVertex(geometry, topRadius * s, 1.0f, topRadius * c,
+			s * normalScale, slope * normalScale, c * normalScale, u, 1.0f);
+	}
+	for (int column = 0; column < slices; column++)
+	{
+		uint32_t bottomLeft = first + (column * 2);
+		AddTriangle(geometry, bottomLeft, bottomLeft + 2, bottomLeft + 3);
+		AddTriangle(geometry, bottomLeft, bottomLeft + 3, bottomLeft + 1);
+	}
+
+	// flat caps, a fan around the center of each end
+	for (int cap = 0; cap < 2; cap++)
+	{
+		bool bTop = (cap == 1);
+		if (bTop && (bTopCap == false))
+		{
+			continue;
+		}
+
+		float y = bTop ? 1.0f : 0.0f;
+		float radius = bTop ? topRadius : bottomRadius;
+		float ny = bTop ? 1.0f : -1.0f;
+
+		uint32_t center = AddVertex(geometry, 0.0f, y, 0.0f, 0.0f, ny, 0.0f, 0.5f, 0.5f);
+		for (int column = 0; column <= slices; column++)
+		{
+			float angle = 2.0f * g_Pi * column / slices;
+			float s = std::sin(angle);
+			float c = std::cos(angle);
+			AddVertex(geometry, radius * s, y, radius * c, 0.0f, ny, 0.0f,
+				0.5f + (0.5f * s), 0.5f + (0.5f * c));
+		}
+		for (int column = 0; column < slices; column++)
+		{
+			uint32_t ring = center + 1 + column;
+			if (bTop)
+				AddTriangle(geometry, center, ring, ring + 1);
+			else
+				AddTriangle(geometry, center, ring + 1, ring);
+		}
+	}
+}
@@ -0,0 +1,82 @@
+///////////////////////////////////////////////////////////////////////////////
+// shapegeometry.h
+// ============
+// generate the vertices and indices of the basic 3D shapes
+//
+//  The shapes follow the same conventions as the course ShapeMeshes:
+//  the box and prism are centered on the origin with a size of one,
+//  the plane lies on XZ from -1 to 1, the cylinder, cone and tapered
+//  cylinder stand on XZ from a height of 0 to 1 with a radius of 1,
+//  the sphere has a radius of 1, and the torus lies on XY.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// basic 3D shapes that scene objects can be drawn with
+enum SCENE_MESH
+{
+	SCENE_MESH_BOX = 0,
+	SCENE_MESH_CONE,
+	SCENE_MESH_CYLINDER,
+	SCENE_MESH_PLANE,
+	SCENE_MESH_PRISM,
+	SCENE_MESH_SPHERE,
+	SCENE_MESH_TAPERED_CYLINDER,
+	SCENE_MESH_TORUS,
+	SCENE_MESH_COUNT
+};
+
+// vertex layout shared by all of the shapes
+struct SHAPE_VERTEX
+{
+	float position[3];
+	float normal[3];
+	float uv[2];
+};
+
+// triangle list of one shape
+struct SHAPE_GEOMETRY
+{
+	std::vector<SHAPE_VERTEX> vertices;
+	std::vector<uint32_t> indices;
+};
+
+/***********************************************************
+ *  ShapeGeometry
+ *
+ *  This class contains the code for building the triangles
+ *  of the basic 3D shapes on the CPU.  Round shapes are
+ *  built with the passed in number of slices around them.
+ ***********************************************************/
+class ShapeGeometry
+{
+public:
+	// number of slices used for round shapes by default
+	static const int DEFAULT_SLICES = 36;
+	// levels of detail that round shapes are built with, each with
+	// half the slices of the one before, down to the fewest slices
+	static const int LOD_COUNT = 4;
+	static const int MIN_LOD_SLICES = 6;
+
+	// build the triangles of the passed in shape
+	static void Build(uint32_t mesh, int slices, SHAPE_GEOMETRY& geometry);
+	// get the name of a shape, as it is written in scene files
+	static const char* GetMeshName(uint32_t mesh);
+	// check whether a shape is round, so it changes with the slices
+	static bool IsRound(uint32_t mesh);
+	// get the number of slices of a level of detail
+	static int GetLodSlices(int slices, int lod);
+
+private:
+	static void BuildBox(SHAPE_GEOMETRY& geometry);
+	static void BuildPlane(SHAPE_GEOMETRY& geometry);
+	static void BuildPrism(SHAPE_GEOMETRY& geometry);
+	static void BuildSphere(int slices, SHAPE_GEOMETRY& geometry);
+	static void BuildTorus(int slices, SHAPE_GEOMETRY& geometry);
+	// cylinder, cone and tapered cylinder with the passed in radii
+	static void BuildRevolved(int slices, float bottomRadius, float topRadius,
+		bool bTopCap, SHAPE_GEOMETRY& geometry);
+};
@@ -0,0 +1,87 @@
+///////////////////////////////////////////////////////////////////////////////
+// tagregistry.cpp
+// ============
+// intern string tags into compact integer handles
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TagRegistry.h"
+
+/***********************************************************
+ *  Intern()
+ *
+ *  This method is used for getting the handle of the passed
+ *  in tag.  A tag that has not been seen before is assigned
+ *  the next unused handle.
+ ***********************************************************/
+int TagRegistry::Intern(const std::string& tag)
+{
+	auto found = m_handles.find(tag);
+	if (found != m_handles.end())
+	{
+		return(found->second);
+	}
+
+	int handle = (int)m_tags.size();
+	m_handles.emplace(tag, handle);
+	m_tags.push_back(tag);
+
+	return(handle);
+}
+
+/***********************************************************
+ *  Find()
+ *
+ *  This method is used for getting the handle of a tag that
+ *  was previously interned, without adding new tags.
+ ***********************************************************/
+int TagRegistry::Find(const std::string& tag) const
+{
+	auto found = m_handles.find(tag);
+	if (found == m_handles.end())
+	{
+		return(INVALID_TAG);
+	}
+
+	return(found->second);
+}
+
+/***********************************************************
+ *  GetTag()
+ *
+ *  This method is used for getting the tag string that the
+ *  passed in handle was assigned to.
+ ***********************************************************/
+const std::string& TagRegistry::GetTag(int handle) const
+{
+	static const std::string emptyTag;
+
+	if ((handle < 0) || (handle >= (int)m_tags.size()))
+	{
+		return(emptyTag);
+	}
+
+	return(m_tags[handle]);
+}
+
+/***********************************************************
+ *  Count()
+ *
+ *  This method is used for getting the number of tags that
+ *  have been interned.
+ ***********************************************************/
+int TagRegistry::Count() const
+{
+	return((int)m_tags.size());
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for forgetting all of the interned
+ *  tags, so that handles start from zero again.
+ ***********************************************************/
+void TagRegistry::Clear()
+{
+	m_handles.clear();
+	m_tags.clear();
+}
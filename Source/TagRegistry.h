@@ -0,0 +1,43 @@
+///////////////////////////////////////////////////////////////////////////////
+// tagregistry.h
+// ============
+// intern string tags into compact integer handles
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  TagRegistry
+ *
+ *  This class assigns each distinct tag string the next
+ *  integer handle, starting from zero, so that the handle
+ *  can be used directly as an index into a table.  Tags are
+ *  interned while the scene is prepared, and the render code
+ *  only ever deals with the handles.
+ ***********************************************************/
+class TagRegistry
+{
+public:
+	// handle returned for tags that have not been interned
+	static const int INVALID_TAG = -1;
+
+	// get the handle for a tag, assigning a new one if needed
+	int Intern(const std::string& tag);
+	// get the handle for an existing tag, or INVALID_TAG
+	int Find(const std::string& tag) const;
+	// get the tag string that a handle was assigned to
+	const std::string& GetTag(int handle) const;
+	// get the number of interned tags
+	int Count() const;
+	// forget all of the interned tags
+	void Clear();
+
+private:
+	// handles by tag, and tags by handle
+	std::unordered_map<std::string, int> m_handles;
+	std::vector<std::string> m_tags;
+};
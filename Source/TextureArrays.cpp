@@ -0,0 +1,276 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturearrays.cpp
+// ============
+// store the textures as layers of texture arrays grouped by size and format
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureArrays.h"
+#include "GLStateCache.h"
+
+#include <algorithm>
+
+// declaration of global variables
+namespace
+{
+	// layers allocated when an array is created, doubled when it is full
+	const int g_InitialLayers = 4;
+}
+
+/***********************************************************
+ *  TextureArrays()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureArrays::TextureArrays()
+{
+	m_maxLayers = 0;
+	m_unitCount = 0;
+}
+
+/***********************************************************
+ *  ~TextureArrays()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureArrays::~TextureArrays()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used for finding a free layer for a texture
+ *  in an array with the same layout.  A full array grows
+ *  until the driver limit, and after that, or when there is
+ *  no array with the layout yet, a new array is created.
+ ***********************************************************/
+TEXTURE_LOCATION TextureArrays::Allocate(GLenum internalFormat, int width, int height, int mipCount)
+{
+	TEXTURE_LOCATION location;
+
+	if (m_maxLayers == 0)
+	{
+		glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &m_maxLayers);
+		m_maxLayers = std::max(m_maxLayers, 1);
+	}
+
+	for (size_t i = 0; i < m_arrays.size(); i++)
+	{
+		TEXTURE_ARRAY& textureArray = m_arrays[i];
+		if ((textureArray.internalFormat != internalFormat) ||
+			(textureArray.width != width) ||
+			(textureArray.height != height) ||
+			(textureArray.mipCount != mipCount))
+		{
+			continue;
+		}
+
+		location.array = (int)i;
+		if (textureArray.freeLayers.empty() == false)
+		{
+			location.layer = textureArray.freeLayers.back();
+			textureArray.freeLayers.pop_back();
+			return(location);
+		}
+		if ((textureArray.layerCount == textureArray.capacity) &&
+			(textureArray.capacity < m_maxLayers))
+		{
+			Grow(textureArray);
+		}
+		if (textureArray.layerCount < textureArray.capacity)
+		{
+			location.layer = textureArray.layerCount++;
+			return(location);
+		}
+	}
+
+	TEXTURE_ARRAY textureArray;
+	textureArray.internalFormat = internalFormat;
+	textureArray.width = width;
+	textureArray.height = height;
+	textureArray.mipCount = mipCount;
+	textureArray.capacity = std::min(g_InitialLayers, m_maxLayers);
+	textureArray.layerCount = 1;
+	textureArray.texture = CreateStorage(textureArray, textureArray.capacity);
+	m_arrays.push_back(textureArray);
+
+	location.array = (int)m_arrays.size() - 1;
+	location.layer = 0;
+	return(location);
+}
+
+/***********************************************************
+ *  Free()
+ *
+ *  This method is used for returning the layer of a texture
+ *  to its array, to be reused by the next texture that is
+ *  allocated with the same layout.  The pixels are left as
+ *  they are.
+ ***********************************************************/
+void TextureArrays::Free(const TEXTURE_LOCATION& location)
+{
+	if ((location.array < 0) || (location.array >= (int)m_arrays.size()))
+	{
+		return;
+	}
+
+	m_arrays[location.array].freeLayers.push_back(location.layer);
+}
+
+/***********************************************************
+ *  HasLayout()
+ *
+ *  This method is used for checking whether the array of a
+ *  layer stores textures of the passed in size, format and
+ *  mip count, so that a changed texture can be specified
+ *  again in the layer that it already has.
+ ***********************************************************/
+bool TextureArrays::HasLayout(const TEXTURE_LOCATION& location, GLenum internalFormat,
+	int width, int height, int mipCount) const
+{
+	if ((location.array < 0) || (location.array >= (int)m_arrays.size()))
+	{
+		return(false);
+	}
+
+	const TEXTURE_ARRAY& textureArray = m_arrays[location.array];
+	return((textureArray.internalFormat == internalFormat) &&
+		(textureArray.width == width) &&
+		(textureArray.height == height) &&
+		(textureArray.mipCount == mipCount));
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for deleting all of the texture arrays.
+ ***********************************************************/
+void TextureArrays::Destroy()
+{
+	for (size_t i = 0; i < m_arrays.size(); i++)
+	{
+		GLStateCache::Current().ForgetTexture(m_arrays[i].texture);
+		glDeleteTextures(1, &m_arrays[i].texture);
+	}
+	m_arrays.clear();
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for making sure that an array is bound
+ *  to its texture unit.  Arrays that have a unit to themselves
+ *  are only bound again after they grew, since the state cache
+ *  skips the binding otherwise, so this is cheap to call
+ *  before every draw.
+ ***********************************************************/
+int TextureArrays::Bind(int array)
+{
+	int unit = GetUnit(array);
+
+	GLStateCache::Current().BindTexture(unit, GL_TEXTURE_2D_ARRAY, m_arrays[array].texture);
+
+	return(unit);
+}
+
+/***********************************************************
+ *  BindForUpdate()
+ *
+ *  This method is used for binding an array with its texture
+ *  unit active, so that its layers can be specified.
+ ***********************************************************/
+void TextureArrays::BindForUpdate(int array)
+{
+	GLStateCache::Current().ActiveTexture(Bind(array));
+}
+
+/***********************************************************
+ *  GetUnit()
+ *
+ *  This method is used for getting the texture unit of an
+ *  array.  The arrays that don't fit take turns on the last
+ *  unit.
+ ***********************************************************/
+int TextureArrays::GetUnit(int array)
+{
+	return std::min(array, GetUnitCount() - 1);
+}
+
+/***********************************************************
+ *  GetUnitCount()
+ *
+ *  This method is used for getting the number of texture
+ *  units that the fragment shader can sample from.
+ ***********************************************************/
+int TextureArrays::GetUnitCount()
+{
+	if (m_unitCount == 0)
+	{
+		GLint unitCount = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &unitCount);
+		m_unitCount = std::max((int)unitCount, 1);
+	}
+
+	return(m_unitCount);
+}
+
+/***********************************************************
+ *  CreateStorage()
+ *
+ *  This method is used for creating the immutable storage of
+ *  an array, with every mip level, and its sampling settings.
+ *  It is created on the last texture unit, which is the one
+ *  the units are shared on.
+ ***********************************************************/
+GLuint TextureArrays::CreateStorage(const TEXTURE_ARRAY& textureArray, int capacity)
+{
+	GLuint texture = 0;
+	int unit = GetUnitCount() - 1;
+
+	glGenTextures(1, &texture);
+	GLStateCache::Current().BindTexture(unit, GL_TEXTURE_2D_ARRAY, texture);
+	GLStateCache::Current().ActiveTexture(unit);
+
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, textureArray.mipCount, textureArray.internalFormat,
+		textureArray.width, textureArray.height, capacity);
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters, sampling between the levels
+	// when there is a mip chain
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+		(textureArray.mipCount > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	return(texture);
+}
+
+/***********************************************************
+ *  Grow()
+ *
+ *  This method is used for moving the layers of a full array
+ *  into new storage with twice the room, copied on the GPU.
+ *  The locations of the textures in it stay the same.
+ ***********************************************************/
+void TextureArrays::Grow(TEXTURE_ARRAY& textureArray)
+{
+	int capacity = std::min(textureArray.capacity * 2, m_maxLayers);
+	GLuint texture = CreateStorage(textureArray, capacity);
+
+	for (int level = 0; level < textureArray.mipCount; level++)
+	{
+		glCopyImageSubData(
+			textureArray.texture, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+			texture, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+			std::max(textureArray.width >> level, 1),
+			std::max(textureArray.height >> level, 1),
+			textureArray.layerCount);
+	}
+
+	GLStateCache::Current().ForgetTexture(textureArray.texture);
+	glDeleteTextures(1, &textureArray.texture);
+	textureArray.texture = texture;
+	textureArray.capacity = capacity;
+}
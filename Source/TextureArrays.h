@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturearrays.h
+// ============
+// store the textures as layers of texture arrays grouped by size and format
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+#include <vector>
+
+// where a texture is stored - the index of its texture array and its
+// layer in that array, or -1 for both when it is not stored
+struct TEXTURE_LOCATION
+{
+	int array;
+	int layer;
+};
+
+/***********************************************************
+ *  TextureArrays
+ *
+ *  This class contains the code for storing any number of
+ *  textures as the layers of a few texture arrays.  Textures
+ *  with the same size, format and mip count share an array,
+ *  which grows as layers are added, so a shader can sample
+ *  any of them through one sampler and a layer index instead
+ *  of needing a texture unit for each texture.  Each array is
+ *  kept bound to its own texture unit, and only when there
+ *  are more arrays than units do the rest share the last one.
+ ***********************************************************/
+class TextureArrays
+{
+public:
+	// constructor
+	TextureArrays();
+	// destructor
+	~TextureArrays();
+
+	// get a free layer for a texture with the passed in layout,
+	// growing an array or creating a new one when needed
+	TEXTURE_LOCATION Allocate(GLenum internalFormat, int width, int height, int mipCount);
+	// return the layer of a texture that is no longer used
+	void Free(const TEXTURE_LOCATION& location);
+	// check whether a layer belongs to an array with the passed in
+	// layout, so a texture with that layout can be written over it
+	bool HasLayout(const TEXTURE_LOCATION& location, GLenum internalFormat,
+		int width, int height, int mipCount) const;
+	// delete all of the texture arrays
+	void Destroy();
+
+	// bind an array to its texture unit if it isn't bound already,
+	// and return the unit for the sampler uniform
+	int Bind(int array);
+	// bind an array and make its unit active, to change its layers
+	void BindForUpdate(int array);
+
+	// get the number of texture arrays
+	int GetArrayCount() const { return (int)m_arrays.size(); }
+
+private:
+	struct TEXTURE_ARRAY
+	{
+		GLuint texture;
+		GLenum internalFormat;
+		int width;
+		int height;
+		int mipCount;
+		// layers allocated in the texture, and layers handed out so far
+		int capacity;
+		int layerCount;
+		// layers below the count that were freed and can be reused
+		std::vector<int> freeLayers;
+	};
+
+	std::vector<TEXTURE_ARRAY> m_arrays;
+	// number of texture units, once it has been looked up
+	int m_unitCount;
+	// most layers the driver allows in one array
+	int m_maxLayers;
+
+	// get the texture unit that an array is bound to
+	int GetUnit(int array);
+	// get the number of texture units, looked up the first time
+	int GetUnitCount();
+	// create the storage of an array with room for the passed in layers
+	GLuint CreateStorage(const TEXTURE_ARRAY& textureArray, int capacity);
+	// move the layers of an array into storage with twice the room
+	void Grow(TEXTURE_ARRAY& textureArray);
+};
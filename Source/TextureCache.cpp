@@ -0,0 +1,564 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecache.cpp
+// ============
+// cook texture images into mipmapped, optionally compressed cache files
+//
+//  Each image is cooked once into a file next to it, named after the
+//  image with ".texbin" appended (".bc.texbin" when block compressed).
+//  The cooked file holds the whole mip chain and the hash of the image
+//  file it was cooked from, and it is cooked again when the hash no
+//  longer matches.  The cooked layout is little-endian only.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureCache.h"
+
+#ifndef STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// identifies cooked texture files and their layout version
+	const char g_CookedMagic[4] = { 'T', 'E', 'X', 'B' };
+	const uint32_t g_CookedVersion = 1;
+	// cooked files are named after the image with one of these appended
+	const char* g_CookedSuffix = ".texbin";
+	const char* g_CompressedSuffix = ".bc.texbin";
+	// a 32 bit size limits the chain to this many levels
+	const uint32_t g_MaxMipCount = 32;
+
+	static_assert(sizeof(TEXTURE_CACHE_HEADER) == 32, "cooked texture header layout changed");
+	static_assert(sizeof(TEXTURE_CACHE_MIP) == 16, "cooked texture mip layout changed");
+
+	/***********************************************************
+	 *  GetMipSize()
+	 *
+	 *  Get the number of bytes of a mip level in a format.
+	 ***********************************************************/
+	uint32_t GetMipSize(uint32_t format, uint32_t width, uint32_t height)
+	{
+		if (format == TEXTURE_CACHE_RGBA8)
+		{
+			return(width * height * 4);
+		}
+
+		uint32_t blockSize = (format == TEXTURE_CACHE_BC1) ? 8 : 16;
+		return(((width + 3) / 4) * ((height + 3) / 4) * blockSize);
+	}
+
+	/***********************************************************
+	 *  FlipRows()
+	 *
+	 *  Flip an RGBA image vertically in place, since OpenGL
+	 *  expects the bottom row first.  This is done per image
+	 *  instead of with the global stb_image setting, which is
+	 *  not safe to use from several threads.
+	 ***********************************************************/
+	void FlipRows(unsigned char* pixels, int width, int height)
+	{
+		size_t rowSize = (size_t)width * 4;
+		std::vector<unsigned char> row(rowSize);
+
+		for (int y = 0; y < height / 2; y++)
+		{
+			unsigned char* top = pixels + (y * rowSize);
+			unsigned char* bottom = pixels + ((height - 1 - y) * rowSize);
+			std::memcpy(row.data(), top, rowSize);
+			std::memcpy(top, bottom, rowSize);
+			std::memcpy(bottom, row.data(), rowSize);
+		}
+	}
+
+	/***********************************************************
+	 *  BuildNextMip()
+	 *
+	 *  Halve an RGBA image by averaging each 2x2 square of
+	 *  pixels.  The last row or column of an odd sized image
+	 *  is repeated.
+	 ***********************************************************/
+	void BuildNextMip(const std::vector<unsigned char>& source, int width, int height,
+		std::vector<unsigned char>& mip, int& mipWidth, int& mipHeight)
+	{
+		mipWidth = std::max(1, width / 2);
+		mipHeight = std::max(1, height / 2);
+		mip.resize((size_t)mipWidth * mipHeight * 4);
+
+		for (int y = 0; y < mipHeight; y++)
+		{
+			int y0 = std::min(y * 2, height - 1);
+			int y1 = std::min((y * 2) + 1, height - 1);
+			for (int x = 0; x < mipWidth; x++)
+			{
+				int x0 = std::min(x * 2, width - 1);
+				int x1 = std::min((x * 2) + 1, width - 1);
+				for (int c = 0; c < 4; c++)
+				{
+					int sum = source[(((y0 * width) + x0) * 4) + c] +
+						source[(((y0 * width) + x1) * 4) + c] +
+						source[(((y1 * width) + x0) * 4) + c] +
+						source[(((y1 * width) + x1) * 4) + c];
+					mip[(((y * mipWidth) + x) * 4) + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  To565() / From565()
+	 *
+	 *  Convert a color to and from the 16 bit endpoint format
+	 *  of the compressed blocks.
+	 ***********************************************************/
+	uint16_t To565(const unsigned char* color)
+	{
+		uint32_t r = ((color[0] * 31) + 127) / 255;
+		uint32_t g = ((color[1] * 63) + 127) / 255;
+		uint32_t b = ((color[2] * 31) + 127) / 255;
+		return (uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	void From565(uint16_t value, int* color)
+	{
+		int r = (value >> 11) & 0x1F;
+		int g = (value >> 5) & 0x3F;
+		int b = value & 0x1F;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	/***********************************************************
+	 *  EncodeColorBlock()
+	 *
+	 *  Compress the colors of a 4x4 block of pixels into 8
+	 *  bytes.  The endpoints are the corners of the bounding
+	 *  box of the colors, pulled in slightly, and each pixel
+	 *  picks the nearest of the four colors between them.
+	 ***********************************************************/
+	void EncodeColorBlock(const unsigned char block[16][4], unsigned char* output)
+	{
+		int minimum[3] = { 255, 255, 255 };
+		int maximum[3] = { 0, 0, 0 };
+
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				minimum[c] = std::min(minimum[c], (int)block[i][c]);
+				maximum[c] = std::max(maximum[c], (int)block[i][c]);
+			}
+		}
+
+		unsigned char high[3];
+		unsigned char low[3];
+		for (int c = 0; c < 3; c++)
+		{
+			int inset = (maximum[c] - minimum[c]) / 16;
+			high[c] = (unsigned char)(maximum[c] - inset);
+			low[c] = (unsigned char)(minimum[c] + inset);
+		}
+
+		// the first endpoint has to be larger for the four color mode
+		uint16_t endpoint0 = To565(high);
+		uint16_t endpoint1 = To565(low);
+		if (endpoint0 < endpoint1)
+		{
+			std::swap(endpoint0, endpoint1);
+		}
+
+		int palette[4][3];
+		From565(endpoint0, palette[0]);
+		From565(endpoint1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = ((2 * palette[0][c]) + palette[1][c] + 1) / 3;
+			palette[3][c] = (palette[0][c] + (2 * palette[1][c]) + 1) / 3;
+		}
+
+		uint32_t indices = 0;
+		if (endpoint0 != endpoint1)
+		{
+			for (int i = 0; i < 16; i++)
+			{
+				int best = 0;
+				int bestDistance = 0x7FFFFFFF;
+				for (int p = 0; p < 4; p++)
+				{
+					int distance = 0;
+					for (int c = 0; c < 3; c++)
+					{
+						int difference = block[i][c] - palette[p][c];
+						distance += difference * difference;
+					}
+					if (distance < bestDistance)
+					{
+						best = p;
+						bestDistance = distance;
+					}
+				}
+				indices |= (uint32_t)best << (i * 2);
+			}
+		}
+
+		output[0] = (unsigned char)(endpoint0 & 0xFF);
+		output[1] = (unsigned char)(endpoint0 >> 8);
+		output[2] = (unsigned char)(endpoint1 & 0xFF);
+		output[3] = (unsigned char)(endpoint1 >> 8);
+		for (int i = 0; i < 4; i++)
+		{
+			output[4 + i] = (unsigned char)((indices >> (i * 8)) & 0xFF);
+		}
+	}
+
+	/***********************************************************
+	 *  EncodeAlphaBlock()
+	 *
+	 *  Compress the alpha of a 4x4 block of pixels into 8
+	 *  bytes, with each pixel picking the nearest of eight
+	 *  values between the lowest and highest alpha.
+	 ***********************************************************/
+	void EncodeAlphaBlock(const unsigned char block[16][4], unsigned char* output)
+	{
+		int high = 0;
+		int low = 255;
+		for (int i = 0; i < 16; i++)
+		{
+			high = std::max(high, (int)block[i][3]);
+			low = std::min(low, (int)block[i][3]);
+		}
+
+		// the eight mode needs the first endpoint to be larger
+		int palette[8];
+		palette[0] = high;
+		palette[1] = low;
+		for (int p = 2; p < 8; p++)
+		{
+			palette[p] = (((8 - p) * high) + ((p - 1) * low) + 3) / 7;
+		}
+
+		uint64_t indices = 0;
+		if (high != low)
+		{
+			for (int i = 0; i < 16; i++)
+			{
+				int best = 0;
+				int bestDistance = 256;
+				for (int p = 0; p < 8; p++)
+				{
+					int distance = std::abs(block[i][3] - palette[p]);
+					if (distance < bestDistance)
+					{
+						best = p;
+						bestDistance = distance;
+					}
+				}
+				indices |= (uint64_t)best << (i * 3);
+			}
+		}
+
+		output[0] = (unsigned char)high;
+		output[1] = (unsigned char)low;
+		for (int i = 0; i < 6; i++)
+		{
+			output[2 + i] = (unsigned char)((indices >> (i * 8)) & 0xFF);
+		}
+	}
+
+	/***********************************************************
+	 *  AppendMip()
+	 *
+	 *  Append one mip level in the passed in format.
+	 ***********************************************************/
+	void AppendMip(const std::vector<unsigned char>& pixels, int width, int height,
+		uint32_t format, std::vector<unsigned char>& cooked)
+	{
+		if (format == TEXTURE_CACHE_RGBA8)
+		{
+			cooked.insert(cooked.end(), pixels.begin(), pixels.end());
+			return;
+		}
+
+		for (int blockY = 0; blockY < height; blockY += 4)
+		{
+			for (int blockX = 0; blockX < width; blockX += 4)
+			{
+				// levels smaller than a block repeat their last row and column
+				unsigned char block[16][4];
+				for (int i = 0; i < 16; i++)
+				{
+					int x = std::min(blockX + (i % 4), width - 1);
+					int y = std::min(blockY + (i / 4), height - 1);
+					std::memcpy(block[i], &pixels[((y * width) + x) * 4], 4);
+				}
+
+				unsigned char encoded[16];
+				size_t encodedSize = 8;
+				if (format == TEXTURE_CACHE_BC3)
+				{
+					EncodeAlphaBlock(block, encoded);
+					EncodeColorBlock(block, encoded + 8);
+					encodedSize = 16;
+				}
+				else
+				{
+					EncodeColorBlock(block, encoded);
+				}
+				cooked.insert(cooked.end(), encoded, encoded + encodedSize);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  TextureCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureCache::TextureCache()
+{
+	m_bCacheHit = false;
+	m_data = NULL;
+	m_header = NULL;
+	m_mips = NULL;
+}
+
+/***********************************************************
+ *  ~TextureCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureCache::~TextureCache()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for loading the mip chain of an image.
+ *  The image file is hashed, and when its cooked file was
+ *  cooked from the same contents it is mapped and used
+ *  directly.  Otherwise the image is decoded and cooked, and
+ *  the cooked file is saved for the next run.
+ ***********************************************************/
+bool TextureCache::Load(const std::string& sourceFilename, bool bCompress)
+{
+	Close();
+
+	MappedFile source;
+	if (source.Open(sourceFilename.c_str()) == false)
+	{
+		return false;
+	}
+
+	uint64_t sourceHash = MappedFile::HashData(source.GetData(), source.GetSize());
+	std::string cookedFilename = sourceFilename + (bCompress ? g_CompressedSuffix : g_CookedSuffix);
+
+	if (m_mappedFile.Open(cookedFilename.c_str()))
+	{
+		if (AttachCooked(m_mappedFile.GetData(), m_mappedFile.GetSize(), sourceHash, bCompress))
+		{
+			m_bCacheHit = true;
+			return true;
+		}
+		m_mappedFile.Close();
+	}
+
+	// always decode to RGBA so that every level has the same layout
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+	unsigned char* image = stbi_load_from_memory(
+		source.GetData(),
+		(int)source.GetSize(),
+		&width,
+		&height,
+		&colorChannels,
+		4);
+	if (NULL == image)
+	{
+		return false;
+	}
+
+	FlipRows(image, width, height);
+	Cook(image, width, height, bCompress, sourceHash, m_cookedData);
+	stbi_image_free(image);
+
+	// save the cooked texture for the next run, failing to is not fatal -
+	// another loader may still have the old cooked file mapped
+	if (MappedFile::SaveFile(cookedFilename.c_str(), m_cookedData.data(), m_cookedData.size()) == false)
+	{
+		std::cout << "Could not save cooked texture:" << cookedFilename << std::endl;
+	}
+
+	if (AttachCooked(m_cookedData.data(), m_cookedData.size(), sourceHash, bCompress) == false)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for releasing the mip chain.
+ ***********************************************************/
+void TextureCache::Close()
+{
+	m_bCacheHit = false;
+	m_data = NULL;
+	m_header = NULL;
+	m_mips = NULL;
+	m_mappedFile.Close();
+	m_cookedData.clear();
+}
+
+/***********************************************************
+ *  GetMipDataSize()
+ *
+ *  This method is used for getting the number of bytes of
+ *  all the mip levels together.
+ ***********************************************************/
+size_t TextureCache::GetMipDataSize() const
+{
+	const TEXTURE_CACHE_MIP& last = m_mips[m_header->mipCount - 1];
+
+	return(last.offset + last.size - m_mips[0].offset);
+}
+
+/***********************************************************
+ *  Cook()
+ *
+ *  This method is used for building the cooked layout of a
+ *  decoded image: the header, the mip table, and then every
+ *  level from the full size down to one pixel.  Compressed
+ *  images use BC3 when any pixel is not opaque, and BC1
+ *  otherwise.
+ ***********************************************************/
+void TextureCache::Cook(const unsigned char* pixels, int width, int height,
+	bool bCompress, uint64_t sourceHash, std::vector<unsigned char>& cooked)
+{
+	std::vector<unsigned char> level(pixels, pixels + ((size_t)width * height * 4));
+	std::vector<unsigned char> nextLevel;
+
+	uint32_t format = TEXTURE_CACHE_RGBA8;
+	if (bCompress)
+	{
+		format = TEXTURE_CACHE_BC1;
+		for (size_t i = 3; i < level.size(); i += 4)
+		{
+			if (level[i] != 255)
+			{
+				format = TEXTURE_CACHE_BC3;
+				break;
+			}
+		}
+	}
+
+	uint32_t mipCount = 1;
+	while ((std::max(width, height) >> mipCount) > 0)
+	{
+		mipCount++;
+	}
+
+	TEXTURE_CACHE_HEADER header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, g_CookedMagic, sizeof(header.magic));
+	header.version = g_CookedVersion;
+	header.sourceHash = sourceHash;
+	header.format = format;
+	header.width = width;
+	header.height = height;
+	header.mipCount = mipCount;
+
+	std::vector<TEXTURE_CACHE_MIP> mips(mipCount);
+
+	cooked.clear();
+	cooked.resize(sizeof(header) + (mipCount * sizeof(TEXTURE_CACHE_MIP)));
+
+	int levelWidth = width;
+	int levelHeight = height;
+	for (uint32_t i = 0; i < mipCount; i++)
+	{
+		mips[i].offset = (uint32_t)cooked.size();
+		mips[i].width = levelWidth;
+		mips[i].height = levelHeight;
+		AppendMip(level, levelWidth, levelHeight, format, cooked);
+		mips[i].size = (uint32_t)cooked.size() - mips[i].offset;
+
+		if (i + 1 < mipCount)
+		{
+			BuildNextMip(level, levelWidth, levelHeight, nextLevel, levelWidth, levelHeight);
+			level.swap(nextLevel);
+		}
+	}
+
+	std::memcpy(cooked.data(), &header, sizeof(header));
+	std::memcpy(cooked.data() + sizeof(header), mips.data(), mipCount * sizeof(TEXTURE_CACHE_MIP));
+}
+
+/***********************************************************
+ *  AttachCooked()
+ *
+ *  This method is used for checking that cooked data was
+ *  cooked from the expected image in the expected format,
+ *  and that its levels are complete, before pointing the
+ *  tables directly into it.
+ ***********************************************************/
+bool TextureCache::AttachCooked(const unsigned char* data, size_t size,
+	uint64_t sourceHash, bool bCompress)
+{
+	if ((NULL == data) || (size < sizeof(TEXTURE_CACHE_HEADER)))
+	{
+		return false;
+	}
+
+	const TEXTURE_CACHE_HEADER* header = (const TEXTURE_CACHE_HEADER*)data;
+	bool bCompressed = (header->format == TEXTURE_CACHE_BC1) || (header->format == TEXTURE_CACHE_BC3);
+	if ((std::memcmp(header->magic, g_CookedMagic, sizeof(header->magic)) != 0) ||
+		(header->version != g_CookedVersion) ||
+		(header->sourceHash != sourceHash) ||
+		((header->format != TEXTURE_CACHE_RGBA8) && (bCompressed == false)) ||
+		(bCompressed != bCompress) ||
+		(header->width == 0) || (header->height == 0) ||
+		(header->mipCount == 0) || (header->mipCount > g_MaxMipCount) ||
+		(size < sizeof(TEXTURE_CACHE_HEADER) + (header->mipCount * sizeof(TEXTURE_CACHE_MIP))))
+	{
+		return false;
+	}
+
+	// the levels have to halve in size and follow each other in the file
+	const TEXTURE_CACHE_MIP* mips = (const TEXTURE_CACHE_MIP*)(data + sizeof(TEXTURE_CACHE_HEADER));
+	uint64_t offset = sizeof(TEXTURE_CACHE_HEADER) + (header->mipCount * sizeof(TEXTURE_CACHE_MIP));
+	uint32_t width = header->width;
+	uint32_t height = header->height;
+	for (uint32_t i = 0; i < header->mipCount; i++)
+	{
+		if ((mips[i].offset != offset) ||
+			(mips[i].width != width) || (mips[i].height != height) ||
+			(mips[i].size != GetMipSize(header->format, width, height)) ||
+			(offset + mips[i].size > size))
+		{
+			std::cout << "Cooked texture data is damaged" << std::endl;
+			return false;
+		}
+		offset += mips[i].size;
+		width = std::max(1u, width / 2);
+		height = std::max(1u, height / 2);
+	}
+
+	m_data = data;
+	m_header = header;
+	m_mips = mips;
+
+	return true;
+}
@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecache.h
+// ============
+// cook texture images into mipmapped, optionally compressed cache files
+//
+//  Each image is cooked once into a file next to it, named after the
+//  image with ".texbin" appended (".bc.texbin" when block compressed).
+//  The cooked file holds the whole mip chain and the hash of the image
+//  file it was cooked from, and it is cooked again when the hash no
+//  longer matches.  The cooked layout is little-endian only.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// pixel formats of the cooked mip levels
+enum TEXTURE_CACHE_FORMAT
+{
+	// 4 bytes per pixel
+	TEXTURE_CACHE_RGBA8 = 0,
+	// 8 bytes per 4x4 block, opaque
+	TEXTURE_CACHE_BC1,
+	// 16 bytes per 4x4 block, with alpha
+	TEXTURE_CACHE_BC3
+};
+
+// header at the start of a cooked texture file
+struct TEXTURE_CACHE_HEADER
+{
+	char magic[4];
+	uint32_t version;
+	// hash of the contents of the image file it was cooked from
+	uint64_t sourceHash;
+	uint32_t format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t mipCount;
+};
+
+// one mip level - the offset is from the start of the file, and the
+// levels are stored one after another from the largest down
+struct TEXTURE_CACHE_MIP
+{
+	uint32_t offset;
+	uint32_t size;
+	uint32_t width;
+	uint32_t height;
+};
+
+/***********************************************************
+ *  TextureCache
+ *
+ *  This class contains the code for loading the mip chain of
+ *  an image, either by mapping its up to date cooked file, or
+ *  by decoding the image, building and compressing the mips,
+ *  and saving the cooked file for the next run.  It makes no
+ *  OpenGL calls, so it can be used on any thread.
+ ***********************************************************/
+class TextureCache
+{
+public:
+	// constructor
+	TextureCache();
+	// destructor
+	~TextureCache();
+
+	// load the mip chain of an image, cooking it if the cache is stale
+	bool Load(const std::string& sourceFilename, bool bCompress);
+	// release the loaded mip chain
+	void Close();
+
+	// whether the mip chain was mapped from an up to date cooked file
+	bool IsCacheHit() const { return m_bCacheHit; }
+
+	// the loaded mip chain
+	uint32_t GetFormat() const { return m_header->format; }
+	int GetMipCount() const { return (int)m_header->mipCount; }
+	const TEXTURE_CACHE_MIP& GetMip(int level) const { return m_mips[level]; }
+	// all of the mip levels, which are stored together
+	const unsigned char* GetMipData() const { return m_data + m_mips[0].offset; }
+	size_t GetMipDataSize() const;
+	// offset of a level from the start of the mip data
+	size_t GetMipDataOffset(int level) const { return m_mips[level].offset - m_mips[0].offset; }
+
+private:
+	// cooked file that is mapped into memory
+	MappedFile m_mappedFile;
+	// freshly cooked data, used when it can't be written to a file
+	std::vector<unsigned char> m_cookedData;
+	bool m_bCacheHit;
+	// the cooked data and the tables inside of it
+	const unsigned char* m_data;
+	const TEXTURE_CACHE_HEADER* m_header;
+	const TEXTURE_CACHE_MIP* m_mips;
+
+	// build the cooked layout of a decoded RGBA image
+	static void Cook(const unsigned char* pixels, int width, int height,
+		bool bCompress, uint64_t sourceHash, std::vector<unsigned char>& cooked);
+	// check the cooked data and point the tables into it
+	bool AttachCooked(const unsigned char* data, size_t size,
+		uint64_t sourceHash, bool bCompress);
+};
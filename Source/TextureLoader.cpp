@@ -0,0 +1,652 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.cpp
+// ============
+// decode texture images on worker threads and upload them in the background
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureLoader.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// color of the placeholder that is shown until a texture is loaded
+	const unsigned char g_PlaceholderPixel[4] = { 128, 128, 128, 255 };
+	// staging buffers, enough for one chain being copied, one being
+	// uploaded and one still being transferred by the driver
+	const int g_StagingBufferCount = 3;
+	// staging buffers grow in steps of this many bytes
+	const size_t g_StagingGranularity = 1024 * 1024;
+	// nanoseconds to wait on a fence at a time, when waiting for every
+	// texture to finish
+	const GLuint64 g_FenceTimeout = 100000000;
+	// mapping flags of the staging buffers, which stay mapped
+	const GLbitfield g_StagingFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+}
+
+/***********************************************************
+ *  TextureLoader()
+ *
+ *  The constructor for the class - starts the decode workers.
+ *  The staging buffers are made on the OpenGL thread once
+ *  the first chains are loaded.
+ ***********************************************************/
+TextureLoader::TextureLoader(int workerCount)
+{
+	m_bStopping = false;
+	m_bCompress = false;
+	m_placeholder.array = -1;
+	m_placeholder.layer = -1;
+
+	m_staging.resize(g_StagingBufferCount);
+	for (size_t i = 0; i < m_staging.size(); i++)
+	{
+		m_staging[i].buffer = 0;
+		m_staging[i].mapped = NULL;
+		m_staging[i].capacity = 0;
+		m_staging[i].fence = 0;
+		m_staging[i].bInUse = false;
+	}
+
+	if (workerCount <= 0)
+	{
+		workerCount = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+	}
+
+	for (int i = 0; i < workerCount; i++)
+	{
+		m_workers.push_back(std::thread(&TextureLoader::WorkerLoop, this));
+	}
+}
+
+/***********************************************************
+ *  ~TextureLoader()
+ *
+ *  The destructor for the class - stops the workers and
+ *  frees any images that were loaded but never uploaded,
+ *  along with the staging buffers.
+ ***********************************************************/
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+	}
+	m_jobReady.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+
+	// chains waiting to be copied are in the decode queue as well
+	std::deque<TEXTURE_JOB>* queues[3] = { &m_decodeQueue, &m_stagingQueue, &m_uploadQueue };
+	for (int i = 0; i < 3; i++)
+	{
+		for (size_t j = 0; j < queues[i]->size(); j++)
+		{
+			delete (*queues[i])[j].cache;
+		}
+		queues[i]->clear();
+	}
+
+	for (size_t i = 0; i < m_staging.size(); i++)
+	{
+		if (m_staging[i].fence != 0)
+		{
+			glDeleteSync(m_staging[i].fence);
+		}
+		if (m_staging[i].buffer != 0)
+		{
+			// deleting a buffer also unmaps it
+			glDeleteBuffers(1, &m_staging[i].buffer);
+		}
+	}
+	m_staging.clear();
+}
+
+/***********************************************************
+ *  Request()
+ *
+ *  This method is used for getting a handle for a texture
+ *  and queueing its file to be loaded.  The handle can be
+ *  drawn with right away, showing the placeholder until the
+ *  image has been uploaded.
+ ***********************************************************/
+int TextureLoader::Request(const std::string& filename)
+{
+	if (m_placeholder.array < 0)
+	{
+		CreatePlaceholder();
+	}
+
+	int handle = (int)m_locations.size();
+	m_locations.push_back(m_placeholder);
+	QueueDecode(handle, filename);
+
+	return(handle);
+}
+
+/***********************************************************
+ *  Reload()
+ *
+ *  This method is used for loading the file of a texture
+ *  again after it changed on disk.  The texture is drawn
+ *  with its old image until the new one is uploaded, which
+ *  goes into the same array layer when the size and format
+ *  did not change.
+ ***********************************************************/
+void TextureLoader::Reload(int handle, const std::string& filename)
+{
+	if ((handle < 0) || (handle >= (int)m_locations.size()) ||
+		(m_locations[handle].array < 0))
+	{
+		return;
+	}
+
+	QueueDecode(handle, filename);
+}
+
+/***********************************************************
+ *  QueueDecode()
+ *
+ *  This method is used for queueing a file to be loaded by
+ *  the workers for a handle, which is tracked as pending
+ *  until the loaded image is uploaded.
+ ***********************************************************/
+void TextureLoader::QueueDecode(int handle, const std::string& filename)
+{
+	TEXTURE_JOB job;
+	job.handle = handle;
+	job.filename = filename;
+	job.bCompress = m_bCompress;
+	job.cache = NULL;
+	job.staging = -1;
+	job.stagingData = NULL;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_decodeQueue.push_back(job);
+	}
+	m_jobReady.notify_one();
+	m_pending.push_back(handle);
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is used by each worker thread for loading
+ *  the mip chains of the queued image files from the cache,
+ *  which decodes and cooks the images that are not cached
+ *  yet, and passing them back for a staging buffer.  A chain
+ *  that was handed a buffer comes back to be copied into it,
+ *  after which it is ready to be uploaded on the thread that
+ *  owns the OpenGL context.
+ ***********************************************************/
+void TextureLoader::WorkerLoop()
+{
+	for (;;)
+	{
+		TEXTURE_JOB job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_jobReady.wait(lock, [this] { return m_bStopping || !m_decodeQueue.empty(); });
+			if (m_bStopping)
+			{
+				return;
+			}
+			job = m_decodeQueue.front();
+			m_decodeQueue.pop_front();
+		}
+
+		if (job.staging >= 0)
+		{
+			std::memcpy(job.stagingData, job.cache->GetMipData(), job.cache->GetMipDataSize());
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_uploadQueue.push_back(job);
+		}
+		else
+		{
+			job.cache = new TextureCache();
+			if (job.cache->Load(job.filename, job.bCompress) == false)
+			{
+				delete job.cache;
+				job.cache = NULL;
+			}
+
+			// a failed load has nothing to stage, and only reports itself
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (NULL == job.cache)
+			{
+				m_uploadQueue.push_back(job);
+			}
+			else
+			{
+				m_stagingQueue.push_back(job);
+			}
+		}
+		m_decodeDone.notify_all();
+	}
+}
+
+/***********************************************************
+ *  ProcessUploads()
+ *
+ *  This method is used for uploading the images that have
+ *  been staged, a few per frame so that a burst of finished
+ *  images does not cause a long frame, and for handing the
+ *  staging buffers that are free again to the next chains.
+ ***********************************************************/
+int TextureLoader::ProcessUploads(int maxUploads)
+{
+	int uploaded = 0;
+
+	RecycleStaging(false);
+	AssignStaging();
+
+	// released textures can still have jobs coming back from the
+	// workers, so the queue is emptied even when nothing is pending
+	while (uploaded < maxUploads)
+	{
+		TEXTURE_JOB job;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_uploadQueue.empty())
+			{
+				break;
+			}
+			job = m_uploadQueue.front();
+			m_uploadQueue.pop_front();
+		}
+
+		// the texture may have been released while it was decoding
+		bool bUploaded = RemovePending(job.handle);
+		if (bUploaded == true)
+		{
+			Upload(job);
+			uploaded++;
+		}
+
+		// the staging buffer is reused once the driver has read it
+		if (job.staging >= 0)
+		{
+			if (bUploaded == true)
+			{
+				m_staging[job.staging].fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			}
+			else
+			{
+				m_staging[job.staging].bInUse = false;
+			}
+		}
+		delete job.cache;
+	}
+
+	return(uploaded);
+}
+
+/***********************************************************
+ *  AssignStaging()
+ *
+ *  This method is used for handing each free staging buffer
+ *  to a loaded mip chain, growing the buffer when the chain
+ *  does not fit, and queueing the chain for a worker to copy
+ *  into it.  Without persistent mapping the chain is queued
+ *  to be uploaded from client memory instead.
+ ***********************************************************/
+void TextureLoader::AssignStaging()
+{
+	for (int index = 0; index < (int)m_staging.size(); index++)
+	{
+		if (m_staging[index].bInUse == true)
+		{
+			continue;
+		}
+
+		TEXTURE_JOB job;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_stagingQueue.empty())
+			{
+				return;
+			}
+			job = m_stagingQueue.front();
+			m_stagingQueue.pop_front();
+		}
+
+		// a texture released while a worker loaded it needs no buffer
+		if (std::find(m_pending.begin(), m_pending.end(), job.handle) == m_pending.end())
+		{
+			delete job.cache;
+			index--;
+			continue;
+		}
+
+		if (ReserveStaging(index, job.cache->GetMipDataSize()))
+		{
+			m_staging[index].bInUse = true;
+			job.staging = index;
+			job.stagingData = m_staging[index].mapped;
+
+			// copies go ahead of the files that are still to be loaded
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_decodeQueue.push_front(job);
+			}
+			m_jobReady.notify_one();
+		}
+		else
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_uploadQueue.push_back(job);
+		}
+	}
+}
+
+/***********************************************************
+ *  RecycleStaging()
+ *
+ *  This method is used for freeing the staging buffers that
+ *  the driver has finished reading the uploads from.  When
+ *  asked to wait, every fence is waited on, so each buffer
+ *  that is not being copied into or uploaded from is free.
+ ***********************************************************/
+void TextureLoader::RecycleStaging(bool bWait)
+{
+	for (size_t i = 0; i < m_staging.size(); i++)
+	{
+		STAGING_BUFFER& staging = m_staging[i];
+		if (staging.fence == 0)
+		{
+			continue;
+		}
+
+		GLenum result = glClientWaitSync(staging.fence, 0, 0);
+		while ((bWait == true) && (result == GL_TIMEOUT_EXPIRED))
+		{
+			result = glClientWaitSync(staging.fence, GL_SYNC_FLUSH_COMMANDS_BIT, g_FenceTimeout);
+		}
+
+		if ((result == GL_ALREADY_SIGNALED) || (result == GL_CONDITION_SATISFIED) ||
+			(result == GL_WAIT_FAILED))
+		{
+			glDeleteSync(staging.fence);
+			staging.fence = 0;
+			staging.bInUse = false;
+		}
+	}
+}
+
+/***********************************************************
+ *  HasFreeStaging()
+ *
+ *  This method is used for checking whether a staging buffer
+ *  can be handed to a loaded chain.
+ ***********************************************************/
+bool TextureLoader::HasFreeStaging() const
+{
+	for (size_t i = 0; i < m_staging.size(); i++)
+	{
+		if (m_staging[i].bInUse == false)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/***********************************************************
+ *  ReserveStaging()
+ *
+ *  This method is used for making sure that a staging buffer
+ *  holds at least the passed in number of bytes.  A buffer
+ *  that is too small is replaced with a bigger one, which is
+ *  given immutable storage and mapped for as long as it lives,
+ *  so the workers can write into it while it is in use.
+ ***********************************************************/
+bool TextureLoader::ReserveStaging(int index, size_t size)
+{
+	STAGING_BUFFER& staging = m_staging[index];
+	if ((staging.buffer != 0) && (staging.capacity >= size))
+	{
+		return true;
+	}
+
+	if (!GLEW_ARB_buffer_storage)
+	{
+		return false;
+	}
+
+	if (staging.buffer != 0)
+	{
+		glDeleteBuffers(1, &staging.buffer);
+		staging.buffer = 0;
+		staging.mapped = NULL;
+		staging.capacity = 0;
+	}
+
+	size_t capacity = ((size + g_StagingGranularity - 1) / g_StagingGranularity) * g_StagingGranularity;
+	glGenBuffers(1, &staging.buffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.buffer);
+	glBufferStorage(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)capacity, NULL, g_StagingFlags);
+	staging.mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+		(GLsizeiptr)capacity, g_StagingFlags);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	if (NULL == staging.mapped)
+	{
+		glDeleteBuffers(1, &staging.buffer);
+		staging.buffer = 0;
+		return false;
+	}
+
+	staging.capacity = capacity;
+	return true;
+}
+
+/***********************************************************
+ *  FinishAll()
+ *
+ *  This method is used for waiting until every requested
+ *  texture is decoded and uploaded, such as before measuring
+ *  frame times.  The staging buffers are waited on as well,
+ *  since the workers can only copy into the free ones.
+ ***********************************************************/
+void TextureLoader::FinishAll()
+{
+	while (m_pending.empty() == false)
+	{
+		RecycleStaging(true);
+		AssignStaging();
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_decodeDone.wait(lock, [this] {
+				return !m_uploadQueue.empty() || (!m_stagingQueue.empty() && HasFreeStaging()); });
+		}
+		ProcessUploads((int)m_pending.size());
+	}
+}
+
+/***********************************************************
+ *  Release()
+ *
+ *  This method is used for freeing the array layer of a
+ *  texture.  Its jobs that are still queued are dropped
+ *  right away, and one that a worker is busy with is dropped
+ *  when the worker hands it back.
+ ***********************************************************/
+void TextureLoader::Release(int handle)
+{
+	// a reloaded texture can be pending more than once
+	while (RemovePending(handle))
+	{
+	}
+	DropJobs(handle);
+
+	TEXTURE_LOCATION& location = m_locations[handle];
+	if ((location.array != m_placeholder.array) || (location.layer != m_placeholder.layer))
+	{
+		m_textureArrays.Free(location);
+	}
+	location.array = -1;
+	location.layer = -1;
+}
+
+/***********************************************************
+ *  SetCompression()
+ *
+ *  This method is used for choosing whether the textures that
+ *  are requested from now on are stored block compressed.
+ *  Compression is only used when the driver supports S3TC.
+ ***********************************************************/
+void TextureLoader::SetCompression(bool bCompress)
+{
+	m_bCompress = bCompress && GLEW_EXT_texture_compression_s3tc;
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for specifying every level of a free
+ *  array layer from the staging buffer that a worker copied
+ *  the mip chain into, which lets the driver transfer the
+ *  pixels without blocking.  The levels come precooked, so
+ *  no mipmaps are generated here.  The texture is drawn from
+ *  the new layer instead of the placeholder from then on.  A
+ *  reloaded texture with the same layout is written over its
+ *  own layer, otherwise it moves and its old layer is freed.
+ ***********************************************************/
+void TextureLoader::Upload(const TEXTURE_JOB& job)
+{
+	if (NULL == job.cache)
+	{
+		std::cout << "Could not load image:" << job.filename << std::endl;
+		return;
+	}
+
+	const TextureCache& cache = *job.cache;
+	const TEXTURE_CACHE_MIP& image = cache.GetMip(0);
+	std::cout << "Successfully loaded image:" << job.filename << ", width:" << image.width << ", height:" << image.height << ", mips:" << cache.GetMipCount() << (cache.IsCacheHit() ? ", cached" : ", cooked") << std::endl;
+
+	GLenum internalFormat = GL_RGBA8;
+	if (cache.GetFormat() == TEXTURE_CACHE_BC1)
+		internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	else if (cache.GetFormat() == TEXTURE_CACHE_BC3)
+		internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+	// without a staging buffer the levels come from client memory
+	bool bStaged = (job.staging >= 0);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, bStaged ? m_staging[job.staging].buffer : 0);
+
+	TEXTURE_LOCATION previous = m_locations[job.handle];
+	bool bPlaceholder = (previous.array == m_placeholder.array) && (previous.layer == m_placeholder.layer);
+	TEXTURE_LOCATION location = previous;
+	if ((bPlaceholder == true) || (m_textureArrays.HasLayout(
+		previous, internalFormat, image.width, image.height, cache.GetMipCount()) == false))
+	{
+		location = m_textureArrays.Allocate(
+			internalFormat, image.width, image.height, cache.GetMipCount());
+	}
+	m_textureArrays.BindForUpdate(location.array);
+	for (int level = 0; level < cache.GetMipCount(); level++)
+	{
+		const TEXTURE_CACHE_MIP& mip = cache.GetMip(level);
+		size_t offset = cache.GetMipDataOffset(level);
+		const void* pixels = bStaged ? (const void*)(uintptr_t)offset :
+			(const void*)(cache.GetMipData() + offset);
+
+		if (internalFormat != GL_RGBA8)
+		{
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, location.layer,
+				mip.width, mip.height, 1, internalFormat, mip.size, pixels);
+		}
+		else
+		{
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, location.layer,
+				mip.width, mip.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		}
+	}
+	m_locations[job.handle] = location;
+	if ((bPlaceholder == false) && ((previous.array != location.array) || (previous.layer != location.layer)))
+	{
+		m_textureArrays.Free(previous);
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+/***********************************************************
+ *  CreatePlaceholder()
+ *
+ *  This method is used for storing the one pixel placeholder
+ *  in an array layer of its own, which every requested
+ *  texture is drawn from until its image is uploaded.
+ ***********************************************************/
+void TextureLoader::CreatePlaceholder()
+{
+	m_placeholder = m_textureArrays.Allocate(GL_RGBA8, 1, 1, 1);
+	m_textureArrays.BindForUpdate(m_placeholder.array);
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, m_placeholder.layer, 1, 1, 1,
+		GL_RGBA, GL_UNSIGNED_BYTE, g_PlaceholderPixel);
+}
+
+/***********************************************************
+ *  RemovePending()
+ *
+ *  This method is used for no longer tracking a texture as
+ *  showing its placeholder.  It is only used on the OpenGL
+ *  thread, so the list needs no lock.
+ ***********************************************************/
+bool TextureLoader::RemovePending(int handle)
+{
+	std::vector<int>::iterator found = std::find(m_pending.begin(), m_pending.end(), handle);
+	if (found == m_pending.end())
+	{
+		return false;
+	}
+
+	m_pending.erase(found);
+	return true;
+}
+
+/***********************************************************
+ *  DropJobs()
+ *
+ *  This method is used for taking the jobs of a released
+ *  texture out of the queues, freeing their loaded chains,
+ *  and handing back the staging buffers that were set aside
+ *  for them.  Nothing was uploaded from those buffers yet,
+ *  so they are free without waiting on a fence.
+ ***********************************************************/
+void TextureLoader::DropJobs(int handle)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	std::deque<TEXTURE_JOB>* queues[3] = { &m_decodeQueue, &m_stagingQueue, &m_uploadQueue };
+	for (int i = 0; i < 3; i++)
+	{
+		std::deque<TEXTURE_JOB>& queue = *queues[i];
+		for (std::deque<TEXTURE_JOB>::iterator job = queue.begin(); job != queue.end();)
+		{
+			if (job->handle != handle)
+			{
+				++job;
+				continue;
+			}
+
+			if (job->staging >= 0)
+			{
+				m_staging[job->staging].bInUse = false;
+			}
+			delete job->cache;
+			job = queue.erase(job);
+		}
+	}
+}
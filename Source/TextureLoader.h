@@ -0,0 +1,146 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.h
+// ============
+// decode texture images on worker threads and upload them in the background
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "TextureArrays.h"
+#include "TextureCache.h"
+
+#include <GL/glew.h>        // GLEW library
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  TextureLoader
+ *
+ *  This class contains the code for loading textures without
+ *  stalling the render loop.  A requested texture gets a
+ *  handle right away that shows a one pixel placeholder, the
+ *  mip chain of the file is loaded from the texture cache by
+ *  a pool of worker threads.  The workers also copy each
+ *  loaded chain into one of a few persistently mapped pixel
+ *  buffers, so the thread with the context only specifies the
+ *  levels of a texture array layer from the buffer, and the
+ *  driver transfers them without stalling it.  A buffer is
+ *  handed out again once a fence shows that the transfer out
+ *  of it finished.  The handle never changes, so it can be
+ *  used for drawing as soon as it is requested, and its
+ *  location is looked up when drawing.  A texture whose file
+ *  changed is loaded again behind the same handle, and keeps
+ *  showing its old image until the new one is written over
+ *  it.  All OpenGL calls are made on the thread that owns the
+ *  context, from Request(), Reload(), ProcessUploads() and
+ *  Release().
+ ***********************************************************/
+class TextureLoader
+{
+public:
+	// constructor - zero workers uses one less than the number of cores
+	TextureLoader(int workerCount = 0);
+	// destructor
+	~TextureLoader();
+
+	// get a handle that shows the placeholder, and queue the file
+	// for decoding
+	int Request(const std::string& filename);
+	// queue the file of a texture for decoding again, after it changed
+	void Reload(int handle, const std::string& filename);
+	// upload up to the passed in number of decoded images, and
+	// return the number that were uploaded
+	int ProcessUploads(int maxUploads);
+	// upload every requested texture, waiting for decodes to finish
+	void FinishAll();
+	// free a texture, dropping it if it is still being loaded
+	void Release(int handle);
+
+	// get the array layer that a texture is currently drawn from
+	const TEXTURE_LOCATION& GetLocation(int handle) const { return m_locations[handle]; }
+	// the texture arrays that hold the loaded textures
+	TextureArrays& GetTextureArrays() { return m_textureArrays; }
+
+	// store requested textures block compressed, if the driver can
+	void SetCompression(bool bCompress);
+
+private:
+	// a file to load, then its loaded mip chain, and then the staging
+	// buffer that the chain is copied into
+	struct TEXTURE_JOB
+	{
+		int handle;
+		std::string filename;
+		bool bCompress;
+		TextureCache* cache;
+		// staging buffer and its mapped memory, or -1 when the chain
+		// is uploaded from client memory instead
+		int staging;
+		unsigned char* stagingData;
+	};
+
+	// a persistently mapped pixel buffer that a worker copies a mip
+	// chain into, and that the levels are uploaded from
+	struct STAGING_BUFFER
+	{
+		GLuint buffer;
+		unsigned char* mapped;
+		size_t capacity;
+		// signaled once the upload out of the buffer is done
+		GLsync fence;
+		bool bInUse;
+	};
+
+	std::vector<std::thread> m_workers;
+	// guards the queues and the stop flag
+	mutable std::mutex m_mutex;
+	std::condition_variable m_jobReady;
+	std::condition_variable m_decodeDone;
+	// files to load and chains to copy, loaded chains waiting for a
+	// staging buffer, and chains that are ready to be uploaded
+	std::deque<TEXTURE_JOB> m_decodeQueue;
+	std::deque<TEXTURE_JOB> m_stagingQueue;
+	std::deque<TEXTURE_JOB> m_uploadQueue;
+	// textures that are requested but not uploaded or released yet,
+	// only used on the OpenGL thread
+	std::vector<int> m_pending;
+	// storage of the loaded textures, the location of each handle,
+	// and the layer holding the placeholder, all on the OpenGL thread
+	TextureArrays m_textureArrays;
+	std::vector<TEXTURE_LOCATION> m_locations;
+	TEXTURE_LOCATION m_placeholder;
+	bool m_bStopping;
+	// pixel buffers that the loaded chains are staged in, only
+	// handed out and recycled on the OpenGL thread
+	std::vector<STAGING_BUFFER> m_staging;
+	bool m_bCompress;
+
+	// queue a file to be decoded for a handle
+	void QueueDecode(int handle, const std::string& filename);
+	// decode queued files until the loader is stopped
+	void WorkerLoop();
+	// hand the free staging buffers to loaded chains, to be copied
+	// into by the workers
+	void AssignStaging();
+	// free the staging buffers whose uploads finished, waiting for
+	// them if asked to
+	void RecycleStaging(bool bWait);
+	// check whether a staging buffer can be handed out
+	bool HasFreeStaging() const;
+	// make a staging buffer big enough for the passed in size
+	bool ReserveStaging(int index, size_t size);
+	// specify the levels of an array layer from a staged mip chain
+	void Upload(const TEXTURE_JOB& job);
+	// store the placeholder in an array, the first time it is needed
+	void CreatePlaceholder();
+	// stop tracking a texture, returns false if it was not tracked
+	bool RemovePending(int handle);
+	// drop the queued jobs of a texture, with their chains and staging
+	// buffers
+	void DropJobs(int handle);
+};
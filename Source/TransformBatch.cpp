@@ -0,0 +1,732 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbatch.cpp
+// ============
+// calculate the matrices of many transforms at once with vector instructions
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformBatch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define TRANSFORM_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// the vector kernels are only built with the instruction sets that they
+// use, so the rest of the program still runs on any CPU
+#if defined(TRANSFORM_X86) && defined(__GNUC__)
+#define TRANSFORM_TARGET_SSE __attribute__((target("sse2")))
+#define TRANSFORM_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TRANSFORM_TARGET_SSE
+#define TRANSFORM_TARGET_AVX2
+#endif
+
+static_assert(sizeof(glm::mat4) == 16 * sizeof(float), "matrices have to be packed floats");
+
+// declaration of global variables
+namespace
+{
+	const float g_DegreesToRadians = 0.017453292519943295f;
+	// fewest transforms that are worth handing to each thread
+	const int g_TransformsPerThread = 4096;
+	// quarter turns in a radian, and a quarter turn split in two so
+	// that the angle left over is exact
+	const float g_QuarterTurnsPerRadian = 0.63661977236758134f;
+	const float g_QuarterTurnHigh = 1.5707963705062866f;
+	const float g_QuarterTurnLow = -4.3711390001862426e-8f;
+	// polynomials of the sine and cosine from -45 to 45 degrees
+	const float g_SinCoefficients[3] = { -1.9515295891e-4f, 8.3321608736e-3f, -1.6666654611e-1f };
+	const float g_CosCoefficients[3] = { 2.443315711809948e-5f, -1.388731625493765e-3f, 4.166664568298827e-2f };
+
+	const char* const g_KernelNames[TRANSFORM_KERNEL_COUNT] = { "scalar", "sse", "avx2" };
+
+	// pointers to the component arrays of a batch
+	struct COMPONENT_ARRAYS
+	{
+		const float* values[TransformBatch::COMPONENT_COUNT];
+	};
+
+	/***********************************************************
+	 *  WriteMatrix()
+	 *
+	 *  Write the matrix of a transform from the sines and
+	 *  cosines of its angles, as the translation times the X,
+	 *  Y and Z rotations times the scale, column by column.
+	 ***********************************************************/
+	void WriteMatrix(const float scale[3], const float sine[3], const float cosine[3],
+		const float position[3], float* matrix)
+	{
+		const float sx = sine[0], sy = sine[1], sz = sine[2];
+		const float cx = cosine[0], cy = cosine[1], cz = cosine[2];
+
+		matrix[0] = (cy * cz) * scale[0];
+		matrix[1] = ((cx * sz) + (sx * sy * cz)) * scale[0];
+		matrix[2] = ((sx * sz) - (cx * sy * cz)) * scale[0];
+		matrix[3] = 0.0f;
+		matrix[4] = -(cy * sz) * scale[1];
+		matrix[5] = ((cx * cz) - (sx * sy * sz)) * scale[1];
+		matrix[6] = ((sx * cz) + (cx * sy * sz)) * scale[1];
+		matrix[7] = 0.0f;
+		matrix[8] = sy * scale[2];
+		matrix[9] = -(sx * cy) * scale[2];
+		matrix[10] = (cx * cy) * scale[2];
+		matrix[11] = 0.0f;
+		matrix[12] = position[0];
+		matrix[13] = position[1];
+		matrix[14] = position[2];
+		matrix[15] = 1.0f;
+	}
+
+	/***********************************************************
+	 *  BuildScalar()
+	 *
+	 *  Calculate a run of matrices one at a time.
+	 ***********************************************************/
+	void BuildScalar(const COMPONENT_ARRAYS& arrays, int first, int count, float* matrices)
+	{
+		for (int i = first; i < first + count; i++)
+		{
+			float scale[3];
+			float sine[3];
+			float cosine[3];
+			float position[3];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				const float radians = arrays.values[TransformBatch::ROTATION_X + axis][i] * g_DegreesToRadians;
+				scale[axis] = arrays.values[TransformBatch::SCALE_X + axis][i];
+				sine[axis] = std::sin(radians);
+				cosine[axis] = std::cos(radians);
+				position[axis] = arrays.values[TransformBatch::POSITION_X + axis][i];
+			}
+			WriteMatrix(scale, sine, cosine, position, matrices + (i * 16));
+		}
+	}
+
+#ifdef TRANSFORM_X86
+	/***********************************************************
+	 *  SinCosSse()
+	 *
+	 *  Calculate the sines and cosines of four angles in
+	 *  degrees.  The angle is brought within 45 degrees of a
+	 *  quarter turn, whose count picks whether the sine and
+	 *  cosine swap and which of them change sign.
+	 ***********************************************************/
+	TRANSFORM_TARGET_SSE
+	void SinCosSse(__m128 degrees, __m128& sine, __m128& cosine)
+	{
+		const __m128 radians = _mm_mul_ps(degrees, _mm_set1_ps(g_DegreesToRadians));
+		const __m128i turns = _mm_cvtps_epi32(_mm_mul_ps(radians, _mm_set1_ps(g_QuarterTurnsPerRadian)));
+		const __m128 turnsFloat = _mm_cvtepi32_ps(turns);
+		__m128 x = _mm_sub_ps(radians, _mm_mul_ps(turnsFloat, _mm_set1_ps(g_QuarterTurnHigh)));
+		x = _mm_sub_ps(x, _mm_mul_ps(turnsFloat, _mm_set1_ps(g_QuarterTurnLow)));
+		const __m128 z = _mm_mul_ps(x, x);
+
+		__m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(g_SinCoefficients[0]), z), _mm_set1_ps(g_SinCoefficients[1]));
+		s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(g_SinCoefficients[2]));
+		s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), x), x);
+
+		__m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(g_CosCoefficients[0]), z), _mm_set1_ps(g_CosCoefficients[1]));
+		c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(g_CosCoefficients[2]));
+		c = _mm_mul_ps(_mm_mul_ps(c, z), z);
+		c = _mm_add_ps(_mm_sub_ps(c, _mm_mul_ps(z, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+
+		const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(
+			_mm_and_si128(turns, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+		const __m128 sineSign = _mm_castsi128_ps(_mm_slli_epi32(
+			_mm_and_si128(turns, _mm_set1_epi32(2)), 30));
+		const __m128 cosineSign = _mm_castsi128_ps(_mm_slli_epi32(
+			_mm_and_si128(_mm_add_epi32(turns, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+
+		sine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s)), sineSign);
+		cosine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c)), cosineSign);
+	}
+
+	/***********************************************************
+	 *  BuildSse()
+	 *
+	 *  Calculate a run of matrices four at a time.  The sixteen
+	 *  values of the four matrices are calculated one value of
+	 *  all four at a time, and turned around four values at a
+	 *  time into a column of each matrix.
+	 ***********************************************************/
+	TRANSFORM_TARGET_SSE
+	void BuildSse(const COMPONENT_ARRAYS& arrays, int first, int count, float* matrices)
+	{
+		const int last = first + (count & ~3);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		for (int i = first; i < last; i += 4)
+		{
+			__m128 sx, sy, sz, cx, cy, cz;
+			SinCosSse(_mm_loadu_ps(arrays.values[TransformBatch::ROTATION_X] + i), sx, cx);
+			SinCosSse(_mm_loadu_ps(arrays.values[TransformBatch::ROTATION_Y] + i), sy, cy);
+			SinCosSse(_mm_loadu_ps(arrays.values[TransformBatch::ROTATION_Z] + i), sz, cz);
+			const __m128 scaleX = _mm_loadu_ps(arrays.values[TransformBatch::SCALE_X] + i);
+			const __m128 scaleY = _mm_loadu_ps(arrays.values[TransformBatch::SCALE_Y] + i);
+			const __m128 scaleZ = _mm_loadu_ps(arrays.values[TransformBatch::SCALE_Z] + i);
+			const __m128 sxsy = _mm_mul_ps(sx, sy);
+			const __m128 cxsy = _mm_mul_ps(cx, sy);
+
+			__m128 columns[4][4];
+			columns[0][0] = _mm_mul_ps(_mm_mul_ps(cy, cz), scaleX);
+			columns[0][1] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(cx, sz), _mm_mul_ps(sxsy, cz)), scaleX);
+			columns[0][2] = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(sx, sz), _mm_mul_ps(cxsy, cz)), scaleX);
+			columns[0][3] = zero;
+			columns[1][0] = _mm_mul_ps(_mm_sub_ps(zero, _mm_mul_ps(cy, sz)), scaleY);
+			columns[1][1] = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(cx, cz), _mm_mul_ps(sxsy, sz)), scaleY);
+			columns[1][2] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(sx, cz), _mm_mul_ps(cxsy, sz)), scaleY);
+			columns[1][3] = zero;
+			columns[2][0] = _mm_mul_ps(sy, scaleZ);
+			columns[2][1] = _mm_mul_ps(_mm_sub_ps(zero, _mm_mul_ps(sx, cy)), scaleZ);
+			columns[2][2] = _mm_mul_ps(_mm_mul_ps(cx, cy), scaleZ);
+			columns[2][3] = zero;
+			columns[3][0] = _mm_loadu_ps(arrays.values[TransformBatch::POSITION_X] + i);
+			columns[3][1] = _mm_loadu_ps(arrays.values[TransformBatch::POSITION_Y] + i);
+			columns[3][2] = _mm_loadu_ps(arrays.values[TransformBatch::POSITION_Z] + i);
+			columns[3][3] = one;
+
+			float* matrix = matrices + (i * 16);
+			for (int column = 0; column < 4; column++)
+			{
+				__m128* rows = columns[column];
+				_MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+				for (int lane = 0; lane < 4; lane++)
+				{
+					_mm_storeu_ps(matrix + (lane * 16) + (column * 4), rows[lane]);
+				}
+			}
+		}
+
+		BuildScalar(arrays, last, first + count - last, matrices);
+	}
+
+	/***********************************************************
+	 *  SinCosAvx2()
+	 *
+	 *  Calculate the sines and cosines of eight angles in
+	 *  degrees, the same way as SinCosSse().
+	 ***********************************************************/
+	TRANSFORM_TARGET_AVX2
+	void SinCosAvx2(__m256 degrees, __m256& sine, __m256& cosine)
+	{
+		const __m256 radians = _mm256_mul_ps(degrees, _mm256_set1_ps(g_DegreesToRadians));
+		const __m256i turns = _mm256_cvtps_epi32(_mm256_mul_ps(radians, _mm256_set1_ps(g_QuarterTurnsPerRadian)));
+		const __m256 turnsFloat = _mm256_cvtepi32_ps(turns);
+		__m256 x = _mm256_sub_ps(radians, _mm256_mul_ps(turnsFloat, _mm256_set1_ps(g_QuarterTurnHigh)));
+		x = _mm256_sub_ps(x, _mm256_mul_ps(turnsFloat, _mm256_set1_ps(g_QuarterTurnLow)));
+		const __m256 z = _mm256_mul_ps(x, x);
+
+		__m256 s = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(g_SinCoefficients[0]), z), _mm256_set1_ps(g_SinCoefficients[1]));
+		s = _mm256_add_ps(_mm256_mul_ps(s, z), _mm256_set1_ps(g_SinCoefficients[2]));
+		s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(s, z), x), x);
+
+		__m256 c = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(g_CosCoefficients[0]), z), _mm256_set1_ps(g_CosCoefficients[1]));
+		c = _mm256_add_ps(_mm256_mul_ps(c, z), _mm256_set1_ps(g_CosCoefficients[2]));
+		c = _mm256_mul_ps(_mm256_mul_ps(c, z), z);
+		c = _mm256_add_ps(_mm256_sub_ps(c, _mm256_mul_ps(z, _mm256_set1_ps(0.5f))), _mm256_set1_ps(1.0f));
+
+		const __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+			_mm256_and_si256(turns, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+		const __m256 sineSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+			_mm256_and_si256(turns, _mm256_set1_epi32(2)), 30));
+		const __m256 cosineSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+			_mm256_and_si256(_mm256_add_epi32(turns, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30));
+
+		sine = _mm256_xor_ps(_mm256_blendv_ps(s, c, swap), sineSign);
+		cosine = _mm256_xor_ps(_mm256_blendv_ps(c, s, swap), cosineSign);
+	}
+
+	/***********************************************************
+	 *  Transpose8x8()
+	 *
+	 *  Turn eight values of eight matrices, one value of all
+	 *  eight matrices per register, into the eight values of
+	 *  each matrix, one matrix per register.
+	 ***********************************************************/
+	TRANSFORM_TARGET_AVX2
+	void Transpose8x8(__m256 rows[8])
+	{
+		const __m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+		const __m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+		const __m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+		const __m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+		const __m256 t4 = _mm256_unpacklo_ps(rows[4], rows[5]);
+		const __m256 t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+		const __m256 t6 = _mm256_unpacklo_ps(rows[6], rows[7]);
+		const __m256 t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+
+		const __m256 u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+		const __m256 u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+		const __m256 u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+		const __m256 u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+		const __m256 u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+		const __m256 u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+		const __m256 u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+		const __m256 u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+		rows[0] = _mm256_permute2f128_ps(u0, u4, 0x20);
+		rows[1] = _mm256_permute2f128_ps(u1, u5, 0x20);
+		rows[2] = _mm256_permute2f128_ps(u2, u6, 0x20);
+		rows[3] = _mm256_permute2f128_ps(u3, u7, 0x20);
+		rows[4] = _mm256_permute2f128_ps(u0, u4, 0x31);
+		rows[5] = _mm256_permute2f128_ps(u1, u5, 0x31);
+		rows[6] = _mm256_permute2f128_ps(u2, u6, 0x31);
+		rows[7] = _mm256_permute2f128_ps(u3, u7, 0x31);
+	}
+
+	/***********************************************************
+	 *  BuildAvx2()
+	 *
+	 *  Calculate a run of matrices eight at a time.  The first
+	 *  and last eight values of the matrices are turned around
+	 *  separately, into the two halves of each matrix.
+	 ***********************************************************/
+	TRANSFORM_TARGET_AVX2
+	void BuildAvx2(const COMPONENT_ARRAYS& arrays, int first, int count, float* matrices)
+	{
+		const int last = first + (count & ~7);
+		const __m256 zero = _mm256_setzero_ps();
+
+		for (int i = first; i < last; i += 8)
+		{
+			__m256 sx, sy, sz, cx, cy, cz;
+			SinCosAvx2(_mm256_loadu_ps(arrays.values[TransformBatch::ROTATION_X] + i), sx, cx);
+			SinCosAvx2(_mm256_loadu_ps(arrays.values[TransformBatch::ROTATION_Y] + i), sy, cy);
+			SinCosAvx2(_mm256_loadu_ps(arrays.values[TransformBatch::ROTATION_Z] + i), sz, cz);
+			const __m256 scaleX = _mm256_loadu_ps(arrays.values[TransformBatch::SCALE_X] + i);
+			const __m256 scaleY = _mm256_loadu_ps(arrays.values[TransformBatch::SCALE_Y] + i);
+			const __m256 scaleZ = _mm256_loadu_ps(arrays.values[TransformBatch::SCALE_Z] + i);
+			const __m256 sxsy = _mm256_mul_ps(sx, sy);
+			const __m256 cxsy = _mm256_mul_ps(cx, sy);
+
+			__m256 values[2][8];
+			values[0][0] = _mm256_mul_ps(_mm256_mul_ps(cy, cz), scaleX);
+			values[0][1] = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(cx, sz), _mm256_mul_ps(sxsy, cz)), scaleX);
+			values[0][2] = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(sx, sz), _mm256_mul_ps(cxsy, cz)), scaleX);
+			values[0][3] = zero;
+			values[0][4] = _mm256_mul_ps(_mm256_sub_ps(zero, _mm256_mul_ps(cy, sz)), scaleY);
+			values[0][5] = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(cx, cz), _mm256_mul_ps(sxsy, sz)), scaleY);
+			values[0][6] = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(sx, cz), _mm256_mul_ps(cxsy, sz)), scaleY);
+			values[0][7] = zero;
+			values[1][0] = _mm256_mul_ps(sy, scaleZ);
+			values[1][1] = _mm256_mul_ps(_mm256_sub_ps(zero, _mm256_mul_ps(sx, cy)), scaleZ);
+			values[1][2] = _mm256_mul_ps(_mm256_mul_ps(cx, cy), scaleZ);
+			values[1][3] = zero;
+			values[1][4] = _mm256_loadu_ps(arrays.values[TransformBatch::POSITION_X] + i);
+			values[1][5] = _mm256_loadu_ps(arrays.values[TransformBatch::POSITION_Y] + i);
+			values[1][6] = _mm256_loadu_ps(arrays.values[TransformBatch::POSITION_Z] + i);
+			values[1][7] = _mm256_set1_ps(1.0f);
+
+			Transpose8x8(values[0]);
+			Transpose8x8(values[1]);
+
+			float* matrix = matrices + (i * 16);
+			for (int lane = 0; lane < 8; lane++)
+			{
+				_mm256_storeu_ps(matrix + (lane * 16), values[0][lane]);
+				_mm256_storeu_ps(matrix + (lane * 16) + 8, values[1][lane]);
+			}
+		}
+
+		BuildScalar(arrays, last, first + count - last, matrices);
+	}
+
+	/***********************************************************
+	 *  ReadCpuFeatures()
+	 *
+	 *  Find out whether the CPU, and the operating system that
+	 *  saves its registers, support SSE2 and AVX2.
+	 ***********************************************************/
+	void ReadCpuFeatures(bool& bSse2, bool& bAvx2)
+	{
+#ifdef _MSC_VER
+		int info[4] = { 0, 0, 0, 0 };
+		__cpuid(info, 0);
+		const int maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		bSse2 = (info[3] & (1 << 26)) != 0;
+		const bool bOsSavesAvx = ((info[2] & (1 << 27)) != 0) && ((info[2] & (1 << 28)) != 0) &&
+			((_xgetbv(0) & 0x6) == 0x6);
+
+		bAvx2 = false;
+		if ((maxLeaf >= 7) && (bOsSavesAvx == true))
+		{
+			__cpuidex(info, 7, 0);
+			bAvx2 = (info[1] & (1 << 5)) != 0;
+		}
+#else
+		// the checks of the compiler include the operating system support
+		__builtin_cpu_init();
+		bSse2 = __builtin_cpu_supports("sse2") != 0;
+		bAvx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+	}
+#endif
+
+	/***********************************************************
+	 *  FindBestKernel()
+	 *
+	 *  Pick the fastest kernel that the CPU can run.
+	 ***********************************************************/
+	TRANSFORM_KERNEL FindBestKernel()
+	{
+		for (int kernel = TRANSFORM_KERNEL_COUNT - 1; kernel > TRANSFORM_KERNEL_SCALAR; kernel--)
+		{
+			if (TransformBatch::IsKernelSupported((TRANSFORM_KERNEL)kernel) == true)
+			{
+				return((TRANSFORM_KERNEL)kernel);
+			}
+		}
+		return(TRANSFORM_KERNEL_SCALAR);
+	}
+
+	// kernel that every batch is calculated with, picked at startup
+	TRANSFORM_KERNEL g_Kernel = FindBestKernel();
+}
+
+/***********************************************************
+ *  TransformBatch()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TransformBatch::TransformBatch()
+{
+	m_count = 0;
+	m_pMatrices = NULL;
+	m_batchGeneration = 0;
+	m_workersDone = 0;
+	m_bStopping = false;
+	m_work.resize(1);
+}
+
+/***********************************************************
+ *  ~TransformBatch()
+ *
+ *  The destructor for the class - stops the workers.
+ ***********************************************************/
+TransformBatch::~TransformBatch()
+{
+	StopWorkers();
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for changing the number of transforms.
+ *  The added transforms have a scale of one and no rotation
+ *  or position.
+ ***********************************************************/
+void TransformBatch::Resize(int count)
+{
+	count = std::max(0, count);
+	for (int component = 0; component < COMPONENT_COUNT; component++)
+	{
+		const float value = (component <= SCALE_Z) ? 1.0f : 0.0f;
+		m_components[component].resize(count, value);
+	}
+	m_count = count;
+}
+
+/***********************************************************
+ *  SetTransform()
+ *
+ *  This method is used for setting the components of one
+ *  transform.  Its matrix is calculated on the next build.
+ ***********************************************************/
+void TransformBatch::SetTransform(int index, const glm::vec3& scale,
+	const glm::vec3& rotationDegrees, const glm::vec3& position)
+{
+	m_components[SCALE_X][index] = scale.x;
+	m_components[SCALE_Y][index] = scale.y;
+	m_components[SCALE_Z][index] = scale.z;
+	m_components[ROTATION_X][index] = rotationDegrees.x;
+	m_components[ROTATION_Y][index] = rotationDegrees.y;
+	m_components[ROTATION_Z][index] = rotationDegrees.z;
+	m_components[POSITION_X][index] = position.x;
+	m_components[POSITION_Y][index] = position.y;
+	m_components[POSITION_Z][index] = position.z;
+}
+
+/***********************************************************
+ *  BuildMatrices()
+ *
+ *  This method is used for calculating the matrices of a run
+ *  of transforms.  A run that is long enough is split into
+ *  one part for each thread, in whole vectors, and the
+ *  calling thread calculates the first part while the
+ *  workers calculate the others.
+ ***********************************************************/
+void TransformBatch::BuildMatrices(int first, int count, glm::mat4* matrices)
+{
+	first = std::max(0, first);
+	count = std::min(count, m_count - first);
+	if ((count <= 0) || (NULL == matrices))
+	{
+		return;
+	}
+
+	const int threadCount = std::min((int)m_work.size(), std::max(1, count / g_TransformsPerThread));
+	if (threadCount <= 1)
+	{
+		TRANSFORM_WORK work;
+		work.first = first;
+		work.count = count;
+		m_pMatrices = matrices;
+		RunKernel(work);
+		return;
+	}
+
+	const int partSize = (((count + threadCount - 1) / threadCount) + 7) & ~7;
+	for (int i = 0; i < (int)m_work.size(); i++)
+	{
+		const int partFirst = std::min(first + (i * partSize), first + count);
+		m_work[i].first = partFirst;
+		m_work[i].count = std::min(partSize, first + count - partFirst);
+	}
+
+	m_pMatrices = matrices;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_workersDone = 0;
+		m_batchGeneration++;
+	}
+	m_batchReady.notify_all();
+
+	RunKernel(m_work[0]);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_batchDone.wait(lock, [this] { return m_workersDone == (int)m_workers.size(); });
+}
+
+/***********************************************************
+ *  SetWorkerCount()
+ *
+ *  This method is used for starting the threads that help
+ *  with the large runs, replacing the ones there were.
+ ***********************************************************/
+void TransformBatch::SetWorkerCount(int workerCount)
+{
+	StopWorkers();
+
+	workerCount = std::max(0, workerCount);
+	m_work.resize(workerCount + 1);
+	m_bStopping = false;
+	m_batchGeneration = 0;
+	for (int i = 0; i < workerCount; i++)
+	{
+		m_workers.push_back(std::thread(&TransformBatch::WorkerLoop, this, i));
+	}
+}
+
+/***********************************************************
+ *  BuildMatrix()
+ *
+ *  This method is used for calculating the matrix of a single
+ *  transform, the same way as a batch of them.
+ ***********************************************************/
+glm::mat4 TransformBatch::BuildMatrix(const glm::vec3& scale,
+	const glm::vec3& rotationDegrees, const glm::vec3& position)
+{
+	COMPONENT_ARRAYS arrays;
+	const float components[COMPONENT_COUNT] = {
+		scale.x, scale.y, scale.z,
+		rotationDegrees.x, rotationDegrees.y, rotationDegrees.z,
+		position.x, position.y, position.z };
+	for (int component = 0; component < COMPONENT_COUNT; component++)
+	{
+		arrays.values[component] = &components[component];
+	}
+
+	glm::mat4 matrix;
+	BuildScalar(arrays, 0, 1, &matrix[0][0]);
+
+	return(matrix);
+}
+
+/***********************************************************
+ *  IsKernelSupported()
+ *
+ *  This method is used for checking whether the CPU can run
+ *  a kernel.  The features are only read once.
+ ***********************************************************/
+bool TransformBatch::IsKernelSupported(TRANSFORM_KERNEL kernel)
+{
+	if (kernel == TRANSFORM_KERNEL_SCALAR)
+	{
+		return(true);
+	}
+
+#ifdef TRANSFORM_X86
+	static bool bSse2 = false;
+	static bool bAvx2 = false;
+	static bool bRead = false;
+	if (bRead == false)
+	{
+		ReadCpuFeatures(bSse2, bAvx2);
+		bRead = true;
+	}
+
+	if (kernel == TRANSFORM_KERNEL_SSE)
+	{
+		return(bSse2);
+	}
+	if (kernel == TRANSFORM_KERNEL_AVX2)
+	{
+		return(bAvx2);
+	}
+#endif
+
+	return(false);
+}
+
+/***********************************************************
+ *  SetKernel() / GetKernel()
+ *
+ *  These methods set and get the kernel that every batch is
+ *  calculated with.  It is only changed at startup, before
+ *  any batch is being calculated.
+ ***********************************************************/
+bool TransformBatch::SetKernel(TRANSFORM_KERNEL kernel)
+{
+	if ((kernel < TRANSFORM_KERNEL_SCALAR) || (kernel >= TRANSFORM_KERNEL_COUNT) ||
+		(IsKernelSupported(kernel) == false))
+	{
+		return(false);
+	}
+
+	g_Kernel = kernel;
+	return(true);
+}
+
+TRANSFORM_KERNEL TransformBatch::GetKernel()
+{
+	return(g_Kernel);
+}
+
+/***********************************************************
+ *  GetKernelName() / FindKernel()
+ *
+ *  These methods convert between kernels and their names.
+ *  An unknown name finds TRANSFORM_KERNEL_COUNT.
+ ***********************************************************/
+const char* TransformBatch::GetKernelName(TRANSFORM_KERNEL kernel)
+{
+	if ((kernel < TRANSFORM_KERNEL_SCALAR) || (kernel >= TRANSFORM_KERNEL_COUNT))
+	{
+		return("unknown");
+	}
+	return(g_KernelNames[kernel]);
+}
+
+TRANSFORM_KERNEL TransformBatch::FindKernel(const char* name)
+{
+	for (int kernel = 0; kernel < TRANSFORM_KERNEL_COUNT; kernel++)
+	{
+		if (std::strcmp(name, g_KernelNames[kernel]) == 0)
+		{
+			return((TRANSFORM_KERNEL)kernel);
+		}
+	}
+	return(TRANSFORM_KERNEL_COUNT);
+}
+
+/***********************************************************
+ *  RunKernel()
+ *
+ *  This method is used for calculating a run of matrices
+ *  with the kernel in use.
+ ***********************************************************/
+void TransformBatch::RunKernel(const TRANSFORM_WORK& work)
+{
+	if (work.count <= 0)
+	{
+		return;
+	}
+
+	COMPONENT_ARRAYS arrays;
+	for (int component = 0; component < COMPONENT_COUNT; component++)
+	{
+		arrays.values[component] = m_components[component].data();
+	}
+	float* matrices = &m_pMatrices[0][0][0];
+
+	switch (g_Kernel)
+	{
+#ifdef TRANSFORM_X86
+	case TRANSFORM_KERNEL_AVX2:
+		BuildAvx2(arrays, work.first, work.count, matrices);
+		break;
+	case TRANSFORM_KERNEL_SSE:
+		BuildSse(arrays, work.first, work.count, matrices);
+		break;
+#endif
+	default:
+		BuildScalar(arrays, work.first, work.count, matrices);
+		break;
+	}
+}
+
+/***********************************************************
+ *  StopWorkers()
+ *
+ *  This method is used for stopping the worker threads and
+ *  waiting for them to end.
+ ***********************************************************/
+void TransformBatch::StopWorkers()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+	}
+	m_batchReady.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+	m_work.resize(1);
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is used by each worker thread for calculating
+ *  its part of every batch that is started.
+ ***********************************************************/
+void TransformBatch::WorkerLoop(int worker)
+{
+	int generation = 0;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_batchReady.wait(lock, [this, &generation] {
+				return m_bStopping || (m_batchGeneration != generation);
+			});
+			if (m_bStopping)
+			{
+				return;
+			}
+			generation = m_batchGeneration;
+		}
+
+		RunKernel(m_work[worker + 1]);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_workersDone++;
+		}
+		m_batchDone.notify_one();
+	}
+}
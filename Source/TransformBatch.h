@@ -0,0 +1,122 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbatch.h
+// ============
+// calculate the matrices of many transforms at once with vector instructions
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// instruction sets that the matrices can be calculated with
+enum TRANSFORM_KERNEL
+{
+	TRANSFORM_KERNEL_SCALAR = 0,
+	TRANSFORM_KERNEL_SSE,
+	TRANSFORM_KERNEL_AVX2,
+	TRANSFORM_KERNEL_COUNT
+};
+
+/***********************************************************
+ *  TransformBatch
+ *
+ *  This class contains the scales, rotations and positions
+ *  of many transforms, with one array for each component, so
+ *  that a kernel can load the same component of eight or four
+ *  transforms with one instruction and calculate all of their
+ *  matrices side by side.  The rotation is put together from
+ *  the sines and cosines of the three angles directly, in the
+ *  same X, Y, Z order as three separate rotation matrices,
+ *  without multiplying any matrices.  The kernel is picked
+ *  once from what the CPU supports: AVX2, SSE2, or plain
+ *  code, which is also used for the few transforms left over
+ *  at the end of a run.  The sines and cosines of the vector
+ *  kernels come from a polynomial that is accurate to a few
+ *  float steps.  Large batches can be split between worker
+ *  threads that wait for the next batch between calls.
+ ***********************************************************/
+class TransformBatch
+{
+public:
+	// constructor
+	TransformBatch();
+	// destructor
+	~TransformBatch();
+
+	// change the number of transforms, the added ones do nothing
+	void Resize(int count);
+	// get the number of transforms
+	int GetCount() const { return m_count; }
+	// set the scale, rotations in degrees around the X, Y and Z axes,
+	// and position of a transform
+	void SetTransform(int index, const glm::vec3& scale,
+		const glm::vec3& rotationDegrees, const glm::vec3& position);
+
+	// calculate the matrices of the run of transforms into the same
+	// indexes of the passed in matrices
+	void BuildMatrices(int first, int count, glm::mat4* matrices);
+	// split the large runs between this many threads besides the
+	// calling thread, or none
+	void SetWorkerCount(int workerCount);
+	// get the number of worker threads
+	int GetWorkerCount() const { return (int)m_workers.size(); }
+
+	// calculate the matrix of one transform
+	static glm::mat4 BuildMatrix(const glm::vec3& scale,
+		const glm::vec3& rotationDegrees, const glm::vec3& position);
+
+	// check whether the CPU can run a kernel
+	static bool IsKernelSupported(TRANSFORM_KERNEL kernel);
+	// use a kernel for every batch, if the CPU can run it - the best
+	// one that it can run is used until then
+	static bool SetKernel(TRANSFORM_KERNEL kernel);
+	static TRANSFORM_KERNEL GetKernel();
+	// get the name of a kernel, or find a kernel by its name
+	static const char* GetKernelName(TRANSFORM_KERNEL kernel);
+	static TRANSFORM_KERNEL FindKernel(const char* name);
+
+	// components of a transform, each kept in an array of its own
+	enum COMPONENT
+	{
+		SCALE_X = 0, SCALE_Y, SCALE_Z,
+		ROTATION_X, ROTATION_Y, ROTATION_Z,
+		POSITION_X, POSITION_Y, POSITION_Z,
+		COMPONENT_COUNT
+	};
+
+private:
+	// run of transforms that one thread calculates
+	struct TRANSFORM_WORK
+	{
+		int first;
+		int count;
+	};
+
+	std::vector<float> m_components[COMPONENT_COUNT];
+	int m_count;
+
+	// matrices of the batch that is being calculated
+	glm::mat4* m_pMatrices;
+	// work of the calling thread, then of each worker
+	std::vector<TRANSFORM_WORK> m_work;
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_batchReady;
+	std::condition_variable m_batchDone;
+	// bumped for every batch that the workers take part in
+	int m_batchGeneration;
+	int m_workersDone;
+	bool m_bStopping;
+
+	// calculate a run of matrices on the calling thread
+	void RunKernel(const TRANSFORM_WORK& work);
+	// stop and join the worker threads
+	void StopWorkers();
+	// calculate for the workers until they are stopped
+	void WorkerLoop(int worker);
+};
@@ -9,6 +9,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "ViewManager.h"
+#include "GLStateCache.h"
 
 // GLM Math Header inclusions
 #include <glm/glm.hpp>
@@ -21,8 +22,13 @@ namespace {
 // Variables for window width and height
 const int WINDOW_WIDTH = 1000;
 const int WINDOW_HEIGHT = 800;
+// size of the window framebuffer in pixels, which changes when the
+// window is resized
+int gFramebufferWidth = WINDOW_WIDTH;
+int gFramebufferHeight = WINDOW_HEIGHT;
 const char *g_ViewName = "view";
 const char *g_ProjectionName = "projection";
+const char *g_ViewPositionName = "viewPosition";
 
 // camera object used for viewing and interacting with
 // the 3D scene
@@ -40,6 +46,9 @@ float gLastFrame = 0.0f;
 // the following variable is false when orthographic projection
 // is off and true when it is on
 bool bOrthographicProjection = false;
+
+// records the camera input, or replays it in place of the live input
+InputRecorder *g_pInputRecorder = nullptr;
 } // namespace
 
 /***********************************************************
@@ -51,6 +60,13 @@ ViewManager::ViewManager(ShaderManager *pShaderManager) {
   // initialize the member variables
   m_pShaderManager = pShaderManager;
   m_pWindow = NULL;
+  m_pUniforms = NULL;
+  m_viewState.view = glm::mat4(1.0f);
+  m_viewState.projection = glm::mat4(1.0f);
+  m_viewState.viewProjection = glm::mat4(1.0f);
+  m_viewState.viewPosition = glm::vec3(0.0f, 0.0f, 0.0f);
+  m_viewState.width = WINDOW_WIDTH;
+  m_viewState.height = WINDOW_HEIGHT;
   g_pCamera = new Camera();
   // default camera view parameters
   g_pCamera->Position = glm::vec3(0.0f, 5.0f, 12.0f);
@@ -101,15 +117,90 @@ GLFWwindow *ViewManager::CreateDisplayWindow(const char *windowTitle) {
   // this callback is used to receive mouse moving events
   glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
 
+  // this callback is used to receive the new size of a resized window,
+  // and the framebuffer can differ from the window size on high DPI
+  // displays, so its starting size is looked up as well
+  glfwSetFramebufferSizeCallback(window, &ViewManager::Framebuffer_Size_Callback);
+  glfwGetFramebufferSize(window, &gFramebufferWidth, &gFramebufferHeight);
+
   // enable blending for supporting tranparent rendering
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  GLStateCache::Current().Enable(GL_BLEND);
+  GLStateCache::Current().BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
   m_pWindow = window;
 
   return (window);
 }
 
+/***********************************************************
+ *  CreateOffscreenView()
+ *
+ *  This method is used to prepare the view when rendering
+ *  into an offscreen framebuffer.  There is no window, so
+ *  keyboard and mouse input are not processed.
+ ***********************************************************/
+void ViewManager::CreateOffscreenView() {
+  m_pWindow = NULL;
+
+  // enable blending for supporting tranparent rendering
+  GLStateCache::Current().Enable(GL_BLEND);
+  GLStateCache::Current().BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+/***********************************************************
+ *  SetInputRecorder()
+ *
+ *  This method is used to record the camera input of this
+ *  run, or to replay a recorded run in place of the live
+ *  input, depending on what the recorder was started with.
+ ***********************************************************/
+void ViewManager::SetInputRecorder(InputRecorder *pRecorder) {
+  g_pInputRecorder = pRecorder;
+}
+
+/***********************************************************
+ *  GetViewWidth() / GetViewHeight()
+ *
+ *  These methods return the size of the rendered view.
+ ***********************************************************/
+int ViewManager::GetViewWidth() const { return gFramebufferWidth; }
+int ViewManager::GetViewHeight() const { return gFramebufferHeight; }
+
+/***********************************************************
+ *  Framebuffer_Size_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the framebuffer of the display window changes size.  A
+ *  minimized window has a size of zero, which keeps the last
+ *  size so that the projection stays valid.
+ ***********************************************************/
+void ViewManager::Framebuffer_Size_Callback(GLFWwindow *window, int width,
+                                            int height) {
+  if ((width > 0) && (height > 0)) {
+    gFramebufferWidth = width;
+    gFramebufferHeight = height;
+  }
+}
+
+/***********************************************************
+ *  GetViewState()
+ *
+ *  This method returns the camera matrices of the last
+ *  updated frame, to be applied when the frame is rendered.
+ ***********************************************************/
+const VIEW_STATE &ViewManager::GetViewState() const { return m_viewState; }
+
+/***********************************************************
+ *  GetViewProjection()
+ *
+ *  This method returns the view and projection matrices of
+ *  the last updated frame, combined, for culling the scene
+ *  objects against the view frustum.
+ ***********************************************************/
+const glm::mat4 &ViewManager::GetViewProjection() const {
+  return m_viewState.viewProjection;
+}
+
 /***********************************************************
  *  Mouse_Position_Callback()
  *
@@ -118,6 +209,24 @@ GLFWwindow *ViewManager::CreateDisplayWindow(const char *windowTitle) {
  ***********************************************************/
 void ViewManager::Mouse_Position_Callback(GLFWwindow *window, double xMousePos,
                                           double yMousePos) {
+  // the live mouse is ignored while a recording is replayed
+  if (NULL != g_pInputRecorder) {
+    if (g_pInputRecorder->IsReplaying()) {
+      return;
+    }
+    g_pInputRecorder->RecordMouseMove((float)xMousePos, (float)yMousePos);
+  }
+
+  ApplyMousePosition(xMousePos, yMousePos);
+}
+
+/***********************************************************
+ *  ApplyMousePosition()
+ *
+ *  This method is used to turn the camera by the distance
+ *  the mouse moved since its last position.
+ ***********************************************************/
+void ViewManager::ApplyMousePosition(double xMousePos, double yMousePos) {
   // when the first mouse move event is received, this needs to be recorded so
   // that all subsequent mouse moves can correctly calculate the X position
   // offset and Y position offset for proper operation
@@ -149,6 +258,24 @@ void ViewManager::Mouse_Position_Callback(GLFWwindow *window, double xMousePos,
  ***********************************************************/
 void ViewManager::Mouse_Wheel_Scroll_Callback(GLFWwindow *window, double x,
                                               double yScrollDistance) {
+  // the live mouse is ignored while a recording is replayed
+  if (NULL != g_pInputRecorder) {
+    if (g_pInputRecorder->IsReplaying()) {
+      return;
+    }
+    g_pInputRecorder->RecordScroll((float)yScrollDistance);
+  }
+
+  ApplyMouseScroll(yScrollDistance);
+}
+
+/***********************************************************
+ *  ApplyMouseScroll()
+ *
+ *  This method is used to zoom the camera by a scroll of the
+ *  mouse wheel.
+ ***********************************************************/
+void ViewManager::ApplyMouseScroll(double yScrollDistance) {
   if (NULL == g_pCamera) {
     return;
   }
@@ -159,7 +286,9 @@ void ViewManager::Mouse_Wheel_Scroll_Callback(GLFWwindow *window, double x,
  *  ProcessKeyboardEvents()
  *
  *  This method is called to process any keyboard events
- *  that may be waiting in the event queue.
+ *  that may be waiting in the event queue.  The camera keys
+ *  are recorded when recording, and left to the replay when
+ *  a recording is replayed.
  ***********************************************************/
 void ViewManager::ProcessKeyboardEvents() {
   // close the window if the escape key has been pressed
@@ -167,44 +296,140 @@ void ViewManager::ProcessKeyboardEvents() {
     glfwSetWindowShouldClose(m_pWindow, true);
   }
 
+  if ((NULL != g_pInputRecorder) && g_pInputRecorder->IsReplaying()) {
+    return;
+  }
+
+  uint16_t keys = ReadCameraKeys();
+  if (NULL != g_pInputRecorder) {
+    g_pInputRecorder->RecordFrame(keys, gDeltaTime);
+  }
+  ApplyCameraKeys(keys, gDeltaTime);
+}
+
+/***********************************************************
+ *  ReadCameraKeys()
+ *
+ *  This method is used to poll the keys that move the camera
+ *  and switch the projection.
+ ***********************************************************/
+uint16_t ViewManager::ReadCameraKeys() const {
+  const int keyCodes[] = {GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D,
+                          GLFW_KEY_Q, GLFW_KEY_E, GLFW_KEY_O, GLFW_KEY_P};
+  const uint16_t keyBits[] = {
+      INPUT_KEY_FORWARD, INPUT_KEY_BACKWARD,     INPUT_KEY_LEFT,
+      INPUT_KEY_RIGHT,   INPUT_KEY_UP,           INPUT_KEY_DOWN,
+      INPUT_KEY_ORTHOGRAPHIC, INPUT_KEY_PERSPECTIVE};
+  uint16_t keys = 0;
+
+  for (int i = 0; i < 8; i++) {
+    if (glfwGetKey(m_pWindow, keyCodes[i]) == GLFW_PRESS) {
+      keys |= keyBits[i];
+    }
+  }
+
+  return (keys);
+}
+
+/***********************************************************
+ *  ApplyCameraKeys()
+ *
+ *  This method is used to move the camera for the keys that
+ *  are held, by the distance it covers in the passed in
+ *  time, and to switch the projection.
+ ***********************************************************/
+void ViewManager::ApplyCameraKeys(uint16_t keys, float deltaTime) {
   // if the camera object is null, then exit this method
   if (NULL == g_pCamera) {
     return;
   }
 
   // process camera zooming in and out
-  if (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS) {
-    g_pCamera->ProcessKeyboard(FORWARD, gDeltaTime);
+  if (keys & INPUT_KEY_FORWARD) {
+    g_pCamera->ProcessKeyboard(FORWARD, deltaTime);
   }
-  if (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS) {
-    g_pCamera->ProcessKeyboard(BACKWARD, gDeltaTime);
+  if (keys & INPUT_KEY_BACKWARD) {
+    g_pCamera->ProcessKeyboard(BACKWARD, deltaTime);
   }
 
   // process camera panning left and right
-  if (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS) {
-    g_pCamera->ProcessKeyboard(LEFT, gDeltaTime);
+  if (keys & INPUT_KEY_LEFT) {
+    g_pCamera->ProcessKeyboard(LEFT, deltaTime);
   }
-  if (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS) {
-    g_pCamera->ProcessKeyboard(RIGHT, gDeltaTime);
+  if (keys & INPUT_KEY_RIGHT) {
+    g_pCamera->ProcessKeyboard(RIGHT, deltaTime);
   }
 
   // process camera upward and downward movement
-  if (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS) {
-    g_pCamera->ProcessKeyboard(UP, gDeltaTime);
+  if (keys & INPUT_KEY_UP) {
+    g_pCamera->ProcessKeyboard(UP, deltaTime);
   }
-  if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS) {
-    g_pCamera->ProcessKeyboard(DOWN, gDeltaTime);
+  if (keys & INPUT_KEY_DOWN) {
+    g_pCamera->ProcessKeyboard(DOWN, deltaTime);
   }
 
   // toggle between orthographic and perspective projections
-  if (glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS) {
+  if (keys & INPUT_KEY_ORTHOGRAPHIC) {
     bOrthographicProjection = true;
   }
-  if (glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS) {
+  if (keys & INPUT_KEY_PERSPECTIVE) {
     bOrthographicProjection = false;
   }
 }
 
+/***********************************************************
+ *  ReplayInput()
+ *
+ *  This method is used to feed the camera the mouse moves,
+ *  scrolls and held keys of the next recorded frame, with
+ *  the frame time that was recorded for it in place of the
+ *  wall clock time.  Once the recording runs out, the camera
+ *  stays where it is.
+ ***********************************************************/
+void ViewManager::ReplayInput() {
+  const INPUT_EVENT *events = NULL;
+  int count = g_pInputRecorder->ReplayFrame(events);
+
+  for (int i = 0; i < count; i++) {
+    const INPUT_EVENT &event = events[i];
+    if (event.type == INPUT_EVENT_MOUSE_MOVE) {
+      ApplyMousePosition(event.x, event.y);
+    } else if (event.type == INPUT_EVENT_SCROLL) {
+      ApplyMouseScroll(event.y);
+    } else if (event.type == INPUT_EVENT_FRAME) {
+      ApplyCameraKeys(event.keys, event.x);
+    }
+  }
+}
+
+/***********************************************************
+ *  ResolveShaderUniforms()
+ *
+ *  This method is used for looking up the locations of the
+ *  view uniforms once, after the shaders have been loaded.
+ ***********************************************************/
+void ViewManager::ResolveShaderUniforms() {
+  m_pUniforms = ShaderUniforms::ForCurrentProgram();
+  if (NULL == m_pUniforms) {
+    return;
+  }
+
+  m_viewUniform = m_pUniforms->Resolve<glm::mat4>(g_ViewName);
+  m_projectionUniform = m_pUniforms->Resolve<glm::mat4>(g_ProjectionName);
+  m_viewPositionUniform = m_pUniforms->Resolve<glm::vec3>(g_ViewPositionName);
+}
+
+/***********************************************************
+ *  ReloadShaderUniforms()
+ *
+ *  This method is used for looking up the view uniforms of
+ *  the shader program in use again, after the shaders were
+ *  changed and linked into a new program.
+ ***********************************************************/
+void ViewManager::ReloadShaderUniforms() {
+  ResolveShaderUniforms();
+}
+
 /***********************************************************
  *  PrepareSceneView()
  *
@@ -213,25 +438,47 @@ void ViewManager::ProcessKeyboardEvents() {
  *  rendering
  ***********************************************************/
 void ViewManager::PrepareSceneView() {
+  UpdateView();
+  ApplyView(m_viewState);
+}
+
+/***********************************************************
+ *  UpdateView()
+ *
+ *  This method is used for processing the waiting input and
+ *  calculating the camera matrices of the next frame.  It
+ *  makes no OpenGL calls, so the next frame can be updated
+ *  while the last one is rendered on another thread.
+ ***********************************************************/
+void ViewManager::UpdateView() {
   glm::mat4 view;
   glm::mat4 projection;
 
-  // per-frame timing
-  float currentFrame = glfwGetTime();
-  gDeltaTime = currentFrame - gLastFrame;
-  gLastFrame = currentFrame;
+  // live input is only available when rendering to a display window
+  if (NULL != m_pWindow) {
+    // per-frame timing
+    float currentFrame = glfwGetTime();
+    gDeltaTime = currentFrame - gLastFrame;
+    gLastFrame = currentFrame;
+
+    // process any keyboard events that may be waiting in the
+    // event queue
+    ProcessKeyboardEvents();
+  }
 
-  // process any keyboard events that may be waiting in the
-  // event queue
-  ProcessKeyboardEvents();
+  // a replayed recording drives the camera with or without a window
+  if ((NULL != g_pInputRecorder) && g_pInputRecorder->IsReplaying()) {
+    ReplayInput();
+  }
 
   // get the current view matrix from the camera
   view = g_pCamera->GetViewMatrix();
 
-  // define the current projection matrix
+  // define the current projection matrix, for the current size of
+  // the window
   if (bOrthographicProjection) {
     float orthoWidth = 10.0f;
-    float orthoHeight = orthoWidth * ((GLfloat)WINDOW_HEIGHT / (GLfloat)WINDOW_WIDTH);
+    float orthoHeight = orthoWidth * ((GLfloat)gFramebufferHeight / (GLfloat)gFramebufferWidth);
     projection = glm::ortho(
         -orthoWidth, orthoWidth, 
         -orthoHeight, orthoHeight, 
@@ -239,17 +486,39 @@ void ViewManager::PrepareSceneView() {
         );
   } else {
     projection = glm::perspective(glm::radians(g_pCamera->Zoom),
-        (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT,
+        (GLfloat)gFramebufferWidth / (GLfloat)gFramebufferHeight,
         0.1f, 100.0f);
   }
 
-  // if the shader manager object is valid
-  if (NULL != m_pShaderManager) {
+  m_viewState.view = view;
+  m_viewState.projection = projection;
+  m_viewState.viewProjection = projection * view;
+  m_viewState.viewPosition = g_pCamera->Position;
+  m_viewState.width = gFramebufferWidth;
+  m_viewState.height = gFramebufferHeight;
+}
+
+/***********************************************************
+ *  ApplyView()
+ *
+ *  This method is used for setting the camera matrices of an
+ *  updated frame into the shader, on the thread that owns
+ *  the OpenGL context.
+ ***********************************************************/
+void ViewManager::ApplyView(const VIEW_STATE &viewState) {
+  // the shaders are loaded after this object is created, so the
+  // uniforms are resolved on the first frame
+  if (NULL == m_pUniforms) {
+    ResolveShaderUniforms();
+  }
+
+  // if the shader uniforms are valid
+  if (NULL != m_pUniforms) {
     // set the view matrix into the shader for proper rendering
-    m_pShaderManager->setMat4Value(g_ViewName, view);
+    m_pUniforms->Set(m_viewUniform, viewState.view);
     // set the view matrix into the shader for proper rendering
-    m_pShaderManager->setMat4Value(g_ProjectionName, projection);
+    m_pUniforms->Set(m_projectionUniform, viewState.projection);
     // set the view position of the camera into the shader for proper rendering
-    m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+    m_pUniforms->Set(m_viewPositionUniform, viewState.viewPosition);
   }
 }
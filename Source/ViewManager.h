@@ -10,11 +10,26 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "ShaderUniforms.h"
+#include "InputRecorder.h"
 #include "camera.h"
 
 // GLFW library
 #include "GLFW/glfw3.h" 
 
+// camera matrices of one frame, handed from its update to its rendering
+struct VIEW_STATE
+{
+  glm::mat4 view;
+  glm::mat4 projection;
+  // view and projection combined
+  glm::mat4 viewProjection;
+  glm::vec3 viewPosition;
+  // size of the output in pixels that the projection was made for
+  int width;
+  int height;
+};
+
 class ViewManager
 {
 public:
@@ -27,20 +42,60 @@ public:
 	// mouse position callback for mouse interaction with the 3D scene
 	static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
   static void Mouse_Wheel_Scroll_Callback(GLFWwindow* window, double x, double yScrollDistance);
+	// framebuffer size callback for resizing the display window
+	static void Framebuffer_Size_Callback(GLFWwindow* window, int width, int height);
 
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
+	// resolved view uniforms of the shader program in use
+	ShaderUniforms* m_pUniforms;
+	UniformHandle<glm::mat4> m_viewUniform;
+	UniformHandle<glm::mat4> m_projectionUniform;
+	UniformHandle<glm::vec3> m_viewPositionUniform;
+	// camera matrices of the last updated frame
+	VIEW_STATE m_viewState;
 
 	// process keyboard events for interaction with the 3D scene
 	void ProcessKeyboardEvents();
+	// get the camera keys that are held down, as INPUT_KEY bits
+	uint16_t ReadCameraKeys() const;
+	// feed the camera the input of the next recorded frame
+	void ReplayInput();
+	// move the camera with held keys, the mouse and the mouse wheel,
+	// from live or replayed input
+	static void ApplyCameraKeys(uint16_t keys, float deltaTime);
+	static void ApplyMousePosition(double xMousePos, double yMousePos);
+	static void ApplyMouseScroll(double yScrollDistance);
+	// resolve the handles of the view uniforms in the shader
+	void ResolveShaderUniforms();
 
 public:
 	// create the initial OpenGL display window
 	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
+	// prepare the view for rendering without a display window
+	void CreateOffscreenView();
+	// record the camera input into, or replay it from, the passed in
+	// recorder, or stop with NULL
+	void SetInputRecorder(InputRecorder* pRecorder);
+
+	// get the current size of the rendered view in pixels
+	int GetViewWidth() const;
+	int GetViewHeight() const;
 	
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
+	// process the input and move the camera, without any OpenGL calls
+	void UpdateView();
+	// set the camera matrices of an updated frame into the shader
+	void ApplyView(const VIEW_STATE& viewState);
+	// look up the view uniforms again, after the shader program in use
+	// was replaced
+	void ReloadShaderUniforms();
+	// get the camera matrices of the last updated frame
+	const VIEW_STATE& GetViewState() const;
+	// get the combined view and projection of the last updated frame
+	const glm::mat4& GetViewProjection() const;
 };